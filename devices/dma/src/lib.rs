@@ -0,0 +1,217 @@
+//! DMA 块传输设备：宿主文件与客户机内存之间的成块搬运
+//!
+//! 大数据集（LZIP/MD5等）既不必烤进ELF也不必经UART逐字节滴灌：
+//! 客户机把文件路径写进名字缓冲、填好地址/偏移/长度寄存器后敲
+//! 门铃，传输由内存子系统对主内存切片直接执行（见`DmaRequest`），
+//! 每次传输一对read(2)/write(2)加一次memcpy，没有逐字的MMIO往返。
+//!
+//! 寄存器映射（相对于设备基址，均为小端）:
+//! - 0x00: GUEST_ADDR（8B，客户机物理地址）
+//! - 0x08: FILE_OFF（8B，文件内偏移）
+//! - 0x10: LEN（8B，门铃前为请求长度，完成后回填实际传输字节数）
+//! - 0x18: 门铃（4B，写1=文件→内存，写2=内存→文件）
+//! - 0x1C: 状态（4B，0=空闲/成功 1=传输中 2=错误）
+//! - 0x40..0x140: 名字缓冲（宿主文件路径，NUL结尾）
+
+use mmio_trait::{DeviceError, DmaRequest, MmioDevice};
+
+const GUEST_ADDR_REG: u64 = 0x00;
+const FILE_OFF_REG: u64 = 0x08;
+const LEN_REG: u64 = 0x10;
+const DOORBELL_REG: u64 = 0x18;
+const STATUS_REG: u64 = 0x1c;
+const NAME_BUF_BASE: u64 = 0x40;
+/// 名字缓冲容量
+const NAME_BUF_SIZE: usize = 0x100;
+
+/// 门铃命令：文件→客户机内存
+const CMD_LOAD: u32 = 1;
+/// 门铃命令：客户机内存→文件
+const CMD_STORE: u32 = 2;
+
+/// 状态：空闲或上次传输成功
+const STATUS_IDLE: u32 = 0;
+/// 状态：请求已挂起等待执行
+const STATUS_BUSY: u32 = 1;
+/// 状态：上次传输失败
+const STATUS_ERROR: u32 = 2;
+
+/// DMA 设备
+pub struct Dma {
+    name: String,
+    guest_addr: u64,
+    file_offset: u64,
+    len: u64,
+    status: u32,
+    name_buf: [u8; NAME_BUF_SIZE],
+    pending: Option<DmaRequest>,
+}
+
+impl Dma {
+    pub fn new(name: String) -> Self {
+        Self {
+            name,
+            guest_addr: 0,
+            file_offset: 0,
+            len: 0,
+            status: STATUS_IDLE,
+            name_buf: [0; NAME_BUF_SIZE],
+            pending: None,
+        }
+    }
+
+    /// 名字缓冲里NUL结尾的路径
+    fn path(&self) -> Result<String, DeviceError> {
+        let end = self
+            .name_buf
+            .iter()
+            .position(|&b| b == 0)
+            .unwrap_or(NAME_BUF_SIZE);
+        if end == 0 {
+            return Err(DeviceError::Access("DMA 文件路径为空".to_string()));
+        }
+        String::from_utf8(self.name_buf[..end].to_vec())
+            .map_err(|_| DeviceError::Access("DMA 文件路径不是合法UTF-8".to_string()))
+    }
+
+    /// 寄存器值的低`size`字节（小端）
+    fn reg_bytes(value: u64, size: usize) -> Vec<u8> {
+        value.to_le_bytes()[..size].to_vec()
+    }
+}
+
+impl MmioDevice for Dma {
+    fn read(&mut self, offset: u64, size: usize) -> Result<Vec<u8>, DeviceError> {
+        match offset {
+            GUEST_ADDR_REG => Ok(Self::reg_bytes(self.guest_addr, size.min(8))),
+            FILE_OFF_REG => Ok(Self::reg_bytes(self.file_offset, size.min(8))),
+            LEN_REG => Ok(Self::reg_bytes(self.len, size.min(8))),
+            STATUS_REG => Ok(Self::reg_bytes(self.status as u64, size.min(4))),
+            o if (NAME_BUF_BASE..NAME_BUF_BASE + NAME_BUF_SIZE as u64).contains(&o) => {
+                let start = (o - NAME_BUF_BASE) as usize;
+                let end = (start + size).min(NAME_BUF_SIZE);
+                Ok(self.name_buf[start..end].to_vec())
+            }
+            _ => Err(DeviceError::Access(format!(
+                "DMA 不支持的寄存器偏移: {:#x}",
+                offset
+            ))),
+        }
+    }
+
+    fn write(&mut self, offset: u64, data: &[u8]) -> Result<(), DeviceError> {
+        let as_u64 = |data: &[u8]| {
+            let mut b = [0u8; 8];
+            b[..data.len().min(8)].copy_from_slice(&data[..data.len().min(8)]);
+            u64::from_le_bytes(b)
+        };
+        match offset {
+            GUEST_ADDR_REG => {
+                self.guest_addr = as_u64(data);
+                Ok(())
+            }
+            FILE_OFF_REG => {
+                self.file_offset = as_u64(data);
+                Ok(())
+            }
+            LEN_REG => {
+                self.len = as_u64(data);
+                Ok(())
+            }
+            DOORBELL_REG => {
+                let cmd = as_u64(data) as u32;
+                let to_file = match cmd {
+                    CMD_LOAD => false,
+                    CMD_STORE => true,
+                    _ => {
+                        return Err(DeviceError::Unsupported(format!(
+                            "DMA 未知门铃命令: {}",
+                            cmd
+                        )))
+                    }
+                };
+                self.pending = Some(DmaRequest {
+                    path: self.path()?,
+                    file_offset: self.file_offset,
+                    guest_addr: self.guest_addr,
+                    len: self.len,
+                    to_file,
+                });
+                self.status = STATUS_BUSY;
+                Ok(())
+            }
+            STATUS_REG => Err(DeviceError::Unsupported(
+                "DMA 状态寄存器是只读的".to_string(),
+            )),
+            o if (NAME_BUF_BASE..NAME_BUF_BASE + NAME_BUF_SIZE as u64).contains(&o) => {
+                let start = (o - NAME_BUF_BASE) as usize;
+                let end = (start + data.len()).min(NAME_BUF_SIZE);
+                self.name_buf[start..end].copy_from_slice(&data[..end - start]);
+                Ok(())
+            }
+            _ => Err(DeviceError::Access(format!(
+                "DMA 不支持的寄存器偏移: {:#x}",
+                offset
+            ))),
+        }
+    }
+
+    fn take_dma_request(&mut self) -> Option<DmaRequest> {
+        self.pending.take()
+    }
+
+    fn complete_dma(&mut self, result: Result<u64, String>) {
+        match result {
+            Ok(n) => {
+                self.len = n; // LEN回填实际传输字节数
+                self.status = STATUS_IDLE;
+            }
+            Err(_) => self.status = STATUS_ERROR,
+        }
+    }
+
+    fn name(&self) -> &str {
+        &self.name
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn read_u32(dev: &mut Dma, off: u64) -> u32 {
+        let b = dev.read(off, 4).unwrap();
+        u32::from_le_bytes(b.try_into().unwrap())
+    }
+
+    #[test]
+    fn test_doorbell_raises_request() {
+        let mut dma = Dma::new("dma0".to_string());
+        dma.write(NAME_BUF_BASE, b"data.bin\0").unwrap();
+        dma.write(GUEST_ADDR_REG, &0x8000_0000u64.to_le_bytes())
+            .unwrap();
+        dma.write(FILE_OFF_REG, &0x1000u64.to_le_bytes()).unwrap();
+        dma.write(LEN_REG, &4096u64.to_le_bytes()).unwrap();
+        dma.write(DOORBELL_REG, &CMD_LOAD.to_le_bytes()).unwrap();
+
+        assert_eq!(read_u32(&mut dma, STATUS_REG), STATUS_BUSY);
+        let req = dma.take_dma_request().expect("门铃后应有挂起请求");
+        assert_eq!(req.path, "data.bin");
+        assert_eq!(req.guest_addr, 0x8000_0000);
+        assert_eq!(req.file_offset, 0x1000);
+        assert_eq!(req.len, 4096);
+        assert!(!req.to_file);
+        assert!(dma.take_dma_request().is_none());
+
+        dma.complete_dma(Ok(4096));
+        assert_eq!(read_u32(&mut dma, STATUS_REG), STATUS_IDLE);
+        dma.complete_dma(Err("io".to_string()));
+        assert_eq!(read_u32(&mut dma, STATUS_REG), STATUS_ERROR);
+    }
+
+    #[test]
+    fn test_empty_path_rejected() {
+        let mut dma = Dma::new("dma0".to_string());
+        assert!(dma.write(DOORBELL_REG, &CMD_STORE.to_le_bytes()).is_err());
+    }
+}
@@ -13,6 +13,25 @@ pub enum DeviceError {
     Internal(String),
 }
 
+/// DMA 传输请求
+///
+/// 设备在MMIO处理器里只能看到自己的寄存器，无法触碰客户机内存；
+/// 门铃写入时设备把请求挂起，由内存子系统在MMIO访问返回后取走
+/// 并对主内存切片直接执行，宿主侧是一次read(2)/write(2)加memcpy
+#[derive(Debug, Clone)]
+pub struct DmaRequest {
+    /// 宿主文件路径
+    pub path: String,
+    /// 文件内偏移
+    pub file_offset: u64,
+    /// 客户机物理地址
+    pub guest_addr: u64,
+    /// 传输字节数
+    pub len: u64,
+    /// true: 客户机内存→文件；false: 文件→客户机内存
+    pub to_file: bool,
+}
+
 /// MMIO 设备 trait
 /// 所有 MMIO 设备都必须实现此 trait
 pub trait MmioDevice: Send + Sync {
@@ -33,6 +52,49 @@ pub trait MmioDevice: Send + Sync {
     /// - data: 要写入的数据，按小端序
     fn write(&mut self, offset: u64, data: &[u8]) -> Result<(), DeviceError>;
 
+    /// 批量从设备读取数据（可选覆盖）
+    ///
+    /// 默认实现按字节循环调用`read`；有连续后备存储的设备
+    /// （如块设备、帧缓冲）可覆盖为一次memcpy
+    ///
+    /// # 参数
+    /// - offset: 相对于设备基址的偏移量
+    /// - buf: 接收数据的缓冲区，长度即读取的字节数
+    fn read_block(&mut self, offset: u64, buf: &mut [u8]) -> Result<(), DeviceError> {
+        for (i, byte) in buf.iter_mut().enumerate() {
+            *byte = self.read(offset + i as u64, 1)?[0];
+        }
+        Ok(())
+    }
+
+    /// 批量向设备写入数据（可选覆盖）
+    ///
+    /// 默认实现按字节循环调用`write`，覆盖方式同`read_block`
+    ///
+    /// # 参数
+    /// - offset: 相对于设备基址的偏移量
+    /// - data: 要写入的数据
+    fn write_block(&mut self, offset: u64, data: &[u8]) -> Result<(), DeviceError> {
+        for (i, &byte) in data.iter().enumerate() {
+            self.write(offset + i as u64, &[byte])?;
+        }
+        Ok(())
+    }
+
+    /// 取走挂起的DMA请求（可选）
+    ///
+    /// 内存子系统在每次MMIO写返回后调用；有门铃请求的设备返回
+    /// Some并清除挂起状态，传输结果经`complete_dma`回报
+    fn take_dma_request(&mut self) -> Option<DmaRequest> {
+        None
+    }
+
+    /// DMA传输完成回报（可选）
+    ///
+    /// # 参数
+    /// - result: Ok携带实际传输的字节数，Err携带错误描述
+    fn complete_dma(&mut self, _result: Result<u64, String>) {}
+
     /// 时钟周期驱动（可选）
     /// 
     /// # 参数
@@ -51,4 +113,20 @@ pub trait MmioDevice: Send + Sync {
     fn name(&self) -> &str {
         "unknown"
     }
+
+    /// 导出设备内部状态（快照用，可选）
+    ///
+    /// # 返回
+    /// 设备自定义格式的状态字节序列；无内部状态的设备返回空
+    fn save_state(&self) -> Vec<u8> {
+        Vec::new()
+    }
+
+    /// 从快照恢复设备内部状态（可选）
+    ///
+    /// # 参数
+    /// - data: 此前由 `save_state` 导出的状态字节序列
+    fn restore_state(&mut self, _data: &[u8]) -> Result<(), DeviceError> {
+        Ok(())
+    }
 }
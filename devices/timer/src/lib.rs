@@ -1,37 +1,76 @@
-//! Timer 设备：直接返回系统时间（以微秒计）
+//! Timer 设备：以微秒计的单调时间源
+//!
+//! 时间由宿主单调时钟驱动，但只按批重采样：每 `REFRESH_READS` 次
+//! 计数器读取才碰一次宿主时钟，批内读取直接返回缓存值，客户机在
+//! 紧循环里轮询时间的代价是纳秒级。控制寄存器可切换到确定性模式，
+//! 此时时间完全由读取次数推进、与宿主时钟无关，difftest 与轨迹
+//! 回放逐位可复现。
 //!
 //! 寄存器映射（相对于设备基址）:
-//! - 0x00: 时间低位（读返回当前系统时间，按访问大小返回小端）
+//! - 0x00: 时间低位（读返回当前时间，按访问大小返回小端）
 //! - 0x04: 保留（与 0x00 同步）
 //! - 0x08: 保留（与 0x00 同步）
-//! - 0x0C: 控制寄存器（保留）
+//! - 0x0C: 控制寄存器（bit0: 确定性模式，写1清零并启用）
 use mmio_trait::{DeviceError, MmioDevice};
-use std::time::{SystemTime, UNIX_EPOCH};
+use std::time::{Instant, SystemTime, UNIX_EPOCH};
 
 const CNT0_REG: u64 = 0x00;
 const CNT1_REG: u64 = 0x04;
 const CNT2_REG: u64 = 0x08;
 const CTRL_REG: u64 = 0x0c;
 
-fn current_time_us() -> u64 {
-    let d = SystemTime::now().duration_since(UNIX_EPOCH);
-    match d {
-        Ok(dur) => {
-            // as_micros 返回 u128，截断为 u64（对于常规用途足够）
-            dur.as_micros() as u64
-        }
-        Err(_) => 0,
-    }
-}
+/// 两次宿主时钟采样之间允许的计数器读取次数
+const REFRESH_READS: u32 = 64;
+/// 确定性模式下每次读取推进的微秒数
+const DET_STEP_US: u64 = 1;
 
-/// 简化的 Timer 设备实现：读出系统时间（us）
+/// Timer 设备：批量重采样的单调微秒计数器
 pub struct Timer {
     name: String,
+    /// 宿主单调时钟基准（创建时采样一次）
+    base: Instant,
+    /// 基准时刻对应的绝对微秒（保留epoch语义，客户机看到的仍是墙钟）
+    base_us: u64,
+    /// 缓存的计数值：批内读取直接返回
+    cached_us: u64,
+    /// 距下次重采样的剩余读取次数
+    refresh_in: u32,
+    /// 确定性模式：时间由读取次数推进
+    deterministic: bool,
 }
 
 impl Timer {
     pub fn new(name: String) -> Self {
-        Self { name }
+        let base_us = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map(|d| d.as_micros() as u64)
+            .unwrap_or(0);
+        Self {
+            name,
+            base: Instant::now(),
+            base_us,
+            cached_us: 0,
+            refresh_in: 0,
+            deterministic: false,
+        }
+    }
+
+    /// 当前计数值（微秒）
+    ///
+    /// 确定性模式每次读取步进固定量；否则批内返回缓存，批首
+    /// 从单调时钟重采样（单调性由Instant保证，不会回拨）
+    #[inline]
+    fn current_us(&mut self) -> u64 {
+        if self.deterministic {
+            self.cached_us += DET_STEP_US;
+            return self.cached_us;
+        }
+        if self.refresh_in == 0 {
+            self.cached_us = self.base_us + self.base.elapsed().as_micros() as u64;
+            self.refresh_in = REFRESH_READS;
+        }
+        self.refresh_in -= 1;
+        self.cached_us
     }
 }
 
@@ -45,10 +84,10 @@ impl MmioDevice for Timer {
     fn read(&mut self, offset: u64, size: usize) -> Result<Vec<u8>, DeviceError> {
         match offset {
             CNT0_REG | CNT1_REG | CNT2_REG => {
-                // 支持 1/2/4/8 字节读取，返回当前系统时间（微秒）的小端字节序
+                // 支持 1/2/4/8 字节读取，返回当前时间（微秒）的小端字节序
                 match size {
                     1 | 2 | 4 | 8 => {
-                        let t = current_time_us();
+                        let t = self.current_us();
                         let bytes = t.to_le_bytes(); // 8 字节
                         let mut out = Vec::new();
                         // 根据 size 返回低位的 size 字节
@@ -61,11 +100,12 @@ impl MmioDevice for Timer {
                 }
             }
             CTRL_REG => {
-                // 控制寄存器暂不实现，返回 0
+                // 控制寄存器：bit0 即确定性模式开关
+                let v = self.deterministic as u64;
                 if size == 1 {
-                    Ok(vec![0u8])
+                    Ok(vec![v as u8])
                 } else if size == 4 {
-                    Ok(vec![0u8, 0u8, 0u8, 0u8])
+                    Ok((v as u32).to_le_bytes().to_vec())
                 } else {
                     Err(DeviceError::Unsupported(
                         "控制寄存器只支持 1 或 4 字节访问".to_string(),
@@ -79,12 +119,27 @@ impl MmioDevice for Timer {
         }
     }
 
-    fn write(&mut self, offset: u64, _data: &[u8]) -> Result<(), DeviceError> {
+    fn write(&mut self, offset: u64, data: &[u8]) -> Result<(), DeviceError> {
         match offset {
-            CNT0_REG | CNT1_REG | CNT2_REG | CTRL_REG => {
-                // 写操作对该设备无效或被忽略（只读设备）
+            CTRL_REG => {
+                // bit0 置位进入确定性模式（计数器清零，保证逐位可复现）
+                if data.is_empty() || data.len() > 8 {
+                    return Err(DeviceError::Unsupported(
+                        "控制寄存器只支持 1/2/4/8 字节访问".to_string(),
+                    ));
+                }
+                let on = data[0] & 1 != 0;
+                if on != self.deterministic {
+                    self.deterministic = on;
+                    self.cached_us = 0;
+                    self.refresh_in = 0;
+                }
+                Ok(())
+            }
+            CNT0_REG | CNT1_REG | CNT2_REG => {
+                // 计数器只读
                 Err(DeviceError::Unsupported(
-                    "Timer 为只读设备（读系统时间）".to_string(),
+                    "Timer 计数器为只读".to_string(),
                 ))
             }
             _ => Err(DeviceError::Access(format!(
@@ -97,6 +152,30 @@ impl MmioDevice for Timer {
     fn name(&self) -> &str {
         &self.name
     }
+
+    fn save_state(&self) -> Vec<u8> {
+        // 格式：[deterministic, cached_us(8B小端)]
+        let mut out = Vec::with_capacity(9);
+        out.push(self.deterministic as u8);
+        out.extend_from_slice(&self.cached_us.to_le_bytes());
+        out
+    }
+
+    fn restore_state(&mut self, data: &[u8]) -> Result<(), DeviceError> {
+        if data.is_empty() {
+            return Ok(()); // 旧快照无Timer状态
+        }
+        if data.len() != 9 {
+            return Err(DeviceError::Internal(format!(
+                "Timer 状态快照长度错误: {}",
+                data.len()
+            )));
+        }
+        self.deterministic = data[0] != 0;
+        self.cached_us = u64::from_le_bytes(data[1..9].try_into().unwrap());
+        self.refresh_in = 0; // 回滚后下一次读取重采样
+        Ok(())
+    }
 }
 
 #[cfg(test)]
@@ -118,4 +197,29 @@ mod tests {
         let ts = u64::from_le_bytes([r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7]]);
         assert!(ts > 0);
     }
+
+    #[test]
+    fn deterministic_mode_bit_stable() {
+        let read_seq = |t: &mut Timer| -> Vec<u64> {
+            (0..4)
+                .map(|_| {
+                    let r = t.read(CNT0_REG, 8).unwrap();
+                    u64::from_le_bytes(r.try_into().unwrap())
+                })
+                .collect()
+        };
+        let mut a = Timer::new("a".to_string());
+        let mut b = Timer::new("b".to_string());
+        a.write(CTRL_REG, &[1]).unwrap();
+        b.write(CTRL_REG, &[1]).unwrap();
+        let sa = read_seq(&mut a);
+        // 严格单调且与宿主时钟无关：两个实例读出完全相同的序列
+        assert!(sa.windows(2).all(|w| w[0] < w[1]));
+        assert_eq!(sa, read_seq(&mut b));
+        // 快照往返保持确定性计数
+        let snap = a.save_state();
+        let mut c = Timer::new("c".to_string());
+        c.restore_state(&snap).unwrap();
+        assert_eq!(read_seq(&mut a), read_seq(&mut c));
+    }
 }
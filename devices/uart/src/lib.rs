@@ -12,11 +12,19 @@ const UART_CTRL_REG: u64 = 0x08;   // 控制寄存器
 const UART_STATUS_TX_READY: u32 = 0x01;  // 发送就绪
 const UART_STATUS_RX_VALID: u32 = 0x02;  // 接收有效
 
+/// 发送缓冲区容量：写满即强制刷新
+const TX_BUF_CAP: usize = 4096;
+
 /// UART 设备
+///
+/// 发送端带行缓冲：每次数据寄存器写入只是一次`Vec::push`，遇到
+/// 换行或缓冲写满才做一次宿主stderr写出。发送就绪位恒为1（缓冲
+/// 永远可写），客户机可以连续突发写入、无需在字符间轮询状态寄存器
 pub struct Uart {
     name: String,
     tx_ready: bool,
     rx_buffer: Option<u8>,
+    tx_buffer: Vec<u8>,
 }
 
 impl Uart {
@@ -26,7 +34,29 @@ impl Uart {
             name,
             tx_ready: true,
             rx_buffer: None,
+            tx_buffer: Vec::with_capacity(TX_BUF_CAP),
+        }
+    }
+
+    /// 把积累的发送字节一次性写到宿主stderr
+    fn flush_tx(&mut self) -> Result<(), DeviceError> {
+        if self.tx_buffer.is_empty() {
+            return Ok(());
         }
+        let stderr = io::stderr();
+        let mut out = stderr.lock();
+        out.write_all(&self.tx_buffer)
+            .and_then(|_| out.flush())
+            .map_err(|e| DeviceError::Internal(format!("UART 输出错误: {}", e)))?;
+        self.tx_buffer.clear();
+        Ok(())
+    }
+}
+
+impl Drop for Uart {
+    fn drop(&mut self) {
+        // 程序退出时残留的半行输出也要落到终端
+        let _ = self.flush_tx();
     }
 }
 
@@ -79,28 +109,20 @@ impl MmioDevice for Uart {
     fn write(&mut self, offset: u64, data: &[u8]) -> Result<(), DeviceError> {
         match offset {
             UART_DATA_REG => {
-                // 写入数据寄存器
-                if data.len() != 1 {
+                // 写入数据寄存器：接受1~8字节的批量写（客户机可用sd一次
+                // 送8个字符），低位字节在前
+                if data.is_empty() || data.len() > 8 {
                     return Err(DeviceError::Unsupported(
-                        "UART 数据寄存器只支持字节访问".to_string(),
+                        "UART 数据寄存器只支持1~8字节访问".to_string(),
                     ));
                 }
-                
-                // 将字节输出到 stderr
-                let byte = data[0];
-                if let Err(e) = io::stderr().write_all(&[byte]) {
-                    return Err(DeviceError::Internal(format!(
-                        "UART 输出错误: {}",
-                        e
-                    )));
-                }
-                if let Err(e) = io::stderr().flush() {
-                    return Err(DeviceError::Internal(format!(
-                        "UART 刷新错误: {}",
-                        e
-                    )));
+
+                // 先进发送缓冲，换行或写满时成批落到 stderr
+                self.tx_buffer.extend_from_slice(data);
+                if data.contains(&b'\n') || self.tx_buffer.len() >= TX_BUF_CAP {
+                    self.flush_tx()?;
                 }
-                
+
                 Ok(())
             }
             UART_STATUS_REG => {
@@ -129,6 +151,27 @@ impl MmioDevice for Uart {
     fn name(&self) -> &str {
         &self.name
     }
+
+    fn save_state(&self) -> Vec<u8> {
+        // 格式：[tx_ready, rx_valid, rx_byte]
+        vec![
+            self.tx_ready as u8,
+            self.rx_buffer.is_some() as u8,
+            self.rx_buffer.unwrap_or(0),
+        ]
+    }
+
+    fn restore_state(&mut self, data: &[u8]) -> Result<(), DeviceError> {
+        if data.len() != 3 {
+            return Err(DeviceError::Internal(format!(
+                "UART 状态快照长度错误: {}",
+                data.len()
+            )));
+        }
+        self.tx_ready = data[0] != 0;
+        self.rx_buffer = if data[1] != 0 { Some(data[2]) } else { None };
+        Ok(())
+    }
 }
 
 #[cfg(test)]
@@ -156,6 +199,35 @@ mod tests {
         assert!(result.is_ok());
     }
 
+    #[test]
+    fn test_tx_line_buffering() {
+        let mut uart = Uart::new("test".to_string());
+        for &b in b"abc" {
+            uart.write(UART_DATA_REG, &[b]).unwrap();
+        }
+        // 未见换行：字节都还在缓冲里
+        assert_eq!(uart.tx_buffer, b"abc");
+        uart.write(UART_DATA_REG, &[b'\n']).unwrap();
+        assert!(uart.tx_buffer.is_empty());
+        // 缓冲期间发送始终就绪，客户机无需轮询
+        let status = uart.read(UART_STATUS_REG, 4).unwrap();
+        let status = u32::from_le_bytes([status[0], status[1], status[2], status[3]]);
+        assert_eq!(status & UART_STATUS_TX_READY, UART_STATUS_TX_READY);
+    }
+
+    #[test]
+    fn test_tx_batch_write() {
+        let mut uart = Uart::new("test".to_string());
+        // 一次8字节的批量写等价于逐字节写入
+        uart.write(UART_DATA_REG, b"abcdefgh").unwrap();
+        assert_eq!(uart.tx_buffer, b"abcdefgh");
+        // 批内含换行则整批随行刷新
+        uart.write(UART_DATA_REG, b"ij\n").unwrap();
+        assert!(uart.tx_buffer.is_empty());
+        // 超过8字节的访问不是合法的MMIO宽度
+        assert!(uart.write(UART_DATA_REG, &[0u8; 9]).is_err());
+    }
+
     #[test]
     fn test_invalid_register() {
         let mut uart = Uart::new("test".to_string());
@@ -0,0 +1,173 @@
+//! 模拟器热路径的criterion微基准
+//!
+//! `cargo bench`运行。整程序运行噪声大、定位粗，这里把各个
+//! 热路径拆开单独计时：译码快/慢路径、主内存读写与取指快
+//! 路径、MMIO区域分发、事件环形缓冲，以及固定客户程序上的
+//! 端到端`steps()`，性能改动据此给出回归数字而非体感。
+//!
+//! 注意：与单元测试一样依赖`profile/config.toml`与设备配置，
+//! 须从emulator目录运行（cargo默认如此）。
+
+use std::rc::Rc;
+
+use criterion::{Criterion, black_box, criterion_group, criterion_main};
+use emulator::const_values::{DeviceFile, EmuConfig};
+use emulator::emulator::{Emulator, InstDecoder, Memory};
+use emulator::utils::ringbuf::RingBuffer;
+use emulator::Args;
+use clap::Parser;
+
+/// 录制的指令字频度混合：来自cpu_test动态直方图的代表性采样，
+/// 覆盖稠密分发表（ALU/访存/分支）与按opcode分桶的兜底路径（ecall）
+const INST_MIX: &[u32] = &[
+    0x00500093, // addi x1, x0, 5
+    0x002081b3, // add  x3, x1, x2
+    0x00013403, // ld   x8, 0(x2)
+    0x00113023, // sd   x1, 0(x2)
+    0x00208663, // beq  x1, x2, +12
+    0x008000ef, // jal  x1, +8
+    0x000011b7, // lui  x3, 0x1
+    0x02208133, // mul  x2, x1, x2
+    0x0020c193, // xori x3, x1, 2
+    0x0020d093, // srli x1, x1, 2
+    0x40208233, // sub  x4, x1, x2
+    0x00000073, // ecall（兜底桶）
+];
+
+fn load_config() -> Rc<EmuConfig> {
+    Rc::new(EmuConfig::new("profile/config.toml").unwrap())
+}
+
+fn load_device_file() -> DeviceFile {
+    DeviceFile::new("../devices/profile/device.toml").unwrap()
+}
+
+fn bench_decoder(c: &mut Criterion) {
+    let mut decoder = InstDecoder::new(load_config());
+
+    c.bench_function("decoder/slow_path_mix", |b| {
+        b.iter(|| {
+            for &inst in INST_MIX {
+                black_box(decoder.slow_path(black_box(inst)).unwrap());
+            }
+        })
+    });
+
+    // 稳态：同一批PC反复命中译码缓存
+    c.bench_function("decoder/fast_path_hit_mix", |b| {
+        b.iter(|| {
+            for (i, &inst) in INST_MIX.iter().enumerate() {
+                let pc = 0x8000_0000u64 + (i as u64) * 4;
+                black_box(decoder.fast_path(black_box(pc), black_box(inst)).unwrap());
+            }
+        })
+    });
+}
+
+fn bench_decoder_classes(c: &mut Criterion) {
+    use emulator::utils::inst_gen::{ALL_CLASSES, InstGen};
+
+    // 按类别预生成受控指令流，单独测各类的慢路径译码吞吐
+    let mut group = c.benchmark_group("decoder/slow_path_class");
+    for &class in ALL_CLASSES {
+        let mut decoder = InstDecoder::new(load_config());
+        let stream = InstGen::new(0xbe9c, &[(class, 1)]).stream(1024);
+        group.throughput(criterion::Throughput::Elements(stream.len() as u64));
+        group.bench_function(format!("{class:?}"), |b| {
+            b.iter(|| {
+                for &inst in &stream {
+                    black_box(decoder.slow_path(black_box(inst)).unwrap());
+                }
+            })
+        });
+    }
+    group.finish();
+
+    // 等权混合流：接近真实负载的分支预测难度
+    let mut decoder = InstDecoder::new(load_config());
+    let stream = InstGen::uniform(0xbe9c).stream(4096);
+    c.bench_function("decoder/slow_path_uniform_mix", |b| {
+        b.iter(|| {
+            for &inst in &stream {
+                black_box(decoder.slow_path(black_box(inst)).unwrap());
+            }
+        })
+    });
+}
+
+fn bench_memory(c: &mut Criterion) {
+    let mut memory = Memory::new(load_config(), &load_device_file()).unwrap();
+    let base = 0x8000_0000u64;
+    memory.write(base, &0xdead_beefu32.to_le_bytes()).unwrap();
+
+    c.bench_function("memory/read_8B", |b| {
+        b.iter(|| black_box(memory.read(black_box(base), 8).unwrap()))
+    });
+
+    c.bench_function("memory/write_8B", |b| {
+        let data = 0x0123_4567_89ab_cdefu64.to_le_bytes();
+        b.iter(|| memory.write(black_box(base), black_box(&data)).unwrap())
+    });
+
+    c.bench_function("memory/read_u32_fast", |b| {
+        // 安全性：base落在主内存且已写入
+        b.iter(|| black_box(unsafe { memory.read_u32_fast(black_box(base)) }))
+    });
+}
+
+fn bench_mmio_dispatch(c: &mut Criterion) {
+    // 经完整模拟器走MMIO读：覆盖find_mmio_region的页标记
+    // 快路径加设备分发；UART状态寄存器读取无副作用
+    let emu = Emulator::new(&Args::parse_from(["emulator"])).unwrap();
+
+    c.bench_function("memory/mmio_uart_status_read", |b| {
+        b.iter(|| black_box(emu.read_memory(black_box(0x1000_0004), 4).unwrap()))
+    });
+}
+
+fn bench_ringbuf(c: &mut Criterion) {
+    let mut ring: RingBuffer<u64> = RingBuffer::new(64);
+
+    c.bench_function("ringbuf/push_overwrite", |b| {
+        let mut i = 0u64;
+        b.iter(|| {
+            ring.push_overwrite(black_box(i));
+            i = i.wrapping_add(1);
+        })
+    });
+}
+
+fn bench_steps(c: &mut Criterion) {
+    // 固定的客户程序：纯ALU循环加回跳，稳态下整块命中块缓存，
+    // 端到端覆盖取指、块查找与处理函数分发
+    let mut emu = Emulator::new(&Args::parse_from(["emulator"])).unwrap();
+    let base = emu.get_pc();
+    let loop_body: &[u32] = &[
+        0x00108093, // addi x1, x1, 1
+        0x00210113, // addi x2, x2, 2
+        0x002081b3, // add  x3, x1, x2
+        0x0011c233, // xor  x4, x3, x1
+        0xff1ff06f, // jal  x0, -16
+    ];
+    for (i, inst) in loop_body.iter().enumerate() {
+        emu.write_memory(base + (i * 4) as u64, &inst.to_le_bytes())
+            .unwrap();
+    }
+
+    const CHUNK: usize = 1 << 16;
+    let mut group = c.benchmark_group("steps");
+    group.throughput(criterion::Throughput::Elements(CHUNK as u64));
+    group.bench_function("alu_loop_64k", |b| b.iter(|| emu.steps(CHUNK).unwrap()));
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_decoder,
+    bench_decoder_classes,
+    bench_memory,
+    bench_mmio_dispatch,
+    bench_ringbuf,
+    bench_steps
+);
+criterion_main!(benches);
@@ -16,6 +16,15 @@ pub struct InstSetConfig {
     pub a_ext: bool,
     #[serde(default)]
     pub c_ext: bool,
+    #[serde(default)]
+    pub f_ext: bool,
+    #[serde(default)]
+    pub d_ext: bool,
+    #[serde(default)]
+    pub v_ext: bool,
+    /// Zba/Zbb位操作扩展
+    #[serde(default)]
+    pub b_ext: bool,
 }
 
 #[derive(Deserialize, Debug)]
@@ -28,6 +37,72 @@ pub struct DebugConfig {
 #[derive(Deserialize, Debug)]
 pub struct OthersConfig {
     pub decoder_cache_size: usize,
+    /// 指令频度画像文件（name count每行），用于译码兜底桶排序；
+    /// 缺省时使用内置的默认画像
+    #[serde(default)]
+    pub decoder_profile: Option<String>,
+    /// hart（硬件线程）数量，缺省为单核
+    #[serde(default = "default_harts")]
+    pub harts: usize,
+}
+
+fn default_harts() -> usize {
+    1
+}
+
+/// L1缓存模型配置（cache-model特性使用；无该节时取默认几何）
+#[derive(Deserialize, Debug, Clone)]
+#[serde(default)]
+pub struct CacheModelConfig {
+    /// 指令缓存组数（须为2的幂）
+    pub icache_sets: usize,
+    /// 指令缓存相联度
+    pub icache_ways: usize,
+    /// 数据缓存组数（须为2的幂）
+    pub dcache_sets: usize,
+    /// 数据缓存相联度
+    pub dcache_ways: usize,
+    /// 缓存行大小（字节，须为2的幂）
+    pub line_size: usize,
+    /// 采样率：每N次访问模拟1次，1为全量（长时间运行建议加大）
+    pub sample_rate: u64,
+}
+
+impl Default for CacheModelConfig {
+    fn default() -> Self {
+        // 32KB 4路I + 32KB 8路D，64字节行：常见嵌入式SoC的L1几何
+        CacheModelConfig {
+            icache_sets: 128,
+            icache_ways: 4,
+            dcache_sets: 64,
+            dcache_ways: 8,
+            line_size: 64,
+            sample_rate: 1,
+        }
+    }
+}
+
+/// 分支预测器模型配置（branch-model特性使用；无该节时取默认规模）
+#[derive(Deserialize, Debug, Clone)]
+#[serde(default)]
+pub struct BranchModelConfig {
+    /// 双模2位计数器表项数（须为2的幂）
+    pub bimodal_entries: usize,
+    /// BTB表项数（须为2的幂）
+    pub btb_entries: usize,
+    /// 每次预测错误的建模罚周期
+    pub mispredict_penalty: u64,
+}
+
+impl Default for BranchModelConfig {
+    fn default() -> Self {
+        // 4K项双模表 + 512项直接映射BTB，错误罚3周期：与目标核一致
+        BranchModelConfig {
+            bimodal_entries: 4096,
+            btb_entries: 512,
+            mispredict_penalty: 3,
+        }
+    }
 }
 
 #[derive(Deserialize, Debug, Clone)]
@@ -52,6 +127,12 @@ pub struct EmuConfig {
     pub inst_set: InstSetConfig,
     pub debug: DebugConfig,
     pub others: OthersConfig,
+    /// L1缓存模型几何（cache-model特性；缺省节取默认值）
+    #[serde(default)]
+    pub cache_model: CacheModelConfig,
+    /// 分支预测器模型规模（branch-model特性；缺省节取默认值）
+    #[serde(default)]
+    pub branch_model: BranchModelConfig,
     // 不再在主配置中包含 devices
 }
 
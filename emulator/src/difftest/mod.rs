@@ -1,4 +1,9 @@
+pub mod shm;
+
+use std::collections::VecDeque;
 use std::fmt::Display;
+use std::sync::mpsc::{self, Receiver, SyncSender};
+use std::thread::JoinHandle;
 
 use rv64emu::{
     self,
@@ -34,6 +39,10 @@ pub trait Difftest {
     fn mode(&self) -> DiffMode;
     fn self_state(&self) -> DiffState;
     fn step(&mut self) -> bool;
+    /// 连续执行n条指令（批量difftest用，实现可覆盖为一次调用）
+    fn steps(&mut self, n: usize) -> bool {
+        (0..n).all(|_| self.step())
+    }
     fn set_regs(&mut self, regs: &[u64; 32]);
     fn set_pc(&mut self, pc: u64);
     fn get_mem(&mut self, addr: u64, size: usize) -> u64;
@@ -108,6 +117,11 @@ impl Difftest for CpuCore {
         true
     }
 
+    fn steps(&mut self, n: usize) -> bool {
+        self.execute(n);
+        true
+    }
+
     fn set_regs(&mut self, regs: &[u64; 32]) {
         for i in 0..32 {
             self.gpr.write(i, regs[i as usize]);
@@ -126,3 +140,209 @@ impl Difftest for CpuCore {
         <CpuCore as rv64emu::difftest::difftest_trait::Difftest>::set_mem(self, addr, data, len);
     }
 }
+
+/// 流水线深度：主循环最多领先参考核这么多批，队列满时send阻塞
+const PIPE_DEPTH: usize = 8;
+
+/// 发往参考核线程的流水线记录
+pub enum RefCmd {
+    /// 参考核补跑count条指令后与DUT批尾状态比较
+    ///
+    /// `mem_spans`/`mem_hash`是DUT自检查点起写过的内存区间及其哈希，
+    /// 寄存器比较通过后再对参考核内存的同样区间复算哈希比较
+    Batch {
+        seq: u64,
+        count: usize,
+        dut: DiffState,
+        mem_spans: Vec<(u64, usize)>,
+        mem_hash: u64,
+    },
+    /// MMIO跳过同步：直接覆盖参考核的寄存器与PC
+    /// （语义同单步路径的is_last_mmio跳过）
+    Sync { regs: [u64; 32], npc: u64 },
+}
+
+/// 参考核线程的异步回报
+pub enum RefReport {
+    /// 批比较通过
+    Ack { seq: u64 },
+    /// 批比较失败：参考核线程随即退出，核经`finish`送回主线程。
+    /// `mem`为真表示寄存器一致而脏页哈希不同（内存分歧）
+    Mismatch {
+        seq: u64,
+        ref_state: DiffState,
+        mem: bool,
+    },
+}
+
+/// 按`Memory::hash_dirty_spans`的规则对参考核内存的同样区间做
+/// FNV-1a哈希（基址与内容都参与，按小端序8字节一组）
+pub fn hash_ref_spans(core: &mut CpuCore, spans: &[(u64, usize)]) -> u64 {
+    use crate::emulator::memory::{FNV_OFFSET, FNV_PRIME};
+
+    let mut hash = FNV_OFFSET;
+    for &(base, len) in spans {
+        hash ^= base;
+        hash = hash.wrapping_mul(FNV_PRIME);
+        for off in (0..len as u64).step_by(8) {
+            hash ^= core.get_mem(base + off, 8);
+            hash = hash.wrapping_mul(FNV_PRIME);
+        }
+    }
+    hash
+}
+
+/// difftest参考后端：批记录的提交与回报收取
+///
+/// 进程内的[`RefPipeline`]与跨进程的[`shm::ShmDiff`]都实现此
+/// trait，流水线执行体对两者一视同仁
+pub trait DiffBackend {
+    /// 送入一条记录；队列满时阻塞。返回false表示后端已停止
+    fn submit(&self, cmd: RefCmd) -> bool;
+    /// 非阻塞取一条回报
+    fn try_report(&self) -> Option<RefReport>;
+    /// 阻塞等待一条回报；后端已停止或超时返回None
+    fn wait_report(&self) -> Option<RefReport>;
+}
+
+/// 跑在专用线程上的参考核流水线
+///
+/// 主循环把批记录经有界队列送入，参考核的执行与比较在工作线程上
+/// 异步进行，DUT只在队列满时停顿。比较失败时线程停止消费并退出，
+/// 核由`finish`收回本线程做分歧定位。
+pub struct RefPipeline {
+    cmds: Option<SyncSender<RefCmd>>,
+    reports: Receiver<RefReport>,
+    worker: JoinHandle<Box<CpuCore>>,
+}
+
+impl RefPipeline {
+    /// 把参考核移交给专用线程，返回主线程侧的句柄
+    pub fn spawn(core: Box<CpuCore>) -> Self {
+        let (cmd_tx, cmd_rx) = mpsc::sync_channel(PIPE_DEPTH);
+        let (rep_tx, rep_rx) = mpsc::channel();
+        let worker = std::thread::Builder::new()
+            .name("difftest-ref".into())
+            .spawn(move || Self::run(core, cmd_rx, rep_tx))
+            .expect("无法创建参考核线程");
+        Self {
+            cmds: Some(cmd_tx),
+            reports: rep_rx,
+            worker,
+        }
+    }
+
+    /// 工作线程主体：消费记录直到分歧或队列关闭，返回参考核
+    fn run(
+        mut core: Box<CpuCore>,
+        cmds: mpsc::Receiver<RefCmd>,
+        reports: mpsc::Sender<RefReport>,
+    ) -> Box<CpuCore> {
+        while let Ok(cmd) = cmds.recv() {
+            match cmd {
+                RefCmd::Batch {
+                    seq,
+                    count,
+                    dut,
+                    mem_spans,
+                    mem_hash,
+                } => {
+                    Difftest::steps(core.as_mut(), count);
+                    let ref_state = core.self_state();
+                    let regs_ok = ref_state == dut;
+                    // 寄存器已分歧时内存哈希没有意义，跳过
+                    let mem_ok = !regs_ok
+                        || mem_spans.is_empty()
+                        || hash_ref_spans(core.as_mut(), &mem_spans) == mem_hash;
+                    if regs_ok && mem_ok {
+                        let _ = reports.send(RefReport::Ack { seq });
+                    } else {
+                        let _ = reports.send(RefReport::Mismatch {
+                            seq,
+                            ref_state,
+                            mem: regs_ok,
+                        });
+                        break;
+                    }
+                }
+                RefCmd::Sync { regs, npc } => {
+                    core.set_regs(&regs);
+                    core.set_pc(npc);
+                }
+            }
+        }
+        core
+    }
+
+    /// 关闭队列、等工作线程跑完在途记录并收回参考核；
+    /// 同时返回途中上报的首个分歧（若有）
+    pub fn finish(mut self) -> (Box<CpuCore>, Option<(u64, DiffState, bool)>) {
+        drop(self.cmds.take());
+        let core = self.worker.join().expect("参考核线程异常退出");
+        let mut mismatch = None;
+        while let Ok(report) = self.reports.try_recv() {
+            if let RefReport::Mismatch {
+                seq,
+                ref_state,
+                mem,
+            } = report
+            {
+                mismatch.get_or_insert((seq, ref_state, mem));
+            }
+        }
+        (core, mismatch)
+    }
+}
+
+impl DiffBackend for RefPipeline {
+    /// 送入一条记录；队列满时阻塞。返回false表示线程已因分歧退出
+    fn submit(&self, cmd: RefCmd) -> bool {
+        self.cmds
+            .as_ref()
+            .is_some_and(|tx| tx.send(cmd).is_ok())
+    }
+
+    /// 非阻塞取一条回报
+    fn try_report(&self) -> Option<RefReport> {
+        self.reports.try_recv().ok()
+    }
+
+    /// 阻塞等待一条回报；工作线程已退出时返回None
+    fn wait_report(&self) -> Option<RefReport> {
+        self.reports.recv().ok()
+    }
+}
+
+/// 主线程侧的在途批记账
+///
+/// 检查点只在流水线排空时前移，保证任何在途批失败都能回滚重放；
+/// 每批记下自检查点起DUT已执行的指令数，分歧时据此换算重放长度
+#[derive(Default)]
+pub struct DiffTracking {
+    /// 在途批：（序号，批尾时自检查点起的DUT指令数）
+    pub outstanding: VecDeque<(u64, usize)>,
+    /// 已分配的批序号
+    pub seq: u64,
+    /// 自检查点起DUT已执行的指令数
+    pub dut_insts: usize,
+    /// 主循环途中收到的分歧回报（批序号、参考核状态、是否内存分歧）
+    pub mismatch: Option<(u64, DiffState, bool)>,
+}
+
+impl DiffTracking {
+    /// 确认序号不大于seq的在途批都已通过
+    pub fn retire(&mut self, seq: u64) {
+        while self.outstanding.front().is_some_and(|&(s, _)| s <= seq) {
+            self.outstanding.pop_front();
+        }
+    }
+
+    /// 失败批对应的重放指令数（自检查点起）
+    pub fn replay_count(&self, seq: u64) -> usize {
+        self.outstanding
+            .iter()
+            .find(|&&(s, _)| s == seq)
+            .map(|&(_, count)| count)
+            .unwrap_or(self.dut_insts)
+    }
+}
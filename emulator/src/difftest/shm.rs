@@ -0,0 +1,380 @@
+//! 共享内存difftest传输
+//!
+//! 把批量difftest协议搬过进程边界：DUT与外部参考实现（如Spike的
+//! 适配器）映射同一个文件，经两条单生产者单消费者环形缓冲交换
+//! 记录，逐批同步，吞吐与进程内参考核相当。
+//!
+//! # 内存布局（版本1，小端，偏移按字节）
+//!
+//! - `0x00` 头部 [`ShmHeader`]：魔数、版本与四个环指针
+//! - 头部后依次是命令环（DUT→参考，[`ShmCmd`] × [`RING_SLOTS`]）
+//!   与回报环（参考→DUT，[`ShmRep`] × [`RING_SLOTS`]）
+//!
+//! 环指针是只增不减的序号，`head - tail`即在途记录数；写侧先以
+//! volatile写入槽位、再以Release存储head，读侧以Acquire载入head。
+//! 参考侧的处理循环与进程内工作线程一致：Batch记录补跑count条
+//! 指令后比较寄存器与脏页区间哈希并回报，Sync记录直接覆盖
+//! 寄存器与PC。
+
+use std::fs::OpenOptions;
+use std::os::fd::AsRawFd;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use super::{DiffBackend, DiffState, RefCmd, RefReport};
+
+/// 头部魔数："DOLPDIFF"
+pub const SHM_MAGIC: u64 = u64::from_le_bytes(*b"DOLPDIFF");
+/// 协议版本
+pub const SHM_VERSION: u64 = 1;
+/// 每个环的槽位数（2的幂）
+pub const RING_SLOTS: u64 = 64;
+/// 单条Batch记录可携带的脏页区间上限
+pub const SPAN_MAX: usize = 32;
+
+/// 记录类型：批比较
+pub const KIND_BATCH: u64 = 0;
+/// 记录类型：MMIO跳过同步
+pub const KIND_SYNC: u64 = 1;
+
+/// 标志位：脏页区间超出`SPAN_MAX`被截断，参考侧应跳过内存比较
+pub const FLAG_SPANS_TRUNCATED: u64 = 1;
+
+/// 回报状态：批比较通过
+pub const STATUS_ACK: u64 = 0;
+/// 回报状态：寄存器分歧
+pub const STATUS_REG_MISMATCH: u64 = 1;
+/// 回报状态：寄存器一致但脏页哈希分歧
+pub const STATUS_MEM_MISMATCH: u64 = 2;
+
+/// 共享头部：环指针为只增序号
+#[repr(C)]
+pub struct ShmHeader {
+    pub magic: AtomicU64,
+    pub version: AtomicU64,
+    /// 命令环写指针（DUT侧递增）
+    pub cmd_head: AtomicU64,
+    /// 命令环读指针（参考侧递增）
+    pub cmd_tail: AtomicU64,
+    /// 回报环写指针（参考侧递增）
+    pub rep_head: AtomicU64,
+    /// 回报环读指针（DUT侧递增）
+    pub rep_tail: AtomicU64,
+}
+
+/// DUT→参考的记录
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct ShmCmd {
+    /// [`KIND_BATCH`]或[`KIND_SYNC`]
+    pub kind: u64,
+    /// 批序号（Sync记录为0）
+    pub seq: u64,
+    /// 参考侧应补跑的指令数（Sync记录为0）
+    pub count: u64,
+    /// Batch：DUT批尾PC；Sync：参考侧应跳转到的下一PC
+    pub pc: u64,
+    /// DUT通用寄存器
+    pub regs: [u64; 32],
+    /// 脏页区间哈希（`Memory::hash_dirty_spans`的规则）
+    pub mem_hash: u64,
+    /// `spans`中有效区间数
+    pub span_count: u64,
+    /// [`FLAG_SPANS_TRUNCATED`]等标志位
+    pub flags: u64,
+    /// 脏页区间（客户机基址，字节长度）
+    pub spans: [[u64; 2]; SPAN_MAX],
+}
+
+/// 参考→DUT的回报
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct ShmRep {
+    /// 对应的批序号
+    pub seq: u64,
+    /// [`STATUS_ACK`]/[`STATUS_REG_MISMATCH`]/[`STATUS_MEM_MISMATCH`]
+    pub status: u64,
+    /// 参考侧批尾PC
+    pub pc: u64,
+    /// 参考侧通用寄存器
+    pub regs: [u64; 32],
+}
+
+const HEADER_SIZE: usize = std::mem::size_of::<ShmHeader>();
+const CMD_SIZE: usize = std::mem::size_of::<ShmCmd>();
+const REP_SIZE: usize = std::mem::size_of::<ShmRep>();
+
+/// 映射文件的总大小
+fn shm_len() -> usize {
+    HEADER_SIZE + (CMD_SIZE + REP_SIZE) * RING_SLOTS as usize
+}
+
+/// DUT侧的共享内存difftest后端
+pub struct ShmDiff {
+    base: *mut u8,
+    len: usize,
+}
+
+// 安全性：映射生命周期与ShmDiff一致，跨槽同步全部经头部的原子序号
+unsafe impl Send for ShmDiff {}
+unsafe impl Sync for ShmDiff {}
+
+impl ShmDiff {
+    /// 创建（或打开）映射文件并初始化头部
+    ///
+    /// 参考侧适配器应在DUT开跑前映射同一路径并轮询命令环
+    pub fn open(path: &str) -> anyhow::Result<Self> {
+        let len = shm_len();
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(false)
+            .open(path)?;
+        file.set_len(len as u64)?;
+        let base = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if base == libc::MAP_FAILED {
+            return Err(anyhow::anyhow!(
+                "无法映射共享内存文件 '{}': errno {}",
+                path,
+                std::io::Error::last_os_error()
+            ));
+        }
+        let shm = Self {
+            base: base as *mut u8,
+            len,
+        };
+        let header = shm.header();
+        header.cmd_head.store(0, Ordering::Relaxed);
+        header.cmd_tail.store(0, Ordering::Relaxed);
+        header.rep_head.store(0, Ordering::Relaxed);
+        header.rep_tail.store(0, Ordering::Relaxed);
+        header.version.store(SHM_VERSION, Ordering::Relaxed);
+        header.magic.store(SHM_MAGIC, Ordering::Release);
+        Ok(shm)
+    }
+
+    fn header(&self) -> &ShmHeader {
+        // 安全性：映射首部按ShmHeader布局初始化，生命周期随self
+        unsafe { &*(self.base as *const ShmHeader) }
+    }
+
+    fn cmd_ptr(&self, slot: u64) -> *mut ShmCmd {
+        let off = HEADER_SIZE + CMD_SIZE * slot as usize;
+        unsafe { self.base.add(off) as *mut ShmCmd }
+    }
+
+    fn rep_ptr(&self, slot: u64) -> *mut ShmRep {
+        let off = HEADER_SIZE + CMD_SIZE * RING_SLOTS as usize + REP_SIZE * slot as usize;
+        unsafe { self.base.add(off) as *mut ShmRep }
+    }
+
+    fn encode(cmd: RefCmd) -> ShmCmd {
+        let mut rec = ShmCmd {
+            kind: KIND_SYNC,
+            seq: 0,
+            count: 0,
+            pc: 0,
+            regs: [0; 32],
+            mem_hash: 0,
+            span_count: 0,
+            flags: 0,
+            spans: [[0; 2]; SPAN_MAX],
+        };
+        match cmd {
+            RefCmd::Batch {
+                seq,
+                count,
+                dut,
+                mem_spans,
+                mem_hash,
+            } => {
+                rec.kind = KIND_BATCH;
+                rec.seq = seq;
+                rec.count = count as u64;
+                rec.pc = dut.pc;
+                rec.regs = dut.reg;
+                rec.mem_hash = mem_hash;
+                if mem_spans.len() > SPAN_MAX {
+                    rec.flags |= FLAG_SPANS_TRUNCATED;
+                }
+                for (slot, &(base, len)) in rec.spans.iter_mut().zip(&mem_spans) {
+                    *slot = [base, len as u64];
+                }
+                rec.span_count = mem_spans.len().min(SPAN_MAX) as u64;
+            }
+            RefCmd::Sync { regs, npc } => {
+                rec.pc = npc;
+                rec.regs = regs;
+            }
+        }
+        rec
+    }
+
+    fn decode(rep: ShmRep) -> Option<RefReport> {
+        let ref_state = DiffState {
+            reg: rep.regs,
+            pc: rep.pc,
+        };
+        match rep.status {
+            STATUS_ACK => Some(RefReport::Ack { seq: rep.seq }),
+            STATUS_REG_MISMATCH => Some(RefReport::Mismatch {
+                seq: rep.seq,
+                ref_state,
+                mem: false,
+            }),
+            STATUS_MEM_MISMATCH => Some(RefReport::Mismatch {
+                seq: rep.seq,
+                ref_state,
+                mem: true,
+            }),
+            _ => None,
+        }
+    }
+}
+
+impl DiffBackend for ShmDiff {
+    /// 送入一条记录；命令环满时自旋让出，即DUT唯一的停顿点
+    fn submit(&self, cmd: RefCmd) -> bool {
+        let rec = Self::encode(cmd);
+        let header = self.header();
+        loop {
+            let head = header.cmd_head.load(Ordering::Relaxed);
+            let tail = header.cmd_tail.load(Ordering::Acquire);
+            if head.wrapping_sub(tail) < RING_SLOTS {
+                // 安全性：head槽位在参考侧看来空闲，写完再发布head
+                unsafe { self.cmd_ptr(head % RING_SLOTS).write_volatile(rec) };
+                header.cmd_head.store(head.wrapping_add(1), Ordering::Release);
+                return true;
+            }
+            std::thread::yield_now();
+        }
+    }
+
+    fn try_report(&self) -> Option<RefReport> {
+        let header = self.header();
+        let tail = header.rep_tail.load(Ordering::Relaxed);
+        let head = header.rep_head.load(Ordering::Acquire);
+        if tail == head {
+            return None;
+        }
+        // 安全性：tail槽位已由参考侧发布，读完再归还
+        let rep = unsafe { self.rep_ptr(tail % RING_SLOTS).read_volatile() };
+        header.rep_tail.store(tail.wrapping_add(1), Ordering::Release);
+        Self::decode(rep)
+    }
+
+    /// 阻塞等待一条回报；参考侧长时间无响应时放弃并返回None
+    fn wait_report(&self) -> Option<RefReport> {
+        const TIMEOUT: std::time::Duration = std::time::Duration::from_secs(10);
+        let deadline = std::time::Instant::now() + TIMEOUT;
+        loop {
+            if let Some(report) = self.try_report() {
+                return Some(report);
+            }
+            if std::time::Instant::now() >= deadline {
+                tracing::warn!("共享内存参考端超时无回报");
+                return None;
+            }
+            std::thread::yield_now();
+        }
+    }
+}
+
+impl Drop for ShmDiff {
+    fn drop(&mut self) {
+        // 安全性：base/len来自成功的mmap调用
+        unsafe {
+            libc::munmap(self.base as *mut libc::c_void, self.len);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// 模拟参考侧：消费一条命令并按给定状态回报
+    fn fake_ref_reply(shm: &ShmDiff, status: u64) -> ShmCmd {
+        let header = shm.header();
+        let tail = header.cmd_tail.load(Ordering::Relaxed);
+        let head = header.cmd_head.load(Ordering::Acquire);
+        assert_ne!(tail, head, "命令环为空");
+        let cmd = unsafe { shm.cmd_ptr(tail % RING_SLOTS).read_volatile() };
+        header.cmd_tail.store(tail.wrapping_add(1), Ordering::Release);
+
+        if cmd.kind == KIND_BATCH {
+            let rep_head = header.rep_head.load(Ordering::Relaxed);
+            let rep = ShmRep {
+                seq: cmd.seq,
+                status,
+                pc: cmd.pc,
+                regs: cmd.regs,
+            };
+            unsafe { shm.rep_ptr(rep_head % RING_SLOTS).write_volatile(rep) };
+            header.rep_head.store(rep_head.wrapping_add(1), Ordering::Release);
+        }
+        cmd
+    }
+
+    #[test]
+    fn test_shm_ring_roundtrip() {
+        let path = std::env::temp_dir().join("dolphin_shm_test.bin");
+        let path = path.to_str().unwrap();
+        let shm = ShmDiff::open(path).unwrap();
+
+        let dut = DiffState {
+            reg: [7; 32],
+            pc: 0x8000_0000,
+        };
+        assert!(shm.submit(RefCmd::Batch {
+            seq: 1,
+            count: 100,
+            dut,
+            mem_spans: vec![(0x8000_1000, 4096)],
+            mem_hash: 0xdead_beef,
+        }));
+
+        let cmd = fake_ref_reply(&shm, STATUS_ACK);
+        assert_eq!(cmd.kind, KIND_BATCH);
+        assert_eq!(cmd.seq, 1);
+        assert_eq!(cmd.count, 100);
+        assert_eq!(cmd.span_count, 1);
+        assert_eq!(cmd.spans[0], [0x8000_1000, 4096]);
+        assert_eq!(cmd.mem_hash, 0xdead_beef);
+
+        match shm.try_report() {
+            Some(RefReport::Ack { seq }) => assert_eq!(seq, 1),
+            _ => panic!("应收到Ack"),
+        }
+        assert!(shm.try_report().is_none());
+
+        // 分歧回报带回参考侧状态
+        assert!(shm.submit(RefCmd::Batch {
+            seq: 2,
+            count: 1,
+            dut,
+            mem_spans: Vec::new(),
+            mem_hash: 0,
+        }));
+        fake_ref_reply(&shm, STATUS_MEM_MISMATCH);
+        match shm.wait_report() {
+            Some(RefReport::Mismatch { seq, mem, .. }) => {
+                assert_eq!(seq, 2);
+                assert!(mem);
+            }
+            _ => panic!("应收到Mismatch"),
+        }
+
+        drop(shm);
+        let _ = std::fs::remove_file(path);
+    }
+}
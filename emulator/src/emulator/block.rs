@@ -0,0 +1,126 @@
+//! 基本块预译码与块缓存执行引擎
+//!
+//! 首次执行到某个PC时，把从该PC开始的顺序指令一次性译码成
+//! 扁平的处理函数数组（[`Block`]），之后整块复用，避免逐条
+//! 取指→译码→分发的开销。块在遇到控制流指令处结束。
+//!
+//! 注意：块缓存假设客户代码不会自修改；重新加载ELF时必须调用
+//! [`BlockCache::clear`] 使缓存失效。
+
+use std::rc::Rc;
+
+use rustc_hash::FxHashMap;
+
+#[cfg(feature = "jit")]
+use super::jit::JitState;
+#[cfg(not(feature = "tracer"))]
+use super::instructions::fusion::FusedHandler;
+use super::instructions::{Instruction, is_compressed};
+
+/// 单个基本块内的最大指令数，防止顺序长代码段生成过大的块
+pub const BLOCK_MAX_INSTS: usize = 64;
+
+/// 预译码后的一条指令：处理函数指针加上执行所需的全部信息
+#[derive(Debug, Clone, Copy)]
+pub struct DecodedInst {
+    /// 指令所在PC
+    pub pc: u64,
+    /// 原始指令字
+    pub inst: u32,
+    /// 指令长度（4，或C扩展下为2）
+    pub len: u64,
+    /// 译码得到的处理函数
+    pub handler: &'static Instruction,
+    /// 宏融合处理函数（融合对的首条指令携带，下一条由其一并执行）
+    #[cfg(not(feature = "tracer"))]
+    pub fused: Option<FusedHandler>,
+}
+
+/// 一个基本块：从起始PC开始的顺序指令序列，最后一条可能是控制流指令
+#[derive(Debug)]
+pub struct Block {
+    /// 块起始PC
+    pub start: u64,
+    /// 预译码的指令序列
+    pub insts: Vec<DecodedInst>,
+    /// JIT编译状态（热度计数/已编译/已放弃）
+    #[cfg(feature = "jit")]
+    pub jit: std::cell::Cell<JitState>,
+}
+
+impl Block {
+    pub fn new(start: u64, insts: Vec<DecodedInst>) -> Self {
+        Block {
+            start,
+            insts,
+            #[cfg(feature = "jit")]
+            jit: std::cell::Cell::new(JitState::Cold(0)),
+        }
+    }
+}
+
+/// 以起始PC为键的基本块缓存
+pub struct BlockCache {
+    blocks: FxHashMap<u64, Rc<Block>>,
+}
+
+impl BlockCache {
+    pub fn new() -> Self {
+        BlockCache {
+            blocks: FxHashMap::default(),
+        }
+    }
+
+    /// 查找以指定PC开始的块
+    #[inline(always)]
+    pub fn lookup(&self, pc: u64) -> Option<Rc<Block>> {
+        self.blocks.get(&pc).cloned()
+    }
+
+    /// 插入新块并返回其引用
+    pub fn insert(&mut self, block: Block) -> Rc<Block> {
+        let start = block.start;
+        let block = Rc::new(block);
+        self.blocks.insert(start, block.clone());
+        block
+    }
+
+    /// 清空全部缓存块（加载新程序后代码已变，必须调用）
+    pub fn clear(&mut self) {
+        self.blocks.clear();
+    }
+
+    /// 遍历全部缓存块（持久化块缓存保存时使用）
+    pub fn iter(&self) -> impl Iterator<Item = &Rc<Block>> {
+        self.blocks.values()
+    }
+
+    /// 当前缓存的块数
+    pub fn len(&self) -> usize {
+        self.blocks.len()
+    }
+}
+
+impl Default for BlockCache {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// 判断指令是否终结基本块（可能改写控制流或产生事件）
+#[inline(always)]
+pub fn ends_block(inst: u32) -> bool {
+    if is_compressed(inst) {
+        let inst = inst & 0xffff;
+        let funct3 = (inst >> 13) & 0b111;
+        return match inst & 0b11 {
+            // c.j / c.beqz / c.bnez
+            0b01 => matches!(funct3, 0b101 | 0b110 | 0b111),
+            // c.jr / c.jalr / c.ebreak（rs2=0区分于c.mv/c.add）
+            0b10 => funct3 == 0b100 && inst & 0x7c == 0,
+            _ => false,
+        };
+    }
+    // BRANCH / JAL / JALR / SYSTEM / MISC-MEM
+    matches!(inst & 0x7f, 0x63 | 0x6f | 0x67 | 0x73 | 0x0f)
+}
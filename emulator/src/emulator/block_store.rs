@@ -0,0 +1,189 @@
+//! 预译码基本块的磁盘持久化
+//!
+//! CI在两次重编译之间会把同一批ELF反复运行成千上万次，每次
+//! 进程都从零重建块缓存。本模块把运行结束时的块表（按译码表
+//! 序号记录处理函数，指令字即操作数）序列化到以ELF内容哈希
+//! 命名的文件，下次运行mmap读回，热身译码开销只付一次。
+//!
+//! 文件对本进程是纯粹的缓存：格式、译码表布局或ELF内容任何
+//! 一处对不上就整体丢弃，失败从不冒泡成运行错误。
+
+use std::path::{Path, PathBuf};
+
+use anyhow::{Result, anyhow};
+
+use crate::utils::elf::MappedFile;
+
+/// 文件魔数："DBLK"
+const MAGIC: u32 = 0x4B4C_4244;
+
+/// 格式版本：记录布局变化时递增，旧文件整体作废
+const VERSION: u32 = 1;
+
+/// 序列化形态的一条预译码指令：处理函数以译码表序号表示
+#[derive(Debug, Clone, Copy)]
+pub struct StoredInst {
+    pub pc: u64,
+    pub inst: u32,
+    pub handler_idx: u32,
+    pub len: u8,
+}
+
+/// 序列化形态的一个基本块
+#[derive(Debug)]
+pub struct StoredBlock {
+    pub start: u64,
+    pub insts: Vec<StoredInst>,
+}
+
+/// FNV-1a内容哈希：确定性且与std哈希器的随机种子无关，
+/// 同一文件在任何进程中得到同一缓存键
+pub fn content_hash(bytes: &[u8]) -> u64 {
+    let mut hash = 0xcbf2_9ce4_8422_2325u64;
+    for &b in bytes {
+        hash ^= b as u64;
+        hash = hash.wrapping_mul(0x100_0000_01b3);
+    }
+    hash
+}
+
+/// 缓存文件路径：目录下以ELF内容哈希命名
+pub fn store_path(dir: &Path, elf_hash: u64) -> PathBuf {
+    dir.join(format!("{elf_hash:016x}.dblk"))
+}
+
+/// 把块表写入缓存文件
+///
+/// 先写进带pid后缀的临时文件再原子rename，并行CI任务写同一
+/// ELF的缓存互不踩踏
+pub fn save(path: &Path, elf_hash: u64, table_hash: u64, blocks: &[StoredBlock]) -> Result<()> {
+    let mut buf = Vec::with_capacity(64 + blocks.iter().map(|b| 12 + b.insts.len() * 17).sum::<usize>());
+    buf.extend_from_slice(&MAGIC.to_le_bytes());
+    buf.extend_from_slice(&VERSION.to_le_bytes());
+    buf.extend_from_slice(&table_hash.to_le_bytes());
+    buf.extend_from_slice(&elf_hash.to_le_bytes());
+    buf.extend_from_slice(&(blocks.len() as u32).to_le_bytes());
+    for block in blocks {
+        buf.extend_from_slice(&block.start.to_le_bytes());
+        buf.extend_from_slice(&(block.insts.len() as u32).to_le_bytes());
+        for inst in &block.insts {
+            buf.extend_from_slice(&inst.pc.to_le_bytes());
+            buf.extend_from_slice(&inst.inst.to_le_bytes());
+            buf.extend_from_slice(&inst.handler_idx.to_le_bytes());
+            buf.push(inst.len);
+        }
+    }
+
+    if let Some(dir) = path.parent() {
+        std::fs::create_dir_all(dir)?;
+    }
+    let tmp = path.with_extension(format!("tmp.{}", std::process::id()));
+    std::fs::write(&tmp, &buf)?;
+    std::fs::rename(&tmp, path)?;
+    Ok(())
+}
+
+/// 读取一条小端整数并前移游标
+macro_rules! take {
+    ($data:expr, $pos:expr, $ty:ty) => {{
+        const N: usize = std::mem::size_of::<$ty>();
+        let bytes = $data
+            .get(*$pos..*$pos + N)
+            .ok_or_else(|| anyhow!("缓存文件截断"))?;
+        *$pos += N;
+        <$ty>::from_le_bytes(bytes.try_into().unwrap())
+    }};
+}
+
+/// mmap并解析缓存文件，校验格式版本、译码表哈希与ELF哈希
+///
+/// 任何不一致都返回错误，由调用方当作缓存未命中处理
+pub fn load(path: &Path, elf_hash: u64, table_hash: u64) -> Result<Vec<StoredBlock>> {
+    let path_str = path
+        .to_str()
+        .ok_or_else(|| anyhow!("缓存路径不是合法UTF-8"))?;
+    let mapped = MappedFile::open(path_str)?;
+    let data = mapped.as_slice();
+    let pos = &mut 0usize;
+
+    if take!(data, pos, u32) != MAGIC {
+        return Err(anyhow!("缓存文件魔数不符"));
+    }
+    if take!(data, pos, u32) != VERSION {
+        return Err(anyhow!("缓存文件版本不符"));
+    }
+    if take!(data, pos, u64) != table_hash {
+        return Err(anyhow!("译码表布局已变化"));
+    }
+    if take!(data, pos, u64) != elf_hash {
+        return Err(anyhow!("ELF内容哈希不符"));
+    }
+
+    let block_count = take!(data, pos, u32) as usize;
+    let mut blocks = Vec::with_capacity(block_count);
+    for _ in 0..block_count {
+        let start = take!(data, pos, u64);
+        let inst_count = take!(data, pos, u32) as usize;
+        if inst_count == 0 || inst_count > super::block::BLOCK_MAX_INSTS {
+            return Err(anyhow!("块指令数越界: {inst_count}"));
+        }
+        let mut insts = Vec::with_capacity(inst_count);
+        for _ in 0..inst_count {
+            insts.push(StoredInst {
+                pc: take!(data, pos, u64),
+                inst: take!(data, pos, u32),
+                handler_idx: take!(data, pos, u32),
+                len: take!(data, pos, u8),
+            });
+        }
+        blocks.push(StoredBlock { start, insts });
+    }
+    Ok(blocks)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sample_blocks() -> Vec<StoredBlock> {
+        vec![StoredBlock {
+            start: 0x8000_0000,
+            insts: vec![
+                StoredInst {
+                    pc: 0x8000_0000,
+                    inst: 0x0000_0513,
+                    handler_idx: 3,
+                    len: 4,
+                },
+                StoredInst {
+                    pc: 0x8000_0004,
+                    inst: 0x9002,
+                    handler_idx: 7,
+                    len: 2,
+                },
+            ],
+        }]
+    }
+
+    #[test]
+    fn test_roundtrip() {
+        let path = std::env::temp_dir().join(format!("dblk_test_{}.dblk", std::process::id()));
+        save(&path, 0x1234, 0x5678, &sample_blocks()).unwrap();
+        let loaded = load(&path, 0x1234, 0x5678).unwrap();
+        assert_eq!(loaded.len(), 1);
+        assert_eq!(loaded[0].start, 0x8000_0000);
+        assert_eq!(loaded[0].insts.len(), 2);
+        assert_eq!(loaded[0].insts[1].inst, 0x9002);
+        assert_eq!(loaded[0].insts[1].len, 2);
+        std::fs::remove_file(&path).unwrap();
+    }
+
+    #[test]
+    fn test_stale_table_rejected() {
+        let path = std::env::temp_dir().join(format!("dblk_stale_{}.dblk", std::process::id()));
+        save(&path, 0x1234, 0x5678, &sample_blocks()).unwrap();
+        assert!(load(&path, 0x1234, 0x9999).is_err());
+        assert!(load(&path, 0x9999, 0x5678).is_err());
+        std::fs::remove_file(&path).unwrap();
+    }
+}
@@ -0,0 +1,217 @@
+//! 可配置的分支预测器模型（branch-model特性）
+//!
+//! 与缓存模型同一动机：目标核是BTB加双模（bimodal）2位饱和
+//! 计数器的简单预测器，分支密集的客户代码（QUEEN_H、bf解释器）
+//! 在其上的表现与纯指令数相去甚远。模型由分支处理器的
+//! `trace_branch`挂钩喂入，按分支站点统计预测错误率（经
+//! `utils/elf.rs`的符号索引标注），并按错误罚周期给出建模的
+//! 周期补偿，退出时随报告输出。
+//!
+//! 特性关闭时挂钩编译为空；配置来自`profile/config.toml`的
+//! `[branch_model]`节。JIT编译块不经过解释器挂钩，画像时应
+//! 关闭jit特性。
+
+use nohash_hasher::BuildNoHashHasher;
+use std::collections::HashMap;
+
+use crate::const_values::BranchModelConfig;
+use crate::utils::elf::FuncSym;
+
+/// 单个分支站点的统计
+#[derive(Debug, Default, Clone, Copy)]
+struct SiteStats {
+    executed: u64,
+    mispredicted: u64,
+}
+
+/// BTB+双模预测器模型与按站点的统计
+pub struct BranchModel {
+    /// 2位饱和计数器表（0/1预测不跳，2/3预测跳）
+    bimodal: Vec<u8>,
+    bimodal_mask: u64,
+    /// BTB：按PC直接映射的(标签,目标)对
+    btb_tags: Vec<u64>,
+    btb_targets: Vec<u64>,
+    btb_mask: u64,
+    /// 以分支PC为键的站点统计
+    sites: HashMap<u64, SiteStats, BuildNoHashHasher<u64>>,
+    /// 按地址排序的函数符号（站点标注用）
+    symbols: Vec<FuncSym>,
+    mispredict_penalty: u64,
+    total: u64,
+    mispredicts: u64,
+}
+
+impl BranchModel {
+    pub fn new(config: &BranchModelConfig) -> Self {
+        assert!(config.bimodal_entries.is_power_of_two(), "双模表项数须为2的幂");
+        assert!(config.btb_entries.is_power_of_two(), "BTB表项数须为2的幂");
+        BranchModel {
+            // 初始为弱不跳（1）：与复位后的真实双模表一致
+            bimodal: vec![1; config.bimodal_entries],
+            bimodal_mask: (config.bimodal_entries - 1) as u64,
+            btb_tags: vec![u64::MAX; config.btb_entries],
+            btb_targets: vec![0; config.btb_entries],
+            btb_mask: (config.btb_entries - 1) as u64,
+            sites: HashMap::default(),
+            symbols: Vec::new(),
+            mispredict_penalty: config.mispredict_penalty,
+            total: 0,
+            mispredicts: 0,
+        }
+    }
+
+    /// 注入函数符号索引（每次加载ELF后调用）
+    pub fn set_symbols(&mut self, symbols: &[FuncSym]) {
+        self.symbols = symbols.to_vec();
+        self.sites.clear();
+        self.total = 0;
+        self.mispredicts = 0;
+    }
+
+    /// 分支处理器上报一次控制流事件
+    ///
+    /// 条件分支查双模表预测方向；间接跳转用BTB预测目标；
+    /// 直接跳转首见算一次BTB未命中（目标尚未建立）
+    #[inline]
+    pub fn branch(&mut self, pc: u64, taken: bool, conditional: bool, indirect: bool, target: u64) {
+        self.total += 1;
+        let mispredicted = if conditional {
+            let idx = ((pc >> 1) & self.bimodal_mask) as usize;
+            let counter = self.bimodal[idx];
+            let predicted_taken = counter >= 2;
+            // 饱和更新
+            self.bimodal[idx] = if taken {
+                (counter + 1).min(3)
+            } else {
+                counter.saturating_sub(1)
+            };
+            predicted_taken != taken
+        } else {
+            let idx = ((pc >> 1) & self.btb_mask) as usize;
+            let hit = self.btb_tags[idx] == pc && (!indirect || self.btb_targets[idx] == target);
+            self.btb_tags[idx] = pc;
+            self.btb_targets[idx] = target;
+            !hit
+        };
+
+        let site = self.sites.entry(pc).or_default();
+        site.executed += 1;
+        if mispredicted {
+            site.mispredicted += 1;
+            self.mispredicts += 1;
+        }
+    }
+
+    /// 建模的周期补偿：预测错误数乘以罚周期
+    pub fn penalty_cycles(&self) -> u64 {
+        self.mispredicts * self.mispredict_penalty
+    }
+
+    /// 分支PC的符号化表示（`函数名+0x偏移`，符号外则裸地址）
+    fn symbolize(&self, pc: u64) -> String {
+        match self.symbols.binary_search_by(|s| {
+            if pc < s.addr {
+                std::cmp::Ordering::Greater
+            } else if pc >= s.addr + s.size {
+                std::cmp::Ordering::Less
+            } else {
+                std::cmp::Ordering::Equal
+            }
+        }) {
+            Ok(i) => {
+                let s = &self.symbols[i];
+                format!("{}+{:#x}", s.name, pc - s.addr)
+            }
+            Err(_) => format!("{:#010x}", pc),
+        }
+    }
+
+    /// 汇总报告：总量、错误率、建模周期补偿与错误最多的站点
+    pub fn summary(&self) -> String {
+        use std::fmt::Write;
+
+        let mut out = String::new();
+        let rate = if self.total > 0 {
+            self.mispredicts as f64 / self.total as f64 * 100.0
+        } else {
+            0.0
+        };
+        let _ = writeln!(
+            out,
+            "分支: {} 预测错误: {} ({:.2}%) 建模周期补偿: +{} (每次错误{}周期)",
+            self.total,
+            self.mispredicts,
+            rate,
+            self.penalty_cycles(),
+            self.mispredict_penalty
+        );
+
+        // 预测错误最多的前8个分支站点
+        let mut ranked: Vec<(&u64, &SiteStats)> = self
+            .sites
+            .iter()
+            .filter(|(_, s)| s.mispredicted > 0)
+            .collect();
+        ranked.sort_by_key(|&(_, s)| std::cmp::Reverse(s.mispredicted));
+        for (&pc, s) in ranked.into_iter().take(8) {
+            let _ = writeln!(
+                out,
+                "  {:<40} 执行 {:>10} 错误 {:>8} ({:.2}%)",
+                self.symbolize(pc),
+                s.executed,
+                s.mispredicted,
+                s.mispredicted as f64 / s.executed as f64 * 100.0
+            );
+        }
+        out
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn small_config() -> BranchModelConfig {
+        BranchModelConfig {
+            bimodal_entries: 16,
+            btb_entries: 8,
+            mispredict_penalty: 3,
+        }
+    }
+
+    /// 稳定循环分支训练后双模表应持续命中
+    #[test]
+    fn test_bimodal_trains_on_loop_branch() {
+        let mut model = BranchModel::new(&small_config());
+        for _ in 0..100 {
+            model.branch(0x8000_0000, true, true, false, 0);
+        }
+        // 初始弱不跳：首次方向错误，训练后全对
+        assert_eq!(model.mispredicts, 1);
+        assert_eq!(model.penalty_cycles(), 3);
+    }
+
+    /// 间接跳转目标变化必须计为预测错误
+    #[test]
+    fn test_btb_indirect_target_change() {
+        let mut model = BranchModel::new(&small_config());
+        model.branch(0x8000_0010, true, false, true, 0x9000_0000); // 首见：未命中
+        model.branch(0x8000_0010, true, false, true, 0x9000_0000); // 命中
+        model.branch(0x8000_0010, true, false, true, 0x9000_0100); // 目标变化：未命中
+        assert_eq!(model.mispredicts, 2);
+    }
+
+    #[test]
+    fn test_site_symbolization() {
+        let mut model = BranchModel::new(&small_config());
+        model.set_symbols(&[FuncSym {
+            addr: 0x8000_0000,
+            size: 0x40,
+            name: "loop_fn".to_string(),
+        }]);
+        model.branch(0x8000_0008, true, true, false, 0);
+        let report = model.summary();
+        assert!(report.contains("loop_fn+0x8"), "报告: {report}");
+    }
+}
@@ -0,0 +1,287 @@
+//! 可选的L1缓存层次模型（cache-model特性）
+//!
+//! 为SoC固件预筛提供存储层次信号：I/D两个组相联LRU缓存由取指
+//! 与载入/存储路径喂入，按函数符号区域统计命中/未命中/逐出，
+//! 退出时汇总报告。几何与采样率来自`profile/config.toml`的
+//! `[cache_model]`节。
+//!
+//! 分层原则：特性关闭时所有挂钩编译为空，`step_internal`无任何
+//! 残留；开启时可用采样模式（每N次访问模拟1次）把长时间运行的
+//! 减速控制在约2x内。注意JIT编译块不经过解释器挂钩，做缓存
+//! 画像时应关闭jit特性。
+
+use crate::const_values::CacheModelConfig;
+use crate::utils::elf::FuncSym;
+
+/// 无效标签
+const INVALID_TAG: u64 = u64::MAX;
+
+/// 一次模拟访问的结果
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Access {
+    Hit,
+    /// 未命中；true表示逐出了有效行
+    Miss(bool),
+}
+
+/// 组相联LRU缓存的标签阵列模拟
+struct CacheSim {
+    /// sets * ways 个标签槽位
+    tags: Vec<u64>,
+    /// 与标签同布局的LRU时间戳
+    stamps: Vec<u64>,
+    ways: usize,
+    set_mask: u64,
+    line_shift: u32,
+    clock: u64,
+}
+
+impl CacheSim {
+    fn new(sets: usize, ways: usize, line_size: usize) -> Self {
+        assert!(sets.is_power_of_two(), "缓存组数须为2的幂");
+        assert!(line_size.is_power_of_two(), "缓存行大小须为2的幂");
+        CacheSim {
+            tags: vec![INVALID_TAG; sets * ways],
+            stamps: vec![0; sets * ways],
+            ways,
+            set_mask: (sets - 1) as u64,
+            line_shift: line_size.trailing_zeros(),
+            clock: 0,
+        }
+    }
+
+    /// 模拟一次访问：命中刷新LRU，未命中按LRU替换
+    fn access(&mut self, addr: u64) -> Access {
+        let line = addr >> self.line_shift;
+        let set = (line & self.set_mask) as usize;
+        let tag = line >> self.set_mask.count_ones();
+        let base = set * self.ways;
+        self.clock += 1;
+
+        let slots = &mut self.tags[base..base + self.ways];
+        if let Some(way) = slots.iter().position(|&t| t == tag) {
+            self.stamps[base + way] = self.clock;
+            return Access::Hit;
+        }
+
+        // LRU替换：时间戳最小的槽位（无效行时间戳0优先被选中）
+        let victim = (0..self.ways)
+            .min_by_key(|&w| self.stamps[base + w])
+            .unwrap();
+        let evicted = self.tags[base + victim] != INVALID_TAG;
+        self.tags[base + victim] = tag;
+        self.stamps[base + victim] = self.clock;
+        Access::Miss(evicted)
+    }
+}
+
+/// 单个符号区域的访问统计
+#[derive(Debug, Default, Clone, Copy)]
+struct RegionStats {
+    hits: u64,
+    misses: u64,
+    evictions: u64,
+}
+
+impl RegionStats {
+    fn record(&mut self, access: Access) {
+        match access {
+            Access::Hit => self.hits += 1,
+            Access::Miss(evicted) => {
+                self.misses += 1;
+                if evicted {
+                    self.evictions += 1;
+                }
+            }
+        }
+    }
+}
+
+/// I/D两级L1模型与按符号区域的统计
+pub struct CacheModel {
+    icache: CacheSim,
+    dcache: CacheSim,
+    /// 按地址排序的函数符号（load_elf后注入；空则全记入"<其他>"）
+    symbols: Vec<FuncSym>,
+    /// 与symbols同序的I缓存统计，末尾附加一个"<其他>"槽位
+    i_regions: Vec<RegionStats>,
+    /// 按访问PC归属的D缓存统计，布局同上
+    d_regions: Vec<RegionStats>,
+    sample_rate: u64,
+    i_tick: u64,
+    d_tick: u64,
+}
+
+impl CacheModel {
+    pub fn new(config: &CacheModelConfig) -> Self {
+        CacheModel {
+            icache: CacheSim::new(config.icache_sets, config.icache_ways, config.line_size),
+            dcache: CacheSim::new(config.dcache_sets, config.dcache_ways, config.line_size),
+            symbols: Vec::new(),
+            i_regions: vec![RegionStats::default()],
+            d_regions: vec![RegionStats::default()],
+            sample_rate: config.sample_rate.max(1),
+            i_tick: 0,
+            d_tick: 0,
+        }
+    }
+
+    /// 注入函数符号索引并清零统计（每次加载ELF后调用）
+    pub fn set_symbols(&mut self, symbols: &[FuncSym]) {
+        self.symbols = symbols.to_vec();
+        self.i_regions = vec![RegionStats::default(); self.symbols.len() + 1];
+        self.d_regions = vec![RegionStats::default(); self.symbols.len() + 1];
+    }
+
+    /// PC所属符号区域的统计槽位（二分查找；不属于任何符号则为末尾槽）
+    #[inline]
+    fn region_index(&self, pc: u64) -> usize {
+        match self.symbols.binary_search_by(|s| {
+            if pc < s.addr {
+                std::cmp::Ordering::Greater
+            } else if pc >= s.addr + s.size {
+                std::cmp::Ordering::Less
+            } else {
+                std::cmp::Ordering::Equal
+            }
+        }) {
+            Ok(i) => i,
+            Err(_) => self.symbols.len(),
+        }
+    }
+
+    /// 取指路径上报一次指令访问
+    #[inline]
+    pub fn fetch(&mut self, pc: u64) {
+        self.i_tick += 1;
+        if self.i_tick < self.sample_rate {
+            return;
+        }
+        self.i_tick = 0;
+        let access = self.icache.access(pc);
+        let idx = self.region_index(pc);
+        self.i_regions[idx].record(access);
+    }
+
+    /// 载入/存储路径上报一次数据访问（按访问PC归属区域）
+    #[inline]
+    pub fn data_access(&mut self, pc: u64, addr: u64) {
+        self.d_tick += 1;
+        if self.d_tick < self.sample_rate {
+            return;
+        }
+        self.d_tick = 0;
+        let access = self.dcache.access(addr);
+        let idx = self.region_index(pc);
+        self.d_regions[idx].record(access);
+    }
+
+    /// 汇总报告：总量加按未命中数排序的前若干符号区域
+    pub fn summary(&self) -> String {
+        use std::fmt::Write;
+
+        let mut out = String::new();
+        if self.sample_rate > 1 {
+            let _ = writeln!(out, "（采样模式：每{}次访问模拟1次，计数为采样值）", self.sample_rate);
+        }
+        for (name, regions) in [("I缓存", &self.i_regions), ("D缓存", &self.d_regions)] {
+            let total = regions.iter().fold(RegionStats::default(), |mut acc, r| {
+                acc.hits += r.hits;
+                acc.misses += r.misses;
+                acc.evictions += r.evictions;
+                acc
+            });
+            let accesses = total.hits + total.misses;
+            let rate = if accesses > 0 {
+                total.misses as f64 / accesses as f64 * 100.0
+            } else {
+                0.0
+            };
+            let _ = writeln!(
+                out,
+                "{}: 访问 {} 命中 {} 未命中 {} ({:.2}%) 逐出 {}",
+                name, accesses, total.hits, total.misses, rate, total.evictions
+            );
+
+            // 未命中最多的前8个符号区域
+            let mut ranked: Vec<(usize, &RegionStats)> = regions
+                .iter()
+                .enumerate()
+                .filter(|(_, r)| r.misses > 0)
+                .collect();
+            ranked.sort_by_key(|&(_, r)| std::cmp::Reverse(r.misses));
+            for (idx, r) in ranked.into_iter().take(8) {
+                let sym = self
+                    .symbols
+                    .get(idx)
+                    .map(|s| s.name.as_str())
+                    .unwrap_or("<其他>");
+                let _ = writeln!(
+                    out,
+                    "  {:<32} 命中 {:>10} 未命中 {:>8} 逐出 {:>8}",
+                    sym, r.hits, r.misses, r.evictions
+                );
+            }
+        }
+        out
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn small_config() -> CacheModelConfig {
+        CacheModelConfig {
+            icache_sets: 4,
+            icache_ways: 2,
+            dcache_sets: 4,
+            dcache_ways: 2,
+            line_size: 64,
+            sample_rate: 1,
+        }
+    }
+
+    #[test]
+    fn test_hit_after_miss_and_lru_eviction() {
+        let mut sim = CacheSim::new(4, 2, 64);
+        // 同一行：首访未命中（无逐出），再访命中
+        assert_eq!(sim.access(0x1000), Access::Miss(false));
+        assert_eq!(sim.access(0x1008), Access::Hit);
+        // 同组两路填满后第三个冲突行逐出LRU（0x1000所在行）
+        assert_eq!(sim.access(0x1000 + 4 * 64), Access::Miss(false));
+        assert_eq!(sim.access(0x1000 + 8 * 64), Access::Miss(true));
+        assert_eq!(sim.access(0x1000), Access::Miss(true));
+    }
+
+    #[test]
+    fn test_region_attribution_and_summary() {
+        let mut model = CacheModel::new(&small_config());
+        model.set_symbols(&[FuncSym {
+            addr: 0x8000_0000,
+            size: 0x100,
+            name: "hot_fn".to_string(),
+        }]);
+        model.fetch(0x8000_0010); // hot_fn内：未命中
+        model.fetch(0x8000_0010); // 命中
+        model.fetch(0x9000_0000); // 符号外：记入<其他>
+        model.data_access(0x8000_0020, 0x8100_0000);
+        let report = model.summary();
+        assert!(report.contains("hot_fn"));
+        assert!(report.contains("<其他>"));
+    }
+
+    #[test]
+    fn test_sampling_skips_accesses() {
+        let mut config = small_config();
+        config.sample_rate = 4;
+        let mut model = CacheModel::new(&config);
+        model.set_symbols(&[]);
+        for _ in 0..16 {
+            model.fetch(0x8000_0000);
+        }
+        // 每4次模拟1次：4次访问，1次未命中3次命中
+        let report = model.summary();
+        assert!(report.contains("访问 4"), "报告: {report}");
+    }
+}
@@ -1,10 +1,12 @@
 //! 设备管理模块
 //! 负责根据配置文件创建和管理 MMIO 设备
 
+use std::cell::RefCell;
+use std::rc::Rc;
 use std::sync::{Arc, Mutex};
 use mmio_trait::MmioDevice;
 use crate::const_values::DeviceConfig;
-use crate::emulator::memory::Memory;
+use crate::emulator::memory::{DeviceCell, Memory};
 
 /// 设备工厂错误
 #[derive(Debug, thiserror::Error)]
@@ -20,16 +22,22 @@ pub struct DeviceFactory;
 
 impl DeviceFactory {
     /// 根据配置创建设备
-    pub fn create_device(config: &DeviceConfig) -> Result<Arc<Mutex<dyn MmioDevice>>, DeviceError> {
-            match config.device_type.as_str() {
-            "uart" => {
-                let uart = uart::Uart::new(config.name.clone());
-                Ok(Arc::new(Mutex::new(uart)))
-            }
-            "timer" => {
-                let timer = timer::Timer::new(config.name.clone());
-                Ok(Arc::new(Mutex::new(timer)))
+    ///
+    /// `threaded`决定设备容器：单线程运行用`Rc<RefCell>`免掉每次
+    /// 访问的原子锁，线程化配置保留`Arc<Mutex>`
+    pub fn create_device(config: &DeviceConfig, threaded: bool) -> Result<DeviceCell, DeviceError> {
+        fn wrap<D: MmioDevice + 'static>(device: D, threaded: bool) -> DeviceCell {
+            if threaded {
+                DeviceCell::Shared(Arc::new(Mutex::new(device)))
+            } else {
+                DeviceCell::Local(Rc::new(RefCell::new(device)))
             }
+        }
+
+        match config.device_type.as_str() {
+            "uart" => Ok(wrap(uart::Uart::new(config.name.clone()), threaded)),
+            "timer" => Ok(wrap(timer::Timer::new(config.name.clone()), threaded)),
+            "dma" => Ok(wrap(dma::Dma::new(config.name.clone()), threaded)),
             _ => Err(DeviceError::UnknownDeviceType(config.device_type.clone())),
         }
     }
@@ -40,9 +48,12 @@ pub struct DeviceManager;
 
 impl DeviceManager {
     /// 根据配置列表初始化所有设备
+    ///
+    /// `threaded`为假（当前所有配置）时设备走无锁的单线程容器
     pub fn initialize_devices(
         memory: &mut Memory,
         device_configs: &[DeviceConfig],
+        threaded: bool,
     ) -> Result<(), Box<dyn std::error::Error>> {
         for config in device_configs {
             if !config.enabled {
@@ -50,10 +61,16 @@ impl DeviceManager {
                 continue;
             }
 
+            // perfcnt是CPU挂靠设备：计数在模拟器手里，由Emulator创建时映射
+            if config.device_type == "perfcnt" {
+                tracing::info!("跳过设备 {}: perfcnt由模拟器挂接", config.name);
+                continue;
+            }
+
             tracing::info!("初始化设备: {} (类型: {}, 地址: {:#x}, 大小: {:#x})",
                      config.name, config.device_type, config.base, config.size);
 
-            let device = DeviceFactory::create_device(config)
+            let device = DeviceFactory::create_device(config, threaded)
                 .map_err(|e| format!("创建设备 {} 失败: {}", config.name, e))?;
 
             memory.map_mmio(
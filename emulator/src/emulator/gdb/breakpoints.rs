@@ -1,6 +1,20 @@
+//! 软件断点：经典的指令补丁实现
+//!
+//! 插入断点时把`ebreak`（或2字节位置上的`c.ebreak`）直接写进
+//! guest内存并保存原字节，命中即执行到ebreak、由其处理器抬出
+//! `Event::Break`；移除时写回原字节。运行循环因此完全没有逐步
+//! 的断点查表，Continue模式下挂着GDB的速度与不挂相同。恢复
+//! 执行时的摘补丁/单步/重打补丁由GDB客户端经Z0/z0包自己编排。
+
+use super::BpPatch;
 use crate::emulator::Emulator;
 use gdbstub::target;
 
+/// ebreak指令编码（小端字节）
+const EBREAK: [u8; 4] = 0x0010_0073u32.to_le_bytes();
+/// c.ebreak指令编码（2字节断点位）
+const C_EBREAK: [u8; 2] = 0x9002u16.to_le_bytes();
+
 impl target::ext::breakpoints::Breakpoints for Emulator {
     #[inline(always)]
     fn support_sw_breakpoint(
@@ -21,9 +35,27 @@ impl target::ext::breakpoints::SwBreakpoint for Emulator {
     fn add_sw_breakpoint(
         &mut self,
         addr: <Self::Arch as gdbstub::arch::Arch>::Usize,
-        _kind: <Self::Arch as gdbstub::arch::Arch>::BreakpointKind,
+        kind: <Self::Arch as gdbstub::arch::Arch>::BreakpointKind,
     ) -> target::TargetResult<bool, Self> {
-        self.gdb_data.breakpoints.insert(addr);
+        if self.gdb_data.breakpoints.contains_key(&addr) {
+            return Ok(false);
+        }
+        // kind即断点长度：压缩指令位置上打2字节的c.ebreak
+        let len: usize = if kind == 2 { 2 } else { 4 };
+        let mut orig = [0u8; 4];
+        self.state
+            .memory
+            .read_into(addr, &mut orig[..len])
+            .map_err(|_| target::TargetError::NonFatal)?;
+        let patch: &[u8] = if len == 2 { &C_EBREAK } else { &EBREAK };
+        self.state
+            .write_memory(addr, patch)
+            .map_err(|_| target::TargetError::NonFatal)?;
+        self.gdb_data
+            .breakpoints
+            .insert(addr, BpPatch { orig, len: len as u8 });
+        // 译码缓存与基本块缓存里还躺着原指令，全部失效
+        self.invalidate_code_caches();
         Ok(true)
     }
 
@@ -32,7 +64,14 @@ impl target::ext::breakpoints::SwBreakpoint for Emulator {
         addr: <Self::Arch as gdbstub::arch::Arch>::Usize,
         _kind: <Self::Arch as gdbstub::arch::Arch>::BreakpointKind,
     ) -> target::TargetResult<bool, Self> {
-        Ok(self.gdb_data.breakpoints.remove(&addr))
+        let Some(patch) = self.gdb_data.breakpoints.remove(&addr) else {
+            return Ok(false);
+        };
+        self.state
+            .write_memory(addr, &patch.orig[..patch.len as usize])
+            .map_err(|_| target::TargetError::NonFatal)?;
+        self.invalidate_code_caches();
+        Ok(true)
     }
 }
 
@@ -44,7 +83,7 @@ impl target::ext::breakpoints::HwWatchpoint for Emulator {
         _kind: target::ext::breakpoints::WatchKind,
     ) -> target::TargetResult<bool, Self> {
         for addr in addr..(addr + len) {
-            self.gdb_data.watchpoints.insert(addr);
+            self.gdb_data.add_watch(addr);
         }
         Ok(true)
     }
@@ -56,7 +95,7 @@ impl target::ext::breakpoints::HwWatchpoint for Emulator {
         _kind: target::ext::breakpoints::WatchKind,
     ) -> target::TargetResult<bool, Self> {
         for addr in addr..(addr + len) {
-            if !self.gdb_data.watchpoints.remove(&addr) {
+            if !self.gdb_data.remove_watch(addr) {
                 return Ok(false);
             }
         }
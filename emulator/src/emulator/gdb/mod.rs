@@ -20,19 +20,127 @@ use gdbstub::stub::{SingleThreadStopReason, run_blocking};
 use gdbstub::target::ext::breakpoints::WatchKind;
 
 type NoHashHashSet<T> = HashSet<T, BuildNoHashHasher<T>>;
+type NoHashHashMap<K, V> = std::collections::HashMap<K, V, BuildNoHashHasher<K>>;
+
+/// 软件断点的补丁记录：打进guest内存的ebreak所覆盖的原指令字节
+#[derive(Debug, Clone, Copy)]
+pub struct BpPatch {
+    /// 被覆盖的原字节（len有效）
+    pub orig: [u8; 4],
+    /// 补丁长度：2（c.ebreak）或4（ebreak）
+    pub len: u8,
+}
+
+/// 观察点页过滤位图的字数（16×64=1024位）
+const WATCH_FILTER_WORDS: usize = 16;
+/// 页过滤的粒度（与内存子系统的脏页粒度一致）
+const WATCH_PAGE_SHIFT: u32 = 12;
+
+/// 页号到过滤位图位序号的散列（斐波那契散列，取高10位）
+#[inline(always)]
+fn watch_filter_bit(page: u64) -> (usize, u64) {
+    let h = page.wrapping_mul(0x9e37_79b9_7f4a_7c15) >> (64 - 10);
+    ((h >> 6) as usize, 1u64 << (h & 63))
+}
 
 pub struct GdbData {
-    pub breakpoints: NoHashHashSet<u64>,
+    /// 已打补丁的断点：地址→原指令字节
+    ///
+    /// 断点以指令补丁的形式活在guest内存里，运行循环不做任何
+    /// 逐步查表——命中断点即执行到ebreak，由其处理器分辨
+    pub breakpoints: NoHashHashMap<u64, BpPatch>,
+    /// 精确的观察点字节集合（慢路径才查）
     pub watchpoints: NoHashHashSet<u64>,
+    /// 页级bloom位图：含观察点的页把散列位置位，访存热路径
+    /// 先做一次位测试，绝大多数访问在这里直接失败返回
+    watch_filter: [u64; WATCH_FILTER_WORDS],
 }
 
 impl GdbData {
     pub fn new() -> Self {
         Self {
-            breakpoints: NoHashHashSet::default(),
+            breakpoints: NoHashHashMap::default(),
             watchpoints: NoHashHashSet::default(),
+            watch_filter: [0; WATCH_FILTER_WORDS],
+        }
+    }
+
+    /// ebreak处理器查询：该地址是否是打过补丁的断点
+    #[inline]
+    pub fn is_breakpoint(&self, addr: u64) -> bool {
+        self.breakpoints.contains_key(&addr)
+    }
+
+    /// 登记一个观察点字节并置位其所在页的过滤位
+    pub fn add_watch(&mut self, addr: u64) {
+        self.watchpoints.insert(addr);
+        let (word, bit) = watch_filter_bit(addr >> WATCH_PAGE_SHIFT);
+        self.watch_filter[word] |= bit;
+    }
+
+    /// 移除一个观察点字节；位图位可能被其他页共享，整体重建
+    pub fn remove_watch(&mut self, addr: u64) -> bool {
+        if !self.watchpoints.remove(&addr) {
+            return false;
+        }
+        self.watch_filter = [0; WATCH_FILTER_WORDS];
+        for &a in &self.watchpoints {
+            let (word, bit) = watch_filter_bit(a >> WATCH_PAGE_SHIFT);
+            self.watch_filter[word] |= bit;
         }
+        true
     }
+
+    /// 访存热路径查询：返回第一个被本次访问覆盖的观察点地址
+    ///
+    /// 快路径是对起始页（跨页时再加末页）的单次位测试，没有
+    /// 观察点时位图全零、必然失败；只有落在可疑页上才走精确的
+    /// 逐字节集合查找
+    #[inline(always)]
+    pub fn watch_hit(&self, addr: u64, size: u8) -> Option<u64> {
+        let first = addr >> WATCH_PAGE_SHIFT;
+        let (word, bit) = watch_filter_bit(first);
+        let mut suspect = self.watch_filter[word] & bit != 0;
+        let last = (addr + size as u64 - 1) >> WATCH_PAGE_SHIFT;
+        if !suspect && last != first {
+            let (word, bit) = watch_filter_bit(last);
+            suspect = self.watch_filter[word] & bit != 0;
+        }
+        if !suspect {
+            return None;
+        }
+        (addr..addr + size as u64).find(|a| self.watchpoints.contains(a))
+    }
+}
+
+/// 把模拟器事件翻译为GDB停止原因（无事件时返回None）
+fn event_stop_reason(event: Event) -> Option<SingleThreadStopReason<u64>> {
+    match event {
+        Event::None => None,
+        Event::Halted(x) => Some(SingleThreadStopReason::Exited(x)),
+        Event::Break => Some(SingleThreadStopReason::SwBreak(())),
+        Event::WatchWrite(addr) => Some(SingleThreadStopReason::Watch {
+            tid: (),
+            kind: WatchKind::Write,
+            addr,
+        }),
+        Event::WatchRead(addr) => Some(SingleThreadStopReason::Watch {
+            tid: (),
+            kind: WatchKind::Read,
+            addr,
+        }),
+    }
+}
+
+/// 执行出错时的冷路径：打印诊断并转成gdbstub的目标错误
+fn step_error<C>(
+    target: &Emulator,
+    e: anyhow::Error,
+) -> run_blocking::WaitForStopReasonError<String, C> {
+    let error_msg = format!("gdb调试过程中出现执行错误: {}", e);
+    tracing::error!("{}", error_msg);
+    tracing::error!("CPU状态:\n{}", target.get_state_ref());
+    run_blocking::WaitForStopReasonError::Target(error_msg)
 }
 
 pub enum EmuGdbEventLoop {}
@@ -55,18 +163,41 @@ impl run_blocking::BlockingEventLoop for EmuGdbEventLoop {
         >,
     > {
         let mode = target.get_exec_mode();
-        let mut cnt = match mode {
-            ExecMode::Step => 1,
-            ExecMode::Continue => usize::MAX,
-            ExecMode::RangeStep(start, end) => {
-                if target.get_state_ref().get_pc() >= end {
+
+        // 范围单步走加速路径：范围内的基本块全速执行，只在批次间
+        // 轮询连接；批预算同时是中断响应粒度
+        if let ExecMode::RangeStep(start, end) = mode {
+            /// 单个批次的指令预算
+            const RANGE_BATCH: usize = 4096;
+            while target.get_exec_state() != ExecState::End {
+                match target.step_range(start, end, RANGE_BATCH) {
+                    Ok(_) => {
+                        if let Some(reason) = event_stop_reason(target.event) {
+                            return Ok(run_blocking::Event::TargetStopped(reason));
+                        }
+                    }
+                    Err(e) => return Err(step_error(target, e)),
+                }
+                if !(start..end).contains(&target.get_state_ref().get_pc()) {
                     return Ok(run_blocking::Event::TargetStopped(
-                        SingleThreadStopReason::Exited(0),
+                        SingleThreadStopReason::DoneStep,
                     ));
                 }
-                (end - start) as usize
+                if conn.peek().is_ok() {
+                    let byte = conn
+                        .read()
+                        .map_err(run_blocking::WaitForStopReasonError::Connection)?;
+                    return Ok(run_blocking::Event::IncomingData(byte));
+                }
             }
-            _ => 1, // 默认单步执行
+            return Ok(run_blocking::Event::TargetStopped(
+                SingleThreadStopReason::DoneStep,
+            ));
+        }
+
+        let mut cnt = match mode {
+            ExecMode::Continue => usize::MAX,
+            _ => 1, // Step及默认：单步执行
         };
         let mut delay_cycles = 0;
         while target.get_exec_state() != ExecState::End {
@@ -78,44 +209,12 @@ impl run_blocking::BlockingEventLoop for EmuGdbEventLoop {
             }
 
             match target.step() {
-                Ok(_) => match target.event {
-                    Event::None => (),
-                    Event::Halted(x) => {
-                        return Ok(run_blocking::Event::TargetStopped(
-                            SingleThreadStopReason::Exited(x),
-                        ));
-                    }
-                    Event::Break => {
-                        return Ok(run_blocking::Event::TargetStopped(
-                            SingleThreadStopReason::Terminated(Signal::SIGSTOP),
-                        ));
-                    }
-                    Event::WatchWrite(addr) => {
-                        return Ok(run_blocking::Event::TargetStopped(
-                            SingleThreadStopReason::Watch {
-                                tid: (),
-                                kind: WatchKind::Write,
-                                addr,
-                            },
-                        ));
-                    }
-                    Event::WatchRead(addr) => {
-                        return Ok(run_blocking::Event::TargetStopped(
-                            SingleThreadStopReason::Watch {
-                                tid: (),
-                                kind: WatchKind::Read,
-                                addr,
-                            },
-                        ));
+                Ok(_) => {
+                    if let Some(reason) = event_stop_reason(target.event) {
+                        return Ok(run_blocking::Event::TargetStopped(reason));
                     }
-                },
-                Err(e) => {
-                    let error_msg = format!("gdb调试过程中出现执行错误: {}", e);
-                    // 打印错误信息
-                    tracing::error!("{}", error_msg);
-                    tracing::error!("CPU状态:\n{}", target.get_state_ref());
-                    return Err(run_blocking::WaitForStopReasonError::Target(error_msg));
                 }
+                Err(e) => return Err(step_error(target, e)),
             }
             if mode != ExecMode::Continue {
                 cnt -= 1;
@@ -187,7 +286,7 @@ impl SingleThreadBase for Emulator {
         self.state.sync_pc();
         for (i, &val) in regs.x.iter().enumerate() {
             self.state
-                .set_reg(i, val)
+                .set_reg(i as u64, val)
                 .map_err(|_| target::TargetError::NonFatal)?;
         }
         Ok(())
@@ -198,12 +297,11 @@ impl SingleThreadBase for Emulator {
         start_addr: <Self::Arch as gdbstub::arch::Arch>::Usize,
         data: &mut [u8],
     ) -> target::TargetResult<usize, Self> {
-        for (addr, val) in (start_addr..).zip(data.iter_mut()) {
-            match self.state.read_memory(addr, 1) {
-                Ok(byte) => *val = byte[0],
-                Err(_) => return Err(target::TargetError::NonFatal),
-            }
-        }
+        // 一次读入整段，避免逐字节的Vec分配
+        self.state
+            .memory
+            .read_into(start_addr, data)
+            .map_err(|_| target::TargetError::NonFatal)?;
         Ok(data.len())
     }
 
@@ -212,6 +310,17 @@ impl SingleThreadBase for Emulator {
         start_addr: <Self::Arch as gdbstub::arch::Arch>::Usize,
         data: &[u8],
     ) -> target::TargetResult<(), Self> {
+        if data.is_empty() {
+            return Ok(());
+        }
+        // 整段落在主内存时一次成块写入（单次memcpy+标脏）；
+        // 触及MMIO的罕见情况退回逐字节，按设备语义分发
+        if self.state.memory.is_mem_region_range(start_addr, data.len()) {
+            self.state
+                .write_memory(start_addr, data)
+                .map_err(|_| target::TargetError::NonFatal)?;
+            return Ok(());
+        }
         for (addr, &val) in (start_addr..).zip(data.iter()) {
             self.state
                 .write_memory(addr, &[val])
@@ -244,7 +353,7 @@ impl SingleRegisterAccess<()> for Emulator {
             RiscvRegId::Gpr(reg) => {
                 let reg_value = self
                     .state
-                    .get_reg(reg as usize)
+                    .get_reg(reg as u64)
                     .map_err(|_| target::TargetError::NonFatal)?;
                 buf.copy_from_slice(&reg_value.to_le_bytes());
                 Ok(buf.len())
@@ -274,7 +383,7 @@ impl SingleRegisterAccess<()> for Emulator {
                 let reg_value =
                     u64::from_le_bytes(val.try_into().map_err(|_| target::TargetError::NonFatal)?);
                 self.state
-                    .set_reg(reg as usize, reg_value)
+                    .set_reg(reg as u64, reg_value)
                     .map_err(|_| target::TargetError::NonFatal)?;
                 Ok(())
             }
@@ -311,6 +420,32 @@ impl SingleThreadRangeStepping for Emulator {
     }
 }
 
+#[cfg(test)]
+mod tests {
+    use super::GdbData;
+
+    #[test]
+    fn test_watch_filter() {
+        let mut data = GdbData::new();
+        // 没有观察点时任何访问都快速失败
+        assert_eq!(data.watch_hit(0x8000_0000, 8), None);
+
+        data.add_watch(0x8000_1004);
+        assert_eq!(data.watch_hit(0x8000_1000, 4), None);
+        assert_eq!(data.watch_hit(0x8000_1004, 4), Some(0x8000_1004));
+        // 访问区间覆盖观察点也要命中（含跨页访问）
+        assert_eq!(data.watch_hit(0x8000_1000, 8), Some(0x8000_1004));
+        data.add_watch(0x8000_2000);
+        assert_eq!(data.watch_hit(0x8000_1ffc, 8), Some(0x8000_2000));
+
+        // 移除后位图重建，另一观察点仍然有效
+        assert!(data.remove_watch(0x8000_1004));
+        assert_eq!(data.watch_hit(0x8000_1004, 4), None);
+        assert_eq!(data.watch_hit(0x8000_2000, 1), Some(0x8000_2000));
+        assert!(!data.remove_watch(0x8000_1004));
+    }
+}
+
 impl SingleThreadResume for Emulator {
     fn resume(
         &mut self,
@@ -0,0 +1,138 @@
+//! 宏操作融合
+//!
+//! RISC-V代码生成大量使用固定的指令对（`lui+addi`/`auipc+addi`地址与
+//! 常量合成、`slli+srli`零扩展、比较+分支），逐条执行时每条都要走一次
+//! 完整的分发回路。块预译码阶段识别这些相邻对，标记到首条指令上，
+//! 执行时由单个融合处理函数一次完成两条指令的架构效果。
+//!
+//! 融合只是分发层面的优化：首条指令的寄存器写入仍然发生，因此无需
+//! 任何活跃性分析，语义与逐条执行完全一致。
+
+use anyhow::Result;
+
+use crate::emulator::Emulator;
+use crate::emulator::block::DecodedInst;
+
+use super::{parse_format_b, parse_format_i, parse_format_r, parse_format_u};
+use crate::utils::bit_utils::{bits, sign_extend};
+
+/// 融合对处理函数：一次执行两条指令（i1/i2为两条指令字，pc为首条PC）
+pub type FusedHandler = fn(emu: &mut Emulator, i1: u32, i2: u32, pc: u64) -> Result<()>;
+
+/// 尝试融合相邻的两条预译码指令，可融合时返回处理函数
+pub fn fuse(first: &DecodedInst, second: &DecodedInst) -> Option<FusedHandler> {
+    match (first.handler.name, second.handler.name) {
+        // lui/auipc + addi(w)：高20位与低12位合成常量/地址
+        ("lui", "addi") | ("lui", "addiw") | ("auipc", "addi") => {
+            let u = parse_format_u(first.inst);
+            let i = parse_format_i(second.inst);
+            if i.rs1 != u.rd || u.rd == 0 {
+                return None;
+            }
+            Some(match (first.handler.name, second.handler.name) {
+                ("lui", "addi") => fused_lui_addi,
+                ("lui", _) => fused_lui_addiw,
+                _ => fused_auipc_addi,
+            })
+        }
+        // slli + srli：移位对（含N=32的零扩展与位段提取）
+        ("slli", "srli") => {
+            let a = parse_format_i(first.inst);
+            let b = parse_format_i(second.inst);
+            (b.rs1 == a.rd && a.rd != 0).then_some(fused_shift_pair as FusedHandler)
+        }
+        // 比较 + 对比较结果的beqz/bnez
+        ("slt" | "sltu" | "slti" | "sltiu", "beq" | "bne") => {
+            let b = parse_format_b(second.inst);
+            let rd = bits::<11, 7>(first.inst);
+            if b.rs1 != rd || b.rs2 != 0 || rd == 0 {
+                return None;
+            }
+            Some(if second.handler.name == "bne" {
+                fused_cmp_bnez
+            } else {
+                fused_cmp_beqz
+            })
+        }
+        _ => None,
+    }
+}
+
+fn fused_lui_addi(emu: &mut Emulator, i1: u32, i2: u32, _pc: u64) -> Result<()> {
+    let u = parse_format_u(i1);
+    let i = parse_format_i(i2);
+    emu.set_reg(u.rd, u.imm)?;
+    emu.set_reg(i.rd, u.imm.wrapping_add(i.imm))
+}
+
+fn fused_lui_addiw(emu: &mut Emulator, i1: u32, i2: u32, _pc: u64) -> Result<()> {
+    let u = parse_format_u(i1);
+    let i = parse_format_i(i2);
+    emu.set_reg(u.rd, u.imm)?;
+    let result = bits::<31, 0>(u.imm.wrapping_add(i.imm));
+    emu.set_reg(i.rd, sign_extend::<32>(result))
+}
+
+fn fused_auipc_addi(emu: &mut Emulator, i1: u32, i2: u32, pc: u64) -> Result<()> {
+    let u = parse_format_u(i1);
+    let i = parse_format_i(i2);
+    let base = pc.wrapping_add(u.imm);
+    emu.set_reg(u.rd, base)?;
+    emu.set_reg(i.rd, base.wrapping_add(i.imm))
+}
+
+fn fused_shift_pair(emu: &mut Emulator, i1: u32, i2: u32, _pc: u64) -> Result<()> {
+    let a = parse_format_i(i1);
+    let b = parse_format_i(i2);
+    let t = emu.get_reg(a.rs1)? << (a.imm & 0x3f);
+    emu.set_reg(a.rd, t)?;
+    emu.set_reg(b.rd, t >> (b.imm & 0x3f))
+}
+
+/// 计算比较类指令的结果并写回rd，返回比较值供分支判断
+fn cmp_result(emu: &mut Emulator, i1: u32) -> Result<u64> {
+    let funct3 = bits::<14, 12>(i1);
+    if i1 & 0x7f == 0x13 {
+        // slti / sltiu
+        let f = parse_format_i(i1);
+        let lhs = emu.get_reg(f.rs1)?;
+        let v = if funct3 == 0b010 {
+            ((lhs as i64) < (f.imm as i64)) as u64
+        } else {
+            (lhs < f.imm) as u64
+        };
+        emu.set_reg(f.rd, v)?;
+        Ok(v)
+    } else {
+        // slt / sltu
+        let f = parse_format_r(i1);
+        let lhs = emu.get_reg(f.rs1)?;
+        let rhs = emu.get_reg(f.rs2)?;
+        let v = if funct3 == 0b010 {
+            ((lhs as i64) < (rhs as i64)) as u64
+        } else {
+            (lhs < rhs) as u64
+        };
+        emu.set_reg(f.rd, v)?;
+        Ok(v)
+    }
+}
+
+fn fused_cmp_bnez(emu: &mut Emulator, i1: u32, i2: u32, pc: u64) -> Result<()> {
+    let v = cmp_result(emu, i1)?;
+    if v != 0 {
+        let b = parse_format_b(i2);
+        // 分支偏移相对第二条指令的PC（首条为32位指令）
+        emu.set_npc(pc.wrapping_add(4).wrapping_add(b.imm));
+    }
+    Ok(())
+}
+
+fn fused_cmp_beqz(emu: &mut Emulator, i1: u32, i2: u32, pc: u64) -> Result<()> {
+    let v = cmp_result(emu, i1)?;
+    if v == 0 {
+        let b = parse_format_b(i2);
+        emu.set_npc(pc.wrapping_add(4).wrapping_add(b.imm));
+    }
+    Ok(())
+}
@@ -1,17 +1,23 @@
-mod insts;
+// 融合只在块执行路径使用；tracer要求逐条回调，整个模块随之关闭
+#[cfg(not(feature = "tracer"))]
+pub(crate) mod fusion;
+pub(crate) mod insts;
 mod rv64a;
+pub(crate) mod rv64c;
+mod rv64d;
+mod rv64f;
 mod rv64i;
 mod rv64m;
-// clock_cache removed: instruction cache not needed
+mod rv64v;
+mod rv64zba;
+mod rv64zbb;
 
 use anyhow::{Ok, Result};
-use nohash_hasher::BuildNoHashHasher;
-use std::collections::HashMap;
 use std::rc::Rc;
 
 use crate::const_values::EmuConfig;
 use crate::emulator::Emulator;
-use crate::utils::bit_utils::{BitSlice, sign_extend_64};
+use crate::utils::bit_utils::{bits, sign_extend};
 
 #[derive(Debug, Clone, Copy, Hash)]
 pub struct Instruction {
@@ -21,31 +27,140 @@ pub struct Instruction {
     pub execute: fn(emu: &mut Emulator, inst: u32, pc: u64) -> Result<()>,
 }
 
+/// 译码缓存条目：以PC为键的直接映射缓存
+#[derive(Debug, Clone, Copy)]
+struct DecodeCacheEntry {
+    /// 该条目对应的PC（`u64::MAX` 表示无效条目）
+    tag: u64,
+    /// 译码结果
+    handler: Option<&'static Instruction>,
+    /// 指令长度（压缩指令2字节，否则4字节），命中时免去重新判别编码
+    len: u8,
+}
+
+impl DecodeCacheEntry {
+    const INVALID: Self = DecodeCacheEntry {
+        tag: u64::MAX,
+        handler: None,
+        len: 0,
+    };
+}
+
 pub struct InstDecoder {
     instructions_set: Vec<&'static Instruction>,
-    compressed_instructions: Vec<Instruction>,
+    #[allow(unused)]
+    compressed_instructions: Vec<&'static Instruction>,
     #[allow(unused)]
     config: Rc<EmuConfig>,
-    opcode_map: HashMap<u32, Vec<&'static Instruction>, BuildNoHashHasher<u32>>,
+    /// 稠密分发表：以 opcode|funct3|funct7 拼成的17位索引直接定位指令，
+    /// 仅收录掩码完全落在这些位域内的指令（约1MB，换取O(1)无哈希译码）
+    dispatch: Vec<Option<&'static Instruction>>,
+    /// 掩码超出索引位域的指令（如ecall/ebreak），按opcode分桶线性匹配
+    residual: Vec<Vec<&'static Instruction>>,
+    /// 以PC为索引的直接映射译码缓存，大小来自配置中的 `decoder_cache_size`
+    decode_cache: Vec<DecodeCacheEntry>,
+    /// 译码缓存索引掩码（容量向上取整到2的幂）
+    cache_mask: usize,
+    /// 压缩指令稠密查找表（以16位指令字直接索引；未启用C扩展时为空）
+    c_table: Vec<Option<&'static Instruction>>,
+    /// 译码缓存命中计数（perf-stats专用）
+    #[cfg(feature = "perf-stats")]
+    cache_hits: u64,
+    /// 译码缓存未命中计数（perf-stats专用）
+    #[cfg(feature = "perf-stats")]
+    cache_misses: u64,
 }
 
 const MASK_OPCODE: u32 = 0x7F;
 
+/// 内置默认指令频度画像：覆盖落在兜底桶中的常见指令，数值只表达
+/// 相对频度（来自若干基准的动态直方图），未列出的指令视为0
+const DEFAULT_DECODE_PROFILE: &[(&str, u64)] = &[
+    ("vle8.v", 1000),
+    ("vse8.v", 900),
+    ("vle64.v", 800),
+    ("vse64.v", 700),
+    ("vle32.v", 600),
+    ("vse32.v", 500),
+    ("vle16.v", 400),
+    ("vse16.v", 350),
+    ("fcvt.d.w", 300),
+    ("fcvt.w.d", 280),
+    ("fcvt.s.w", 260),
+    ("fcvt.w.s", 240),
+    ("fcvt.d.s", 220),
+    ("fcvt.s.d", 200),
+    ("fsqrt.d", 150),
+    ("fsqrt.s", 140),
+    ("sext.h", 120),
+    ("sext.b", 110),
+    ("zext.h", 100),
+    ("clz", 90),
+    ("ctz", 80),
+    ("cpop", 70),
+    ("rev8", 60),
+    ("orc.b", 50),
+    ("lr.w", 40),
+    ("lr.d", 40),
+    ("fclass.d", 20),
+    ("fclass.s", 20),
+    ("ecall", 10),
+    ("ebreak", 1),
+];
+
+/// 读取指令频度画像（`name count`每行，`#`开头为注释行），
+/// 内置默认画像作为基底，文件中的条目覆盖同名默认值
+fn load_decode_profile(path: Option<&str>) -> rustc_hash::FxHashMap<String, u64> {
+    let mut profile: rustc_hash::FxHashMap<String, u64> = DEFAULT_DECODE_PROFILE
+        .iter()
+        .map(|&(name, count)| (name.to_string(), count))
+        .collect();
+    if let Some(path) = path {
+        match std::fs::read_to_string(path) {
+            std::result::Result::Ok(text) => {
+                for line in text.lines() {
+                    let line = line.trim();
+                    if line.is_empty() || line.starts_with('#') {
+                        continue;
+                    }
+                    let mut fields = line.split_whitespace();
+                    if let (Some(name), Some(count)) = (fields.next(), fields.next()) {
+                        if let std::result::Result::Ok(count) = count.parse::<u64>() {
+                            profile.insert(name.to_string(), count);
+                        }
+                    }
+                }
+            }
+            Err(e) => {
+                tracing::warn!("无法读取译码画像文件 {}: {}, 使用内置默认画像", path, e);
+            }
+        }
+    }
+    profile
+}
+
+/// 稠密分发表索引覆盖的指令位域：opcode[6:0] | funct3[14:12] | funct7[31:25]
+const DISPATCH_FIELD_MASK: u32 = 0xFE00_707F;
+
+/// 稠密分发表大小：7位opcode + 3位funct3 + 7位funct7
+const DISPATCH_TABLE_SIZE: usize = 1 << 17;
+
+/// 由指令字计算稠密分发表索引
 #[inline(always)]
-pub fn is_compressed(inst: u32) -> bool {
-    inst & 0b11 != 0b11
+fn dispatch_index(inst: u32) -> usize {
+    // opcode -> [6:0], funct3 -> [9:7], funct7 -> [16:10]
+    ((inst & 0x7F) | ((inst >> 5) & 0x380) | ((inst >> 15) & 0x1FC00)) as usize
 }
 
 #[inline(always)]
-pub fn is_inst_addr_misaligned(pc: u64) -> bool {
-    pc & 0b11 != 0
+pub fn is_compressed(inst: u32) -> bool {
+    inst & 0b11 != 0b11
 }
 
 impl InstDecoder {
     pub fn new(config: Rc<EmuConfig>) -> Self {
         let mut instructions_set: Vec<&'static Instruction> = vec![];
-        let compressed_instructions = vec![];
-        let mut opcode_map = HashMap::with_hasher(BuildNoHashHasher::default());
+        let mut compressed_instructions: Vec<&'static Instruction> = vec![];
 
         instructions_set.extend(rv64i::RV_I);
         if config.inst_set.m_ext {
@@ -54,51 +169,123 @@ impl InstDecoder {
         if config.inst_set.a_ext {
             instructions_set.extend(rv64a::RV_A);
         }
+        if config.inst_set.f_ext {
+            instructions_set.extend(rv64f::RV_F);
+        }
+        if config.inst_set.d_ext {
+            instructions_set.extend(rv64d::RV_D);
+        }
+        if config.inst_set.v_ext {
+            instructions_set.extend(rv64v::RV_V);
+        }
+        if config.inst_set.b_ext {
+            instructions_set.extend(rv64zba::RV_ZBA);
+            instructions_set.extend(rv64zbb::RV_ZBB);
+        }
 
         if config.inst_set.c_ext {
-            todo!("Implement compressed instructions");
+            compressed_instructions.extend(rv64c::RV_C);
+            if config.inst_set.d_ext {
+                compressed_instructions.extend(rv64c::RV_C_D);
+            }
+        }
+
+        // 为压缩指令构建以16位指令字直接索引的稠密查找表，
+        // 按表内顺序取首个匹配项（特化编码排在通用编码之前）
+        let c_table: Vec<Option<&'static Instruction>> = if config.inst_set.c_ext {
+            let mut table = vec![None; 1 << 16];
+            // 全零指令字在RVC中定义为非法，保持为None
+            for val in 1u32..(1 << 16) {
+                if !is_compressed(val) {
+                    continue;
+                }
+                table[val as usize] = compressed_instructions
+                    .iter()
+                    .copied()
+                    .find(|&x| val & x.mask == x.identifier);
+            }
+            table
+        } else {
+            Vec::new()
+        };
+
+        // 构建稠密分发表：rv64i.rs/rv64m.rs等表仍是唯一数据源，
+        // 这里仅在构造时展开为O(1)索引结构
+        let mut dispatch: Vec<Option<&'static Instruction>> = vec![None; DISPATCH_TABLE_SIZE];
+        let mut residual: Vec<Vec<&'static Instruction>> = vec![Vec::new(); 128];
+        for &inst in &instructions_set {
+            if inst.mask & !DISPATCH_FIELD_MASK != 0 {
+                // 掩码用到了索引位域之外的位，走按opcode分桶的兜底路径
+                residual[(inst.identifier & MASK_OPCODE) as usize].push(inst);
+                continue;
+            }
+            // 对掩码未覆盖的funct3/funct7组合全部填充同一条指令
+            for funct3 in 0u32..8 {
+                for funct7 in 0u32..128 {
+                    let word = (inst.identifier & MASK_OPCODE) | funct3 << 12 | funct7 << 25;
+                    if word & inst.mask == inst.identifier {
+                        dispatch[dispatch_index(word)] = Some(inst);
+                    }
+                }
+            }
         }
 
-        for inst in &instructions_set {
-            let opcode = inst.identifier & MASK_OPCODE;
-            let entry: &mut Vec<&'static Instruction> = opcode_map.entry(opcode).or_default();
-            entry.push(inst);
+        // 按动态频度画像对兜底桶做稳定降序排序：高频指令排到线性
+        // 扫描前部，未出现在画像中的指令维持声明顺序。兜底桶内的
+        // 指令编码互不重叠，重排不改变译码结果
+        let profile = load_decode_profile(config.others.decoder_profile.as_deref());
+        for bucket in residual.iter_mut() {
+            bucket.sort_by_key(|inst| std::cmp::Reverse(profile.get(inst.name).copied().unwrap_or(0)));
         }
+
+        // 译码缓存容量向上取整到2的幂，便于用掩码取索引
+        let cache_size = config.others.decoder_cache_size.next_power_of_two().max(1);
         InstDecoder {
             instructions_set,
             compressed_instructions,
             config,
-            opcode_map,
+            dispatch,
+            residual,
+            decode_cache: vec![DecodeCacheEntry::INVALID; cache_size],
+            cache_mask: cache_size - 1,
+            c_table,
+            #[cfg(feature = "perf-stats")]
+            cache_hits: 0,
+            #[cfg(feature = "perf-stats")]
+            cache_misses: 0,
         }
     }
 
     #[inline]
-    pub fn slow_path(&mut self, inst: u32) -> Result<&Instruction> {
+    pub fn slow_path(&mut self, inst: u32) -> Result<&'static Instruction> {
         if is_compressed(inst) {
-            self.compressed_instructions
-                .iter()
-                .find(|&&x| x.mask & inst == x.identifier)
-                .ok_or(anyhow::anyhow!("Compressed instruction not found"))
+            // 16位指令字直接索引稠密表，O(1)译码
+            self.c_table
+                .get((inst & 0xFFFF) as usize)
+                .copied()
+                .flatten()
+                .ok_or(anyhow::anyhow!(
+                    "Compressed instruction not found: {:#06x}",
+                    inst & 0xFFFF
+                ))
         } else {
-            // 提取 opcode
-            let opcode = inst & MASK_OPCODE;
+            // 稠密分发表直接索引，表内指令的掩码完全落在索引位域内，命中即精确
+            if let Some(instruction) = self.dispatch[dispatch_index(inst)] {
+                return Ok(instruction);
+            }
 
-            // 尝试在优化过的 opcode_map 中查找
-            let maybe_instruction = self.opcode_map.get(&opcode).and_then(|instructions| {
-                instructions
-                    .iter()
-                    .find(|&&x| x.mask & inst == x.identifier)
-            });
+            // 掩码超出索引位域的指令走按opcode分桶的线性兜底
+            let opcode = inst & MASK_OPCODE;
+            let maybe_instruction = self.residual[opcode as usize]
+                .iter()
+                .copied()
+                .find(|&x| x.mask & inst == x.identifier);
 
             // 根据查找结果进行处理
             match maybe_instruction {
-                // 1. 在 opcode_map 中成功找到，这是最理想的情况
-                Some(instruction) => {
-                    // cache removed: directly return the instruction
-                    Ok(instruction)
-                }
+                Some(instruction) => Ok(instruction),
 
-                // 2. 在 opcode_map 中未找到，需要进一步检查以确定是真错误还是状态不一致
+                // 未找到，需要进一步检查以确定是真错误还是状态不一致
                 None => {
                     // 检查指令是否存在于完整的指令集中，以判断是否为数据结构不一致的 panic 情况
                     if self
@@ -106,9 +293,9 @@ impl InstDecoder {
                         .iter()
                         .any(|&x| x.mask & inst == x.identifier)
                     {
-                        // 如果在这里找到了，说明 opcode_map 构建有误，这是一个不可恢复的逻辑错误
+                        // 如果在这里找到了，说明分发表构建有误，这是一个不可恢复的逻辑错误
                         panic!(
-                            "Instruction found in instructions_set but not in its opcode_map bucket: {:#010x}",
+                            "Instruction found in instructions_set but not in dispatch tables: {:#010x}",
                             inst
                         );
                     } else {
@@ -120,118 +307,214 @@ impl InstDecoder {
         }
     }
 
+    /// 带译码缓存的译码：返回指令及其长度（字节），供调用方直接推进PC
     #[inline(always)]
-    pub fn fast_path(&mut self, inst: u32) -> Result<&Instruction> {
-        // instruction cache removed: always use slow_path
-        self.slow_path(inst)
+    pub fn fast_path(&mut self, pc: u64, inst: u32) -> Result<(&'static Instruction, u64)> {
+        // 稳态下同一批PC反复执行，直接命中缓存即可完全跳过译码
+        let idx = (pc >> 1) as usize & self.cache_mask;
+        let entry = &self.decode_cache[idx];
+        if entry.tag == pc {
+            if let Some(handler) = entry.handler {
+                #[cfg(feature = "perf-stats")]
+                {
+                    self.cache_hits += 1;
+                }
+                return Ok((handler, entry.len as u64));
+            }
+        }
+
+        #[cfg(feature = "perf-stats")]
+        {
+            self.cache_misses += 1;
+        }
+        let handler = self.slow_path(inst)?;
+        let len: u8 = if is_compressed(inst) { 2 } else { 4 };
+        self.decode_cache[idx] = DecodeCacheEntry {
+            tag: pc,
+            handler: Some(handler),
+            len,
+        };
+        Ok((handler, len as u64))
+    }
+
+    /// 译码缓存命中/未命中计数
+    #[cfg(feature = "perf-stats")]
+    pub fn cache_stats(&self) -> (u64, u64) {
+        (self.cache_hits, self.cache_misses)
+    }
+
+    /// 清空译码缓存（代码内存被快照回滚等方式改写后调用）
+    pub fn clear_cache(&mut self) {
+        self.decode_cache.fill(DecodeCacheEntry::INVALID);
+    }
+
+    /// 参考译码：按声明顺序线性扫描完整指令表
+    ///
+    /// 不经稠密分发表、兜底桶与译码缓存，作为模糊校验的基准
+    /// 实现——`fast_path`的结果必须与它一致
+    pub fn lookup_linear(&self, inst: u32) -> Option<&'static Instruction> {
+        if is_compressed(inst) {
+            let low = inst & 0xFFFF;
+            self.compressed_instructions
+                .iter()
+                .copied()
+                .find(|&x| low & x.mask == x.identifier)
+        } else {
+            self.instructions_set
+                .iter()
+                .copied()
+                .find(|&x| inst & x.mask == x.identifier)
+        }
     }
 
+    /// 处理函数在译码表中的稳定序号（持久化块缓存的序列化形态）
+    ///
+    /// 序号空间为常规表与压缩表的拼接，按指针相等查找；只在
+    /// 保存缓存时逐块调用，不在热路径上
+    pub fn handler_index(&self, handler: &'static Instruction) -> Option<u32> {
+        if let Some(i) = self
+            .instructions_set
+            .iter()
+            .position(|&x| std::ptr::eq(x, handler))
+        {
+            return Some(i as u32);
+        }
+        self.compressed_instructions
+            .iter()
+            .position(|&x| std::ptr::eq(x, handler))
+            .map(|i| (self.instructions_set.len() + i) as u32)
+    }
+
+    /// 由序号还原处理函数，[`Self::handler_index`] 的逆映射
+    pub fn handler_by_index(&self, idx: u32) -> Option<&'static Instruction> {
+        let idx = idx as usize;
+        if idx < self.instructions_set.len() {
+            return Some(self.instructions_set[idx]);
+        }
+        self.compressed_instructions
+            .get(idx - self.instructions_set.len())
+            .copied()
+    }
+
+    /// 译码表布局哈希：对两张表按序哈希(name, mask, identifier)
+    ///
+    /// 指令表增删、重排或配置启用的扩展集变化都会改变该值，
+    /// 使按旧布局序号序列化的持久化块缓存整体失效
+    pub fn table_hash(&self) -> u64 {
+        let mut bytes = Vec::new();
+        for &inst in self.instructions_set.iter().chain(&self.compressed_instructions) {
+            bytes.extend_from_slice(inst.name.as_bytes());
+            bytes.extend_from_slice(&inst.mask.to_le_bytes());
+            bytes.extend_from_slice(&inst.identifier.to_le_bytes());
+        }
+        super::block_store::content_hash(&bytes)
+    }
 }
 
-struct FormatR {
-    rs1: u64,
-    rs2: u64,
-    rd: u64,
+pub(crate) struct FormatR {
+    pub(crate) rs1: u64,
+    pub(crate) rs2: u64,
+    pub(crate) rd: u64,
 }
 
 impl FormatR {}
 
 #[inline(always)]
-fn parse_format_r(inst: u32) -> FormatR {
-    let rs1 = inst.bit_range(15..20);
-    let rs2 = inst.bit_range(20..25);
-    let rd = inst.bit_range(7..12);
+pub(crate) fn parse_format_r(inst: u32) -> FormatR {
+    let rs1 = bits::<19, 15>(inst);
+    let rs2 = bits::<24, 20>(inst);
+    let rd = bits::<11, 7>(inst);
     FormatR { rs1, rs2, rd }
 }
 
-struct FormatI {
-    rs1: u64,
-    rd: u64,
-    imm: u64,
+pub(crate) struct FormatI {
+    pub(crate) rs1: u64,
+    pub(crate) rd: u64,
+    pub(crate) imm: u64,
 }
 
 impl FormatI {}
 
 #[inline(always)]
-fn parse_format_i(inst: u32) -> FormatI {
-    let rs1 = inst.bit_range(15..20);
-    let rd = inst.bit_range(7..12);
-    let imm = inst.bit_range(20..32);
+pub(crate) fn parse_format_i(inst: u32) -> FormatI {
+    let rs1 = bits::<19, 15>(inst);
+    let rd = bits::<11, 7>(inst);
+    let imm = bits::<31, 20>(inst);
     // 符号扩展
-    let imm = sign_extend_64(imm, 12);
+    let imm = sign_extend::<12>(imm);
     FormatI { rs1, rd, imm }
 }
 
-struct FormatS {
-    rs1: u64,
-    rs2: u64,
-    imm: u64,
+pub(crate) struct FormatS {
+    pub(crate) rs1: u64,
+    pub(crate) rs2: u64,
+    pub(crate) imm: u64,
 }
 
 impl FormatS {}
 
 #[inline(always)]
-fn parse_format_s(inst: u32) -> FormatS {
-    let rs1 = inst.bit_range(15..20);
-    let rs2 = inst.bit_range(20..25);
-    let imm = inst.bit_range(25..32) << 5 | inst.bit_range(7..12);
+pub(crate) fn parse_format_s(inst: u32) -> FormatS {
+    let rs1 = bits::<19, 15>(inst);
+    let rs2 = bits::<24, 20>(inst);
+    let imm = bits::<31, 25>(inst) << 5 | bits::<11, 7>(inst);
     // 符号扩展
-    let imm = sign_extend_64(imm, 12);
+    let imm = sign_extend::<12>(imm);
     FormatS { rs1, rs2, imm }
 }
 
-struct FormatB {
-    rs1: u64,
-    rs2: u64,
-    imm: u64,
+pub(crate) struct FormatB {
+    pub(crate) rs1: u64,
+    pub(crate) rs2: u64,
+    pub(crate) imm: u64,
 }
 
 impl FormatB {}
 
 #[inline(always)]
-fn parse_format_b(inst: u32) -> FormatB {
-    let rs1 = inst.bit_range(15..20);
-    let rs2 = inst.bit_range(20..25);
-    let imm = (inst.bit(31) as u64) << 12
-        | (inst.bit(7) as u64) << 11
-        | inst.bit_range(25..31) << 5
-        | inst.bit_range(8..12) << 1;
+pub(crate) fn parse_format_b(inst: u32) -> FormatB {
+    let rs1 = bits::<19, 15>(inst);
+    let rs2 = bits::<24, 20>(inst);
+    let imm = bits::<31, 31>(inst) << 12
+        | bits::<7, 7>(inst) << 11
+        | bits::<30, 25>(inst) << 5
+        | bits::<11, 8>(inst) << 1;
     // 符号扩展
-    let imm = sign_extend_64(imm, 13);
+    let imm = sign_extend::<13>(imm);
     FormatB { rs1, rs2, imm }
 }
 
-struct FormatU {
-    rd: u64,
-    imm: u64,
+pub(crate) struct FormatU {
+    pub(crate) rd: u64,
+    pub(crate) imm: u64,
 }
 
 impl FormatU {}
 
 #[inline(always)]
-fn parse_format_u(inst: u32) -> FormatU {
-    let imm = inst.bit_range(12..32) << 12;
-    let rd = inst.bit_range(7..12);
+pub(crate) fn parse_format_u(inst: u32) -> FormatU {
+    let imm = bits::<31, 12>(inst) << 12;
+    let rd = bits::<11, 7>(inst);
     // 符号扩展
-    let imm = sign_extend_64(imm, 32);
+    let imm = sign_extend::<32>(imm);
     FormatU { rd, imm }
 }
 
-struct FormatJ {
-    rd: u64,
-    imm: u64,
+pub(crate) struct FormatJ {
+    pub(crate) rd: u64,
+    pub(crate) imm: u64,
 }
 
 impl FormatJ {}
 
 #[inline(always)]
-fn parse_format_j(inst: u32) -> FormatJ {
-    let rd = inst.bit_range(7..12);
-    let imm = (inst.bit(31) as u64) << 20
-        | inst.bit_range(12..20) << 12
-        | (inst.bit(20) as u64) << 11
-        | inst.bit_range(21..31) << 1;
+pub(crate) fn parse_format_j(inst: u32) -> FormatJ {
+    let rd = bits::<11, 7>(inst);
+    let imm = bits::<31, 31>(inst) << 20
+        | bits::<19, 12>(inst) << 12
+        | bits::<20, 20>(inst) << 11
+        | bits::<30, 21>(inst) << 1;
     // 符号扩展
-    let imm = sign_extend_64(imm, 21);
+    let imm = sign_extend::<21>(imm);
     FormatJ { rd, imm }
 }
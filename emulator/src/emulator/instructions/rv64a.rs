@@ -1,13 +1,204 @@
+//! RV64A 原子指令扩展
+//!
+//! 单hart实现：解释器逐条执行，AMO的读-改-写天然不可分割。
+//! LR 在 [`State`](crate::emulator::State) 上登记保留地址，SC 仅在保留
+//! 命中时写入并返回0，否则返回1；无论成败SC都会清除保留。
+//! aq/rl 内存序位在单hart下无需额外动作，译码掩码已将其忽略。
+
+use anyhow::Result;
+
 use crate::emulator::Emulator;
+use crate::utils::bit_utils::sign_extend;
 
 use super::Instruction;
 use super::insts::*;
+use super::parse_format_r;
+
+/// 32位AMO公共路径：读出旧值（符号扩展）、写入f(旧值, rs2)、旧值写回rd
+#[inline(always)]
+fn amo_w(emu: &mut Emulator, inst: u32, f: fn(u64, u64) -> u64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let addr = emu.get_reg(r.rs1)?;
+    let old = sign_extend::<32>(emu.state.memory.read_word(addr)? as u64);
+    let src = emu.get_reg(r.rs2)?;
+    emu.state.memory.write_word(addr, f(old, src) as u32)?;
+    emu.set_reg(r.rd, old)
+}
+
+/// 64位AMO公共路径
+#[inline(always)]
+fn amo_d(emu: &mut Emulator, inst: u32, f: fn(u64, u64) -> u64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let addr = emu.get_reg(r.rs1)?;
+    let old = emu.state.memory.read_doubleword(addr)?;
+    let src = emu.get_reg(r.rs2)?;
+    emu.state.memory.write_doubleword(addr, f(old, src))?;
+    emu.set_reg(r.rd, old)
+}
 
-pub const RV_A: &[Instruction] = &[Instruction {
-    mask: MASK_MUL,
-    identifier: MATCH_MUL,
-    name: "todo!",
-    execute: |_emu: &mut Emulator, _inst: u32, _pc: u64| {
-        todo!("Implement MUL instruction execution");
+pub const RV_A: &[Instruction] = &[
+    Instruction {
+        mask: MASK_LR_W,
+        identifier: MATCH_LR_W,
+        name: "lr.w",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let addr = emu.get_reg(r.rs1)?;
+            let v = sign_extend::<32>(emu.state.memory.read_word(addr)? as u64);
+            emu.state.reservation = Some(addr);
+            emu.set_reg(r.rd, v)
+        },
+    },
+    Instruction {
+        mask: MASK_LR_D,
+        identifier: MATCH_LR_D,
+        name: "lr.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let addr = emu.get_reg(r.rs1)?;
+            let v = emu.state.memory.read_doubleword(addr)?;
+            emu.state.reservation = Some(addr);
+            emu.set_reg(r.rd, v)
+        },
+    },
+    Instruction {
+        mask: MASK_SC_W,
+        identifier: MATCH_SC_W,
+        name: "sc.w",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let addr = emu.get_reg(r.rs1)?;
+            if emu.state.reservation.take() == Some(addr) {
+                let v = emu.get_reg(r.rs2)?;
+                emu.state.memory.write_word(addr, v as u32)?;
+                emu.set_reg(r.rd, 0)
+            } else {
+                emu.set_reg(r.rd, 1)
+            }
+        },
+    },
+    Instruction {
+        mask: MASK_SC_D,
+        identifier: MATCH_SC_D,
+        name: "sc.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let addr = emu.get_reg(r.rs1)?;
+            if emu.state.reservation.take() == Some(addr) {
+                let v = emu.get_reg(r.rs2)?;
+                emu.state.memory.write_doubleword(addr, v)?;
+                emu.set_reg(r.rd, 0)
+            } else {
+                emu.set_reg(r.rd, 1)
+            }
+        },
+    },
+    Instruction {
+        mask: MASK_AMOSWAP_W,
+        identifier: MATCH_AMOSWAP_W,
+        name: "amoswap.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |_, src| src),
+    },
+    Instruction {
+        mask: MASK_AMOADD_W,
+        identifier: MATCH_AMOADD_W,
+        name: "amoadd.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| old.wrapping_add(src)),
+    },
+    Instruction {
+        mask: MASK_AMOXOR_W,
+        identifier: MATCH_AMOXOR_W,
+        name: "amoxor.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| old ^ src),
+    },
+    Instruction {
+        mask: MASK_AMOAND_W,
+        identifier: MATCH_AMOAND_W,
+        name: "amoand.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| old & src),
+    },
+    Instruction {
+        mask: MASK_AMOOR_W,
+        identifier: MATCH_AMOOR_W,
+        name: "amoor.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| old | src),
+    },
+    Instruction {
+        mask: MASK_AMOMIN_W,
+        identifier: MATCH_AMOMIN_W,
+        name: "amomin.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| (old as i32).min(src as i32) as u64),
+    },
+    Instruction {
+        mask: MASK_AMOMAX_W,
+        identifier: MATCH_AMOMAX_W,
+        name: "amomax.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| (old as i32).max(src as i32) as u64),
+    },
+    Instruction {
+        mask: MASK_AMOMINU_W,
+        identifier: MATCH_AMOMINU_W,
+        name: "amominu.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| (old as u32).min(src as u32) as u64),
+    },
+    Instruction {
+        mask: MASK_AMOMAXU_W,
+        identifier: MATCH_AMOMAXU_W,
+        name: "amomaxu.w",
+        execute: |emu, inst, _pc| amo_w(emu, inst, |old, src| (old as u32).max(src as u32) as u64),
+    },
+    Instruction {
+        mask: MASK_AMOSWAP_D,
+        identifier: MATCH_AMOSWAP_D,
+        name: "amoswap.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |_, src| src),
+    },
+    Instruction {
+        mask: MASK_AMOADD_D,
+        identifier: MATCH_AMOADD_D,
+        name: "amoadd.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| old.wrapping_add(src)),
+    },
+    Instruction {
+        mask: MASK_AMOXOR_D,
+        identifier: MATCH_AMOXOR_D,
+        name: "amoxor.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| old ^ src),
+    },
+    Instruction {
+        mask: MASK_AMOAND_D,
+        identifier: MATCH_AMOAND_D,
+        name: "amoand.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| old & src),
+    },
+    Instruction {
+        mask: MASK_AMOOR_D,
+        identifier: MATCH_AMOOR_D,
+        name: "amoor.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| old | src),
+    },
+    Instruction {
+        mask: MASK_AMOMIN_D,
+        identifier: MATCH_AMOMIN_D,
+        name: "amomin.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| (old as i64).min(src as i64) as u64),
+    },
+    Instruction {
+        mask: MASK_AMOMAX_D,
+        identifier: MATCH_AMOMAX_D,
+        name: "amomax.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| (old as i64).max(src as i64) as u64),
+    },
+    Instruction {
+        mask: MASK_AMOMINU_D,
+        identifier: MATCH_AMOMINU_D,
+        name: "amominu.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| old.min(src)),
+    },
+    Instruction {
+        mask: MASK_AMOMAXU_D,
+        identifier: MATCH_AMOMAXU_D,
+        name: "amomaxu.d",
+        execute: |emu, inst, _pc| amo_d(emu, inst, |old, src| old.max(src)),
     },
-}];
+];
@@ -0,0 +1,540 @@
+//! RV64C 压缩指令扩展
+//!
+//! 表内顺序即译码优先级：更特化的编码（如 c.addi16sp、c.jr）必须
+//! 排在覆盖其编码空间的通用指令（c.lui、c.mv）之前，稠密查找表
+//! 构建时按首个匹配项填充。
+
+use crate::emulator::{Emulator, state::Event};
+
+use super::insts::*;
+use super::*;
+
+/// 压缩寄存器编号（3位）映射到 x8-x15
+#[inline(always)]
+fn creg(r: u64) -> u64 {
+    r + 8
+}
+
+/// CI/CB 等格式中 inst[11:7] 的完整寄存器号
+#[inline(always)]
+pub(crate) fn reg_full(inst: u32) -> u64 {
+    bits::<11, 7>(inst)
+}
+
+/// CR/CSS 格式中 inst[6:2] 的完整寄存器号
+#[inline(always)]
+pub(crate) fn reg_rs2(inst: u32) -> u64 {
+    bits::<6, 2>(inst)
+}
+
+/// CL/CS/CA/CB 格式中 inst[9:7] 的压缩寄存器号
+#[inline(always)]
+pub(crate) fn reg_9_7(inst: u32) -> u64 {
+    creg(bits::<9, 7>(inst))
+}
+
+/// CL/CS/CA 格式中 inst[4:2] 的压缩寄存器号
+#[inline(always)]
+pub(crate) fn reg_4_2(inst: u32) -> u64 {
+    creg(bits::<4, 2>(inst))
+}
+
+/// CI 格式6位立即数（符号扩展）：imm[5]=inst[12], imm[4:0]=inst[6:2]
+#[inline(always)]
+pub(crate) fn imm_ci(inst: u32) -> u64 {
+    sign_extend::<6>(bits::<12, 12>(inst) << 5 | bits::<6, 2>(inst))
+}
+
+/// CI 格式6位移位量：shamt[5]=inst[12], shamt[4:0]=inst[6:2]
+#[inline(always)]
+pub(crate) fn shamt_ci(inst: u32) -> u64 {
+    bits::<12, 12>(inst) << 5 | bits::<6, 2>(inst)
+}
+
+/// CL/CS 格式字偏移：uimm[5:3]=inst[12:10], uimm[2]=inst[6], uimm[6]=inst[5]
+#[inline(always)]
+pub(crate) fn uimm_w(inst: u32) -> u64 {
+    bits::<12, 10>(inst) << 3 | bits::<6, 6>(inst) << 2 | bits::<5, 5>(inst) << 6
+}
+
+/// CL/CS 格式双字偏移：uimm[5:3]=inst[12:10], uimm[7:6]=inst[6:5]
+#[inline(always)]
+pub(crate) fn uimm_d(inst: u32) -> u64 {
+    bits::<12, 10>(inst) << 3 | bits::<6, 5>(inst) << 6
+}
+
+/// CJ 格式跳转偏移（符号扩展12位）
+#[inline(always)]
+pub(crate) fn imm_cj(inst: u32) -> u64 {
+    let imm = bits::<12, 12>(inst) << 11
+        | bits::<11, 11>(inst) << 4
+        | bits::<10, 9>(inst) << 8
+        | bits::<8, 8>(inst) << 10
+        | bits::<7, 7>(inst) << 6
+        | bits::<6, 6>(inst) << 7
+        | bits::<5, 3>(inst) << 1
+        | bits::<2, 2>(inst) << 5;
+    sign_extend::<12>(imm)
+}
+
+/// CB 格式分支偏移（符号扩展9位）
+#[inline(always)]
+pub(crate) fn imm_cb(inst: u32) -> u64 {
+    let imm = bits::<12, 12>(inst) << 8
+        | bits::<11, 10>(inst) << 3
+        | bits::<6, 5>(inst) << 6
+        | bits::<4, 3>(inst) << 1
+        | bits::<2, 2>(inst) << 5;
+    sign_extend::<9>(imm)
+}
+
+/// c.addi4spn 无符号偏移：nzuimm[5:4]=inst[12:11], [9:6]=inst[10:7], [2]=inst[6], [3]=inst[5]
+#[inline(always)]
+pub(crate) fn uimm_addi4spn(inst: u32) -> u64 {
+    bits::<12, 11>(inst) << 4
+        | bits::<10, 7>(inst) << 6
+        | bits::<6, 6>(inst) << 2
+        | bits::<5, 5>(inst) << 3
+}
+
+/// c.addi16sp 立即数（符号扩展10位）：nzimm[9]=inst[12], [4]=inst[6], [6]=inst[5], [8:7]=inst[4:3], [5]=inst[2]
+#[inline(always)]
+pub(crate) fn imm_addi16sp(inst: u32) -> u64 {
+    let imm = bits::<12, 12>(inst) << 9
+        | bits::<6, 6>(inst) << 4
+        | bits::<5, 5>(inst) << 6
+        | bits::<4, 3>(inst) << 7
+        | bits::<2, 2>(inst) << 5;
+    sign_extend::<10>(imm)
+}
+
+/// c.lui 立即数（符号扩展18位）：nzimm[17]=inst[12], [16:12]=inst[6:2]
+#[inline(always)]
+pub(crate) fn imm_clui(inst: u32) -> u64 {
+    let imm = bits::<12, 12>(inst) << 17 | bits::<6, 2>(inst) << 12;
+    sign_extend::<18>(imm)
+}
+
+/// c.lwsp 无符号偏移：uimm[5]=inst[12], [4:2]=inst[6:4], [7:6]=inst[3:2]
+#[inline(always)]
+pub(crate) fn uimm_lwsp(inst: u32) -> u64 {
+    bits::<12, 12>(inst) << 5 | bits::<6, 4>(inst) << 2 | bits::<3, 2>(inst) << 6
+}
+
+/// c.ldsp 无符号偏移：uimm[5]=inst[12], [4:3]=inst[6:5], [8:6]=inst[4:2]
+#[inline(always)]
+pub(crate) fn uimm_ldsp(inst: u32) -> u64 {
+    bits::<12, 12>(inst) << 5 | bits::<6, 5>(inst) << 3 | bits::<4, 2>(inst) << 6
+}
+
+/// c.swsp 无符号偏移：uimm[5:2]=inst[12:9], [7:6]=inst[8:7]
+#[inline(always)]
+pub(crate) fn uimm_swsp(inst: u32) -> u64 {
+    bits::<12, 9>(inst) << 2 | bits::<8, 7>(inst) << 6
+}
+
+/// c.sdsp 无符号偏移：uimm[5:3]=inst[12:10], [8:6]=inst[9:7]
+#[inline(always)]
+pub(crate) fn uimm_sdsp(inst: u32) -> u64 {
+    bits::<12, 10>(inst) << 3 | bits::<9, 7>(inst) << 6
+}
+
+pub const RV_C: &[Instruction] = &[
+    // ---- Quadrant 0 ----
+    Instruction {
+        mask: MASK_C_ADDI4SPN,
+        identifier: MATCH_C_ADDI4SPN,
+        name: "c.addi4spn",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let sp = emu.get_reg(2)?;
+            emu.set_reg(reg_4_2(inst), sp.wrapping_add(uimm_addi4spn(inst)))
+        },
+    },
+    Instruction {
+        mask: MASK_C_LW,
+        identifier: MATCH_C_LW,
+        name: "c.lw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(reg_9_7(inst))?.wrapping_add(uimm_w(inst));
+            let raw = emu.state.memory.read_word(addr)?;
+            emu.set_reg(reg_4_2(inst), sign_extend::<32>(raw as u64))
+        },
+    },
+    Instruction {
+        mask: MASK_C_LD,
+        identifier: MATCH_C_LD,
+        name: "c.ld",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(reg_9_7(inst))?.wrapping_add(uimm_d(inst));
+            let raw = emu.state.memory.read_doubleword(addr)?;
+            emu.set_reg(reg_4_2(inst), raw)
+        },
+    },
+    Instruction {
+        mask: MASK_C_SW,
+        identifier: MATCH_C_SW,
+        name: "c.sw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(reg_9_7(inst))?.wrapping_add(uimm_w(inst));
+            let value = emu.get_reg(reg_4_2(inst))?;
+            emu.state.memory.write_word(addr, value as u32)?;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_SD,
+        identifier: MATCH_C_SD,
+        name: "c.sd",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(reg_9_7(inst))?.wrapping_add(uimm_d(inst));
+            let value = emu.get_reg(reg_4_2(inst))?;
+            emu.state.memory.write_doubleword(addr, value)?;
+            Ok(())
+        },
+    },
+    // ---- Quadrant 1 ----
+    Instruction {
+        mask: MASK_C_ADDI,
+        identifier: MATCH_C_ADDI,
+        name: "c.addi",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            // nzimm=0 即 c.nop，按加零执行
+            let rd = reg_full(inst);
+            let lhs = emu.get_reg(rd)?;
+            emu.set_reg(rd, lhs.wrapping_add(imm_ci(inst)))
+        },
+    },
+    Instruction {
+        mask: MASK_C_ADDIW,
+        identifier: MATCH_C_ADDIW,
+        name: "c.addiw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_full(inst);
+            let lhs = emu.get_reg(rd)?;
+            let result = bits::<31, 0>(lhs.wrapping_add(imm_ci(inst)));
+            emu.set_reg(rd, sign_extend::<32>(result))
+        },
+    },
+    Instruction {
+        mask: MASK_C_LI,
+        identifier: MATCH_C_LI,
+        name: "c.li",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            emu.set_reg(reg_full(inst), imm_ci(inst))
+        },
+    },
+    // c.addi16sp 占用 c.lui 的 rd=2 编码空间，必须排在 c.lui 之前
+    Instruction {
+        mask: MASK_C_ADDI16SP,
+        identifier: MATCH_C_ADDI16SP,
+        name: "c.addi16sp",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let sp = emu.get_reg(2)?;
+            emu.set_reg(2, sp.wrapping_add(imm_addi16sp(inst)))
+        },
+    },
+    Instruction {
+        mask: MASK_C_LUI,
+        identifier: MATCH_C_LUI,
+        name: "c.lui",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            emu.set_reg(reg_full(inst), imm_clui(inst))
+        },
+    },
+    Instruction {
+        mask: MASK_C_SRLI,
+        identifier: MATCH_C_SRLI,
+        name: "c.srli",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = emu.get_reg(rd)?;
+            emu.set_reg(rd, lhs >> shamt_ci(inst))
+        },
+    },
+    Instruction {
+        mask: MASK_C_SRAI,
+        identifier: MATCH_C_SRAI,
+        name: "c.srai",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = emu.get_reg(rd)?;
+            emu.set_reg(rd, (lhs as i64 >> shamt_ci(inst)) as u64)
+        },
+    },
+    Instruction {
+        mask: MASK_C_ANDI,
+        identifier: MATCH_C_ANDI,
+        name: "c.andi",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = emu.get_reg(rd)?;
+            emu.set_reg(rd, lhs & imm_ci(inst))
+        },
+    },
+    Instruction {
+        mask: MASK_C_SUB,
+        identifier: MATCH_C_SUB,
+        name: "c.sub",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = emu.get_reg(rd)?;
+            let rhs = emu.get_reg(reg_4_2(inst))?;
+            emu.set_reg(rd, lhs.wrapping_sub(rhs))
+        },
+    },
+    Instruction {
+        mask: MASK_C_XOR,
+        identifier: MATCH_C_XOR,
+        name: "c.xor",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = emu.get_reg(rd)?;
+            let rhs = emu.get_reg(reg_4_2(inst))?;
+            emu.set_reg(rd, lhs ^ rhs)
+        },
+    },
+    Instruction {
+        mask: MASK_C_OR,
+        identifier: MATCH_C_OR,
+        name: "c.or",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = emu.get_reg(rd)?;
+            let rhs = emu.get_reg(reg_4_2(inst))?;
+            emu.set_reg(rd, lhs | rhs)
+        },
+    },
+    Instruction {
+        mask: MASK_C_AND,
+        identifier: MATCH_C_AND,
+        name: "c.and",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = emu.get_reg(rd)?;
+            let rhs = emu.get_reg(reg_4_2(inst))?;
+            emu.set_reg(rd, lhs & rhs)
+        },
+    },
+    Instruction {
+        mask: MASK_C_SUBW,
+        identifier: MATCH_C_SUBW,
+        name: "c.subw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = bits::<31, 0>(emu.get_reg(rd)?);
+            let rhs = bits::<31, 0>(emu.get_reg(reg_4_2(inst))?);
+            let result = lhs.wrapping_sub(rhs);
+            emu.set_reg(rd, sign_extend::<32>(bits::<31, 0>(result)))
+        },
+    },
+    Instruction {
+        mask: MASK_C_ADDW,
+        identifier: MATCH_C_ADDW,
+        name: "c.addw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_9_7(inst);
+            let lhs = bits::<31, 0>(emu.get_reg(rd)?);
+            let rhs = bits::<31, 0>(emu.get_reg(reg_4_2(inst))?);
+            let result = lhs.wrapping_add(rhs);
+            emu.set_reg(rd, sign_extend::<32>(bits::<31, 0>(result)))
+        },
+    },
+    Instruction {
+        mask: MASK_C_J,
+        identifier: MATCH_C_J,
+        name: "c.j",
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
+            let target = pc.wrapping_add(imm_cj(inst));
+            emu.set_npc(target);
+            emu.trace_branch(pc, true, false, false, target);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_BEQZ,
+        identifier: MATCH_C_BEQZ,
+        name: "c.beqz",
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
+            let taken = emu.get_reg(reg_9_7(inst))? == 0;
+            if taken {
+                emu.set_npc(pc.wrapping_add(imm_cb(inst)));
+            }
+            emu.trace_branch(pc, taken, true, false, 0);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_BNEZ,
+        identifier: MATCH_C_BNEZ,
+        name: "c.bnez",
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
+            let taken = emu.get_reg(reg_9_7(inst))? != 0;
+            if taken {
+                emu.set_npc(pc.wrapping_add(imm_cb(inst)));
+            }
+            emu.trace_branch(pc, taken, true, false, 0);
+            Ok(())
+        },
+    },
+    // ---- Quadrant 2 ----
+    Instruction {
+        mask: MASK_C_SLLI,
+        identifier: MATCH_C_SLLI,
+        name: "c.slli",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_full(inst);
+            let lhs = emu.get_reg(rd)?;
+            emu.set_reg(rd, lhs << shamt_ci(inst))
+        },
+    },
+    Instruction {
+        mask: MASK_C_LWSP,
+        identifier: MATCH_C_LWSP,
+        name: "c.lwsp",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(2)?.wrapping_add(uimm_lwsp(inst));
+            let raw = emu.state.memory.read_word(addr)?;
+            emu.set_reg(reg_full(inst), sign_extend::<32>(raw as u64))
+        },
+    },
+    Instruction {
+        mask: MASK_C_LDSP,
+        identifier: MATCH_C_LDSP,
+        name: "c.ldsp",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(2)?.wrapping_add(uimm_ldsp(inst));
+            let raw = emu.state.memory.read_doubleword(addr)?;
+            emu.set_reg(reg_full(inst), raw)
+        },
+    },
+    // c.ebreak / c.jalr / c.jr 占用 c.add / c.mv 的编码空间，优先匹配
+    Instruction {
+        mask: MASK_C_EBREAK,
+        identifier: MATCH_C_EBREAK,
+        name: "c.ebreak",
+        execute: |emu: &mut Emulator, _inst: u32, _pc: u64| {
+            // 断点补丁打出来的c.ebreak：PC留在断点处并抬出Break事件
+            #[cfg(feature = "gdb")]
+            if emu.gdb_data.is_breakpoint(_pc) {
+                emu.set_npc(_pc);
+                emu.raise_event(Event::Break);
+                return Ok(());
+            }
+            emu.raise_event(Event::Halted(emu.get_reg(10)? as u8));
+            tracing::info!("执行 C.EBREAK 指令, 触发 CPU 停止事件");
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_JALR,
+        identifier: MATCH_C_JALR,
+        name: "c.jalr",
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
+            let target = emu.get_reg(reg_full(inst))? & !1u64;
+            emu.set_npc(target);
+            emu.trace_branch(pc, true, false, true, target);
+            emu.set_reg(1, pc.wrapping_add(2))
+        },
+    },
+    Instruction {
+        mask: MASK_C_JR,
+        identifier: MATCH_C_JR,
+        name: "c.jr",
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
+            let target = emu.get_reg(reg_full(inst))? & !1u64;
+            emu.set_npc(target);
+            emu.trace_branch(pc, true, false, true, target);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_MV,
+        identifier: MATCH_C_MV,
+        name: "c.mv",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let value = emu.get_reg(reg_rs2(inst))?;
+            emu.set_reg(reg_full(inst), value)
+        },
+    },
+    Instruction {
+        mask: MASK_C_ADD,
+        identifier: MATCH_C_ADD,
+        name: "c.add",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = reg_full(inst);
+            let lhs = emu.get_reg(rd)?;
+            let rhs = emu.get_reg(reg_rs2(inst))?;
+            emu.set_reg(rd, lhs.wrapping_add(rhs))
+        },
+    },
+    Instruction {
+        mask: MASK_C_SWSP,
+        identifier: MATCH_C_SWSP,
+        name: "c.swsp",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(2)?.wrapping_add(uimm_swsp(inst));
+            let value = emu.get_reg(reg_rs2(inst))?;
+            emu.state.memory.write_word(addr, value as u32)?;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_SDSP,
+        identifier: MATCH_C_SDSP,
+        name: "c.sdsp",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(2)?.wrapping_add(uimm_sdsp(inst));
+            let value = emu.get_reg(reg_rs2(inst))?;
+            emu.state.memory.write_doubleword(addr, value)?;
+            Ok(())
+        },
+    },
+];
+
+/// C扩展中依赖D扩展的浮点加载/存储，仅在同时启用C与D时注册
+pub const RV_C_D: &[Instruction] = &[
+    Instruction {
+        mask: MASK_C_FLD,
+        identifier: MATCH_C_FLD,
+        name: "c.fld",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(reg_9_7(inst))?.wrapping_add(uimm_d(inst));
+            let raw = emu.state.memory.read_doubleword(addr)?;
+            emu.state.f_regs[reg_4_2(inst) as usize] = raw;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_FSD,
+        identifier: MATCH_C_FSD,
+        name: "c.fsd",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(reg_9_7(inst))?.wrapping_add(uimm_d(inst));
+            let value = emu.state.f_regs[reg_4_2(inst) as usize];
+            emu.state.memory.write_doubleword(addr, value)?;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_FLDSP,
+        identifier: MATCH_C_FLDSP,
+        name: "c.fldsp",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(2)?.wrapping_add(uimm_ldsp(inst));
+            let raw = emu.state.memory.read_doubleword(addr)?;
+            emu.state.f_regs[reg_full(inst) as usize] = raw;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_C_FSDSP,
+        identifier: MATCH_C_FSDSP,
+        name: "c.fsdsp",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let addr = emu.get_reg(2)?.wrapping_add(uimm_sdsp(inst));
+            let value = emu.state.f_regs[reg_rs2(inst) as usize];
+            emu.state.memory.write_doubleword(addr, value)?;
+            Ok(())
+        },
+    },
+];
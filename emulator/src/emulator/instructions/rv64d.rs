@@ -0,0 +1,436 @@
+//! RV64D 双精度浮点扩展
+//!
+//! 双精度值直接占满64位浮点寄存器，无需NaN装箱。舍入与fflags的
+//! 实现口径同 [`rv64f`](super::rv64f)：算术运算用宿主`f64`（RNE），
+//! 浮点转整数按rm字段舍入，fflags累积NV/DZ。精度互转fcvt.s.d的
+//! 窄化舍入采用宿主默认的RNE。
+
+use anyhow::Result;
+
+use crate::emulator::Emulator;
+
+use super::Instruction;
+use super::insts::*;
+use super::rv64f::{
+    FFLAG_DZ, FFLAG_NV, cvt_l, cvt_lu, cvt_w, cvt_wu, parse_rm, parse_rs3, write_f32,
+};
+use super::{parse_format_i, parse_format_r, parse_format_s};
+
+/// 双精度规范NaN
+const CANONICAL_NAN_F64: u64 = 0x7ff8_0000_0000_0000;
+
+/// 从浮点寄存器读出双精度值
+#[inline(always)]
+fn read_f64(emu: &Emulator, reg: u64) -> f64 {
+    f64::from_bits(emu.state.f_regs[reg as usize])
+}
+
+/// 写入双精度值，NaN结果统一规范化
+#[inline(always)]
+fn write_f64(emu: &mut Emulator, reg: u64, v: f64) {
+    emu.state.f_regs[reg as usize] = if v.is_nan() {
+        CANONICAL_NAN_F64
+    } else {
+        v.to_bits()
+    };
+}
+
+/// 是否为信号NaN（NaN且尾数最高位为0）
+#[inline(always)]
+fn is_snan64(v: f64) -> bool {
+    v.is_nan() && v.to_bits() & 0x0008_0000_0000_0000 == 0
+}
+
+/// 运算产生新NaN（操作数均非NaN）或操作数含信号NaN时置NV
+#[inline(always)]
+fn check_nv64(emu: &mut Emulator, result: f64, inputs: &[f64]) {
+    if inputs.iter().any(|v| is_snan64(*v))
+        || (result.is_nan() && !inputs.iter().any(|v| v.is_nan()))
+    {
+        emu.state.accrue_fflags(FFLAG_NV);
+    }
+}
+
+/// 双精度二元算术公共路径
+#[inline(always)]
+fn arith_d(emu: &mut Emulator, inst: u32, f: fn(f64, f64) -> f64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f64(emu, r.rs1), read_f64(emu, r.rs2));
+    let v = f(a, b);
+    check_nv64(emu, v, &[a, b]);
+    write_f64(emu, r.rd, v);
+    Ok(())
+}
+
+/// 双精度FMA公共路径
+#[inline(always)]
+fn fma_d(emu: &mut Emulator, inst: u32, f: fn(f64, f64, f64) -> f64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f64(emu, r.rs1), read_f64(emu, r.rs2));
+    let c = read_f64(emu, parse_rs3(inst));
+    let v = f(a, b, c);
+    check_nv64(emu, v, &[a, b, c]);
+    write_f64(emu, r.rd, v);
+    Ok(())
+}
+
+/// 符号注入公共路径：rs1的数值位加f(s1, s2)的符号位，不经过NaN规范化
+#[inline(always)]
+fn sgnj_d(emu: &mut Emulator, inst: u32, f: fn(u64, u64) -> u64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let a = emu.state.f_regs[r.rs1 as usize];
+    let b = emu.state.f_regs[r.rs2 as usize];
+    emu.state.f_regs[r.rd as usize] = (a & !(1 << 63)) | (f(a, b) & (1 << 63));
+    Ok(())
+}
+
+/// fmin.d/fmax.d：NaN全部时给规范NaN，单侧NaN取另一方，±0按符号区分
+#[inline(always)]
+fn minmax_d(emu: &mut Emulator, inst: u32, min: bool) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f64(emu, r.rs1), read_f64(emu, r.rs2));
+    if is_snan64(a) || is_snan64(b) {
+        emu.state.accrue_fflags(FFLAG_NV);
+    }
+    let v = if a.is_nan() && b.is_nan() {
+        f64::from_bits(CANONICAL_NAN_F64)
+    } else if a.is_nan() {
+        b
+    } else if b.is_nan() {
+        a
+    } else if a == b {
+        if a.is_sign_negative() == min { a } else { b }
+    } else if min {
+        a.min(b)
+    } else {
+        a.max(b)
+    };
+    write_f64(emu, r.rd, v);
+    Ok(())
+}
+
+/// 比较公共路径，NaN语义同rv64f::cmp_s
+#[inline(always)]
+fn cmp_d(emu: &mut Emulator, inst: u32, signaling: bool, f: fn(f64, f64) -> bool) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f64(emu, r.rs1), read_f64(emu, r.rs2));
+    if a.is_nan() || b.is_nan() {
+        if signaling || is_snan64(a) || is_snan64(b) {
+            emu.state.accrue_fflags(FFLAG_NV);
+        }
+        return emu.set_reg(r.rd, 0);
+    }
+    emu.set_reg(r.rd, f(a, b) as u64)
+}
+
+/// fclass的10位分类掩码
+#[inline(always)]
+fn fclass64(v: f64) -> u64 {
+    let neg = v.is_sign_negative();
+    if v.is_nan() {
+        if is_snan64(v) { 1 << 8 } else { 1 << 9 }
+    } else if v.is_infinite() {
+        if neg { 1 << 0 } else { 1 << 7 }
+    } else if v == 0.0 {
+        if neg { 1 << 3 } else { 1 << 4 }
+    } else if v.is_subnormal() {
+        if neg { 1 << 2 } else { 1 << 5 }
+    } else if neg {
+        1 << 1
+    } else {
+        1 << 6
+    }
+}
+
+pub const RV_D: &[Instruction] = &[
+    Instruction {
+        mask: MASK_FLD,
+        identifier: MATCH_FLD,
+        name: "fld",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let i = parse_format_i(inst);
+            let addr = emu.get_reg(i.rs1)?.wrapping_add(i.imm);
+            let raw = emu.state.memory.read_doubleword(addr)?;
+            emu.state.f_regs[i.rd as usize] = raw;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FSD,
+        identifier: MATCH_FSD,
+        name: "fsd",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let s = parse_format_s(inst);
+            let addr = emu.get_reg(s.rs1)?.wrapping_add(s.imm);
+            emu.state
+                .memory
+                .write_doubleword(addr, emu.state.f_regs[s.rs2 as usize])?;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FMADD_D,
+        identifier: MATCH_FMADD_D,
+        name: "fmadd.d",
+        execute: |emu, inst, _pc| fma_d(emu, inst, |a, b, c| a.mul_add(b, c)),
+    },
+    Instruction {
+        mask: MASK_FMSUB_D,
+        identifier: MATCH_FMSUB_D,
+        name: "fmsub.d",
+        execute: |emu, inst, _pc| fma_d(emu, inst, |a, b, c| a.mul_add(b, -c)),
+    },
+    Instruction {
+        mask: MASK_FNMSUB_D,
+        identifier: MATCH_FNMSUB_D,
+        name: "fnmsub.d",
+        execute: |emu, inst, _pc| fma_d(emu, inst, |a, b, c| (-a).mul_add(b, c)),
+    },
+    Instruction {
+        mask: MASK_FNMADD_D,
+        identifier: MATCH_FNMADD_D,
+        name: "fnmadd.d",
+        execute: |emu, inst, _pc| fma_d(emu, inst, |a, b, c| (-a).mul_add(b, -c)),
+    },
+    Instruction {
+        mask: MASK_FADD_D,
+        identifier: MATCH_FADD_D,
+        name: "fadd.d",
+        execute: |emu, inst, _pc| arith_d(emu, inst, |a, b| a + b),
+    },
+    Instruction {
+        mask: MASK_FSUB_D,
+        identifier: MATCH_FSUB_D,
+        name: "fsub.d",
+        execute: |emu, inst, _pc| arith_d(emu, inst, |a, b| a - b),
+    },
+    Instruction {
+        mask: MASK_FMUL_D,
+        identifier: MATCH_FMUL_D,
+        name: "fmul.d",
+        execute: |emu, inst, _pc| arith_d(emu, inst, |a, b| a * b),
+    },
+    Instruction {
+        mask: MASK_FDIV_D,
+        identifier: MATCH_FDIV_D,
+        name: "fdiv.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let (a, b) = (read_f64(emu, r.rs1), read_f64(emu, r.rs2));
+            if b == 0.0 && a.is_finite() && a != 0.0 {
+                emu.state.accrue_fflags(FFLAG_DZ);
+            }
+            let v = a / b;
+            check_nv64(emu, v, &[a, b]);
+            write_f64(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FSQRT_D,
+        identifier: MATCH_FSQRT_D,
+        name: "fsqrt.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let a = read_f64(emu, r.rs1);
+            let v = a.sqrt();
+            check_nv64(emu, v, &[a]);
+            write_f64(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FSGNJ_D,
+        identifier: MATCH_FSGNJ_D,
+        name: "fsgnj.d",
+        execute: |emu, inst, _pc| sgnj_d(emu, inst, |_, b| b),
+    },
+    Instruction {
+        mask: MASK_FSGNJN_D,
+        identifier: MATCH_FSGNJN_D,
+        name: "fsgnjn.d",
+        execute: |emu, inst, _pc| sgnj_d(emu, inst, |_, b| !b),
+    },
+    Instruction {
+        mask: MASK_FSGNJX_D,
+        identifier: MATCH_FSGNJX_D,
+        name: "fsgnjx.d",
+        execute: |emu, inst, _pc| sgnj_d(emu, inst, |a, b| a ^ b),
+    },
+    Instruction {
+        mask: MASK_FMIN_D,
+        identifier: MATCH_FMIN_D,
+        name: "fmin.d",
+        execute: |emu, inst, _pc| minmax_d(emu, inst, true),
+    },
+    Instruction {
+        mask: MASK_FMAX_D,
+        identifier: MATCH_FMAX_D,
+        name: "fmax.d",
+        execute: |emu, inst, _pc| minmax_d(emu, inst, false),
+    },
+    Instruction {
+        mask: MASK_FCVT_S_D,
+        identifier: MATCH_FCVT_S_D,
+        name: "fcvt.s.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let a = read_f64(emu, r.rs1);
+            if is_snan64(a) {
+                emu.state.accrue_fflags(FFLAG_NV);
+            }
+            write_f32(emu, r.rd, a as f32);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_D_S,
+        identifier: MATCH_FCVT_D_S,
+        name: "fcvt.d.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let a = super::rv64f::read_f32(emu, r.rs1);
+            if super::rv64f::is_snan32(a) {
+                emu.state.accrue_fflags(FFLAG_NV);
+            }
+            write_f64(emu, r.rd, a as f64);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FEQ_D,
+        identifier: MATCH_FEQ_D,
+        name: "feq.d",
+        execute: |emu, inst, _pc| cmp_d(emu, inst, false, |a, b| a == b),
+    },
+    Instruction {
+        mask: MASK_FLT_D,
+        identifier: MATCH_FLT_D,
+        name: "flt.d",
+        execute: |emu, inst, _pc| cmp_d(emu, inst, true, |a, b| a < b),
+    },
+    Instruction {
+        mask: MASK_FLE_D,
+        identifier: MATCH_FLE_D,
+        name: "fle.d",
+        execute: |emu, inst, _pc| cmp_d(emu, inst, true, |a, b| a <= b),
+    },
+    Instruction {
+        mask: MASK_FCLASS_D,
+        identifier: MATCH_FCLASS_D,
+        name: "fclass.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f64(emu, r.rs1);
+            emu.set_reg(r.rd, fclass64(v))
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_W_D,
+        identifier: MATCH_FCVT_W_D,
+        name: "fcvt.w.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f64(emu, r.rs1);
+            let out = cvt_w(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_WU_D,
+        identifier: MATCH_FCVT_WU_D,
+        name: "fcvt.wu.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f64(emu, r.rs1);
+            let out = cvt_wu(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_L_D,
+        identifier: MATCH_FCVT_L_D,
+        name: "fcvt.l.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f64(emu, r.rs1);
+            let out = cvt_l(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_LU_D,
+        identifier: MATCH_FCVT_LU_D,
+        name: "fcvt.lu.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f64(emu, r.rs1);
+            let out = cvt_lu(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_D_W,
+        identifier: MATCH_FCVT_D_W,
+        name: "fcvt.d.w",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as i32 as f64;
+            write_f64(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_D_WU,
+        identifier: MATCH_FCVT_D_WU,
+        name: "fcvt.d.wu",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as u32 as f64;
+            write_f64(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_D_L,
+        identifier: MATCH_FCVT_D_L,
+        name: "fcvt.d.l",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as i64 as f64;
+            write_f64(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_D_LU,
+        identifier: MATCH_FCVT_D_LU,
+        name: "fcvt.d.lu",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as f64;
+            write_f64(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FMV_X_D,
+        identifier: MATCH_FMV_X_D,
+        name: "fmv.x.d",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let bits = emu.state.f_regs[r.rs1 as usize];
+            emu.set_reg(r.rd, bits)
+        },
+    },
+    Instruction {
+        mask: MASK_FMV_D_X,
+        identifier: MATCH_FMV_D_X,
+        name: "fmv.d.x",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            emu.state.f_regs[r.rd as usize] = emu.get_reg(r.rs1)?;
+            Ok(())
+        },
+    },
+];
@@ -0,0 +1,517 @@
+//! RV64F 单精度浮点扩展
+//!
+//! 浮点寄存器按FLEN=64实现（[`State`](crate::emulator::State) 的
+//! `f_regs`），单精度值按规范NaN装箱存放（高32位全1）。运算借助宿主
+//! `f32`完成，算术运算的舍入为宿主默认的RNE；浮点转整数按指令rm字段
+//! 实现全部五种舍入模式。fflags累积NV/DZ以及转换越界，宿主浮点难以
+//! 观测的NX/OF/UF不做跟踪。
+//!
+//! 本模块同时提供与精度无关的公共设施（舍入、整数转换、fflags位），
+//! 供 [`rv64d`](super::rv64d) 复用。
+
+use anyhow::Result;
+
+use crate::emulator::Emulator;
+use crate::utils::bit_utils::bits;
+
+use super::Instruction;
+use super::insts::*;
+use super::{parse_format_i, parse_format_r, parse_format_s};
+
+/// fflags：无效操作
+pub(super) const FFLAG_NV: u64 = 0x10;
+/// fflags：除零
+pub(super) const FFLAG_DZ: u64 = 0x08;
+
+/// 单精度规范NaN
+const CANONICAL_NAN_F32: u32 = 0x7fc0_0000;
+
+/// 从浮点寄存器读出装箱后的32位原始位型
+/// （未正确装箱的值按规范要求视为规范NaN）
+#[inline(always)]
+pub(super) fn bits32(emu: &Emulator, reg: u64) -> u32 {
+    let bits = emu.state.f_regs[reg as usize];
+    if bits >> 32 == 0xffff_ffff {
+        bits as u32
+    } else {
+        CANONICAL_NAN_F32
+    }
+}
+
+/// 从浮点寄存器读出单精度值
+#[inline(always)]
+pub(super) fn read_f32(emu: &Emulator, reg: u64) -> f32 {
+    f32::from_bits(bits32(emu, reg))
+}
+
+/// NaN装箱写入32位原始位型
+#[inline(always)]
+pub(super) fn write_bits32(emu: &mut Emulator, reg: u64, bits: u32) {
+    emu.state.f_regs[reg as usize] = 0xffff_ffff_0000_0000 | bits as u64;
+}
+
+/// NaN装箱写入单精度值，NaN结果统一规范化
+#[inline(always)]
+pub(super) fn write_f32(emu: &mut Emulator, reg: u64, v: f32) {
+    let bits = if v.is_nan() {
+        CANONICAL_NAN_F32
+    } else {
+        v.to_bits()
+    };
+    write_bits32(emu, reg, bits);
+}
+
+/// 是否为信号NaN（NaN且尾数最高位为0）
+#[inline(always)]
+pub(super) fn is_snan32(v: f32) -> bool {
+    v.is_nan() && v.to_bits() & 0x0040_0000 == 0
+}
+
+/// 运算产生新NaN（操作数均非NaN）或操作数含信号NaN时置NV
+#[inline(always)]
+fn check_nv32(emu: &mut Emulator, result: f32, inputs: &[f32]) {
+    if inputs.iter().any(|v| is_snan32(*v))
+        || (result.is_nan() && !inputs.iter().any(|v| v.is_nan()))
+    {
+        emu.state.accrue_fflags(FFLAG_NV);
+    }
+}
+
+/// 按rm字段舍入到整数值（0b111为动态模式，取frm）
+pub(super) fn round_rm(emu: &Emulator, v: f64, rm: u32) -> f64 {
+    let rm = if rm == 0b111 { emu.state.get_frm() } else { rm };
+    match rm {
+        0b001 => v.trunc(),  // RTZ
+        0b010 => v.floor(),  // RDN
+        0b011 => v.ceil(),   // RUP
+        0b100 => v.round(),  // RMM（中点远离零）
+        _ => v.round_ties_even(), // RNE
+    }
+}
+
+/// 浮点转32位有符号整数：NaN/越界置NV并饱和，结果符号扩展
+pub(super) fn cvt_w(emu: &mut Emulator, v: f64, rm: u32) -> u64 {
+    let r = round_rm(emu, v, rm);
+    if r.is_nan() || r >= 2147483648.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        i32::MAX as i64 as u64
+    } else if r < -2147483648.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        i32::MIN as i64 as u64
+    } else {
+        r as i32 as i64 as u64
+    }
+}
+
+/// 浮点转32位无符号整数（结果按RV64惯例符号扩展）
+pub(super) fn cvt_wu(emu: &mut Emulator, v: f64, rm: u32) -> u64 {
+    let r = round_rm(emu, v, rm);
+    if r.is_nan() || r >= 4294967296.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        u32::MAX as i32 as i64 as u64
+    } else if r < 0.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        0
+    } else {
+        r as u32 as i32 as i64 as u64
+    }
+}
+
+/// 浮点转64位有符号整数
+pub(super) fn cvt_l(emu: &mut Emulator, v: f64, rm: u32) -> u64 {
+    let r = round_rm(emu, v, rm);
+    if r.is_nan() || r >= 9223372036854775808.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        i64::MAX as u64
+    } else if r < -9223372036854775808.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        i64::MIN as u64
+    } else {
+        r as i64 as u64
+    }
+}
+
+/// 浮点转64位无符号整数
+pub(super) fn cvt_lu(emu: &mut Emulator, v: f64, rm: u32) -> u64 {
+    let r = round_rm(emu, v, rm);
+    if r.is_nan() || r >= 18446744073709551616.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        u64::MAX
+    } else if r < 0.0 {
+        emu.state.accrue_fflags(FFLAG_NV);
+        0
+    } else {
+        r as u64
+    }
+}
+
+/// FMA编码的rs3字段（R4格式，[31:27]）
+#[inline(always)]
+pub(super) fn parse_rs3(inst: u32) -> u64 {
+    bits::<31, 27>(inst)
+}
+
+/// 指令编码中的rm字段（[14:12]）
+#[inline(always)]
+pub(super) fn parse_rm(inst: u32) -> u32 {
+    bits::<14, 12>(inst) as u32
+}
+
+/// 单精度二元算术公共路径
+#[inline(always)]
+fn arith_s(emu: &mut Emulator, inst: u32, f: fn(f32, f32) -> f32) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f32(emu, r.rs1), read_f32(emu, r.rs2));
+    let v = f(a, b);
+    check_nv32(emu, v, &[a, b]);
+    write_f32(emu, r.rd, v);
+    Ok(())
+}
+
+/// 单精度FMA公共路径：f(a, b, c)，内部乘加只舍入一次
+#[inline(always)]
+fn fma_s(emu: &mut Emulator, inst: u32, f: fn(f32, f32, f32) -> f32) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f32(emu, r.rs1), read_f32(emu, r.rs2));
+    let c = read_f32(emu, parse_rs3(inst));
+    let v = f(a, b, c);
+    check_nv32(emu, v, &[a, b, c]);
+    write_f32(emu, r.rd, v);
+    Ok(())
+}
+
+/// 符号注入公共路径：在原始位型上合成rs1的数值位与f(s1, s2)的符号位
+#[inline(always)]
+fn sgnj_s(emu: &mut Emulator, inst: u32, f: fn(u32, u32) -> u32) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (bits32(emu, r.rs1), bits32(emu, r.rs2));
+    write_bits32(emu, r.rd, (a & 0x7fff_ffff) | (f(a, b) & 0x8000_0000));
+    Ok(())
+}
+
+/// fmin.s/fmax.s：NaN全部时给规范NaN，单侧NaN取另一方，±0按符号区分
+#[inline(always)]
+fn minmax_s(emu: &mut Emulator, inst: u32, min: bool) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f32(emu, r.rs1), read_f32(emu, r.rs2));
+    if is_snan32(a) || is_snan32(b) {
+        emu.state.accrue_fflags(FFLAG_NV);
+    }
+    let v = if a.is_nan() && b.is_nan() {
+        f32::from_bits(CANONICAL_NAN_F32)
+    } else if a.is_nan() {
+        b
+    } else if b.is_nan() {
+        a
+    } else if a == b {
+        // 覆盖±0：min取负零，max取正零
+        if a.is_sign_negative() == min { a } else { b }
+    } else if min {
+        a.min(b)
+    } else {
+        a.max(b)
+    };
+    write_f32(emu, r.rd, v);
+    Ok(())
+}
+
+/// 比较公共路径：NaN结果恒为0；signaling=true（flt/fle）时任一NaN即置NV，
+/// 否则（feq）仅对信号NaN置NV
+#[inline(always)]
+fn cmp_s(emu: &mut Emulator, inst: u32, signaling: bool, f: fn(f32, f32) -> bool) -> Result<()> {
+    let r = parse_format_r(inst);
+    let (a, b) = (read_f32(emu, r.rs1), read_f32(emu, r.rs2));
+    if a.is_nan() || b.is_nan() {
+        if signaling || is_snan32(a) || is_snan32(b) {
+            emu.state.accrue_fflags(FFLAG_NV);
+        }
+        return emu.set_reg(r.rd, 0);
+    }
+    emu.set_reg(r.rd, f(a, b) as u64)
+}
+
+/// fclass的10位分类掩码
+#[inline(always)]
+fn fclass32(v: f32) -> u64 {
+    let neg = v.is_sign_negative();
+    if v.is_nan() {
+        if is_snan32(v) { 1 << 8 } else { 1 << 9 }
+    } else if v.is_infinite() {
+        if neg { 1 << 0 } else { 1 << 7 }
+    } else if v == 0.0 {
+        if neg { 1 << 3 } else { 1 << 4 }
+    } else if v.is_subnormal() {
+        if neg { 1 << 2 } else { 1 << 5 }
+    } else if neg {
+        1 << 1
+    } else {
+        1 << 6
+    }
+}
+
+pub const RV_F: &[Instruction] = &[
+    Instruction {
+        mask: MASK_FLW,
+        identifier: MATCH_FLW,
+        name: "flw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let i = parse_format_i(inst);
+            let addr = emu.get_reg(i.rs1)?.wrapping_add(i.imm);
+            let raw = emu.state.memory.read_word(addr)?;
+            write_bits32(emu, i.rd, raw);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FSW,
+        identifier: MATCH_FSW,
+        name: "fsw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let s = parse_format_s(inst);
+            let addr = emu.get_reg(s.rs1)?.wrapping_add(s.imm);
+            emu.state
+                .memory
+                .write_word(addr, emu.state.f_regs[s.rs2 as usize] as u32)?;
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FMADD_S,
+        identifier: MATCH_FMADD_S,
+        name: "fmadd.s",
+        execute: |emu, inst, _pc| fma_s(emu, inst, |a, b, c| a.mul_add(b, c)),
+    },
+    Instruction {
+        mask: MASK_FMSUB_S,
+        identifier: MATCH_FMSUB_S,
+        name: "fmsub.s",
+        execute: |emu, inst, _pc| fma_s(emu, inst, |a, b, c| a.mul_add(b, -c)),
+    },
+    Instruction {
+        mask: MASK_FNMSUB_S,
+        identifier: MATCH_FNMSUB_S,
+        name: "fnmsub.s",
+        execute: |emu, inst, _pc| fma_s(emu, inst, |a, b, c| (-a).mul_add(b, c)),
+    },
+    Instruction {
+        mask: MASK_FNMADD_S,
+        identifier: MATCH_FNMADD_S,
+        name: "fnmadd.s",
+        execute: |emu, inst, _pc| fma_s(emu, inst, |a, b, c| (-a).mul_add(b, -c)),
+    },
+    Instruction {
+        mask: MASK_FADD_S,
+        identifier: MATCH_FADD_S,
+        name: "fadd.s",
+        execute: |emu, inst, _pc| arith_s(emu, inst, |a, b| a + b),
+    },
+    Instruction {
+        mask: MASK_FSUB_S,
+        identifier: MATCH_FSUB_S,
+        name: "fsub.s",
+        execute: |emu, inst, _pc| arith_s(emu, inst, |a, b| a - b),
+    },
+    Instruction {
+        mask: MASK_FMUL_S,
+        identifier: MATCH_FMUL_S,
+        name: "fmul.s",
+        execute: |emu, inst, _pc| arith_s(emu, inst, |a, b| a * b),
+    },
+    Instruction {
+        mask: MASK_FDIV_S,
+        identifier: MATCH_FDIV_S,
+        name: "fdiv.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let (a, b) = (read_f32(emu, r.rs1), read_f32(emu, r.rs2));
+            if b == 0.0 && a.is_finite() && a != 0.0 {
+                emu.state.accrue_fflags(FFLAG_DZ);
+            }
+            let v = a / b;
+            check_nv32(emu, v, &[a, b]);
+            write_f32(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FSQRT_S,
+        identifier: MATCH_FSQRT_S,
+        name: "fsqrt.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let a = read_f32(emu, r.rs1);
+            let v = a.sqrt();
+            check_nv32(emu, v, &[a]);
+            write_f32(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FSGNJ_S,
+        identifier: MATCH_FSGNJ_S,
+        name: "fsgnj.s",
+        execute: |emu, inst, _pc| sgnj_s(emu, inst, |_, b| b),
+    },
+    Instruction {
+        mask: MASK_FSGNJN_S,
+        identifier: MATCH_FSGNJN_S,
+        name: "fsgnjn.s",
+        execute: |emu, inst, _pc| sgnj_s(emu, inst, |_, b| !b),
+    },
+    Instruction {
+        mask: MASK_FSGNJX_S,
+        identifier: MATCH_FSGNJX_S,
+        name: "fsgnjx.s",
+        execute: |emu, inst, _pc| sgnj_s(emu, inst, |a, b| a ^ b),
+    },
+    Instruction {
+        mask: MASK_FMIN_S,
+        identifier: MATCH_FMIN_S,
+        name: "fmin.s",
+        execute: |emu, inst, _pc| minmax_s(emu, inst, true),
+    },
+    Instruction {
+        mask: MASK_FMAX_S,
+        identifier: MATCH_FMAX_S,
+        name: "fmax.s",
+        execute: |emu, inst, _pc| minmax_s(emu, inst, false),
+    },
+    Instruction {
+        mask: MASK_FCVT_W_S,
+        identifier: MATCH_FCVT_W_S,
+        name: "fcvt.w.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f32(emu, r.rs1) as f64;
+            let out = cvt_w(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_WU_S,
+        identifier: MATCH_FCVT_WU_S,
+        name: "fcvt.wu.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f32(emu, r.rs1) as f64;
+            let out = cvt_wu(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_L_S,
+        identifier: MATCH_FCVT_L_S,
+        name: "fcvt.l.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f32(emu, r.rs1) as f64;
+            let out = cvt_l(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_LU_S,
+        identifier: MATCH_FCVT_LU_S,
+        name: "fcvt.lu.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f32(emu, r.rs1) as f64;
+            let out = cvt_lu(emu, v, parse_rm(inst));
+            emu.set_reg(r.rd, out)
+        },
+    },
+    Instruction {
+        mask: MASK_FMV_X_W,
+        identifier: MATCH_FMV_X_W,
+        name: "fmv.x.w",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            // 按位搬运低32位并符号扩展，不做NaN装箱校验
+            let bits = emu.state.f_regs[r.rs1 as usize] as u32;
+            emu.set_reg(r.rd, bits as i32 as i64 as u64)
+        },
+    },
+    Instruction {
+        mask: MASK_FEQ_S,
+        identifier: MATCH_FEQ_S,
+        name: "feq.s",
+        execute: |emu, inst, _pc| cmp_s(emu, inst, false, |a, b| a == b),
+    },
+    Instruction {
+        mask: MASK_FLT_S,
+        identifier: MATCH_FLT_S,
+        name: "flt.s",
+        execute: |emu, inst, _pc| cmp_s(emu, inst, true, |a, b| a < b),
+    },
+    Instruction {
+        mask: MASK_FLE_S,
+        identifier: MATCH_FLE_S,
+        name: "fle.s",
+        execute: |emu, inst, _pc| cmp_s(emu, inst, true, |a, b| a <= b),
+    },
+    Instruction {
+        mask: MASK_FCLASS_S,
+        identifier: MATCH_FCLASS_S,
+        name: "fclass.s",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = read_f32(emu, r.rs1);
+            emu.set_reg(r.rd, fclass32(v))
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_S_W,
+        identifier: MATCH_FCVT_S_W,
+        name: "fcvt.s.w",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as i32 as f32;
+            write_f32(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_S_WU,
+        identifier: MATCH_FCVT_S_WU,
+        name: "fcvt.s.wu",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as u32 as f32;
+            write_f32(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_S_L,
+        identifier: MATCH_FCVT_S_L,
+        name: "fcvt.s.l",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as i64 as f32;
+            write_f32(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FCVT_S_LU,
+        identifier: MATCH_FCVT_S_LU,
+        name: "fcvt.s.lu",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let v = emu.get_reg(r.rs1)? as f32;
+            write_f32(emu, r.rd, v);
+            Ok(())
+        },
+    },
+    Instruction {
+        mask: MASK_FMV_W_X,
+        identifier: MATCH_FMV_W_X,
+        name: "fmv.w.x",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let r = parse_format_r(inst);
+            let bits = emu.get_reg(r.rs1)? as u32;
+            write_bits32(emu, r.rd, bits);
+            Ok(())
+        },
+    },
+];
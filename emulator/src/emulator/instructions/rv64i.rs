@@ -30,7 +30,8 @@ pub const RV_I: &[Instruction] = &[
             let j = parse_format_j(inst);
             emu.set_reg(j.rd, pc.wrapping_add(4))?;
             let target = pc.wrapping_add(j.imm);
-            if is_inst_addr_misaligned(target) {
+            emu.trace_branch(pc, true, false, false, target);
+            if emu.is_inst_addr_misaligned(target) {
                 emu.execption = Some(InstructionAddressMisaligned { addr: target });
                 return Ok(());
             }
@@ -45,7 +46,8 @@ pub const RV_I: &[Instruction] = &[
         execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let target = (emu.get_reg(i.rs1)?).wrapping_add(i.imm) & !1u64;
-            if is_inst_addr_misaligned(target) {
+            emu.trace_branch(pc, true, false, true, target);
+            if emu.is_inst_addr_misaligned(target) {
                 emu.execption = Some(InstructionAddressMisaligned { addr: target });
                 return Ok(());
             }
@@ -61,9 +63,11 @@ pub const RV_I: &[Instruction] = &[
             let b = parse_format_b(inst);
             let lhs = emu.get_reg(b.rs1)?;
             let rhs = emu.get_reg(b.rs2)?;
-            if lhs == rhs {
+            let taken = lhs == rhs;
+            emu.trace_branch(pc, taken, true, false, 0);
+            if taken {
                 let target = pc.wrapping_add(b.imm);
-                if is_inst_addr_misaligned(target) {
+                if emu.is_inst_addr_misaligned(target) {
                     emu.execption = Some(InstructionAddressMisaligned { addr: target });
                     return Ok(());
                 }
@@ -80,9 +84,11 @@ pub const RV_I: &[Instruction] = &[
             let b = parse_format_b(inst);
             let lhs = emu.get_reg(b.rs1)?;
             let rhs = emu.get_reg(b.rs2)?;
-            if lhs != rhs {
+            let taken = lhs != rhs;
+            emu.trace_branch(pc, taken, true, false, 0);
+            if taken {
                 let target = pc.wrapping_add(b.imm);
-                if is_inst_addr_misaligned(target) {
+                if emu.is_inst_addr_misaligned(target) {
                     emu.execption = Some(InstructionAddressMisaligned { addr: target });
                     return Ok(());
                 }
@@ -99,9 +105,11 @@ pub const RV_I: &[Instruction] = &[
             let b = parse_format_b(inst);
             let lhs = emu.get_reg(b.rs1)?;
             let rhs = emu.get_reg(b.rs2)?;
-            if (lhs as i64) < (rhs as i64) {
+            let taken = (lhs as i64) < (rhs as i64);
+            emu.trace_branch(pc, taken, true, false, 0);
+            if taken {
                 let target = pc.wrapping_add(b.imm);
-                if is_inst_addr_misaligned(target) {
+                if emu.is_inst_addr_misaligned(target) {
                     emu.execption = Some(InstructionAddressMisaligned { addr: target });
                     return Ok(());
                 }
@@ -118,9 +126,11 @@ pub const RV_I: &[Instruction] = &[
             let b = parse_format_b(inst);
             let lhs = emu.get_reg(b.rs1)?;
             let rhs = emu.get_reg(b.rs2)?;
-            if (lhs as i64) >= (rhs as i64) {
+            let taken = (lhs as i64) >= (rhs as i64);
+            emu.trace_branch(pc, taken, true, false, 0);
+            if taken {
                 let target = pc.wrapping_add(b.imm);
-                if is_inst_addr_misaligned(target) {
+                if emu.is_inst_addr_misaligned(target) {
                     emu.execption = Some(InstructionAddressMisaligned { addr: target });
                     return Ok(());
                 }
@@ -137,9 +147,11 @@ pub const RV_I: &[Instruction] = &[
             let b = parse_format_b(inst);
             let lhs = emu.get_reg(b.rs1)?;
             let rhs = emu.get_reg(b.rs2)?;
-            if lhs < rhs {
+            let taken = lhs < rhs;
+            emu.trace_branch(pc, taken, true, false, 0);
+            if taken {
                 let target = pc.wrapping_add(b.imm);
-                if is_inst_addr_misaligned(target) {
+                if emu.is_inst_addr_misaligned(target) {
                     emu.execption = Some(InstructionAddressMisaligned { addr: target });
                     return Ok(());
                 }
@@ -156,9 +168,11 @@ pub const RV_I: &[Instruction] = &[
             let b = parse_format_b(inst);
             let lhs = emu.get_reg(b.rs1)?;
             let rhs = emu.get_reg(b.rs2)?;
-            if lhs >= rhs {
+            let taken = lhs >= rhs;
+            emu.trace_branch(pc, taken, true, false, 0);
+            if taken {
                 let target = pc.wrapping_add(b.imm);
-                if is_inst_addr_misaligned(target) {
+                if emu.is_inst_addr_misaligned(target) {
                     emu.execption = Some(InstructionAddressMisaligned { addr: target });
                     return Ok(());
                 }
@@ -171,11 +185,12 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_LB,
         identifier: MATCH_LB,
         name: "lb",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let addr = emu.get_reg(i.rs1)?.wrapping_add(i.imm);
             let raw = emu.state.memory.read_byte(addr)?;
-            let value = sign_extend_64(raw as u64, 8);
+            let value = sign_extend::<8>(raw as u64);
+            emu.trace_mem(pc, addr, 1, false, value);
             emu.set_reg(i.rd, value)
         },
     },
@@ -183,11 +198,12 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_LH,
         identifier: MATCH_LH,
         name: "lh",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let addr = emu.get_reg(i.rs1)?.wrapping_add(i.imm);
             let raw = emu.state.memory.read_halfword(addr)?;
-            let value = sign_extend_64(raw as u64, 16);
+            let value = sign_extend::<16>(raw as u64);
+            emu.trace_mem(pc, addr, 2, false, value);
             emu.set_reg(i.rd, value)
         },
     },
@@ -195,11 +211,12 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_LW,
         identifier: MATCH_LW,
         name: "lw",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let addr = emu.get_reg(i.rs1)?.wrapping_add(i.imm);
             let raw = emu.state.memory.read_word(addr)?;
-            let value = sign_extend_64(raw as u64, 32);
+            let value = sign_extend::<32>(raw as u64);
+            emu.trace_mem(pc, addr, 4, false, value);
             emu.set_reg(i.rd, value)
         },
     },
@@ -207,10 +224,11 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_LBU,
         identifier: MATCH_LBU,
         name: "lbu",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let addr = emu.get_reg(i.rs1)?.wrapping_add(i.imm);
             let raw = emu.state.memory.read_byte(addr)?;
+            emu.trace_mem(pc, addr, 1, false, raw as u64);
             emu.set_reg(i.rd, raw as u64)
         },
     },
@@ -218,10 +236,11 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_LHU,
         identifier: MATCH_LHU,
         name: "lhu",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let addr = emu.get_reg(i.rs1)?.wrapping_add(i.imm);
             let raw = emu.state.memory.read_halfword(addr)?;
+            emu.trace_mem(pc, addr, 2, false, raw as u64);
             emu.set_reg(i.rd, raw as u64)
         },
     },
@@ -229,11 +248,12 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_SB,
         identifier: MATCH_SB,
         name: "sb",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let s = parse_format_s(inst);
             let addr = emu.get_reg(s.rs1)?.wrapping_add(s.imm);
             let value = emu.get_reg(s.rs2)?;
             emu.state.memory.write_byte(addr, (value & 0xFF) as u8)?;
+            emu.trace_mem(pc, addr, 1, true, value & 0xFF);
             Ok(())
         },
     },
@@ -241,13 +261,14 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_SH,
         identifier: MATCH_SH,
         name: "sh",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let s = parse_format_s(inst);
             let addr = emu.get_reg(s.rs1)?.wrapping_add(s.imm);
             let value = emu.get_reg(s.rs2)?;
             emu.state
                 .memory
                 .write_halfword(addr, (value & 0xFFFF) as u16)?;
+            emu.trace_mem(pc, addr, 2, true, value & 0xFFFF);
             Ok(())
         },
     },
@@ -255,13 +276,14 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_SW,
         identifier: MATCH_SW,
         name: "sw",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let s = parse_format_s(inst);
             let addr = emu.get_reg(s.rs1)?.wrapping_add(s.imm);
             let value = emu.get_reg(s.rs2)?;
             emu.state
                 .memory
                 .write_word(addr, (value & 0xFFFFFFFF) as u32)?;
+            emu.trace_mem(pc, addr, 4, true, value & 0xFFFFFFFF);
             Ok(())
         },
     },
@@ -501,11 +523,74 @@ pub const RV_I: &[Instruction] = &[
         identifier: MATCH_EBREAK,
         name: "ebreak",
         execute: |emu: &mut Emulator, _inst: u32, _pc: u64| {
-            emu.event = Event::Halted(emu.get_reg(10)? as u8);
+            // 断点补丁打出来的ebreak：PC留在断点处并抬出Break事件
+            #[cfg(feature = "gdb")]
+            if emu.gdb_data.is_breakpoint(_pc) {
+                emu.set_npc(_pc);
+                emu.raise_event(Event::Break);
+                return Ok(());
+            }
+            emu.raise_event(Event::Halted(emu.get_reg(10)? as u8));
             tracing::info!("执行 EBREAK 指令, 触发 CPU 停止事件");
             Ok(())
         },
     },
+    Instruction {
+        mask: MASK_CSRRW,
+        identifier: MATCH_CSRRW,
+        name: "csrrw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let src = emu.get_reg(bits::<19, 15>(inst))?;
+            csr_op(emu, inst, src, true, |_, s| s)
+        },
+    },
+    Instruction {
+        mask: MASK_CSRRS,
+        identifier: MATCH_CSRRS,
+        name: "csrrs",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rs1 = bits::<19, 15>(inst);
+            let src = emu.get_reg(rs1)?;
+            csr_op(emu, inst, src, rs1 != 0, |old, s| old | s)
+        },
+    },
+    Instruction {
+        mask: MASK_CSRRC,
+        identifier: MATCH_CSRRC,
+        name: "csrrc",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rs1 = bits::<19, 15>(inst);
+            let src = emu.get_reg(rs1)?;
+            csr_op(emu, inst, src, rs1 != 0, |old, s| old & !s)
+        },
+    },
+    Instruction {
+        mask: MASK_CSRRWI,
+        identifier: MATCH_CSRRWI,
+        name: "csrrwi",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let uimm = bits::<19, 15>(inst);
+            csr_op(emu, inst, uimm, true, |_, s| s)
+        },
+    },
+    Instruction {
+        mask: MASK_CSRRSI,
+        identifier: MATCH_CSRRSI,
+        name: "csrrsi",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let uimm = bits::<19, 15>(inst);
+            csr_op(emu, inst, uimm, uimm != 0, |old, s| old | s)
+        },
+    },
+    Instruction {
+        mask: MASK_CSRRCI,
+        identifier: MATCH_CSRRCI,
+        name: "csrrci",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let uimm = bits::<19, 15>(inst);
+            csr_op(emu, inst, uimm, uimm != 0, |old, s| old & !s)
+        },
+    },
     Instruction {
         mask: MASK_ADDIW,
         identifier: MATCH_ADDIW,
@@ -513,8 +598,8 @@ pub const RV_I: &[Instruction] = &[
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let i = parse_format_i(inst);
             let lhs = emu.get_reg(i.rs1)?;
-            let result = lhs.wrapping_add(i.imm).bit_range(0..32);
-            emu.set_reg(i.rd, sign_extend_64(result, 32))
+            let result = bits::<31, 0>(lhs.wrapping_add(i.imm));
+            emu.set_reg(i.rd, sign_extend::<32>(result))
         },
     },
     Instruction {
@@ -525,8 +610,8 @@ pub const RV_I: &[Instruction] = &[
             let i = parse_format_i(inst);
             let lhs = emu.get_reg(i.rs1)?;
             let shamt = (i.imm & 0x1F) as u64; // 确保移位量在0-31范围内
-            let result = (lhs << shamt).bit_range(0..32);
-            emu.set_reg(i.rd, sign_extend_64(result, 32))
+            let result = bits::<31, 0>(lhs << shamt);
+            emu.set_reg(i.rd, sign_extend::<32>(result))
         },
     },
     Instruction {
@@ -535,10 +620,10 @@ pub const RV_I: &[Instruction] = &[
         name: "srliw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let i = parse_format_i(inst);
-            let lhs = emu.get_reg(i.rs1)?.bit_range(0..32);
+            let lhs = bits::<31, 0>(emu.get_reg(i.rs1)?);
             let shamt = (i.imm & 0x1F) as u64;
             let result = lhs >> shamt;
-            emu.set_reg(i.rd, sign_extend_64(result, 32))
+            emu.set_reg(i.rd, sign_extend::<32>(result))
         },
     },
     Instruction {
@@ -547,10 +632,10 @@ pub const RV_I: &[Instruction] = &[
         name: "sraiw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let i = parse_format_i(inst);
-            let lhs = emu.get_reg(i.rs1)?.bit_range(0..32);
+            let lhs = bits::<31, 0>(emu.get_reg(i.rs1)?);
             let shamt = (i.imm & 0x1F) as u64;
             let result = lhs as i32 >> shamt;
-            emu.set_reg(i.rd, sign_extend_64(result as u32 as u64, 32))
+            emu.set_reg(i.rd, sign_extend::<32>(result as u32 as u64))
         },
     },
     Instruction {
@@ -559,10 +644,10 @@ pub const RV_I: &[Instruction] = &[
         name: "addw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32);
-            let rhs = emu.get_reg(r.rs2)?.bit_range(0..32);
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?);
+            let rhs = bits::<31, 0>(emu.get_reg(r.rs2)?);
             let result = lhs.wrapping_add(rhs);
-            emu.set_reg(r.rd, sign_extend_64(result, 32))
+            emu.set_reg(r.rd, sign_extend::<32>(result))
         },
     },
     Instruction {
@@ -571,10 +656,10 @@ pub const RV_I: &[Instruction] = &[
         name: "subw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32);
-            let rhs = emu.get_reg(r.rs2)?.bit_range(0..32);
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?);
+            let rhs = bits::<31, 0>(emu.get_reg(r.rs2)?);
             let result = lhs.wrapping_sub(rhs);
-            emu.set_reg(r.rd, sign_extend_64(result, 32))
+            emu.set_reg(r.rd, sign_extend::<32>(result))
         },
     },
     Instruction {
@@ -586,8 +671,8 @@ pub const RV_I: &[Instruction] = &[
             let lhs = emu.get_reg(r.rs1)?;
             let rhs = emu.get_reg(r.rs2)?;
             let shamt = (rhs & 0x1F) as u64;
-            let result = (lhs << shamt).bit_range(0..32);
-            emu.set_reg(r.rd, sign_extend_64(result, 32))
+            let result = bits::<31, 0>(lhs << shamt);
+            emu.set_reg(r.rd, sign_extend::<32>(result))
         },
     },
     Instruction {
@@ -596,11 +681,11 @@ pub const RV_I: &[Instruction] = &[
         name: "srlw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32);
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?);
             let rhs = emu.get_reg(r.rs2)?;
             let shamt = (rhs & 0x1F) as u64;
-            let result = (lhs >> shamt).bit_range(0..32);
-            emu.set_reg(r.rd, sign_extend_64(result, 32))
+            let result = bits::<31, 0>(lhs >> shamt);
+            emu.set_reg(r.rd, sign_extend::<32>(result))
         },
     },
     Instruction {
@@ -609,22 +694,23 @@ pub const RV_I: &[Instruction] = &[
         name: "sraw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32);
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?);
             let rhs = emu.get_reg(r.rs2)?;
             let shamt = (rhs & 0x1F) as u64;
             let result = (lhs as i32 >> shamt) as u32;
-            emu.set_reg(r.rd, sign_extend_64(result as u64, 32))
+            emu.set_reg(r.rd, sign_extend::<32>(result as u64))
         },
     },
     Instruction {
         mask: MASK_LD,
         identifier: MATCH_LD,
         name: "ld",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let rhs = emu.get_reg(i.rs1)?;
             let addr = rhs.wrapping_add(i.imm);
             let raw = emu.state.memory.read_doubleword(addr)?;
+            emu.trace_mem(pc, addr, 8, false, raw);
             emu.set_reg(i.rd, raw)
         },
     },
@@ -632,11 +718,12 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_LWU,
         identifier: MATCH_LWU,
         name: "lwu",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let i = parse_format_i(inst);
             let rhs = emu.get_reg(i.rs1)?;
             let addr = rhs.wrapping_add(i.imm);
             let raw = emu.state.memory.read_word(addr)?;
+            emu.trace_mem(pc, addr, 4, false, raw as u64);
             emu.set_reg(i.rd, raw as u64)
         },
     },
@@ -644,12 +731,31 @@ pub const RV_I: &[Instruction] = &[
         mask: MASK_SD,
         identifier: MATCH_SD,
         name: "sd",
-        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+        execute: |emu: &mut Emulator, inst: u32, pc: u64| {
             let s = parse_format_s(inst);
             let addr = emu.get_reg(s.rs1)?.wrapping_add(s.imm);
             let value = emu.get_reg(s.rs2)?;
             emu.state.memory.write_doubleword(addr, value)?;
+            emu.trace_mem(pc, addr, 8, true, value);
             Ok(())
         },
     },
 ];
+
+/// Zicsr读-改-写公共路径：旧值写入rd，`write`为false时不触发CSR写
+/// （csrrs/csrrc在rs1或uimm为0时按规范只读不写）
+fn csr_op(
+    emu: &mut Emulator,
+    inst: u32,
+    src: u64,
+    write: bool,
+    f: fn(u64, u64) -> u64,
+) -> Result<()> {
+    let csr = bits::<31, 20>(inst) as u16;
+    let rd = bits::<11, 7>(inst);
+    let old = emu.state.get_csr(csr)?;
+    if write {
+        emu.state.set_csr(csr, f(old, src))?;
+    }
+    emu.set_reg(rd, old)
+}
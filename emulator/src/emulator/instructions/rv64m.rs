@@ -3,7 +3,7 @@ use std::u64;
 
 use crate::emulator::Emulator;
 use crate::emulator::instructions::parse_format_r;
-use crate::utils::bit_utils::BitSlice;
+use crate::utils::bit_utils::bits;
 
 use super::Instruction;
 use super::insts::*;
@@ -28,7 +28,7 @@ pub const RV_M: &[Instruction] = &[
             let lhs = emu.get_reg(r.rs1)?;
             let rhs = emu.get_reg(r.rs2)?;
             let res = lhs.wrapping_mul(rhs);
-            emu.set_reg(r.rd, res.bit_range(0..64))
+            emu.set_reg(r.rd, bits::<63, 0>(res))
         },
     },
     Instruction {
@@ -133,8 +133,8 @@ pub const RV_M: &[Instruction] = &[
         name: "mulw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32) as i32;
-            let rhs = emu.get_reg(r.rs2)?.bit_range(0..32) as i32;
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?) as i32;
+            let rhs = bits::<31, 0>(emu.get_reg(r.rs2)?) as i32;
             let res = lhs.wrapping_mul(rhs);
             emu.set_reg(r.rd, res as i64 as u64)
         },
@@ -145,8 +145,8 @@ pub const RV_M: &[Instruction] = &[
         name: "divw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32) as i32;
-            let rhs = emu.get_reg(r.rs2)?.bit_range(0..32) as i32;
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?) as i32;
+            let rhs = bits::<31, 0>(emu.get_reg(r.rs2)?) as i32;
             if rhs == 0 {
                 return emu.set_reg(r.rd, -1i64 as u64);
             }
@@ -160,8 +160,8 @@ pub const RV_M: &[Instruction] = &[
         name: "divuw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32) as u32;
-            let rhs = emu.get_reg(r.rs2)?.bit_range(0..32) as u32;
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?) as u32;
+            let rhs = bits::<31, 0>(emu.get_reg(r.rs2)?) as u32;
             if rhs == 0 {
                 return emu.set_reg(r.rd, u64::MAX);
             }
@@ -175,8 +175,8 @@ pub const RV_M: &[Instruction] = &[
         name: "remw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32) as i32;
-            let rhs = emu.get_reg(r.rs2)?.bit_range(0..32) as i32;
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?) as i32;
+            let rhs = bits::<31, 0>(emu.get_reg(r.rs2)?) as i32;
             if rhs == 0 {
                 return emu.set_reg(r.rd, rhs as i64 as u64);
             }
@@ -190,8 +190,8 @@ pub const RV_M: &[Instruction] = &[
         name: "remuw",
         execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
             let r = parse_format_r(inst);
-            let lhs = emu.get_reg(r.rs1)?.bit_range(0..32) as u32;
-            let rhs = emu.get_reg(r.rs2)?.bit_range(0..32) as u32;
+            let lhs = bits::<31, 0>(emu.get_reg(r.rs1)?) as u32;
+            let rhs = bits::<31, 0>(emu.get_reg(r.rs2)?) as u32;
             if rhs == 0 {
                 return emu.set_reg(r.rd, rhs as i32 as i64 as u64);
             }
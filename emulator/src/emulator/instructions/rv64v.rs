@@ -0,0 +1,444 @@
+//! RV64V 向量扩展（RVV 1.0 子集）
+//!
+//! 实现数据并行内核（memcpy/memset、散列等）所需的最小子集：
+//! vsetvli/vsetivli/vsetvl、单位步长加载存储 vle/vse{8,16,32,64}、
+//! 整数ALU（add/sub/rsub/and/or/xor/sll/srl）与vmv。VLEN=128，
+//! 向量寄存器组按字节平铺存放（见 [`State`](crate::emulator::State)
+//! 的 `v_regs`），整数LMUL分组由平铺布局天然支持；不支持分数LMUL，
+//! 非法vtype按规范置vill。vm=0时按v0.t逐元素屏蔽；无掩码的单位
+//! 步长访存走一次成块读写，每条指令搬运vl×EEW字节。
+//!
+//! vstart恒为0（解释器内访存出错即报错终止，无部分重启语义）。
+
+use anyhow::Result;
+
+use crate::emulator::Emulator;
+use crate::emulator::state::{VLEN, VLENB};
+use crate::utils::bit_utils::{bits, sign_extend};
+
+use super::Instruction;
+use super::insts::*;
+
+/// vtype中的SEW（字节数）
+#[inline(always)]
+fn sew_bytes(vtype: u64) -> usize {
+    1 << ((vtype >> 3) & 0b111)
+}
+
+/// 按vtype计算VLMAX；分数LMUL、SEW>64或保留位非零时返回None（vill）
+fn vlmax(vtype: u64) -> Option<u64> {
+    let lmul = match vtype & 0b111 {
+        0b000 => 1,
+        0b001 => 2,
+        0b010 => 4,
+        0b011 => 8,
+        _ => return None,
+    };
+    if sew_bytes(vtype) > 8 || vtype >> 8 != 0 {
+        return None;
+    }
+    Some((lmul * VLEN / (sew_bytes(vtype) * 8)) as u64)
+}
+
+/// vset{i}vli/vsetvl公共路径：校验vtype、更新vl并写回rd。
+/// avl为None时保持当前vl（rs1=x0且rd=x0的形式）。
+fn set_vtype(emu: &mut Emulator, vtype: u64, avl: Option<u64>, rd: u64) -> Result<()> {
+    match vlmax(vtype) {
+        Some(max) => {
+            emu.state.vtype = vtype;
+            emu.state.vl = avl.unwrap_or(emu.state.vl).min(max);
+        }
+        None => {
+            emu.state.vtype = 1 << 63;
+            emu.state.vl = 0;
+        }
+    }
+    emu.set_reg(rd, emu.state.vl)
+}
+
+/// 解析vset{i}vli的avl来源：rs1非x0取寄存器，rs1=x0且rd非x0取VLMAX，
+/// 两者均为x0时保持vl
+fn parse_avl(emu: &Emulator, rs1: u64, rd: u64) -> Result<Option<u64>> {
+    if rs1 != 0 {
+        Ok(Some(emu.get_reg(rs1)?))
+    } else if rd != 0 {
+        Ok(Some(u64::MAX))
+    } else {
+        Ok(None)
+    }
+}
+
+/// 读元素（小端，元素宽度sew字节）
+#[inline(always)]
+fn get_elem(emu: &Emulator, reg: u64, i: usize, sew: usize) -> u64 {
+    let off = reg as usize * VLENB + i * sew;
+    let mut buf = [0u8; 8];
+    buf[..sew].copy_from_slice(&emu.state.v_regs[off..off + sew]);
+    u64::from_le_bytes(buf)
+}
+
+/// 写元素（高位截断到元素宽度）
+#[inline(always)]
+fn set_elem(emu: &mut Emulator, reg: u64, i: usize, sew: usize, v: u64) {
+    let off = reg as usize * VLENB + i * sew;
+    emu.state.v_regs[off..off + sew].copy_from_slice(&v.to_le_bytes()[..sew]);
+}
+
+/// v0.t掩码的第i位
+#[inline(always)]
+fn mask_bit(emu: &Emulator, i: usize) -> bool {
+    emu.state.v_regs[i / 8] >> (i % 8) & 1 != 0
+}
+
+/// 第二操作数来源：向量（.vv）、标量寄存器（.vx）或5位立即数（.vi）
+#[derive(Clone, Copy)]
+enum Src2 {
+    V,
+    X,
+    I,
+}
+
+/// 整数ALU公共路径：vd[i] = f(vs2[i], src2, SEW位宽)，vm=0时按v0.t屏蔽
+#[inline(always)]
+fn alu(emu: &mut Emulator, inst: u32, src: Src2, f: fn(u64, u64, u64) -> u64) -> Result<()> {
+    let vd = bits::<11, 7>(inst);
+    let r1 = bits::<19, 15>(inst);
+    let vs2 = bits::<24, 20>(inst);
+    let vm = inst & (1 << 25) != 0;
+    let sew = sew_bytes(emu.state.vtype);
+    let scalar = match src {
+        Src2::V => 0,
+        Src2::X => emu.get_reg(r1)?,
+        Src2::I => sign_extend::<5>(r1),
+    };
+    for i in 0..emu.state.vl as usize {
+        if !vm && !mask_bit(emu, i) {
+            continue;
+        }
+        let a = get_elem(emu, vs2, i, sew);
+        let b = match src {
+            Src2::V => get_elem(emu, r1, i, sew),
+            _ => scalar,
+        };
+        set_elem(emu, vd, i, sew, f(a, b, (sew * 8) as u64));
+    }
+    Ok(())
+}
+
+/// 单位步长加载公共路径（esize为指令EEW的字节数）
+#[inline(always)]
+fn vload(emu: &mut Emulator, inst: u32, esize: usize) -> Result<()> {
+    let vd = bits::<11, 7>(inst) as usize;
+    let addr = emu.get_reg(bits::<19, 15>(inst))?;
+    let vm = inst & (1 << 25) != 0;
+    let vl = emu.state.vl as usize;
+    let off = vd * VLENB;
+    if off + vl * esize > emu.state.v_regs.len() {
+        return Err(anyhow::anyhow!(
+            "向量加载越界: v{} EEW={} vl={}",
+            vd,
+            esize * 8,
+            vl
+        ));
+    }
+    if vm {
+        // 无掩码：整段一次读入目标寄存器组，无中间分配
+        emu.state
+            .memory
+            .read_into(addr, &mut emu.state.v_regs[off..off + vl * esize])?;
+    } else {
+        for i in 0..vl {
+            if !mask_bit(emu, i) {
+                continue;
+            }
+            emu.state.memory.read_into(
+                addr + (i * esize) as u64,
+                &mut emu.state.v_regs[off + i * esize..off + (i + 1) * esize],
+            )?;
+        }
+    }
+    Ok(())
+}
+
+/// 单位步长存储公共路径
+#[inline(always)]
+fn vstore(emu: &mut Emulator, inst: u32, esize: usize) -> Result<()> {
+    let vs3 = bits::<11, 7>(inst) as usize;
+    let addr = emu.get_reg(bits::<19, 15>(inst))?;
+    let vm = inst & (1 << 25) != 0;
+    let vl = emu.state.vl as usize;
+    let off = vs3 * VLENB;
+    if off + vl * esize > emu.state.v_regs.len() {
+        return Err(anyhow::anyhow!(
+            "向量存储越界: v{} EEW={} vl={}",
+            vs3,
+            esize * 8,
+            vl
+        ));
+    }
+    if vm {
+        // 直接从寄存器组切片写出，绕过`State`整体可变借用所需的拷贝
+        emu.state
+            .memory
+            .write(addr, &emu.state.v_regs[off..off + vl * esize])?;
+    } else {
+        for i in 0..vl {
+            if !mask_bit(emu, i) {
+                continue;
+            }
+            emu.state.memory.write(
+                addr + (i * esize) as u64,
+                &emu.state.v_regs[off + i * esize..off + (i + 1) * esize],
+            )?;
+        }
+    }
+    Ok(())
+}
+
+pub const RV_V: &[Instruction] = &[
+    Instruction {
+        mask: MASK_VSETVLI,
+        identifier: MATCH_VSETVLI,
+        name: "vsetvli",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = bits::<11, 7>(inst);
+            let rs1 = bits::<19, 15>(inst);
+            let vtype = bits::<30, 20>(inst);
+            let avl = parse_avl(emu, rs1, rd)?;
+            set_vtype(emu, vtype, avl, rd)
+        },
+    },
+    Instruction {
+        mask: MASK_VSETIVLI,
+        identifier: MATCH_VSETIVLI,
+        name: "vsetivli",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = bits::<11, 7>(inst);
+            let avl = bits::<19, 15>(inst);
+            let vtype = bits::<29, 20>(inst);
+            set_vtype(emu, vtype, Some(avl), rd)
+        },
+    },
+    Instruction {
+        mask: MASK_VSETVL,
+        identifier: MATCH_VSETVL,
+        name: "vsetvl",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let rd = bits::<11, 7>(inst);
+            let rs1 = bits::<19, 15>(inst);
+            let vtype = emu.get_reg(bits::<24, 20>(inst))?;
+            let avl = parse_avl(emu, rs1, rd)?;
+            set_vtype(emu, vtype, avl, rd)
+        },
+    },
+    Instruction {
+        mask: MASK_VLE8_V,
+        identifier: MATCH_VLE8_V,
+        name: "vle8.v",
+        execute: |emu, inst, _pc| vload(emu, inst, 1),
+    },
+    Instruction {
+        mask: MASK_VLE16_V,
+        identifier: MATCH_VLE16_V,
+        name: "vle16.v",
+        execute: |emu, inst, _pc| vload(emu, inst, 2),
+    },
+    Instruction {
+        mask: MASK_VLE32_V,
+        identifier: MATCH_VLE32_V,
+        name: "vle32.v",
+        execute: |emu, inst, _pc| vload(emu, inst, 4),
+    },
+    Instruction {
+        mask: MASK_VLE64_V,
+        identifier: MATCH_VLE64_V,
+        name: "vle64.v",
+        execute: |emu, inst, _pc| vload(emu, inst, 8),
+    },
+    Instruction {
+        mask: MASK_VSE8_V,
+        identifier: MATCH_VSE8_V,
+        name: "vse8.v",
+        execute: |emu, inst, _pc| vstore(emu, inst, 1),
+    },
+    Instruction {
+        mask: MASK_VSE16_V,
+        identifier: MATCH_VSE16_V,
+        name: "vse16.v",
+        execute: |emu, inst, _pc| vstore(emu, inst, 2),
+    },
+    Instruction {
+        mask: MASK_VSE32_V,
+        identifier: MATCH_VSE32_V,
+        name: "vse32.v",
+        execute: |emu, inst, _pc| vstore(emu, inst, 4),
+    },
+    Instruction {
+        mask: MASK_VSE64_V,
+        identifier: MATCH_VSE64_V,
+        name: "vse64.v",
+        execute: |emu, inst, _pc| vstore(emu, inst, 8),
+    },
+    Instruction {
+        mask: MASK_VADD_VV,
+        identifier: MATCH_VADD_VV,
+        name: "vadd.vv",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::V, |a, b, _| a.wrapping_add(b)),
+    },
+    Instruction {
+        mask: MASK_VADD_VX,
+        identifier: MATCH_VADD_VX,
+        name: "vadd.vx",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |a, b, _| a.wrapping_add(b)),
+    },
+    Instruction {
+        mask: MASK_VADD_VI,
+        identifier: MATCH_VADD_VI,
+        name: "vadd.vi",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::I, |a, b, _| a.wrapping_add(b)),
+    },
+    Instruction {
+        mask: MASK_VSUB_VV,
+        identifier: MATCH_VSUB_VV,
+        name: "vsub.vv",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::V, |a, b, _| a.wrapping_sub(b)),
+    },
+    Instruction {
+        mask: MASK_VSUB_VX,
+        identifier: MATCH_VSUB_VX,
+        name: "vsub.vx",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |a, b, _| a.wrapping_sub(b)),
+    },
+    Instruction {
+        mask: MASK_VRSUB_VX,
+        identifier: MATCH_VRSUB_VX,
+        name: "vrsub.vx",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |a, b, _| b.wrapping_sub(a)),
+    },
+    Instruction {
+        mask: MASK_VRSUB_VI,
+        identifier: MATCH_VRSUB_VI,
+        name: "vrsub.vi",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::I, |a, b, _| b.wrapping_sub(a)),
+    },
+    Instruction {
+        mask: MASK_VAND_VV,
+        identifier: MATCH_VAND_VV,
+        name: "vand.vv",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::V, |a, b, _| a & b),
+    },
+    Instruction {
+        mask: MASK_VAND_VX,
+        identifier: MATCH_VAND_VX,
+        name: "vand.vx",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |a, b, _| a & b),
+    },
+    Instruction {
+        mask: MASK_VAND_VI,
+        identifier: MATCH_VAND_VI,
+        name: "vand.vi",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::I, |a, b, _| a & b),
+    },
+    Instruction {
+        mask: MASK_VOR_VV,
+        identifier: MATCH_VOR_VV,
+        name: "vor.vv",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::V, |a, b, _| a | b),
+    },
+    Instruction {
+        mask: MASK_VOR_VX,
+        identifier: MATCH_VOR_VX,
+        name: "vor.vx",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |a, b, _| a | b),
+    },
+    Instruction {
+        mask: MASK_VOR_VI,
+        identifier: MATCH_VOR_VI,
+        name: "vor.vi",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::I, |a, b, _| a | b),
+    },
+    Instruction {
+        mask: MASK_VXOR_VV,
+        identifier: MATCH_VXOR_VV,
+        name: "vxor.vv",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::V, |a, b, _| a ^ b),
+    },
+    Instruction {
+        mask: MASK_VXOR_VX,
+        identifier: MATCH_VXOR_VX,
+        name: "vxor.vx",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |a, b, _| a ^ b),
+    },
+    Instruction {
+        mask: MASK_VXOR_VI,
+        identifier: MATCH_VXOR_VI,
+        name: "vxor.vi",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::I, |a, b, _| a ^ b),
+    },
+    Instruction {
+        mask: MASK_VSLL_VV,
+        identifier: MATCH_VSLL_VV,
+        name: "vsll.vv",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::V, |a, b, w| a << (b & (w - 1))),
+    },
+    Instruction {
+        mask: MASK_VSLL_VX,
+        identifier: MATCH_VSLL_VX,
+        name: "vsll.vx",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |a, b, w| a << (b & (w - 1))),
+    },
+    Instruction {
+        mask: MASK_VSLL_VI,
+        identifier: MATCH_VSLL_VI,
+        name: "vsll.vi",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::I, |a, b, w| a << (b & (w - 1))),
+    },
+    Instruction {
+        mask: MASK_VSRL_VV,
+        identifier: MATCH_VSRL_VV,
+        name: "vsrl.vv",
+        execute: |emu, inst, _pc| {
+            alu(emu, inst, Src2::V, |a, b, w| {
+                (a & (u64::MAX >> (64 - w))) >> (b & (w - 1))
+            })
+        },
+    },
+    Instruction {
+        mask: MASK_VSRL_VX,
+        identifier: MATCH_VSRL_VX,
+        name: "vsrl.vx",
+        execute: |emu, inst, _pc| {
+            alu(emu, inst, Src2::X, |a, b, w| {
+                (a & (u64::MAX >> (64 - w))) >> (b & (w - 1))
+            })
+        },
+    },
+    Instruction {
+        mask: MASK_VSRL_VI,
+        identifier: MATCH_VSRL_VI,
+        name: "vsrl.vi",
+        execute: |emu, inst, _pc| {
+            alu(emu, inst, Src2::I, |a, b, w| {
+                (a & (u64::MAX >> (64 - w))) >> (b & (w - 1))
+            })
+        },
+    },
+    Instruction {
+        mask: MASK_VMV_V_V,
+        identifier: MATCH_VMV_V_V,
+        name: "vmv.v.v",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::V, |_, b, _| b),
+    },
+    Instruction {
+        mask: MASK_VMV_V_X,
+        identifier: MATCH_VMV_V_X,
+        name: "vmv.v.x",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::X, |_, b, _| b),
+    },
+    Instruction {
+        mask: MASK_VMV_V_I,
+        identifier: MATCH_VMV_V_I,
+        name: "vmv.v.i",
+        execute: |emu, inst, _pc| alu(emu, inst, Src2::I, |_, b, _| b),
+    },
+];
@@ -0,0 +1,82 @@
+//! Zba 地址生成扩展
+//!
+//! 移位加（shNadd）与无符号字变体，供编译器合成数组索引与
+//! 32位无符号地址运算，消除多条移位/掩码指令序列。
+
+use anyhow::Result;
+
+use crate::emulator::Emulator;
+
+use super::Instruction;
+use super::insts::*;
+use super::{parse_format_i, parse_format_r};
+
+/// 移位加公共路径：rd = (f(rs1) << shift) + rs2
+#[inline(always)]
+fn sh_add(emu: &mut Emulator, inst: u32, shift: u32, f: fn(u64) -> u64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let lhs = f(emu.get_reg(r.rs1)?);
+    let rhs = emu.get_reg(r.rs2)?;
+    emu.set_reg(r.rd, (lhs << shift).wrapping_add(rhs))
+}
+
+/// 低32位零扩展
+#[inline(always)]
+fn zext32(v: u64) -> u64 {
+    v as u32 as u64
+}
+
+pub const RV_ZBA: &[Instruction] = &[
+    Instruction {
+        mask: MASK_ADD_UW,
+        identifier: MATCH_ADD_UW,
+        name: "add.uw",
+        execute: |emu, inst, _pc| sh_add(emu, inst, 0, zext32),
+    },
+    Instruction {
+        mask: MASK_SH1ADD,
+        identifier: MATCH_SH1ADD,
+        name: "sh1add",
+        execute: |emu, inst, _pc| sh_add(emu, inst, 1, |v| v),
+    },
+    Instruction {
+        mask: MASK_SH2ADD,
+        identifier: MATCH_SH2ADD,
+        name: "sh2add",
+        execute: |emu, inst, _pc| sh_add(emu, inst, 2, |v| v),
+    },
+    Instruction {
+        mask: MASK_SH3ADD,
+        identifier: MATCH_SH3ADD,
+        name: "sh3add",
+        execute: |emu, inst, _pc| sh_add(emu, inst, 3, |v| v),
+    },
+    Instruction {
+        mask: MASK_SH1ADD_UW,
+        identifier: MATCH_SH1ADD_UW,
+        name: "sh1add.uw",
+        execute: |emu, inst, _pc| sh_add(emu, inst, 1, zext32),
+    },
+    Instruction {
+        mask: MASK_SH2ADD_UW,
+        identifier: MATCH_SH2ADD_UW,
+        name: "sh2add.uw",
+        execute: |emu, inst, _pc| sh_add(emu, inst, 2, zext32),
+    },
+    Instruction {
+        mask: MASK_SH3ADD_UW,
+        identifier: MATCH_SH3ADD_UW,
+        name: "sh3add.uw",
+        execute: |emu, inst, _pc| sh_add(emu, inst, 3, zext32),
+    },
+    Instruction {
+        mask: MASK_SLLI_UW,
+        identifier: MATCH_SLLI_UW,
+        name: "slli.uw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let i = parse_format_i(inst);
+            let v = zext32(emu.get_reg(i.rs1)?);
+            emu.set_reg(i.rd, v << (i.imm & 0x3f))
+        },
+    },
+];
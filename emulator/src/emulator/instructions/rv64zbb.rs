@@ -0,0 +1,208 @@
+//! Zbb 基础位操作扩展
+//!
+//! 逻辑取反组合（andn/orn/xnor）、前导/尾随零与置位计数、有/无符号
+//! 最值、窄位宽符号/零扩展、循环移位与字节重排（orc.b/rev8）。
+//! 大部分位运算直接映射到Rust的内建整数方法。
+
+use anyhow::Result;
+
+use crate::emulator::Emulator;
+use crate::utils::bit_utils::sign_extend;
+
+use super::Instruction;
+use super::insts::*;
+use super::{parse_format_i, parse_format_r};
+
+/// R型二元运算公共路径
+#[inline(always)]
+fn binop(emu: &mut Emulator, inst: u32, f: fn(u64, u64) -> u64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let lhs = emu.get_reg(r.rs1)?;
+    let rhs = emu.get_reg(r.rs2)?;
+    emu.set_reg(r.rd, f(lhs, rhs))
+}
+
+/// 单操作数运算公共路径（clz/ctz/cpop/sext等，rs2字段为功能编码）
+#[inline(always)]
+fn unary(emu: &mut Emulator, inst: u32, f: fn(u64) -> u64) -> Result<()> {
+    let r = parse_format_r(inst);
+    let v = emu.get_reg(r.rs1)?;
+    emu.set_reg(r.rd, f(v))
+}
+
+pub const RV_ZBB: &[Instruction] = &[
+    Instruction {
+        mask: MASK_ANDN,
+        identifier: MATCH_ANDN,
+        name: "andn",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| a & !b),
+    },
+    Instruction {
+        mask: MASK_ORN,
+        identifier: MATCH_ORN,
+        name: "orn",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| a | !b),
+    },
+    Instruction {
+        mask: MASK_XNOR,
+        identifier: MATCH_XNOR,
+        name: "xnor",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| !(a ^ b)),
+    },
+    Instruction {
+        mask: MASK_CLZ,
+        identifier: MATCH_CLZ,
+        name: "clz",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| v.leading_zeros() as u64),
+    },
+    Instruction {
+        mask: MASK_CLZW,
+        identifier: MATCH_CLZW,
+        name: "clzw",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| (v as u32).leading_zeros() as u64),
+    },
+    Instruction {
+        mask: MASK_CTZ,
+        identifier: MATCH_CTZ,
+        name: "ctz",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| v.trailing_zeros() as u64),
+    },
+    Instruction {
+        mask: MASK_CTZW,
+        identifier: MATCH_CTZW,
+        name: "ctzw",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| (v as u32).trailing_zeros() as u64),
+    },
+    Instruction {
+        mask: MASK_CPOP,
+        identifier: MATCH_CPOP,
+        name: "cpop",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| v.count_ones() as u64),
+    },
+    Instruction {
+        mask: MASK_CPOPW,
+        identifier: MATCH_CPOPW,
+        name: "cpopw",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| (v as u32).count_ones() as u64),
+    },
+    Instruction {
+        mask: MASK_MAX,
+        identifier: MATCH_MAX,
+        name: "max",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| (a as i64).max(b as i64) as u64),
+    },
+    Instruction {
+        mask: MASK_MAXU,
+        identifier: MATCH_MAXU,
+        name: "maxu",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| a.max(b)),
+    },
+    Instruction {
+        mask: MASK_MIN,
+        identifier: MATCH_MIN,
+        name: "min",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| (a as i64).min(b as i64) as u64),
+    },
+    Instruction {
+        mask: MASK_MINU,
+        identifier: MATCH_MINU,
+        name: "minu",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| a.min(b)),
+    },
+    Instruction {
+        mask: MASK_SEXT_B,
+        identifier: MATCH_SEXT_B,
+        name: "sext.b",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| sign_extend::<8>(v & 0xff)),
+    },
+    Instruction {
+        mask: MASK_SEXT_H,
+        identifier: MATCH_SEXT_H,
+        name: "sext.h",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| sign_extend::<16>(v & 0xffff)),
+    },
+    Instruction {
+        // RV64的zext.h是packw rd, rs1, x0的专用形式，掩码需固定rs2=0
+        mask: MASK_PACKW | 0x01f0_0000,
+        identifier: MATCH_PACKW,
+        name: "zext.h",
+        execute: |emu, inst, _pc| unary(emu, inst, |v| v & 0xffff),
+    },
+    Instruction {
+        mask: MASK_ROL,
+        identifier: MATCH_ROL,
+        name: "rol",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| a.rotate_left(b as u32 & 0x3f)),
+    },
+    Instruction {
+        mask: MASK_ROLW,
+        identifier: MATCH_ROLW,
+        name: "rolw",
+        execute: |emu, inst, _pc| {
+            binop(emu, inst, |a, b| {
+                sign_extend::<32>((a as u32).rotate_left(b as u32 & 0x1f) as u64)
+            })
+        },
+    },
+    Instruction {
+        mask: MASK_ROR,
+        identifier: MATCH_ROR,
+        name: "ror",
+        execute: |emu, inst, _pc| binop(emu, inst, |a, b| a.rotate_right(b as u32 & 0x3f)),
+    },
+    Instruction {
+        mask: MASK_RORW,
+        identifier: MATCH_RORW,
+        name: "rorw",
+        execute: |emu, inst, _pc| {
+            binop(emu, inst, |a, b| {
+                sign_extend::<32>((a as u32).rotate_right(b as u32 & 0x1f) as u64)
+            })
+        },
+    },
+    Instruction {
+        mask: MASK_RORI,
+        identifier: MATCH_RORI,
+        name: "rori",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let i = parse_format_i(inst);
+            let v = emu.get_reg(i.rs1)?;
+            emu.set_reg(i.rd, v.rotate_right(i.imm as u32 & 0x3f))
+        },
+    },
+    Instruction {
+        mask: MASK_RORIW,
+        identifier: MATCH_RORIW,
+        name: "roriw",
+        execute: |emu: &mut Emulator, inst: u32, _pc: u64| {
+            let i = parse_format_i(inst);
+            let v = emu.get_reg(i.rs1)? as u32;
+            emu.set_reg(
+                i.rd,
+                sign_extend::<32>(v.rotate_right(i.imm as u32 & 0x1f) as u64),
+            )
+        },
+    },
+    Instruction {
+        mask: MASK_ORC_B,
+        identifier: MATCH_ORC_B,
+        name: "orc.b",
+        execute: |emu, inst, _pc| {
+            unary(emu, inst, |v| {
+                let mut out = 0u64;
+                for byte in 0..8 {
+                    if v >> (byte * 8) & 0xff != 0 {
+                        out |= 0xff << (byte * 8);
+                    }
+                }
+                out
+            })
+        },
+    },
+    Instruction {
+        mask: MASK_REV8,
+        identifier: MATCH_REV8,
+        name: "rev8",
+        execute: |emu, inst, _pc| unary(emu, inst, u64::swap_bytes),
+    },
+];
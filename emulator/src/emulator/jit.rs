@@ -0,0 +1,799 @@
+//! 可选的JIT执行层（Cranelift后端，`jit` feature）
+//!
+//! 基本块执行计数达到 [`HOT_THRESHOLD`] 后，将其编译为宿主机器码：
+//! 寄存器与主内存通过裸指针直接访问，彻底消除解释循环的分发开销。
+//!
+//! 编译后的函数签名为 `fn(regs: *mut u64, mem: *mut u8, dirty: *mut u64) -> u64`，
+//! 返回值是下一条PC；低位为1时表示在 `返回值 & !1` 处退出JIT
+//! （MMIO访问、越界或不支持的指令），由解释器从该PC继续执行，
+//! 之前已提交的寄存器写入全部有效，不会重复执行任何指令。
+//! store在写入后把所在页在`dirty`位图中置位，与解释器的
+//! `mark_dirty`同一语义，批量复位与快照增量因此不漏页。
+//! 首条指令即不支持的块标记为 [`JitState::Blocked`]，不再尝试编译。
+
+use std::mem;
+
+use cranelift_codegen::ir::{AbiParam, InstBuilder, MemFlags, Value, condcodes::IntCC, types};
+use cranelift_frontend::{FunctionBuilder, FunctionBuilderContext};
+use cranelift_jit::{JITBuilder, JITModule};
+use cranelift_module::Module;
+
+use super::block::{Block, DecodedInst};
+use super::instructions::rv64c;
+use super::instructions::{
+    parse_format_b, parse_format_i, parse_format_j, parse_format_r, parse_format_s, parse_format_u,
+};
+
+/// 块执行次数达到该阈值后触发编译
+pub const HOT_THRESHOLD: u32 = 64;
+
+/// 编译后的基本块：参数为寄存器数组、主内存与脏页位图的宿主指针，
+/// 返回下一条PC
+pub type CompiledBlock =
+    unsafe extern "C" fn(regs: *mut u64, mem: *mut u8, dirty: *mut u64) -> u64;
+
+/// 基本块的JIT状态
+#[derive(Debug, Clone, Copy)]
+pub enum JitState {
+    /// 未编译，记录已执行次数
+    Cold(u32),
+    /// 已编译
+    Compiled(CompiledBlock),
+    /// 放弃编译（首条指令不支持），始终走解释器
+    Blocked,
+}
+
+/// 降级后的ALU运算种类（word为true时为32位运算后符号扩展）
+#[derive(Debug, Clone, Copy)]
+enum Alu {
+    Add,
+    Sub,
+    Sll,
+    Slt,
+    Sltu,
+    Xor,
+    Srl,
+    Sra,
+    Or,
+    And,
+    Mul,
+}
+
+/// 指令降级后的中间表示：32位与压缩指令归一到同一组操作
+#[derive(Debug, Clone, Copy)]
+enum JitOp {
+    /// 寄存器-寄存器ALU运算
+    AluRR {
+        op: Alu,
+        word: bool,
+        rd: u8,
+        rs1: u8,
+        rs2: u8,
+    },
+    /// 寄存器-立即数ALU运算
+    AluRI {
+        op: Alu,
+        word: bool,
+        rd: u8,
+        rs1: u8,
+        imm: i64,
+    },
+    /// 加载常量（lui/c.li/c.lui，auipc在编译期折叠为常量）
+    Li { rd: u8, imm: i64 },
+    /// 内存读
+    Load {
+        rd: u8,
+        rs1: u8,
+        imm: i64,
+        size: u8,
+        signed: bool,
+    },
+    /// 内存写
+    Store {
+        rs2: u8,
+        rs1: u8,
+        imm: i64,
+        size: u8,
+    },
+    /// 直接跳转（终结块）
+    Jal { rd: u8, link: u64, target: u64 },
+    /// 间接跳转（终结块）
+    Jalr {
+        rd: u8,
+        rs1: u8,
+        imm: i64,
+        link: u64,
+    },
+    /// 条件分支（终结块）
+    Branch {
+        cc: IntCC,
+        rs1: u8,
+        rs2: u8,
+        target: u64,
+        fall: u64,
+    },
+}
+
+impl JitOp {
+    /// 编译期已知的控制流目标（用于非C扩展下的对齐检查）
+    fn static_target(&self) -> Option<u64> {
+        match *self {
+            JitOp::Jal { target, .. } | JitOp::Branch { target, .. } => Some(target),
+            _ => None,
+        }
+    }
+}
+
+/// R型ALU指令降级
+fn rr(op: Alu, word: bool, inst: u32) -> JitOp {
+    let f = parse_format_r(inst);
+    JitOp::AluRR {
+        op,
+        word,
+        rd: f.rd as u8,
+        rs1: f.rs1 as u8,
+        rs2: f.rs2 as u8,
+    }
+}
+
+/// I型ALU指令降级
+fn ri(op: Alu, word: bool, inst: u32) -> JitOp {
+    let f = parse_format_i(inst);
+    JitOp::AluRI {
+        op,
+        word,
+        rd: f.rd as u8,
+        rs1: f.rs1 as u8,
+        imm: f.imm as i64,
+    }
+}
+
+/// 移位立即数指令降级（imm字段含funct位，须截取shamt）
+fn ri_shamt(op: Alu, word: bool, inst: u32) -> JitOp {
+    let f = parse_format_i(inst);
+    let shamt = f.imm & if word { 0x1f } else { 0x3f };
+    JitOp::AluRI {
+        op,
+        word,
+        rd: f.rd as u8,
+        rs1: f.rs1 as u8,
+        imm: shamt as i64,
+    }
+}
+
+/// 加载指令降级
+fn load(inst: u32, size: u8, signed: bool) -> JitOp {
+    let f = parse_format_i(inst);
+    JitOp::Load {
+        rd: f.rd as u8,
+        rs1: f.rs1 as u8,
+        imm: f.imm as i64,
+        size,
+        signed,
+    }
+}
+
+/// 存储指令降级
+fn store(inst: u32, size: u8) -> JitOp {
+    let f = parse_format_s(inst);
+    JitOp::Store {
+        rs2: f.rs2 as u8,
+        rs1: f.rs1 as u8,
+        imm: f.imm as i64,
+        size,
+    }
+}
+
+/// 条件分支指令降级
+fn branch(cc: IntCC, inst: u32, pc: u64, fall: u64) -> JitOp {
+    let f = parse_format_b(inst);
+    JitOp::Branch {
+        cc,
+        rs1: f.rs1 as u8,
+        rs2: f.rs2 as u8,
+        target: pc.wrapping_add(f.imm),
+        fall,
+    }
+}
+
+/// 按指令名把一条预译码指令降级为 [`JitOp`]，不支持的指令返回 `None`
+fn lower(d: &DecodedInst) -> Option<JitOp> {
+    let inst = d.inst;
+    let pc = d.pc;
+    // 顺序执行的下一条PC，也是跳转的链接值
+    let next = pc.wrapping_add(d.len);
+    Some(match d.handler.name {
+        // ---- RV64I ----
+        "lui" => {
+            let f = parse_format_u(inst);
+            JitOp::Li {
+                rd: f.rd as u8,
+                imm: f.imm as i64,
+            }
+        }
+        "auipc" => {
+            let f = parse_format_u(inst);
+            JitOp::Li {
+                rd: f.rd as u8,
+                imm: pc.wrapping_add(f.imm) as i64,
+            }
+        }
+        "jal" => {
+            let f = parse_format_j(inst);
+            JitOp::Jal {
+                rd: f.rd as u8,
+                link: next,
+                target: pc.wrapping_add(f.imm),
+            }
+        }
+        "jalr" => {
+            let f = parse_format_i(inst);
+            JitOp::Jalr {
+                rd: f.rd as u8,
+                rs1: f.rs1 as u8,
+                imm: f.imm as i64,
+                link: next,
+            }
+        }
+        "beq" => branch(IntCC::Equal, inst, pc, next),
+        "bne" => branch(IntCC::NotEqual, inst, pc, next),
+        "blt" => branch(IntCC::SignedLessThan, inst, pc, next),
+        "bge" => branch(IntCC::SignedGreaterThanOrEqual, inst, pc, next),
+        "bltu" => branch(IntCC::UnsignedLessThan, inst, pc, next),
+        "bgeu" => branch(IntCC::UnsignedGreaterThanOrEqual, inst, pc, next),
+        "lb" => load(inst, 1, true),
+        "lh" => load(inst, 2, true),
+        "lw" => load(inst, 4, true),
+        "ld" => load(inst, 8, true),
+        "lbu" => load(inst, 1, false),
+        "lhu" => load(inst, 2, false),
+        "lwu" => load(inst, 4, false),
+        "sb" => store(inst, 1),
+        "sh" => store(inst, 2),
+        "sw" => store(inst, 4),
+        "sd" => store(inst, 8),
+        "addi" => ri(Alu::Add, false, inst),
+        "slti" => ri(Alu::Slt, false, inst),
+        "sltiu" => ri(Alu::Sltu, false, inst),
+        "xori" => ri(Alu::Xor, false, inst),
+        "ori" => ri(Alu::Or, false, inst),
+        "andi" => ri(Alu::And, false, inst),
+        "slli" => ri_shamt(Alu::Sll, false, inst),
+        "srli" => ri_shamt(Alu::Srl, false, inst),
+        "srai" => ri_shamt(Alu::Sra, false, inst),
+        "addiw" => ri(Alu::Add, true, inst),
+        "slliw" => ri_shamt(Alu::Sll, true, inst),
+        "srliw" => ri_shamt(Alu::Srl, true, inst),
+        "sraiw" => ri_shamt(Alu::Sra, true, inst),
+        "add" => rr(Alu::Add, false, inst),
+        "sub" => rr(Alu::Sub, false, inst),
+        "sll" => rr(Alu::Sll, false, inst),
+        "slt" => rr(Alu::Slt, false, inst),
+        "sltu" => rr(Alu::Sltu, false, inst),
+        "xor" => rr(Alu::Xor, false, inst),
+        "srl" => rr(Alu::Srl, false, inst),
+        "sra" => rr(Alu::Sra, false, inst),
+        "or" => rr(Alu::Or, false, inst),
+        "and" => rr(Alu::And, false, inst),
+        "addw" => rr(Alu::Add, true, inst),
+        "subw" => rr(Alu::Sub, true, inst),
+        "sllw" => rr(Alu::Sll, true, inst),
+        "srlw" => rr(Alu::Srl, true, inst),
+        "sraw" => rr(Alu::Sra, true, inst),
+        // ---- RV64M（除法语义复杂，仍走解释器） ----
+        "mul" => rr(Alu::Mul, false, inst),
+        "mulw" => rr(Alu::Mul, true, inst),
+        // ---- RV64C ----
+        "c.addi" => {
+            let rd = rv64c::reg_full(inst) as u8;
+            JitOp::AluRI {
+                op: Alu::Add,
+                word: false,
+                rd,
+                rs1: rd,
+                imm: rv64c::imm_ci(inst) as i64,
+            }
+        }
+        "c.addiw" => {
+            let rd = rv64c::reg_full(inst) as u8;
+            JitOp::AluRI {
+                op: Alu::Add,
+                word: true,
+                rd,
+                rs1: rd,
+                imm: rv64c::imm_ci(inst) as i64,
+            }
+        }
+        "c.li" => JitOp::Li {
+            rd: rv64c::reg_full(inst) as u8,
+            imm: rv64c::imm_ci(inst) as i64,
+        },
+        "c.lui" => JitOp::Li {
+            rd: rv64c::reg_full(inst) as u8,
+            imm: rv64c::imm_clui(inst) as i64,
+        },
+        "c.addi4spn" => JitOp::AluRI {
+            op: Alu::Add,
+            word: false,
+            rd: rv64c::reg_4_2(inst) as u8,
+            rs1: 2,
+            imm: rv64c::uimm_addi4spn(inst) as i64,
+        },
+        "c.addi16sp" => JitOp::AluRI {
+            op: Alu::Add,
+            word: false,
+            rd: 2,
+            rs1: 2,
+            imm: rv64c::imm_addi16sp(inst) as i64,
+        },
+        "c.slli" => {
+            let rd = rv64c::reg_full(inst) as u8;
+            JitOp::AluRI {
+                op: Alu::Sll,
+                word: false,
+                rd,
+                rs1: rd,
+                imm: rv64c::shamt_ci(inst) as i64,
+            }
+        }
+        "c.srli" | "c.srai" => {
+            let rd = rv64c::reg_9_7(inst) as u8;
+            JitOp::AluRI {
+                op: if d.handler.name == "c.srli" {
+                    Alu::Srl
+                } else {
+                    Alu::Sra
+                },
+                word: false,
+                rd,
+                rs1: rd,
+                imm: rv64c::shamt_ci(inst) as i64,
+            }
+        }
+        "c.andi" => {
+            let rd = rv64c::reg_9_7(inst) as u8;
+            JitOp::AluRI {
+                op: Alu::And,
+                word: false,
+                rd,
+                rs1: rd,
+                imm: rv64c::imm_ci(inst) as i64,
+            }
+        }
+        "c.sub" | "c.xor" | "c.or" | "c.and" | "c.subw" | "c.addw" => {
+            let rd = rv64c::reg_9_7(inst) as u8;
+            let (op, word) = match d.handler.name {
+                "c.sub" => (Alu::Sub, false),
+                "c.xor" => (Alu::Xor, false),
+                "c.or" => (Alu::Or, false),
+                "c.and" => (Alu::And, false),
+                "c.subw" => (Alu::Sub, true),
+                _ => (Alu::Add, true),
+            };
+            JitOp::AluRR {
+                op,
+                word,
+                rd,
+                rs1: rd,
+                rs2: rv64c::reg_4_2(inst) as u8,
+            }
+        }
+        "c.mv" => JitOp::AluRR {
+            op: Alu::Add,
+            word: false,
+            rd: rv64c::reg_full(inst) as u8,
+            rs1: 0,
+            rs2: rv64c::reg_rs2(inst) as u8,
+        },
+        "c.add" => {
+            let rd = rv64c::reg_full(inst) as u8;
+            JitOp::AluRR {
+                op: Alu::Add,
+                word: false,
+                rd,
+                rs1: rd,
+                rs2: rv64c::reg_rs2(inst) as u8,
+            }
+        }
+        "c.lw" => JitOp::Load {
+            rd: rv64c::reg_4_2(inst) as u8,
+            rs1: rv64c::reg_9_7(inst) as u8,
+            imm: rv64c::uimm_w(inst) as i64,
+            size: 4,
+            signed: true,
+        },
+        "c.ld" => JitOp::Load {
+            rd: rv64c::reg_4_2(inst) as u8,
+            rs1: rv64c::reg_9_7(inst) as u8,
+            imm: rv64c::uimm_d(inst) as i64,
+            size: 8,
+            signed: true,
+        },
+        "c.sw" => JitOp::Store {
+            rs2: rv64c::reg_4_2(inst) as u8,
+            rs1: rv64c::reg_9_7(inst) as u8,
+            imm: rv64c::uimm_w(inst) as i64,
+            size: 4,
+        },
+        "c.sd" => JitOp::Store {
+            rs2: rv64c::reg_4_2(inst) as u8,
+            rs1: rv64c::reg_9_7(inst) as u8,
+            imm: rv64c::uimm_d(inst) as i64,
+            size: 8,
+        },
+        "c.lwsp" => JitOp::Load {
+            rd: rv64c::reg_full(inst) as u8,
+            rs1: 2,
+            imm: rv64c::uimm_lwsp(inst) as i64,
+            size: 4,
+            signed: true,
+        },
+        "c.ldsp" => JitOp::Load {
+            rd: rv64c::reg_full(inst) as u8,
+            rs1: 2,
+            imm: rv64c::uimm_ldsp(inst) as i64,
+            size: 8,
+            signed: true,
+        },
+        "c.swsp" => JitOp::Store {
+            rs2: rv64c::reg_rs2(inst) as u8,
+            rs1: 2,
+            imm: rv64c::uimm_swsp(inst) as i64,
+            size: 4,
+        },
+        "c.sdsp" => JitOp::Store {
+            rs2: rv64c::reg_rs2(inst) as u8,
+            rs1: 2,
+            imm: rv64c::uimm_sdsp(inst) as i64,
+            size: 8,
+        },
+        "c.j" => JitOp::Jal {
+            rd: 0,
+            link: next,
+            target: pc.wrapping_add(rv64c::imm_cj(inst)),
+        },
+        "c.jr" => JitOp::Jalr {
+            rd: 0,
+            rs1: rv64c::reg_full(inst) as u8,
+            imm: 0,
+            link: next,
+        },
+        "c.jalr" => JitOp::Jalr {
+            rd: 1,
+            rs1: rv64c::reg_full(inst) as u8,
+            imm: 0,
+            link: next,
+        },
+        "c.beqz" => JitOp::Branch {
+            cc: IntCC::Equal,
+            rs1: rv64c::reg_9_7(inst) as u8,
+            rs2: 0,
+            target: pc.wrapping_add(rv64c::imm_cb(inst)),
+            fall: next,
+        },
+        "c.bnez" => JitOp::Branch {
+            cc: IntCC::NotEqual,
+            rs1: rv64c::reg_9_7(inst) as u8,
+            rs2: 0,
+            target: pc.wrapping_add(rv64c::imm_cb(inst)),
+            fall: next,
+        },
+        // 其余指令（系统指令、除法、MMIO密集路径等）由解释器处理
+        _ => return None,
+    })
+}
+
+/// 读客户机寄存器（x0恒为0）
+fn read_reg(b: &mut FunctionBuilder, regs: Value, r: u8) -> Value {
+    if r == 0 {
+        b.ins().iconst(types::I64, 0)
+    } else {
+        b.ins()
+            .load(types::I64, MemFlags::trusted(), regs, (r as i32) * 8)
+    }
+}
+
+/// 写客户机寄存器（对x0的写被丢弃）
+fn write_reg(b: &mut FunctionBuilder, regs: Value, r: u8, v: Value) {
+    if r != 0 {
+        b.ins().store(MemFlags::trusted(), v, regs, (r as i32) * 8);
+    }
+}
+
+/// 在脏页位图中置位`off`所在页（与[`super::memory::Memory`]的
+/// `mark_dirty`同一布局：每u64覆盖64页，页内序号为低6位）
+fn emit_mark_dirty(b: &mut FunctionBuilder, dirty: Value, off: Value) {
+    let page = b.ins().ushr_imm(off, super::memory::PAGE_SHIFT as i64);
+    let word_off = b.ins().ushr_imm(page, 6 - 3); // 字节偏移 = (page >> 6) * 8
+    let word_off = b.ins().band_imm(word_off, !7);
+    let ptr = b.ins().iadd(dirty, word_off);
+    let cur = b.ins().load(types::I64, MemFlags::trusted(), ptr, 0);
+    let bit_idx = b.ins().band_imm(page, 63);
+    let one = b.ins().iconst(types::I64, 1);
+    let bit = b.ins().ishl(one, bit_idx);
+    let set = b.ins().bor(cur, bit);
+    b.ins().store(MemFlags::trusted(), set, ptr, 0);
+}
+
+/// 生成一条ALU运算（word为true时按32位计算后符号扩展，与解释器语义一致）
+fn emit_alu(b: &mut FunctionBuilder, op: Alu, word: bool, lhs: Value, rhs: Value) -> Value {
+    if word {
+        let l = b.ins().ireduce(types::I32, lhs);
+        let r = b.ins().ireduce(types::I32, rhs);
+        let v = match op {
+            Alu::Add => b.ins().iadd(l, r),
+            Alu::Sub => b.ins().isub(l, r),
+            // 移位量由指令自动按位宽取模，与RISC-V的5位截断一致
+            Alu::Sll => b.ins().ishl(l, r),
+            Alu::Srl => b.ins().ushr(l, r),
+            Alu::Sra => b.ins().sshr(l, r),
+            Alu::Mul => b.ins().imul(l, r),
+            _ => unreachable!("ALU op {:?} has no word form", op),
+        };
+        b.ins().sextend(types::I64, v)
+    } else {
+        match op {
+            Alu::Add => b.ins().iadd(lhs, rhs),
+            Alu::Sub => b.ins().isub(lhs, rhs),
+            Alu::Sll => b.ins().ishl(lhs, rhs),
+            Alu::Srl => b.ins().ushr(lhs, rhs),
+            Alu::Sra => b.ins().sshr(lhs, rhs),
+            Alu::Xor => b.ins().bxor(lhs, rhs),
+            Alu::Or => b.ins().bor(lhs, rhs),
+            Alu::And => b.ins().band(lhs, rhs),
+            Alu::Mul => b.ins().imul(lhs, rhs),
+            Alu::Slt => {
+                let c = b.ins().icmp(IntCC::SignedLessThan, lhs, rhs);
+                b.ins().uextend(types::I64, c)
+            }
+            Alu::Sltu => {
+                let c = b.ins().icmp(IntCC::UnsignedLessThan, lhs, rhs);
+                b.ins().uextend(types::I64, c)
+            }
+        }
+    }
+}
+
+/// Cranelift JIT编译器：持有JIT模块，按需编译热基本块
+pub struct Jit {
+    module: JITModule,
+    func_ctx: FunctionBuilderContext,
+}
+
+impl Jit {
+    pub fn new() -> Self {
+        let builder = JITBuilder::new(cranelift_module::default_libcall_names())
+            .expect("无法创建宿主平台的JIT构建器");
+        Jit {
+            module: JITModule::new(builder),
+            func_ctx: FunctionBuilderContext::new(),
+        }
+    }
+
+    /// 编译一个基本块，返回可直接调用的宿主函数
+    ///
+    /// 从首条不支持的指令（或编译期可知的非对齐跳转目标）起截断，
+    /// 截断处生成bail返回；首条指令即不支持时返回 `None`。
+    pub fn compile(
+        &mut self,
+        blk: &Block,
+        mem_base: u64,
+        mem_size: u64,
+        c_ext: bool,
+    ) -> Option<CompiledBlock> {
+        // ---- 降级 ----
+        let mut ops: Vec<(u64, JitOp)> = Vec::with_capacity(blk.insts.len());
+        // 截断处的bail PC（该处及之后的指令交给解释器）
+        let mut bail_at: Option<u64> = None;
+        // 全部指令顺序执行完的落空PC
+        let mut fall_through = blk.start;
+        for (i, d) in blk.insts.iter().enumerate() {
+            let op = lower(d);
+            // IALIGN=32时编译期已知的非对齐目标按不支持处理（解释器负责报异常）
+            let supported = match op {
+                Some(op) => !matches!(op.static_target(), Some(t) if !c_ext && t & 0b11 != 0),
+                None => false,
+            };
+            if !supported {
+                if i == 0 {
+                    return None;
+                }
+                bail_at = Some(d.pc);
+                break;
+            }
+            ops.push((d.pc, op.unwrap()));
+            fall_through = d.pc.wrapping_add(d.len);
+        }
+
+        // ---- 代码生成 ----
+        let mut ctx = self.module.make_context();
+        let ptr_t = self.module.target_config().pointer_type();
+        ctx.func.signature.params.push(AbiParam::new(ptr_t));
+        ctx.func.signature.params.push(AbiParam::new(ptr_t));
+        ctx.func.signature.params.push(AbiParam::new(ptr_t));
+        ctx.func.signature.returns.push(AbiParam::new(types::I64));
+
+        let mut b = FunctionBuilder::new(&mut ctx.func, &mut self.func_ctx);
+        let entry = b.create_block();
+        b.append_block_params_for_function_params(entry);
+        b.switch_to_block(entry);
+        b.seal_block(entry);
+        let regs = b.block_params(entry)[0];
+        let mem = b.block_params(entry)[1];
+        let dirty = b.block_params(entry)[2];
+
+        // 计算客户机地址对应的宿主地址与主内存内偏移，
+        // 越界（含MMIO）时bail回解释器
+        let guest_ea = |b: &mut FunctionBuilder, rs1: u8, imm: i64, size: u8, pc: u64| {
+            let base = read_reg(b, regs, rs1);
+            let addr = b.ins().iadd_imm(base, imm);
+            let off = b.ins().iadd_imm(addr, (mem_base as i64).wrapping_neg());
+            let limit = (mem_size - size as u64 + 1) as i64;
+            let in_range = b.ins().icmp_imm(IntCC::UnsignedLessThan, off, limit);
+            let ok_blk = b.create_block();
+            let bail_blk = b.create_block();
+            b.ins().brif(in_range, ok_blk, &[], bail_blk, &[]);
+            b.seal_block(ok_blk);
+            b.seal_block(bail_blk);
+            b.switch_to_block(bail_blk);
+            let ret = b.ins().iconst(types::I64, (pc | 1) as i64);
+            b.ins().return_(&[ret]);
+            b.switch_to_block(ok_blk);
+            (b.ins().iadd(mem, off), off)
+        };
+
+        let mut terminated = false;
+        for &(pc, op) in &ops {
+            match op {
+                JitOp::Li { rd, imm } => {
+                    let v = b.ins().iconst(types::I64, imm);
+                    write_reg(&mut b, regs, rd, v);
+                }
+                JitOp::AluRI {
+                    op,
+                    word,
+                    rd,
+                    rs1,
+                    imm,
+                } => {
+                    let lhs = read_reg(&mut b, regs, rs1);
+                    let rhs = b.ins().iconst(types::I64, imm);
+                    let v = emit_alu(&mut b, op, word, lhs, rhs);
+                    write_reg(&mut b, regs, rd, v);
+                }
+                JitOp::AluRR {
+                    op,
+                    word,
+                    rd,
+                    rs1,
+                    rs2,
+                } => {
+                    let lhs = read_reg(&mut b, regs, rs1);
+                    let rhs = read_reg(&mut b, regs, rs2);
+                    let v = emit_alu(&mut b, op, word, lhs, rhs);
+                    write_reg(&mut b, regs, rd, v);
+                }
+                JitOp::Load {
+                    rd,
+                    rs1,
+                    imm,
+                    size,
+                    signed,
+                } => {
+                    let (ea, _) = guest_ea(&mut b, rs1, imm, size, pc);
+                    let flags = MemFlags::new();
+                    let v = match (size, signed) {
+                        (1, true) => b.ins().sload8(types::I64, flags, ea, 0),
+                        (1, false) => b.ins().uload8(types::I64, flags, ea, 0),
+                        (2, true) => b.ins().sload16(types::I64, flags, ea, 0),
+                        (2, false) => b.ins().uload16(types::I64, flags, ea, 0),
+                        (4, true) => b.ins().sload32(flags, ea, 0),
+                        (4, false) => b.ins().uload32(flags, ea, 0),
+                        (8, _) => b.ins().load(types::I64, flags, ea, 0),
+                        _ => unreachable!("invalid load size {}", size),
+                    };
+                    write_reg(&mut b, regs, rd, v);
+                }
+                JitOp::Store {
+                    rs2,
+                    rs1,
+                    imm,
+                    size,
+                } => {
+                    let (ea, off) = guest_ea(&mut b, rs1, imm, size, pc);
+                    let v = read_reg(&mut b, regs, rs2);
+                    let flags = MemFlags::new();
+                    match size {
+                        1 => b.ins().istore8(flags, v, ea, 0),
+                        2 => b.ins().istore16(flags, v, ea, 0),
+                        4 => b.ins().istore32(flags, v, ea, 0),
+                        8 => b.ins().store(flags, v, ea, 0),
+                        _ => unreachable!("invalid store size {}", size),
+                    };
+                    // 脏页标记：批量复位、快照与脏页哈希都从位图取页集合
+                    emit_mark_dirty(&mut b, dirty, off);
+                    if size > 1 {
+                        // 非对齐写可能跨页，末字节所在页也置位
+                        let end = b.ins().iadd_imm(off, (size - 1) as i64);
+                        emit_mark_dirty(&mut b, dirty, end);
+                    }
+                }
+                JitOp::Jal { rd, link, target } => {
+                    let l = b.ins().iconst(types::I64, link as i64);
+                    write_reg(&mut b, regs, rd, l);
+                    let t = b.ins().iconst(types::I64, target as i64);
+                    b.ins().return_(&[t]);
+                    terminated = true;
+                }
+                JitOp::Jalr { rd, rs1, imm, link } => {
+                    // 先算目标再写链接寄存器，rd与rs1相同时语义才正确
+                    let base = read_reg(&mut b, regs, rs1);
+                    let t0 = b.ins().iadd_imm(base, imm);
+                    let target = b.ins().band_imm(t0, -2);
+                    if !c_ext {
+                        // IALIGN=32：运行期才知道目标，非对齐时bail给解释器报异常
+                        let mis = b.ins().band_imm(target, 0b10);
+                        let ok_blk = b.create_block();
+                        let bail_blk = b.create_block();
+                        b.ins().brif(mis, bail_blk, &[], ok_blk, &[]);
+                        b.seal_block(ok_blk);
+                        b.seal_block(bail_blk);
+                        b.switch_to_block(bail_blk);
+                        let ret = b.ins().iconst(types::I64, (pc | 1) as i64);
+                        b.ins().return_(&[ret]);
+                        b.switch_to_block(ok_blk);
+                    }
+                    let l = b.ins().iconst(types::I64, link as i64);
+                    write_reg(&mut b, regs, rd, l);
+                    b.ins().return_(&[target]);
+                    terminated = true;
+                }
+                JitOp::Branch {
+                    cc,
+                    rs1,
+                    rs2,
+                    target,
+                    fall,
+                } => {
+                    let lhs = read_reg(&mut b, regs, rs1);
+                    let rhs = read_reg(&mut b, regs, rs2);
+                    let c = b.ins().icmp(cc, lhs, rhs);
+                    let tv = b.ins().iconst(types::I64, target as i64);
+                    let fv = b.ins().iconst(types::I64, fall as i64);
+                    let v = b.ins().select(c, tv, fv);
+                    b.ins().return_(&[v]);
+                    terminated = true;
+                }
+            }
+        }
+
+        if !terminated {
+            // 块被截断（bail）或自然落空（达到块长上限）
+            let ret_pc = match bail_at {
+                Some(pc) => pc | 1,
+                None => fall_through,
+            };
+            let ret = b.ins().iconst(types::I64, ret_pc as i64);
+            b.ins().return_(&[ret]);
+        }
+        b.finalize();
+
+        // ---- 定义并取回宿主代码 ----
+        let id = self
+            .module
+            .declare_anonymous_function(&ctx.func.signature)
+            .ok()?;
+        self.module.define_function(id, &mut ctx).ok()?;
+        self.module.clear_context(&mut ctx);
+        self.module.finalize_definitions().ok()?;
+        let code = self.module.get_finalized_function(id);
+        // 安全性：签名与上面构造的Cranelift签名逐参数对应
+        Some(unsafe { mem::transmute::<*const u8, CompiledBlock>(code) })
+    }
+}
+
+impl Default for Jit {
+    fn default() -> Self {
+        Self::new()
+    }
+}
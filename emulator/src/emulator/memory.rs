@@ -1,6 +1,6 @@
 //! 内存管理模块
 
-use std::cell::RefCell;
+use std::cell::{Cell, RefCell};
 use std::rc::Rc;
 use std::sync::{Arc, Mutex};
 
@@ -9,6 +9,25 @@ use mmio_trait::{MmioDevice, DeviceError};
 
 use crate::const_values::EmuConfig;
 
+/// 脏页跟踪的页大小（字节），也是快照增量复制与TLB的粒度
+pub const PAGE_SIZE: usize = 4096;
+/// 页内偏移的位数（PAGE_SIZE = 1 << PAGE_SHIFT）
+pub(crate) const PAGE_SHIFT: u32 = PAGE_SIZE.trailing_zeros();
+/// 软件TLB条目数（直接映射，每条覆盖一个主内存页）
+const TLB_ENTRIES: usize = 64;
+
+// 页粒度区域查找表的特殊条目；其余值为mmio_regions的下标
+/// 未映射地址
+const PAGE_UNMAPPED: u8 = 0xff;
+/// 主内存
+const PAGE_RAM: u8 = 0xfe;
+/// 同一页内有多个MMIO区域，回退二分查找
+const PAGE_MMIO_MULTI: u8 = 0xfd;
+
+/// FNV-1a哈希参数（脏页哈希用；difftest侧按同一参数复算）
+pub(crate) const FNV_OFFSET: u64 = 0xcbf2_9ce4_8422_2325;
+pub(crate) const FNV_PRIME: u64 = 0x100_0000_01b3;
+
 /// 内存错误类型
 #[derive(Debug, Error)]
 pub enum MemoryError {
@@ -20,13 +39,214 @@ pub enum MemoryError {
     MmioOverlap { addr: u64 },
     #[error("设备错误: {0}")]
     Device(#[from] DeviceError),
+    #[error("宿主内存分配失败: mmap errno {0}")]
+    HostAlloc(i32),
+}
+
+/// 匿名私有映射承载的客户机主内存
+///
+/// 内核在页首次被写入时才实际分配并清零物理页：`memory_size`配得
+/// 再大，未触碰的部分既不占驻留内存也不花启动时的清零时间。对
+/// 短小程序的批量运行，这把上电成本从O(内存大小)降到O(实际用量)
+struct HostMem {
+    ptr: std::ptr::NonNull<u8>,
+    len: usize,
+}
+
+impl HostMem {
+    fn new(len: usize) -> Result<Self, MemoryError> {
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_PRIVATE | libc::MAP_ANONYMOUS | libc::MAP_NORESERVE,
+                -1,
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(MemoryError::HostAlloc(
+                std::io::Error::last_os_error().raw_os_error().unwrap_or(0),
+            ));
+        }
+        Ok(Self {
+            ptr: std::ptr::NonNull::new(ptr as *mut u8).unwrap(),
+            len,
+        })
+    }
+
+    /// 映射基址的裸指针（TLB等直接寻址的快路径使用）
+    #[inline(always)]
+    fn base_ptr(&self) -> *mut u8 {
+        self.ptr.as_ptr()
+    }
+}
+
+impl Drop for HostMem {
+    fn drop(&mut self) {
+        unsafe {
+            libc::munmap(self.ptr.as_ptr() as *mut libc::c_void, self.len);
+        }
+    }
+}
+
+impl std::ops::Deref for HostMem {
+    type Target = [u8];
+    #[inline(always)]
+    fn deref(&self) -> &[u8] {
+        unsafe { std::slice::from_raw_parts(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl std::ops::DerefMut for HostMem {
+    #[inline(always)]
+    fn deref_mut(&mut self) -> &mut [u8] {
+        unsafe { std::slice::from_raw_parts_mut(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl std::fmt::Debug for HostMem {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("HostMem").field("len", &self.len).finish()
+    }
+}
+
+/// 内存访问计数（perf-stats专用）
+///
+/// 用 `Cell` 使只读访问路径也能累加；普通u64操作，开销可忽略
+#[cfg(feature = "perf-stats")]
+#[derive(Debug, Default)]
+pub struct MemStats {
+    /// 主内存读次数（通用 `read` 路径）
+    pub mem_reads: std::cell::Cell<u64>,
+    /// 主内存写次数（通用 `write` 路径）
+    pub mem_writes: std::cell::Cell<u64>,
+    /// MMIO读次数
+    pub mmio_reads: std::cell::Cell<u64>,
+    /// MMIO写次数
+    pub mmio_writes: std::cell::Cell<u64>,
+    /// 取指快路径（`read_u32_fast`）次数
+    pub fetch_fast: std::cell::Cell<u64>,
+    /// 取指慢路径（MMIO或边界情况）次数
+    pub fetch_slow: std::cell::Cell<u64>,
+}
+
+#[cfg(feature = "perf-stats")]
+impl MemStats {
+    #[inline(always)]
+    pub(crate) fn bump(counter: &std::cell::Cell<u64>) {
+        counter.set(counter.get() + 1);
+    }
+}
+
+/// 载入/存储快路径的直接映射软件TLB
+///
+/// 客户机页号直接映射到宿主页基址：命中时一次掩码+比较就换来裸
+/// 指针访问，省去逐次的基址换算与区域判断。条目只装入主内存页，
+/// MMIO区域与主内存不可重叠，因此命中不可能落到设备上
+#[derive(Debug)]
+struct Tlb {
+    /// 客户机页号标签（`u64::MAX`表示空条目）
+    tags: [Cell<u64>; TLB_ENTRIES],
+    /// 对应的宿主页基址
+    hosts: [Cell<*mut u8>; TLB_ENTRIES],
+}
+
+impl Tlb {
+    fn new() -> Self {
+        Self {
+            tags: std::array::from_fn(|_| Cell::new(u64::MAX)),
+            hosts: std::array::from_fn(|_| Cell::new(std::ptr::null_mut())),
+        }
+    }
+
+    /// 查找覆盖 `addr` 起 `size` 字节的宿主指针；跨页或未命中返回None
+    #[inline(always)]
+    fn lookup(&self, addr: u64, size: usize) -> Option<*mut u8> {
+        let off = addr as usize & (PAGE_SIZE - 1);
+        if off + size > PAGE_SIZE {
+            return None;
+        }
+        let page = addr >> PAGE_SHIFT;
+        let idx = page as usize & (TLB_ENTRIES - 1);
+        if self.tags[idx].get() == page {
+            Some(unsafe { self.hosts[idx].get().add(off) })
+        } else {
+            None
+        }
+    }
+
+    /// 装入 `addr` 所在页（`host_page` 为该页的宿主基址）
+    #[inline(always)]
+    fn fill(&self, addr: u64, host_page: *mut u8) {
+        let page = addr >> PAGE_SHIFT;
+        let idx = page as usize & (TLB_ENTRIES - 1);
+        self.tags[idx].set(page);
+        self.hosts[idx].set(host_page);
+    }
+
+    /// 整体失效
+    fn flush(&self) {
+        for tag in &self.tags {
+            tag.set(u64::MAX);
+        }
+    }
+}
+
+/// 遍历页位图中所有置位的页号（升序）
+fn iter_set_pages(bitmap: &[u64]) -> impl Iterator<Item = usize> + '_ {
+    bitmap.iter().enumerate().flat_map(|(word_idx, &word)| {
+        let mut w = word;
+        std::iter::from_fn(move || {
+            if w == 0 {
+                return None;
+            }
+            let bit = w.trailing_zeros() as usize;
+            w &= w - 1;
+            Some((word_idx << 6) | bit)
+        })
+    })
+}
+
+/// MMIO设备容器
+///
+/// 模拟器今天在一个宿主线程上运行（多hart也只是轮转调度），设备
+/// 访问默认走`Local`，免掉客户机轮询设备寄存器时每次一对原子
+/// 锁/解锁；`Shared`保留`Arc<Mutex>`给未来真正线程化的配置
+#[derive(Clone)]
+pub enum DeviceCell {
+    /// 单线程路径：无原子操作的内部可变性
+    Local(Rc<RefCell<dyn MmioDevice>>),
+    /// 跨线程共享路径（线程化配置使用）
+    Shared(Arc<Mutex<dyn MmioDevice>>),
+}
+
+impl DeviceCell {
+    /// 以独占访问执行一次设备操作
+    #[inline(always)]
+    pub fn with<R>(&self, f: impl FnOnce(&mut dyn MmioDevice) -> R) -> R {
+        match self {
+            DeviceCell::Local(d) => f(&mut *d.borrow_mut()),
+            DeviceCell::Shared(d) => f(&mut *d.lock().unwrap()),
+        }
+    }
+}
+
+impl std::fmt::Debug for DeviceCell {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            DeviceCell::Local(_) => write!(f, "DeviceCell::Local"),
+            DeviceCell::Shared(_) => write!(f, "DeviceCell::Shared"),
+        }
+    }
 }
 
 /// MMIO 区域
 pub struct MmioRegion {
     pub base: u64,
     pub size: u64,
-    pub device: Arc<Mutex<dyn MmioDevice>>,
+    pub device: DeviceCell,
     pub name: String,
 }
 
@@ -43,8 +263,8 @@ impl std::fmt::Debug for MmioRegion {
 /// 内存管理结构
 #[derive(Debug)]
 pub struct Memory {
-    /// 内存数据
-    data: Vec<u8>,
+    /// 内存数据（匿名mmap，页按需物化）
+    data: HostMem,
     #[allow(unused)]
     config: Rc<EmuConfig>,
     /// 主内存基地址（来自设备配置文件）
@@ -53,8 +273,23 @@ pub struct Memory {
     memory_size: usize,
     /// MMIO 区域列表
     mmio_regions: Vec<MmioRegion>,
+    /// 页号→区域种类的平面查找表（RAM/具体设备/未映射）
+    page_kinds: Vec<u8>,
     /// is last mmio
     is_last_mmio: RefCell<bool>,
+    /// 读TLB（典型的载入数据路径）
+    rtlb: Tlb,
+    /// 写TLB：条目装入时页已标脏，命中路径不再维护脏页位图
+    wtlb: Tlb,
+    /// 脏页位图：每页1位，记录上次检查点（或创建）以来被写过的页
+    dirty: Vec<u64>,
+    /// 自上次复位以来被写过、但脏位已被检查点/回滚消费掉的页
+    touched: Vec<u64>,
+    /// 内存检查点基线：首次快照时全量复制，之后只增量同步脏页
+    checkpoint: Option<Vec<u8>>,
+    /// 访问计数（perf-stats专用）
+    #[cfg(feature = "perf-stats")]
+    pub stats: MemStats,
 }
 
 impl Memory {
@@ -64,14 +299,60 @@ impl Memory {
         if !size.is_power_of_two() {
             return Err(MemoryError::Misaligned { addr: 0, alignment: 2 });
         }
-        Ok(Self {
-            data: vec![0; size],
+        let mut memory = Self {
+            data: HostMem::new(size)?,
             config,
             memory_base: device_file.memory.memory_base,
             memory_size: device_file.memory.memory_size * 1024 * 1024,
             mmio_regions: Vec::new(),
+            page_kinds: Vec::new(),
             is_last_mmio: RefCell::new(false),
-        })
+            rtlb: Tlb::new(),
+            wtlb: Tlb::new(),
+            dirty: vec![0; size / PAGE_SIZE / 64 + 1],
+            touched: vec![0; size / PAGE_SIZE / 64 + 1],
+            checkpoint: None,
+            #[cfg(feature = "perf-stats")]
+            stats: MemStats::default(),
+        };
+        memory.rebuild_page_table();
+        Ok(memory)
+    }
+
+    /// 重建页粒度的区域查找表
+    ///
+    /// 表按4KB页把地址空间映射到 主内存/具体设备/未映射，区域解析
+    /// 变成一次移位加一次表载入。小于一页的设备命中后仍核对精确
+    /// 范围；同页多设备的罕见布局回退到二分查找
+    fn rebuild_page_table(&mut self) {
+        let mut end = self.memory_base + self.memory_size as u64;
+        for region in &self.mmio_regions {
+            end = end.max(region.base + region.size);
+        }
+        let pages = (end as usize).div_ceil(PAGE_SIZE);
+        let mut table = vec![PAGE_UNMAPPED; pages];
+
+        let ram_first = (self.memory_base >> PAGE_SHIFT) as usize;
+        let ram_last = ((self.memory_base + self.memory_size as u64) >> PAGE_SHIFT) as usize;
+        table[ram_first..ram_last].fill(PAGE_RAM);
+
+        for (idx, region) in self.mmio_regions.iter().enumerate() {
+            let kind = if idx < PAGE_MMIO_MULTI as usize {
+                idx as u8
+            } else {
+                PAGE_MMIO_MULTI
+            };
+            let first = (region.base >> PAGE_SHIFT) as usize;
+            let last = ((region.base + region.size - 1) >> PAGE_SHIFT) as usize;
+            for entry in &mut table[first..=last] {
+                *entry = if *entry == PAGE_UNMAPPED {
+                    kind
+                } else {
+                    PAGE_MMIO_MULTI
+                };
+            }
+        }
+        self.page_kinds = table;
     }
 
     /// 映射 MMIO 设备
@@ -79,7 +360,7 @@ impl Memory {
         &mut self,
         base: u64,
         size: u64,
-        device: Arc<Mutex<dyn MmioDevice>>,
+        device: DeviceCell,
         name: String,
     ) -> Result<(), MemoryError> {
         let new_end = base + size;
@@ -103,6 +384,10 @@ impl Memory {
             device,
             name,
         });
+        // 地址空间布局变化：重建页查找表，保守地清空两个TLB
+        self.rebuild_page_table();
+        self.rtlb.flush();
+        self.wtlb.flush();
 
         Ok(())
     }
@@ -110,14 +395,38 @@ impl Memory {
     /// 排序 MMIO 区域
     pub fn sort_mmio_regions(&mut self) {
         self.mmio_regions.sort_by_key(|region| region.base);
+        // 区域下标变化，页查找表须重建
+        self.rebuild_page_table();
+    }
+
+    /// 按名字查找已映射的设备（调度器登记等冷路径使用）
+    pub fn device_by_name(&self, name: &str) -> Option<DeviceCell> {
+        self.mmio_regions
+            .iter()
+            .find(|r| r.name == name)
+            .map(|r| r.device.clone())
     }
 
     /// 查找覆盖指定地址的 MMIO 区域
+    ///
+    /// 页查找表直接给出候选区域，常规布局下一次移位一次表载入；
+    /// 子页大小的设备命中后核对精确范围，同页多设备回退二分查找
     #[inline(always)]
     fn find_mmio_region(&self, addr: u64) -> Option<&MmioRegion> {
-        // self.mmio_regions
-        //     .iter()
-        //     .find(|region| addr >= region.base && addr < region.base + region.size)
+        let page = (addr >> PAGE_SHIFT) as usize;
+        match self.page_kinds.get(page).copied().unwrap_or(PAGE_UNMAPPED) {
+            PAGE_UNMAPPED | PAGE_RAM => None,
+            PAGE_MMIO_MULTI => self.find_mmio_region_slow(addr),
+            idx => {
+                let region = &self.mmio_regions[idx as usize];
+                (addr >= region.base && addr < region.base + region.size).then_some(region)
+            }
+        }
+    }
+
+    /// 二分查找回退路径（仅同页多设备的布局使用）
+    #[cold]
+    fn find_mmio_region_slow(&self, addr: u64) -> Option<&MmioRegion> {
         self.mmio_regions
             .binary_search_by(|region| {
                 let start = region.base;
@@ -148,6 +457,9 @@ impl Memory {
     pub fn unmap_mmio(&mut self, base: u64) -> bool {
         if let Some(index) = self.mmio_regions.iter().position(|r| r.base == base) {
             self.mmio_regions.remove(index);
+            self.rebuild_page_table();
+            self.rtlb.flush();
+            self.wtlb.flush();
             true
         } else {
             false
@@ -186,6 +498,8 @@ impl Memory {
     #[inline(always)]
     pub fn read(&self, addr: u64, size: usize) -> Result<Vec<u8>, MemoryError> {
         if self.is_mem_region(addr) {
+            #[cfg(feature = "perf-stats")]
+            MemStats::bump(&self.stats.mem_reads);
             // 普通内存访问 - 根据长度选择优化路径
             match size {
                 1 => {
@@ -235,9 +549,17 @@ impl Memory {
 
         // 检查是否为 MMIO 访问
         if let Some(region) = self.find_mmio_region(addr) {
+            #[cfg(feature = "perf-stats")]
+            MemStats::bump(&self.stats.mmio_reads);
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            let res = device.read(offset, size)?;
+            // 寄存器宽度的访问走read保留设备副作用语义，更长的走批量接口
+            let res = if size <= 8 {
+                region.device.with(|d| d.read(offset, size))?
+            } else {
+                let mut buf = vec![0u8; size];
+                region.device.with(|d| d.read_block(offset, &mut buf))?;
+                buf
+            };
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(res);
         }
@@ -245,6 +567,46 @@ impl Memory {
         Err(MemoryError::OutOfBounds { addr, size })
     }
 
+    /// 读取内存到调用方提供的缓冲区（零分配版本）
+    ///
+    /// 主内存区域直接按切片复制；MMIO回退到设备读。长度只在运行时
+    /// 确定的热调用方（向量访存、GDB内存读取）使用，不经过`Vec`中转
+    #[inline(always)]
+    pub fn read_into(&self, addr: u64, buf: &mut [u8]) -> Result<(), MemoryError> {
+        // 不论对齐与否：落在单页内的主内存读直接按宿主指针复制
+        if let Some(p) = self.rtlb.lookup(addr, buf.len()) {
+            unsafe { std::ptr::copy_nonoverlapping(p, buf.as_mut_ptr(), buf.len()) };
+            return Ok(());
+        }
+        if self.is_mem_region(addr) {
+            #[cfg(feature = "perf-stats")]
+            MemStats::bump(&self.stats.mem_reads);
+            if !self.is_mem_region_range(addr, buf.len()) {
+                return Err(MemoryError::OutOfBounds { addr, size: buf.len() });
+            }
+            let start = addr.wrapping_sub(self.memory_base) as usize;
+            buf.copy_from_slice(&self.data[start..start + buf.len()]);
+            return Ok(());
+        }
+
+        // 检查是否为 MMIO 访问
+        if let Some(region) = self.find_mmio_region(addr) {
+            #[cfg(feature = "perf-stats")]
+            MemStats::bump(&self.stats.mmio_reads);
+            let offset = addr - region.base;
+            if buf.len() <= 8 {
+                let res = region.device.with(|d| d.read(offset, buf.len()))?;
+                buf.copy_from_slice(&res);
+            } else {
+                region.device.with(|d| d.read_block(offset, buf))?;
+            }
+            *self.is_last_mmio.borrow_mut() = true;
+            return Ok(());
+        }
+
+        Err(MemoryError::OutOfBounds { addr, size: buf.len() })
+    }
+
     /// 快速读取u32指令（unsafe版本，仅用于取指）
     /// 假设地址有效且在主内存范围内，跳过边界检查和MMIO检查以提高性能
     #[inline(always)]
@@ -291,15 +653,33 @@ impl Memory {
         }
     }
 
+    /// 标记主内存偏移 `real_addr` 起 `len` 字节覆盖的页为脏
+    ///
+    /// 常见的页内访问只置一位；非对齐访问可能跨页，循环覆盖
+    #[inline(always)]
+    fn mark_dirty(&mut self, real_addr: usize, len: usize) {
+        let mut page = real_addr / PAGE_SIZE;
+        let last = (real_addr + len - 1) / PAGE_SIZE;
+        loop {
+            self.dirty[page >> 6] |= 1 << (page & 63);
+            if page >= last {
+                break;
+            }
+            page += 1;
+        }
+    }
+
     /// 快速写入字节（unsafe版本）
     #[inline(always)]
     unsafe fn write_byte_unsafe(&mut self, real_addr: usize, value: u8) {
+        self.mark_dirty(real_addr, 1);
         unsafe { *self.data.get_unchecked_mut(real_addr) = value; }
     }
 
     /// 快速写入半字（unsafe版本）
     #[inline(always)]
     unsafe fn write_halfword_unsafe(&mut self, real_addr: usize, value: u16) {
+        self.mark_dirty(real_addr, 2);
         unsafe {
             let ptr = self.data.as_mut_ptr().add(real_addr) as *mut u16;
             ptr.write_unaligned(value.to_le());
@@ -309,6 +689,7 @@ impl Memory {
     /// 快速写入字（unsafe版本）
     #[inline(always)]
     unsafe fn write_word_unsafe(&mut self, real_addr: usize, value: u32) {
+        self.mark_dirty(real_addr, 4);
         unsafe {
             let ptr = self.data.as_mut_ptr().add(real_addr) as *mut u32;
             ptr.write_unaligned(value.to_le());
@@ -318,6 +699,7 @@ impl Memory {
     /// 快速写入双字（unsafe版本）
     #[inline(always)]
     unsafe fn write_doubleword_unsafe(&mut self, real_addr: usize, value: u64) {
+        self.mark_dirty(real_addr, 8);
         unsafe {
             let ptr = self.data.as_mut_ptr().add(real_addr) as *mut u64;
             ptr.write_unaligned(value.to_le());
@@ -327,7 +709,15 @@ impl Memory {
     /// 写入内存
     #[inline(always)]
     pub fn write(&mut self, addr: u64, data: &[u8]) -> Result<(), MemoryError> {
+        // 不论对齐与否：落在单页内的主内存写直接按宿主指针复制
+        // （写TLB条目装入时页已标脏）
+        if let Some(p) = self.wtlb.lookup(addr, data.len()) {
+            unsafe { std::ptr::copy_nonoverlapping(data.as_ptr(), p, data.len()) };
+            return Ok(());
+        }
         if self.is_mem_region(addr) {
+            #[cfg(feature = "perf-stats")]
+            MemStats::bump(&self.stats.mem_writes);
             // 普通内存访问 - 根据长度选择优化路径
             match data.len() {
                 1 => {
@@ -372,6 +762,7 @@ impl Memory {
                     // 非标准长度，使用传统方法
                     let real_addr = self.translate_address(addr, data.len(), 1)?;
                     let start = real_addr as usize;
+                    self.mark_dirty(start, data.len());
                     self.data[start..start + data.len()].copy_from_slice(data);
                 }
             }
@@ -380,16 +771,117 @@ impl Memory {
 
         // 检查是否为 MMIO 访问
         if let Some(region) = self.find_mmio_region(addr) {
+            #[cfg(feature = "perf-stats")]
+            MemStats::bump(&self.stats.mmio_writes);
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            device.write(offset, data)?;
+            if data.len() <= 8 {
+                region.device.with(|d| d.write(offset, data))?;
+            } else {
+                region.device.with(|d| d.write_block(offset, data))?;
+            }
             *self.is_last_mmio.borrow_mut() = true;
+            // DMA设备在门铃写里挂起传输请求：MMIO处理器看不到客户机
+            // 内存，这里取走请求并对主内存切片直接执行
+            if let Some(req) = region.device.with(|d| d.take_dma_request()) {
+                let device = region.device.clone();
+                self.service_dma(&device, req);
+            }
             return Ok(());
         }
 
         Err(MemoryError::OutOfBounds { addr, size: data.len() })
     }
 
+    /// 执行设备挂起的DMA请求并把结果回报给设备
+    ///
+    /// 传输同步完成：客户机的门铃MMIO写返回后立即能从状态寄存器
+    /// 读到结果
+    fn service_dma(&mut self, device: &DeviceCell, req: mmio_trait::DmaRequest) {
+        let result = self.run_dma(&req);
+        device.with(|d| d.complete_dma(result));
+    }
+
+    /// 宿主文件与主内存切片之间的成块搬运，返回实际传输字节数
+    ///
+    /// 没有逐字MMIO：读方向是一次read(2)循环直接落进主内存并标脏，
+    /// 写方向把内存切片一次write_all到文件
+    fn run_dma(&mut self, req: &mmio_trait::DmaRequest) -> Result<u64, String> {
+        use std::io::{Read, Seek, SeekFrom, Write};
+
+        let len = req.len as usize;
+        if len == 0 {
+            return Ok(0);
+        }
+        if !self.is_mem_region_range(req.guest_addr, len) {
+            return Err(format!(
+                "DMA 客户机区间越界: {:#x}+{:#x}",
+                req.guest_addr, req.len
+            ));
+        }
+        let start = req.guest_addr.wrapping_sub(self.memory_base) as usize;
+
+        if req.to_file {
+            let mut file = std::fs::OpenOptions::new()
+                .write(true)
+                .create(true)
+                .open(&req.path)
+                .map_err(|e| format!("DMA 打开文件 '{}' 失败: {}", req.path, e))?;
+            file.seek(SeekFrom::Start(req.file_offset))
+                .and_then(|_| file.write_all(&self.data[start..start + len]))
+                .map_err(|e| format!("DMA 写文件 '{}' 失败: {}", req.path, e))?;
+            Ok(req.len)
+        } else {
+            let mut file = std::fs::File::open(&req.path)
+                .map_err(|e| format!("DMA 打开文件 '{}' 失败: {}", req.path, e))?;
+            file.seek(SeekFrom::Start(req.file_offset))
+                .map_err(|e| format!("DMA 定位文件 '{}' 失败: {}", req.path, e))?;
+            // 短文件按实际长度截断，回报传输字节数
+            let mut done = 0usize;
+            while done < len {
+                match file.read(&mut self.data[start + done..start + len]) {
+                    Ok(0) => break,
+                    Ok(n) => done += n,
+                    Err(e) => return Err(format!("DMA 读文件 '{}' 失败: {}", req.path, e)),
+                }
+            }
+            if done > 0 {
+                self.mark_dirty(start, done);
+            }
+            Ok(done as u64)
+        }
+    }
+
+    /// 主内存宿主指针（JIT生成的代码直接以 基址+偏移 访问）
+    ///
+    /// 编译代码的store经[`Self::dirty_ptr`]回写脏页位图，reset/快照/
+    /// difftest看到的脏页集合与解释执行一致
+    #[cfg(feature = "jit")]
+    #[inline(always)]
+    pub(crate) fn host_ptr(&mut self) -> *mut u8 {
+        self.data.as_mut_ptr()
+    }
+
+    /// 脏页位图宿主指针（JIT编译的store写入后直接置位对应页）
+    #[cfg(feature = "jit")]
+    #[inline(always)]
+    pub(crate) fn dirty_ptr(&mut self) -> *mut u64 {
+        self.dirty.as_mut_ptr()
+    }
+
+    /// 主内存客户机基地址
+    #[cfg(feature = "jit")]
+    #[inline(always)]
+    pub(crate) fn base(&self) -> u64 {
+        self.memory_base
+    }
+
+    /// 主内存大小（字节）
+    #[cfg(feature = "jit")]
+    #[inline(always)]
+    pub(crate) fn size(&self) -> usize {
+        self.memory_size
+    }
+
     #[inline(always)]
     pub fn is_last_mmio(&self) -> bool {
         let res = *self.is_last_mmio.borrow();
@@ -397,23 +889,33 @@ impl Memory {
         res
     }
 
+    /// 把 `addr` 所在的主内存页装入指定TLB（调用方已确认在主内存内）
+    #[inline(always)]
+    fn tlb_fill(&self, tlb: &Tlb, addr: u64) {
+        let page_off = (addr.wrapping_sub(self.memory_base) as usize) & !(PAGE_SIZE - 1);
+        tlb.fill(addr, unsafe { self.data.base_ptr().add(page_off) });
+    }
+
     /// 读取字节
     #[inline(always)]
     pub fn read_byte(&self, addr: u64) -> Result<u8, MemoryError> {
+        if let Some(p) = self.rtlb.lookup(addr, 1) {
+            return Ok(unsafe { *p });
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 1) {
                 return Err(MemoryError::OutOfBounds { addr, size: 1 });
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
+            self.tlb_fill(&self.rtlb, addr);
             return Ok(unsafe { self.read_byte_unsafe(real_addr) });
         }
 
         // MMIO访问 - 通过通用read方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            let res = device.read(offset, 1)?;
+            let res = region.device.with(|d| d.read(offset, 1))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(res[0]);
         }
@@ -424,20 +926,23 @@ impl Memory {
     /// 读取半字
     #[inline(always)]
     pub fn read_halfword(&self, addr: u64) -> Result<u16, MemoryError> {
+        if let Some(p) = self.rtlb.lookup(addr, 2) {
+            return Ok(unsafe { (p as *const u16).read_unaligned().to_le() });
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 2) {
                 return Err(MemoryError::OutOfBounds { addr, size: 2 });
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
+            self.tlb_fill(&self.rtlb, addr);
             return Ok(unsafe { self.read_halfword_unsafe(real_addr) });
         }
 
         // MMIO访问 - 通过通用read方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            let res = device.read(offset, 2)?;
+            let res = region.device.with(|d| d.read(offset, 2))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(u16::from_le_bytes([res[0], res[1]]));
         }
@@ -448,20 +953,23 @@ impl Memory {
     /// 读取字
     #[inline(always)]
     pub fn read_word(&self, addr: u64) -> Result<u32, MemoryError> {
+        if let Some(p) = self.rtlb.lookup(addr, 4) {
+            return Ok(unsafe { (p as *const u32).read_unaligned().to_le() });
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 4) {
                 return Err(MemoryError::OutOfBounds { addr, size: 4 });
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
+            self.tlb_fill(&self.rtlb, addr);
             return Ok(unsafe { self.read_word_unsafe(real_addr) });
         }
 
         // MMIO访问 - 通过通用read方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            let res = device.read(offset, 4)?;
+            let res = region.device.with(|d| d.read(offset, 4))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(u32::from_le_bytes([res[0], res[1], res[2], res[3]]));
         }
@@ -472,20 +980,23 @@ impl Memory {
     /// 读取双字
     #[inline(always)]
     pub fn read_doubleword(&self, addr: u64) -> Result<u64, MemoryError> {
+        if let Some(p) = self.rtlb.lookup(addr, 8) {
+            return Ok(unsafe { (p as *const u64).read_unaligned().to_le() });
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 8) {
                 return Err(MemoryError::OutOfBounds { addr, size: 8 });
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
+            self.tlb_fill(&self.rtlb, addr);
             return Ok(unsafe { self.read_doubleword_unsafe(real_addr) });
         }
 
         // MMIO访问 - 通过通用read方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            let res = device.read(offset, 8)?;
+            let res = region.device.with(|d| d.read(offset, 8))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(u64::from_le_bytes([
                 res[0], res[1], res[2], res[3],
@@ -499,6 +1010,10 @@ impl Memory {
     /// 写入字节
     #[inline(always)]
     pub fn write_byte(&mut self, addr: u64, value: u8) -> Result<(), MemoryError> {
+        if let Some(p) = self.wtlb.lookup(addr, 1) {
+            unsafe { *p = value };
+            return Ok(());
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 1) {
@@ -506,14 +1021,14 @@ impl Memory {
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
             unsafe { self.write_byte_unsafe(real_addr, value); }
+            self.tlb_fill(&self.wtlb, addr);
             return Ok(());
         }
 
         // MMIO访问 - 通过通用write方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            device.write(offset, &[value])?;
+            region.device.with(|d| d.write(offset, &[value]))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(());
         }
@@ -524,6 +1039,10 @@ impl Memory {
     /// 写入半字
     #[inline(always)]
     pub fn write_halfword(&mut self, addr: u64, value: u16) -> Result<(), MemoryError> {
+        if let Some(p) = self.wtlb.lookup(addr, 2) {
+            unsafe { (p as *mut u16).write_unaligned(value.to_le()) };
+            return Ok(());
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 2) {
@@ -531,14 +1050,14 @@ impl Memory {
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
             unsafe { self.write_halfword_unsafe(real_addr, value); }
+            self.tlb_fill(&self.wtlb, addr);
             return Ok(());
         }
 
         // MMIO访问 - 通过通用write方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            device.write(offset, &value.to_le_bytes())?;
+            region.device.with(|d| d.write(offset, &value.to_le_bytes()))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(());
         }
@@ -549,6 +1068,10 @@ impl Memory {
     /// 写入字
     #[inline(always)]
     pub fn write_word(&mut self, addr: u64, value: u32) -> Result<(), MemoryError> {
+        if let Some(p) = self.wtlb.lookup(addr, 4) {
+            unsafe { (p as *mut u32).write_unaligned(value.to_le()) };
+            return Ok(());
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 4) {
@@ -556,14 +1079,14 @@ impl Memory {
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
             unsafe { self.write_word_unsafe(real_addr, value); }
+            self.tlb_fill(&self.wtlb, addr);
             return Ok(());
         }
 
         // MMIO访问 - 通过通用write方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            device.write(offset, &value.to_le_bytes())?;
+            region.device.with(|d| d.write(offset, &value.to_le_bytes()))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(());
         }
@@ -574,6 +1097,10 @@ impl Memory {
     /// 写入双字
     #[inline(always)]
     pub fn write_doubleword(&mut self, addr: u64, value: u64) -> Result<(), MemoryError> {
+        if let Some(p) = self.wtlb.lookup(addr, 8) {
+            unsafe { (p as *mut u64).write_unaligned(value.to_le()) };
+            return Ok(());
+        }
         if self.is_mem_region(addr) {
             // 主内存访问 - 直接使用unsafe版本
             if !self.is_mem_region_range(addr, 8) {
@@ -581,20 +1108,175 @@ impl Memory {
             }
             let real_addr = (addr.wrapping_sub(self.memory_base)) as usize;
             unsafe { self.write_doubleword_unsafe(real_addr, value); }
+            self.tlb_fill(&self.wtlb, addr);
             return Ok(());
         }
 
         // MMIO访问 - 通过通用write方法
         if let Some(region) = self.find_mmio_region(addr) {
             let offset = addr - region.base;
-            let mut device = region.device.lock().unwrap();
-            device.write(offset, &value.to_le_bytes())?;
+            region.device.with(|d| d.write(offset, &value.to_le_bytes()))?;
             *self.is_last_mmio.borrow_mut() = true;
             return Ok(());
         }
 
         Err(MemoryError::OutOfBounds { addr, size: 8 })
     }
+
+    /// 建立/刷新内存检查点
+    ///
+    /// 首次调用做一次全量复制作为基线；之后的调用只把自上次检查点
+    /// 以来的脏页同步进基线，并清空脏页位图。对128MB主内存来说，
+    /// 周期性快照的代价与两次快照间实际写过的页数成正比
+    pub fn checkpoint(&mut self) {
+        match &mut self.checkpoint {
+            None => {
+                self.checkpoint = Some(self.data.to_vec());
+            }
+            Some(base) => {
+                for page in iter_set_pages(&self.dirty) {
+                    let start = page * PAGE_SIZE;
+                    let end = (start + PAGE_SIZE).min(self.data.len());
+                    base[start..end].copy_from_slice(&self.data[start..end]);
+                }
+            }
+        }
+        self.retire_dirty();
+    }
+
+    /// 回滚到最近一次检查点
+    ///
+    /// 只把检查点之后被写过的页从基线复制回主内存，然后清空脏页位图。
+    /// 没有检查点时返回 `false`
+    pub fn rollback(&mut self) -> bool {
+        let Some(base) = &self.checkpoint else {
+            return false;
+        };
+        for page in iter_set_pages(&self.dirty) {
+            let start = page * PAGE_SIZE;
+            let end = (start + PAGE_SIZE).min(self.data.len());
+            self.data[start..end].copy_from_slice(&base[start..end]);
+        }
+        self.retire_dirty();
+        true
+    }
+
+    /// 把脏页位图并入`touched`后清零（检查点/回滚消费脏位时调用）
+    ///
+    /// 写TLB条目意味着"该页已标脏"，脏位被消费后必须整体失效
+    fn retire_dirty(&mut self) {
+        for (t, d) in self.touched.iter_mut().zip(&self.dirty) {
+            *t |= *d;
+        }
+        self.dirty.fill(0);
+        self.wtlb.flush();
+    }
+
+    /// 复位主内存供同进程内的下一次运行复用
+    ///
+    /// 只清零自创建（或上次复位）以来被写过的页——从未写过的页
+    /// 本来就是0；同时丢弃内存检查点（其基线属于已结束的运行）
+    pub fn reset(&mut self) {
+        for word_idx in 0..self.dirty.len() {
+            let mut w = self.dirty[word_idx] | self.touched[word_idx];
+            while w != 0 {
+                let page = (word_idx << 6) | w.trailing_zeros() as usize;
+                w &= w - 1;
+                let start = page * PAGE_SIZE;
+                let end = (start + PAGE_SIZE).min(self.data.len());
+                self.data[start..end].fill(0);
+            }
+        }
+        self.dirty.fill(0);
+        self.touched.fill(0);
+        self.wtlb.flush();
+        self.checkpoint = None;
+    }
+
+    /// 自上次检查点/清空以来被写过的页号（升序）
+    ///
+    /// 批量复位、difftest内存比较、观察点过滤等消费方据此只扫描
+    /// 实际写过的页，而不是整个主内存
+    pub fn dirty_pages(&self) -> impl Iterator<Item = usize> + '_ {
+        iter_set_pages(&self.dirty)
+    }
+
+    /// 清空脏页位图（消费掉的脏位并入复位跟踪，语义同检查点消费）
+    pub fn clear_dirty(&mut self) {
+        self.retire_dirty();
+    }
+
+    /// 脏页对应的客户机地址区间
+    ///
+    /// difftest分歧定位在回滚DUT后，按这些区间把参考核内存
+    /// 同步回批首内容；须在回滚消费脏位之前调用
+    pub fn dirty_page_spans(&self) -> Vec<(u64, usize)> {
+        self.dirty_pages()
+            .map(|page| {
+                let start = page * PAGE_SIZE;
+                let len = PAGE_SIZE.min(self.data.len() - start);
+                (self.memory_base + start as u64, len)
+            })
+            .collect()
+    }
+
+    /// 对脏页做64位FNV-1a哈希并返回其客户机地址区间
+    ///
+    /// 哈希覆盖每页的客户机基址与内容（按小端序8字节一组）。difftest
+    /// 在批边界把区间列表发给参考核线程，对参考核内存的同样区间按
+    /// `crate::difftest::hash_ref_spans`的同一规则哈希后比较
+    pub fn hash_dirty_spans(&self) -> (Vec<(u64, usize)>, u64) {
+        let mut spans = Vec::new();
+        let mut hash = FNV_OFFSET;
+        for page in self.dirty_pages() {
+            let start = page * PAGE_SIZE;
+            let end = (start + PAGE_SIZE).min(self.data.len());
+            let base = self.memory_base + start as u64;
+            spans.push((base, end - start));
+            hash ^= base;
+            hash = hash.wrapping_mul(FNV_PRIME);
+            for chunk in self.data[start..end].chunks_exact(8) {
+                hash ^= u64::from_le_bytes(chunk.try_into().unwrap());
+                hash = hash.wrapping_mul(FNV_PRIME);
+            }
+        }
+        (spans, hash)
+    }
+
+    /// 对所有脏页做64位FNV-1a哈希，覆盖页号与页内容
+    ///
+    /// 脏页集合或其中任一字节不同，结果即不同；给difftest等只需
+    /// 比较"写过的内存是否一致"的调用方用，免去整段内存传输
+    pub fn hash_dirty_pages(&self) -> u64 {
+        let mut hash = FNV_OFFSET;
+        for page in self.dirty_pages() {
+            hash ^= page as u64;
+            hash = hash.wrapping_mul(FNV_PRIME);
+            let start = page * PAGE_SIZE;
+            let end = (start + PAGE_SIZE).min(self.data.len());
+            for &byte in &self.data[start..end] {
+                hash ^= byte as u64;
+                hash = hash.wrapping_mul(FNV_PRIME);
+            }
+        }
+        hash
+    }
+
+    /// 收集所有MMIO设备的快照状态（顺序与 `mmio_regions` 一致）
+    pub fn save_device_states(&self) -> Vec<Vec<u8>> {
+        self.mmio_regions
+            .iter()
+            .map(|region| region.device.with(|d| d.save_state()))
+            .collect()
+    }
+
+    /// 恢复所有MMIO设备的快照状态（顺序与 `save_device_states` 一致）
+    pub fn restore_device_states(&mut self, states: &[Vec<u8>]) -> Result<(), MemoryError> {
+        for (region, state) in self.mmio_regions.iter().zip(states) {
+            region.device.with(|d| d.restore_state(state))?;
+        }
+        Ok(())
+    }
 }
 
 #[cfg(test)]
@@ -638,6 +1320,10 @@ mod tests {
                 m_ext: false,
                 a_ext: false,
                 c_ext: false,
+                f_ext: false,
+                d_ext: false,
+                v_ext: false,
+                b_ext: false,
             },
             debug: DebugConfig {
                 event_list_size: 64,
@@ -646,7 +1332,11 @@ mod tests {
             },
             others: OthersConfig {
                 decoder_cache_size: 1024,
+                decoder_profile: None,
+                harts: 1,
             },
+            cache_model: Default::default(),
+            branch_model: Default::default(),
         });
 
         let device_file = crate::const_values::DeviceFile {
@@ -672,7 +1362,7 @@ mod tests {
         let (config, device_file) = create_test_config();
         let mut memory = Memory::new(config, &device_file).unwrap();
 
-        let uart = Arc::new(Mutex::new(MockUart::new()));
+        let uart = DeviceCell::Local(Rc::new(RefCell::new(MockUart::new())));
         let result = memory.map_mmio(0x1000_0000, 0x100, uart, "test_uart".to_string());
         assert!(result.is_ok());
 
@@ -687,10 +1377,10 @@ mod tests {
         let (config, device_file) = create_test_config();
         let mut memory = Memory::new(config, &device_file).unwrap();
 
-        let uart1 = Arc::new(Mutex::new(MockUart::new()));
+        let uart1 = DeviceCell::Shared(Arc::new(Mutex::new(MockUart::new())));
         memory.map_mmio(0x1000_0000, 0x100, uart1, "uart1".to_string()).unwrap();
 
-        let uart2 = Arc::new(Mutex::new(MockUart::new()));
+        let uart2 = DeviceCell::Shared(Arc::new(Mutex::new(MockUart::new())));
         let result = memory.map_mmio(0x1000_0050, 0x100, uart2, "uart2".to_string());
         assert!(matches!(result, Err(MemoryError::MmioOverlap { .. })));
     }
@@ -700,15 +1390,20 @@ mod tests {
         let (config, device_file) = create_test_config();
         let mut memory = Memory::new(config, &device_file).unwrap();
 
-        let uart = Arc::new(Mutex::new(MockUart::new()));
-        memory.map_mmio(0x1000_0000, 0x100, uart.clone(), "test_uart".to_string()).unwrap();
+        let uart = Rc::new(RefCell::new(MockUart::new()));
+        memory.map_mmio(
+            0x1000_0000,
+            0x100,
+            DeviceCell::Local(uart.clone()),
+            "test_uart".to_string(),
+        ).unwrap();
 
         // 测试写入
         memory.write_byte(0x1000_0000, b'H').unwrap();
         memory.write_byte(0x1000_0001, b'i').unwrap();
 
         // 验证数据被写入设备
-        let device = uart.lock().unwrap();
+        let device = uart.borrow();
         assert_eq!(device.data, vec![b'H', b'i']);
 
         // 测试读取
@@ -717,6 +1412,42 @@ mod tests {
         assert_eq!(data, 0x01); // MockUart 返回 0x01
     }
 
+    #[test]
+    fn test_dma_roundtrip() {
+        let (config, device_file) = create_test_config();
+        let mut memory = Memory::new(config, &device_file).unwrap();
+        let dma = DeviceCell::Local(Rc::new(RefCell::new(dma::Dma::new("dma0".to_string()))));
+        memory
+            .map_mmio(0x1000_0200, 0x200, dma, "dma0".to_string())
+            .unwrap();
+
+        let path = std::env::temp_dir().join(format!("dolphin_dma_test_{}", std::process::id()));
+        std::fs::write(&path, b"hello dma").unwrap();
+        let path_str = path.to_str().unwrap();
+
+        // 路径进名字缓冲，填寄存器后敲门铃：文件→客户机内存
+        let mut name = path_str.as_bytes().to_vec();
+        name.push(0);
+        memory.write(0x1000_0200 + 0x40, &name).unwrap();
+        memory.write(0x1000_0200, &0x8000_2000u64.to_le_bytes()).unwrap();
+        memory.write(0x1000_0208, &0u64.to_le_bytes()).unwrap();
+        memory.write(0x1000_0210, &9u64.to_le_bytes()).unwrap();
+        memory.write(0x1000_0218, &1u32.to_le_bytes()).unwrap();
+
+        // 状态回到空闲，数据已落进主内存，LEN回填实际字节数
+        assert_eq!(memory.read_word(0x1000_021c).unwrap(), 0);
+        assert_eq!(memory.read(0x8000_2000, 9).unwrap(), b"hello dma");
+        assert_eq!(memory.read_doubleword(0x1000_0210).unwrap(), 9);
+
+        // 反方向：客户机内存→文件
+        memory.write(0x8000_2000, b"DMA WRITE").unwrap();
+        memory.write(0x1000_0218, &2u32.to_le_bytes()).unwrap();
+        assert_eq!(memory.read_word(0x1000_021c).unwrap(), 0);
+        assert_eq!(std::fs::read(&path).unwrap(), b"DMA WRITE");
+
+        std::fs::remove_file(&path).ok();
+    }
+
     #[test]
     fn test_regular_memory_access() {
         let (config, device_file) = create_test_config();
@@ -734,6 +1465,91 @@ mod tests {
         assert_eq!(word, 0x12345678);
     }
 
+    /// 非对齐访问：页内与跨页的各宽度读写都走宿主非对齐指令
+    #[test]
+    fn test_unaligned_access() {
+        let (config, device_file) = create_test_config();
+        let mut memory = Memory::new(config, &device_file).unwrap();
+
+        // 页内非对齐（含TLB命中的第二次访问）
+        let addr = 0x8000_1003;
+        memory.write_word(addr, 0xdead_beef).unwrap();
+        assert_eq!(memory.read_word(addr).unwrap(), 0xdead_beef);
+        memory.write_doubleword(addr + 4, 0x0123_4567_89ab_cdef).unwrap();
+        assert_eq!(memory.read_doubleword(addr + 4).unwrap(), 0x0123_4567_89ab_cdef);
+
+        // 跨页边界的非对齐双字
+        let edge = 0x8000_1FFC;
+        memory.write_doubleword(edge, 0x1122_3344_5566_7788).unwrap();
+        assert_eq!(memory.read_doubleword(edge).unwrap(), 0x1122_3344_5566_7788);
+
+        // 跨出主内存末尾的访问报错
+        let end = 0x8000_0000 + 128 * 1024 * 1024;
+        assert!(memory.write_word(end - 2, 0).is_err());
+        assert!(memory.read_word(end - 2).is_err());
+    }
+
+    /// 脏页API：遍历、哈希与清空
+    #[test]
+    fn test_dirty_page_tracking() {
+        let (config, device_file) = create_test_config();
+        let mut memory = Memory::new(config, &device_file).unwrap();
+        assert_eq!(memory.dirty_pages().count(), 0);
+
+        // 两页各写一次（第二个写跨页，覆盖两页）
+        memory.write_byte(0x8000_0000, 1).unwrap();
+        memory.write(0x8000_2FFF, &[2, 3]).unwrap();
+        let pages: Vec<usize> = memory.dirty_pages().collect();
+        assert_eq!(pages, vec![0, 2, 3]);
+
+        // 哈希随脏页内容变化
+        let h1 = memory.hash_dirty_pages();
+        memory.write_byte(0x8000_0000, 9).unwrap();
+        assert_ne!(memory.hash_dirty_pages(), h1);
+
+        memory.clear_dirty();
+        assert_eq!(memory.dirty_pages().count(), 0);
+    }
+
+    /// TLB命中路径与脏页跟踪的配合：检查点后经TLB写过的页能回滚
+    #[test]
+    fn test_tlb_hit_and_rollback() {
+        let (config, device_file) = create_test_config();
+        let mut memory = Memory::new(config, &device_file).unwrap();
+        let addr = 0x8000_4000;
+
+        // 第二次访问同页走TLB命中路径
+        memory.write_doubleword(addr, 0x1111).unwrap();
+        memory.write_doubleword(addr + 8, 0x2222).unwrap();
+        assert_eq!(memory.read_doubleword(addr).unwrap(), 0x1111);
+        assert_eq!(memory.read_doubleword(addr + 8).unwrap(), 0x2222);
+
+        // 检查点后写TLB失效，命中路径的写仍被脏页跟踪覆盖
+        memory.checkpoint();
+        memory.write_doubleword(addr, 0x3333).unwrap();
+        memory.write_doubleword(addr + 8, 0x4444).unwrap();
+        assert!(memory.rollback());
+        assert_eq!(memory.read_doubleword(addr).unwrap(), 0x1111);
+        assert_eq!(memory.read_doubleword(addr + 8).unwrap(), 0x2222);
+    }
+
+    #[test]
+    fn test_read_into() {
+        let (config, device_file) = create_test_config();
+        let mut memory = Memory::new(config, &device_file).unwrap();
+
+        // 主内存：整段读入调用方缓冲区
+        let addr = 0x8000_1000;
+        memory.write(addr, &[1, 2, 3, 4, 5, 6]).unwrap();
+        let mut buf = [0u8; 6];
+        memory.read_into(addr, &mut buf).unwrap();
+        assert_eq!(buf, [1, 2, 3, 4, 5, 6]);
+
+        // 越界读取报错
+        let end = 0x8000_0000 + 128 * 1024 * 1024;
+        assert!(memory.read_into(end - 2, &mut buf).is_err());
+    }
+
     #[test]
     fn test_fast_u32_read() {
         let (config, device_file) = create_test_config();
@@ -778,4 +1594,42 @@ mod tests {
         assert!(!memory.is_mem_region_range(0x9000_0000, 4));
         assert!(!memory.is_mem_region_range(0x7000_0000, 4));
     }
+
+    #[test]
+    fn test_page_table_region_lookup() {
+        let (config, device_file) = create_test_config();
+        let mut memory = Memory::new(config, &device_file).unwrap();
+
+        // 子页大小的设备：页表命中后仍须核对精确范围
+        let uart = Rc::new(RefCell::new(MockUart::new()));
+        memory.map_mmio(
+            0x1000_0000,
+            0x100,
+            DeviceCell::Local(uart.clone()),
+            "sub_page_uart".to_string(),
+        ).unwrap();
+
+        assert!(memory.read_byte(0x1000_00ff).is_ok());
+        // 同页但越过设备末尾，必须报未映射而不是误入设备
+        assert!(memory.read_byte(0x1000_0100).is_err());
+
+        // 同页第二个设备触发多设备回退路径
+        let uart2 = Rc::new(RefCell::new(MockUart::new()));
+        memory.map_mmio(
+            0x1000_0200,
+            0x100,
+            DeviceCell::Local(uart2.clone()),
+            "sub_page_uart2".to_string(),
+        ).unwrap();
+        memory.sort_mmio_regions();
+
+        assert!(memory.read_byte(0x1000_0000).is_ok());
+        assert!(memory.read_byte(0x1000_0200).is_ok());
+        assert!(memory.read_byte(0x1000_0180).is_err());
+
+        // 卸载后页表同步回收
+        assert!(memory.unmap_mmio(0x1000_0000));
+        assert!(memory.read_byte(0x1000_0000).is_err());
+        assert!(memory.read_byte(0x1000_0200).is_ok());
+    }
 }
@@ -1,6 +1,14 @@
 //! 模拟器核心模块
 
+mod block;
+pub(crate) mod block_store;
+#[cfg(feature = "cache-model")] // 条件编译缓存模型
+mod cache_model;
+#[cfg(feature = "branch-model")] // 条件编译分支预测器模型
+mod branch_model;
 mod exception;
+#[cfg(feature = "jit")] // 条件编译 JIT 模块
+mod jit;
 mod instructions;
 pub mod state;
 
@@ -10,12 +18,13 @@ pub mod gdb;
 pub mod tracer;
 
 mod device_manager;
-mod memory;
+pub(crate) mod memory;
+mod perfcnt;
+mod scheduler;
 
 use std::path::PathBuf;
 use std::rc::Rc;
 
-use crate::emulator::instructions::is_compressed;
 use crate::utils::disasm_riscv64_instruction;
 use crate::{const_values, utils::ringbuf::RingBuffer};
 use anyhow::{Context, Result};
@@ -23,6 +32,8 @@ pub use exception::Exception;
 
 #[cfg(feature = "gdb")] // 条件编译 GDB 模块
 pub use gdb::EmuGdbEventLoop;
+// 微基准与指令流生成器需要单独构造译码器（模块本身保持私有）
+pub use instructions::{InstDecoder, is_compressed};
 pub use memory::{Memory, MemoryError};
 
 #[cfg(feature = "difftest")]
@@ -30,6 +41,33 @@ use rv64emu::rv64core::{bus::DeviceType, cpu_core::CpuCore};
 pub use state::State;
 pub use state::{Event, ExecMode, ExecState};
 
+/// CLI等外部驱动单次`steps`调用的指令数上限：按块推进，
+/// 便于调用方在块间插入自己的检查而不必逐条回调
+pub const RUN_CHUNK: usize = 1 << 22;
+
+/// 热路径性能计数器：普通u64，perf-stats关闭时不存在，零开销
+#[cfg(feature = "perf-stats")]
+#[derive(Debug, Default)]
+struct PerfCounters {
+    /// 已执行（退休）指令数
+    instructions: u64,
+    /// 触发的事件数（断点、观察点、停机等）
+    events: u64,
+}
+
+/// 模拟器检查点：hart体系结构状态与设备状态
+///
+/// 主内存的基线由`Memory`自己持有（脏页增量维护），不在此结构中
+struct EmuCheckpoint {
+    /// 快照时正在运行的hart的体系结构状态
+    live: state::HartContext,
+    /// 其余hart的上下文槽位
+    harts: Vec<state::HartContext>,
+    cur_hart: usize,
+    /// 各MMIO设备导出的状态（顺序与内存的MMIO区域一致）
+    devices: Vec<Vec<u8>>,
+}
+
 /// 模拟器结构体
 pub struct Emulator {
     /// CPU状态（包含内存）
@@ -37,15 +75,59 @@ pub struct Emulator {
     exec_state: ExecState,
     exec_mode: ExecMode,
     event: Event,
+    /// 有未消费事件的标志：热路径只检查这一位，事件枚举与事件
+    /// 列表的记账全部推迟到事件实际触发后的冷路径
+    event_pending: bool,
     execption: Option<Exception>,
     event_list: RingBuffer<Event>,
     decoder: instructions::InstDecoder,
+    /// 各hart的体系结构上下文（当前运行hart在`state`中，对应槽位内容过期）
+    #[allow(unused)]
+    harts: Vec<state::HartContext>,
+    /// 当前运行的hart编号
+    #[allow(unused)]
+    cur_hart: usize,
+    /// 基本块缓存（非difftest/gdb的连续执行热路径使用）
+    #[allow(unused)]
+    block_cache: block::BlockCache,
+    /// 设备事件调度器：按退休指令数唤醒设备，热路径只比较期限整数
+    scheduler: scheduler::DeviceScheduler,
+    /// perfcnt设备的共享计数存储（配置中无perfcnt设备时为None）
+    // difftest逐条单步，发布点在块循环里，该链路在此构建下不可达
+    #[cfg_attr(feature = "difftest", allow(dead_code))]
+    perf_shared: Option<std::sync::Arc<perfcnt::PerfShared>>,
+    /// 最近一次快照（无则为None）
+    checkpoint: Option<EmuCheckpoint>,
+    /// L1缓存层次模型（cache-model特性）
+    #[cfg(feature = "cache-model")]
+    cache_model: cache_model::CacheModel,
+    /// BTB+双模分支预测器模型（branch-model特性）
+    #[cfg(feature = "branch-model")]
+    branch_model: branch_model::BranchModel,
+    /// 预译码块持久缓存目录（未配置则不持久化）
+    block_store_dir: Option<PathBuf>,
+    /// 当前加载ELF的内容哈希，持久化块缓存的键
+    elf_hash: Option<u64>,
+    /// 热基本块的Cranelift编译器
+    #[cfg(feature = "jit")]
+    #[allow(unused)]
+    jit: jit::Jit,
     #[allow(unused)]
     config: Rc<const_values::EmuConfig>, // 模拟器配置
     #[cfg(feature = "gdb")] // 条件编译 GDB 相关
     gdb_data: gdb::GdbData,
+    /// 参考核：在本线程时为Some，steps期间移交流水线线程时为None
     #[cfg(feature = "difftest")] // 条件编译 DiffTest 相关
-    ref_emu: rv64emu::rv64core::cpu_core::CpuCore,
+    ref_emu: Option<Box<rv64emu::rv64core::cpu_core::CpuCore>>,
+    /// 共享内存difftest后端：设置时替代内置参考核
+    #[cfg(feature = "difftest")]
+    diff_shm: Option<std::sync::Arc<crate::difftest::shm::ShmDiff>>,
+    /// 热路径性能计数（perf-stats专用）
+    #[cfg(feature = "perf-stats")]
+    perf: PerfCounters,
+    /// 指令追踪器：模拟器直接持有，逐条trace无需任何同步
+    #[cfg(feature = "tracer")]
+    tracer: tracer::Tracer,
 }
 
 impl Emulator {
@@ -71,7 +153,26 @@ impl Emulator {
         let device_file = const_values::DeviceFile::new(&device_path)?;
 
         // 使用主配置和设备配置创建状态
-        let state = State::new(emu_config.clone(), &device_file)?;
+        let mut state = State::new(emu_config.clone(), &device_file)?;
+
+        // perfcnt是CPU挂靠设备（计数在模拟器手里），设备工厂建不了，
+        // 这里按配置直接映射并保留共享存储供运行循环发布计数
+        let mut perf_shared = None;
+        if let Some(dev) = device_file
+            .devices
+            .iter()
+            .find(|d| d.enabled && d.device_type == "perfcnt")
+        {
+            let shared = std::sync::Arc::new(perfcnt::PerfShared::default());
+            let cell = memory::DeviceCell::Local(std::rc::Rc::new(std::cell::RefCell::new(
+                perfcnt::PerfCnt::new(dev.name.clone(), shared.clone()),
+            )));
+            state
+                .memory
+                .map_mmio(dev.base, dev.size, cell, dev.name.clone())?;
+            state.memory.sort_mmio_regions();
+            perf_shared = Some(shared);
+        }
         let exec_mode = if cfg!(feature = "gdb") {
             ExecMode::Continue // 如果启用了GDB，默认执行模式为连续执行
         } else {
@@ -111,32 +212,111 @@ impl Emulator {
             });
 
             in_core.init();
-            ref_emu = in_core;
+            ref_emu = Some(Box::new(in_core));
+        }
+
+        // 追踪器在构造时按启动参数配置一次，此后逐条trace无需同步
+        #[cfg(feature = "tracer")]
+        let tracer = {
+            let mut tracer = tracer::Tracer::new();
+            tracer.add_tracers(&args.tracer, &emu_config)?;
+            tracer
+        };
+
+        // difftest参考核只有单hart，轮转后的第二个hart无从比较，直接拒绝
+        #[cfg(feature = "difftest")]
+        if emu_config.others.harts > 1 {
+            use anyhow::anyhow;
+            return Err(anyhow!("difftest不支持多hart配置（参考核为单hart）"));
         }
 
+        // 每个hart从boot_pc复位启动，mhartid区分；hart 0直接活在state中
+        let harts: Vec<state::HartContext> = (0..emu_config.others.harts.max(1))
+            .map(|i| state.new_hart_context(i as u64))
+            .collect();
+
         Ok(Self {
             state,
+            harts,
+            cur_hart: 0,
             exec_state: ExecState::Idle,
             exec_mode,
             event: Event::None,
+            event_pending: false,
             execption: None,
             event_list: RingBuffer::new(emu_config.debug.event_list_size),
             decoder: instructions::InstDecoder::new(emu_config.clone()),
+            block_cache: block::BlockCache::new(),
+            scheduler: scheduler::DeviceScheduler::new(),
+            perf_shared,
+            checkpoint: None,
+            #[cfg(feature = "cache-model")]
+            cache_model: cache_model::CacheModel::new(&emu_config.cache_model),
+            #[cfg(feature = "branch-model")]
+            branch_model: branch_model::BranchModel::new(&emu_config.branch_model),
+            block_store_dir: args.block_store.as_ref().map(PathBuf::from),
+            elf_hash: None,
+            #[cfg(feature = "jit")]
+            jit: jit::Jit::new(),
             config: emu_config,
             #[cfg(feature = "gdb")] // 条件编译 GDB 相关
             gdb_data: gdb::GdbData::new(),
             #[cfg(feature = "difftest")] // 条件编译 DiffTest 相关
             ref_emu,
+            #[cfg(feature = "difftest")]
+            diff_shm: match &args.diff_shm {
+                Some(path) => Some(std::sync::Arc::new(
+                    crate::difftest::shm::ShmDiff::open(path)?,
+                )),
+                None => None,
+            },
+            #[cfg(feature = "perf-stats")]
+            perf: PerfCounters::default(),
+            #[cfg(feature = "tracer")]
+            tracer,
         })
     }
 
     /// 加载ELF文件
+    ///
+    /// difftest下若参考核在本线程则走一趟共享加载：同一次mmap与
+    /// 解析同时写入DUT与参考核，不再各读各解析一遍
     pub fn load_elf(&mut self, path: &str) -> Result<()> {
         use crate::utils::load_elf;
 
         // 使用工具模块加载ELF
-        load_elf(&mut self.state, path)
+        #[cfg(feature = "difftest")]
+        let elf_hash = match self.ref_emu.as_deref_mut() {
+            Some(ref_core) => crate::utils::load_elf_shared(&mut self.state, ref_core, path)
+                .with_context(|| format!("无法从 '{}' 加载ELF文件", path))?,
+            None => load_elf(&mut self.state, path)
+                .with_context(|| format!("无法从 '{}' 加载ELF文件", path))?,
+        };
+        #[cfg(not(feature = "difftest"))]
+        let elf_hash = load_elf(&mut self.state, path)
             .with_context(|| format!("无法从 '{}' 加载ELF文件", path))?;
+        self.elf_hash = Some(elf_hash);
+
+        // 代码已变化，预译码的基本块全部失效
+        self.block_cache.clear();
+
+        // 持久化块缓存命中则直接灌入预译码块，热身译码只付一次
+        self.load_block_store();
+
+        // 调用追踪器需要函数符号索引（批量模式下每个ELF重建一次）
+        #[cfg(feature = "tracer")]
+        self.tracer
+            .set_symbols(&crate::utils::elf::load_function_symbols(path)?);
+
+        // 缓存模型按符号区域归属统计，同样需要符号索引
+        #[cfg(feature = "cache-model")]
+        self.cache_model
+            .set_symbols(&crate::utils::elf::load_function_symbols(path)?);
+
+        // 分支模型按站点统计预测错误率，符号化报告同样依赖符号索引
+        #[cfg(feature = "branch-model")]
+        self.branch_model
+            .set_symbols(&crate::utils::elf::load_function_symbols(path)?);
 
         Ok(())
     }
@@ -147,90 +327,636 @@ impl Emulator {
         let (pc, instruction) = {
             self.state.sync_pc();
             let pc = self.state.get_pc();
-            let instruction = self
-                .state
-                .fetch_instruction(pc)
-                .with_context(|| format!("无法从PC {:#x} 处读取指令", pc))?;
+            let instruction = match self.state.fetch_instruction(pc) {
+                Ok(inst) => inst,
+                Err(e) => return Err(Self::fetch_diagnostic(pc, e)),
+            };
             (pc, instruction)
         };
 
-        // 执行指令
-        // let mut executor = execute::RV64I::new(instruction);
-
-        // let event = executor.execute(&mut self.state).with_context(|| {
-        //     let instruction_msg =
-        //         disasm_riscv64_instruction(instruction, pc).unwrap_or("未知指令".to_string());
-        //     format!(
-        //         "无法执行PC {:#010x} 处的指令 {:#010x} ({}), cpu状态:\n{}",
-        //         pc, instruction, instruction_msg, self.state
-        //     )
-        // })?;
-        let inst = self.decoder.fast_path(instruction).with_context(|| {
-            let instruction_msg =
-                disasm_riscv64_instruction(instruction, pc).unwrap_or("未知指令".to_string());
-            format!(
-                "无法解码PC {:#010x} 处的指令 {:#010x} ({}), cpu状态:\n{}",
-                pc, instruction, instruction_msg, self.state
-            )
-        })?;
-
-        if is_compressed(instruction) {
-            // 如果是压缩指令，PC需要加2
-            self.state.set_npc(pc + 2);
+        // 缓存模型的取指喂入（特性关闭时本行不存在于step_internal）
+        #[cfg(feature = "cache-model")]
+        self.cache_model.fetch(pc);
+
+        // 热路径只传播底层的轻量错误，诊断信息在失败后由冷路径补全
+        let (inst, len) = match self.decoder.fast_path(pc, instruction) {
+            Ok(inst) => inst,
+            Err(e) => return Err(self.step_diagnostic("解码", pc, instruction, e)),
+        };
+
+        // 译码缓存携带指令长度，无需再次判别压缩编码
+        self.state.set_npc(pc + len);
+
+        if let Err(e) = (inst.execute)(self, instruction, pc) {
+            return Err(self.step_diagnostic("执行", pc, instruction, e));
+        }
+
+        self.state.bump_counters(1);
+
+        #[cfg(feature = "perf-stats")]
+        {
+            self.perf.instructions += 1;
+            if self.event_pending {
+                self.perf.events += 1;
+            }
+        }
+
+        if self.event_pending {
+            if let Event::Halted(x) = self.event {
+                self.on_halted(x)?;
+            }
+        }
+        #[cfg(feature = "tracer")] // 条件编译追踪器相关
+        self.tracer.trace(pc, instruction, self.pending_event());
+        Ok(())
+    }
+
+    /// 冷路径：取指失败后的诊断信息
+    #[cold]
+    #[inline(never)]
+    fn fetch_diagnostic(pc: u64, e: anyhow::Error) -> anyhow::Error {
+        e.context(format!("无法从PC {:#x} 处读取指令", pc))
+    }
+
+    /// 冷路径：译码/执行失败后构造带反汇编与CPU状态转储的诊断信息
+    ///
+    /// 单独外联出来，避免在每条指令上都生成context闭包的捕获与格式化代码
+    #[cold]
+    #[inline(never)]
+    fn step_diagnostic(
+        &self,
+        stage: &str,
+        pc: u64,
+        instruction: u32,
+        e: anyhow::Error,
+    ) -> anyhow::Error {
+        let instruction_msg =
+            disasm_riscv64_instruction(instruction, pc).unwrap_or("未知指令".to_string());
+        e.context(format!(
+            "无法{}PC {:#010x} 处的指令 {:#010x} ({}), cpu状态:\n{}",
+            stage, pc, instruction, instruction_msg, self.state
+        ))
+    }
+
+    /// 本条指令产生的事件；`event`字段可能残留旧值，以pending位为准
+    #[cfg(feature = "tracer")]
+    fn pending_event(&self) -> Event {
+        if self.event_pending {
+            self.event
         } else {
-            // 否则PC加4
-            self.state.set_npc(pc + 4);
-        }
-
-        (inst.execute)(self, instruction, pc).with_context(|| {
-            let instruction_msg =
-                disasm_riscv64_instruction(instruction, pc).unwrap_or("未知指令".to_string());
-            format!(
-                "无法执行PC {:#010x} 处的指令 {:#010x} ({}), cpu状态:\n{}",
-                pc, instruction, instruction_msg, self.state
-            )
-        })?;
-
-        if let Event::Halted(x) = self.event {
-            use colored::Colorize;
-            self.exec_state = ExecState::End; // 结束执行状态
-            if x != 0 {
-                tracing::error!("程序不正确退出，退出码：{x}");
-                println!("{}", "HIT AT BAD TRAP".red());
-                return Err(anyhow::anyhow!("程序不正确退出，退出码：{x}"));
+            Event::None
+        }
+    }
+
+    /// 载入/存储处理器上报一次数据访存（tracer/gdb/cache-model都关闭时编译为空）
+    ///
+    /// gdb特性下同时承担观察点检查：页级位图过滤把无观察点时的
+    /// 开销压到一次位测试
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub(crate) fn trace_mem(&mut self, pc: u64, addr: u64, size: u8, is_write: bool, value: u64) {
+        #[cfg(feature = "tracer")]
+        self.tracer.trace_mem(pc, addr, size, is_write, value);
+        #[cfg(feature = "cache-model")]
+        self.cache_model.data_access(pc, addr);
+        #[cfg(feature = "gdb")]
+        if let Some(hit) = self.gdb_data.watch_hit(addr, size) {
+            self.raise_event(if is_write {
+                Event::WatchWrite(hit)
             } else {
-                println!("{}", "HIT AT GOOD TRAP".green());
+                Event::WatchRead(hit)
+            });
+        }
+    }
+
+    /// 分支/跳转处理器上报一次控制流事件（tracer/branch-model都关闭时编译为空）
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub(crate) fn trace_branch(
+        &mut self,
+        pc: u64,
+        taken: bool,
+        conditional: bool,
+        indirect: bool,
+        target: u64,
+    ) {
+        #[cfg(feature = "tracer")]
+        self.tracer
+            .trace_branch(pc, taken, conditional, indirect, target);
+
+        #[cfg(feature = "branch-model")]
+        self.branch_model
+            .branch(pc, taken, conditional, indirect, target);
+    }
+
+    /// 把CPU侧计数发布给perfcnt设备（每块/每批一次的宽松存储）
+    ///
+    /// 无perfcnt设备时只是一次Option检查；周期按1 CPI模型与指令数
+    /// 同值，perf-stats构建额外发布内存子系统的热路径计数
+    #[cfg_attr(feature = "difftest", allow(dead_code))]
+    #[inline(always)]
+    fn publish_perf(&self) {
+        let Some(shared) = &self.perf_shared else {
+            return;
+        };
+        use std::sync::atomic::Ordering;
+        let retired = self.retired_insts();
+        shared.instret.store(retired, Ordering::Relaxed);
+        shared.cycles.store(retired, Ordering::Relaxed);
+        #[cfg(feature = "perf-stats")]
+        {
+            let stats = &self.state.memory.stats;
+            shared.mem_reads.store(stats.mem_reads.get(), Ordering::Relaxed);
+            shared.mem_writes.store(stats.mem_writes.get(), Ordering::Relaxed);
+            shared.mmio_reads.store(stats.mmio_reads.get(), Ordering::Relaxed);
+            shared.mmio_writes.store(stats.mmio_writes.get(), Ordering::Relaxed);
+            shared.fetch_fast.store(stats.fetch_fast.get(), Ordering::Relaxed);
+            shared.fetch_slow.store(stats.fetch_slow.get(), Ordering::Relaxed);
+        }
+    }
+
+    /// 为命名设备登记一次性唤醒：全局退休指令数到达`due`时驱动其`tick`
+    ///
+    /// 冷路径API，供设备初始化或中断配置时调用；运行循环每批只做
+    /// 一次期限整数比较
+    pub fn schedule_device_at(&mut self, name: &str, due: u64) -> Result<()> {
+        let device = self
+            .state
+            .memory
+            .device_by_name(name)
+            .ok_or_else(|| anyhow::anyhow!("调度失败：未找到设备 '{}'", name))?;
+        self.scheduler.schedule_at(due, device);
+        Ok(())
+    }
+
+    /// 为命名设备登记周期性唤醒：首次在`due`，此后每`period`条指令重复
+    pub fn schedule_device_every(&mut self, name: &str, due: u64, period: u64) -> Result<()> {
+        let device = self
+            .state
+            .memory
+            .device_by_name(name)
+            .ok_or_else(|| anyhow::anyhow!("调度失败：未找到设备 '{}'", name))?;
+        self.scheduler.schedule_every(due, period, device);
+        Ok(())
+    }
+
+    /// 客户机代码被修改（如断点补丁）后失效所有预译码缓存
+    #[cfg(feature = "gdb")]
+    pub(crate) fn invalidate_code_caches(&mut self) {
+        self.decoder.clear_cache();
+        self.block_cache.clear();
+    }
+
+    /// gdb范围单步的加速路径：pc在 `[start, end)` 内时全速执行
+    ///
+    /// 完整落在范围内的基本块整块执行——块以控制转移收尾，等价于只在
+    /// 分支退休处检查范围；跨出范围边界的块退回逐条执行，保证离开
+    /// 范围的那一刻精确停下。最多执行 `max` 条指令后交还调用方，供
+    /// 事件循环轮询连接上的中断。difftest下全部逐条执行以保留比对。
+    #[cfg(feature = "gdb")]
+    pub fn step_range(&mut self, start: u64, end: u64, max: usize) -> Result<usize> {
+        self.exec_state = ExecState::Running;
+        if self.event_pending {
+            // 上一批的事件外层已读取过，归档并清除
+            self.consume_event();
+        }
+
+        let mut executed = 0usize;
+        while executed < max {
+            self.state.sync_pc();
+            let pc = self.state.get_pc();
+            if !(start..end).contains(&pc) {
+                break;
+            }
+
+            #[cfg(not(feature = "difftest"))]
+            let contained = self
+                .block_cache
+                .lookup(pc)
+                .or_else(|| self.build_block(pc))
+                .is_some_and(|blk| blk.insts.last().is_some_and(|d| d.pc + d.len <= end));
+            #[cfg(feature = "difftest")]
+            let contained = false;
+
+            let retired = if contained {
+                // 块内所有指令的pc都落在范围内，整块无检查地执行
+                let n = self.step_block()?;
+                self.state.bump_counters(n as u64);
+                n
+            } else {
+                self.step()?;
+                1
+            };
+            executed += retired;
+
+            if self.event_pending || self.exec_state == ExecState::End {
+                break;
             }
         }
-        #[cfg(feature = "tracer")] // 条件编译追踪器相关
-        tracer::global_trace(self);
+        if self.exec_state != ExecState::End {
+            self.exec_state = ExecState::Idle;
+        }
+        Ok(executed)
+    }
+
+    /// 取出追踪器积累的日志（退出时由驱动方打印）
+    #[cfg(feature = "tracer")]
+    pub fn tracer_log(&mut self) -> String {
+        self.tracer.print_log()
+    }
+
+    /// 汇总各子系统的性能计数，生成可读的统计表
+    ///
+    /// 比率分母为0时显示为0%，避免空跑时除零
+    #[cfg(feature = "perf-stats")]
+    pub fn perf_summary(&self) -> String {
+        use std::fmt::Write;
+
+        fn pct(part: u64, total: u64) -> f64 {
+            if total == 0 {
+                0.0
+            } else {
+                part as f64 / total as f64 * 100.0
+            }
+        }
+
+        let (hits, misses) = self.decoder.cache_stats();
+        let stats = &self.state.memory.stats;
+        let fetch_fast = stats.fetch_fast.get();
+        let fetch_slow = stats.fetch_slow.get();
+        let insts = self.perf.instructions;
+
+        let mut out = String::new();
+        let _ = writeln!(out, "{:<28} {:>16}", "指令数", insts);
+        let _ = writeln!(
+            out,
+            "{:<28} {:>16} ({:.3}/M指令)",
+            "事件数",
+            self.perf.events,
+            if insts == 0 {
+                0.0
+            } else {
+                self.perf.events as f64 * 1e6 / insts as f64
+            }
+        );
+        let _ = writeln!(
+            out,
+            "{:<28} {:>16} ({:.2}%)",
+            "译码缓存命中",
+            hits,
+            pct(hits, hits + misses)
+        );
+        let _ = writeln!(out, "{:<28} {:>16}", "译码缓存未命中", misses);
+        let _ = writeln!(
+            out,
+            "{:<28} {:>16} ({:.2}%)",
+            "取指快路径",
+            fetch_fast,
+            pct(fetch_fast, fetch_fast + fetch_slow)
+        );
+        let _ = writeln!(out, "{:<28} {:>16}", "取指慢路径", fetch_slow);
+        let _ = writeln!(out, "{:<28} {:>16}", "主内存读", stats.mem_reads.get());
+        let _ = writeln!(out, "{:<28} {:>16}", "主内存写", stats.mem_writes.get());
+        let _ = writeln!(out, "{:<28} {:>16}", "MMIO读", stats.mmio_reads.get());
+        let _ = write!(out, "{:<28} {:>16}", "MMIO写", stats.mmio_writes.get());
+        out
+    }
+
+    /// 处理CPU停止事件，设置结束状态并按退出码返回
+    fn on_halted(&mut self, exit_code: u8) -> Result<()> {
+        use colored::Colorize;
+        self.exec_state = ExecState::End; // 结束执行状态
+        if exit_code != 0 {
+            tracing::error!("程序不正确退出，退出码：{exit_code}");
+            println!("{}", "HIT AT BAD TRAP".red());
+            return Err(anyhow::anyhow!("程序不正确退出，退出码：{exit_code}"));
+        }
+        println!("{}", "HIT AT GOOD TRAP".green());
         Ok(())
     }
 
+    /// 缓存模型统计报告（退出时打印）
+    #[cfg(feature = "cache-model")]
+    pub fn cache_summary(&self) -> String {
+        self.cache_model.summary()
+    }
+
+    /// 分支预测器模型统计报告（退出时打印）
+    #[cfg(feature = "branch-model")]
+    pub fn branch_summary(&self) -> String {
+        self.branch_model.summary()
+    }
+
+    /// 尝试从持久缓存读入当前ELF的预译码块表
+    ///
+    /// 键（ELF内容哈希）或译码表布局不符时静默放弃，回到
+    /// 运行时按需预译码；序号还原的处理函数逐条复验编码匹配
+    fn load_block_store(&mut self) {
+        let (Some(dir), Some(elf_hash)) = (self.block_store_dir.as_deref(), self.elf_hash) else {
+            return;
+        };
+        let path = block_store::store_path(dir, elf_hash);
+        if !path.exists() {
+            return;
+        }
+        let stored = match block_store::load(&path, elf_hash, self.decoder.table_hash()) {
+            Ok(stored) => stored,
+            Err(e) => {
+                tracing::warn!(path = %path.display(), "预译码块缓存不可用: {}", e);
+                return;
+            }
+        };
+
+        let mut loaded = 0usize;
+        'blocks: for sb in stored {
+            let mut insts = Vec::with_capacity(sb.insts.len());
+            for si in &sb.insts {
+                let Some(handler) = self.decoder.handler_by_index(si.handler_idx) else {
+                    continue 'blocks;
+                };
+                if si.inst & handler.mask != handler.identifier {
+                    continue 'blocks;
+                }
+                insts.push(block::DecodedInst {
+                    pc: si.pc,
+                    inst: si.inst,
+                    len: si.len as u64,
+                    handler,
+                    #[cfg(not(feature = "tracer"))]
+                    fused: None,
+                });
+            }
+
+            // 融合对不序列化，读回后按与build_block相同的规则重配
+            #[cfg(not(feature = "tracer"))]
+            {
+                let mut i = 0;
+                while i + 1 < insts.len() {
+                    if let Some(f) = instructions::fusion::fuse(&insts[i], &insts[i + 1]) {
+                        insts[i].fused = Some(f);
+                        i += 2;
+                    } else {
+                        i += 1;
+                    }
+                }
+            }
+
+            self.block_cache.insert(block::Block::new(sb.start, insts));
+            loaded += 1;
+        }
+        tracing::info!(path = %path.display(), blocks = loaded, "预译码块缓存已加载");
+    }
+
+    /// 把当前块缓存写入持久缓存（配置了目录且加载过ELF时）
+    ///
+    /// 运行结束时调用；写入失败只告警，不影响运行结果
+    pub fn save_block_store(&self) {
+        let (Some(dir), Some(elf_hash)) = (self.block_store_dir.as_deref(), self.elf_hash) else {
+            return;
+        };
+        if self.block_cache.len() == 0 {
+            return;
+        }
+
+        let mut blocks = Vec::with_capacity(self.block_cache.len());
+        'blocks: for blk in self.block_cache.iter() {
+            let mut insts = Vec::with_capacity(blk.insts.len());
+            for di in &blk.insts {
+                let Some(idx) = self.decoder.handler_index(di.handler) else {
+                    continue 'blocks;
+                };
+                insts.push(block_store::StoredInst {
+                    pc: di.pc,
+                    inst: di.inst,
+                    handler_idx: idx,
+                    len: di.len as u8,
+                });
+            }
+            blocks.push(block_store::StoredBlock {
+                start: blk.start,
+                insts,
+            });
+        }
+
+        let path = block_store::store_path(dir, elf_hash);
+        match block_store::save(&path, elf_hash, self.decoder.table_hash(), &blocks) {
+            Ok(()) => {
+                tracing::info!(path = %path.display(), blocks = blocks.len(), "预译码块缓存已保存")
+            }
+            Err(e) => tracing::warn!(path = %path.display(), "保存预译码块缓存失败: {}", e),
+        }
+    }
+
+    /// 从指定PC开始预译码一个基本块
+    ///
+    /// 译码失败时返回 `None`，调用方回退到逐条执行以获得完整的错误上下文。
+    #[allow(unused)]
+    fn build_block(&mut self, start: u64) -> Option<std::rc::Rc<block::Block>> {
+        let mut insts = Vec::new();
+        let mut pc = start;
+        loop {
+            let Ok(inst) = self.state.fetch_instruction(pc) else {
+                break;
+            };
+            let Ok((handler, len)) = self.decoder.fast_path(pc, inst) else {
+                break;
+            };
+            insts.push(block::DecodedInst {
+                pc,
+                inst,
+                len,
+                handler,
+                #[cfg(not(feature = "tracer"))]
+                fused: None,
+            });
+            if block::ends_block(inst) || insts.len() >= block::BLOCK_MAX_INSTS {
+                break;
+            }
+            pc += len;
+        }
+        if insts.is_empty() {
+            return None;
+        }
+
+        // 宏操作融合：标记可成对执行的相邻指令（tracer需要逐条回调，跳过）
+        #[cfg(not(feature = "tracer"))]
+        {
+            let mut i = 0;
+            while i + 1 < insts.len() {
+                if let Some(f) = instructions::fusion::fuse(&insts[i], &insts[i + 1]) {
+                    insts[i].fused = Some(f);
+                    i += 2;
+                } else {
+                    i += 1;
+                }
+            }
+        }
+
+        Some(self.block_cache.insert(block::Block::new(start, insts)))
+    }
+
+    /// 执行一个基本块（无块可用时回退单步），返回执行的指令数
+    #[allow(unused)]
+    #[inline(always)]
+    fn step_block(&mut self) -> Result<usize> {
+        if self.event_pending {
+            // 罕见：上一块的事件仍未被外层读取，先归档再继续
+            self.consume_event();
+        }
+        self.state.sync_pc();
+        let start = self.state.get_pc();
+        let blk = match self.block_cache.lookup(start) {
+            Some(blk) => blk,
+            None => match self.build_block(start) {
+                Some(blk) => blk,
+                None => {
+                    // 预译码失败：退回逐条路径，由其生成带上下文的错误
+                    self.step_internal()?;
+                    return Ok(1);
+                }
+            },
+        };
+
+        // JIT热路径：热块编译后直接运行宿主代码（tracer需逐条回调，保持解释执行）
+        #[cfg(all(feature = "jit", not(feature = "tracer")))]
+        {
+            // 观察点靠解释器store路径的trace_mem命中，编译代码不经过它；
+            // 存在观察点时整块回退解释执行（断点打的是ebreak补丁并使
+            // 块缓存失效，不受影响）
+            #[cfg(feature = "gdb")]
+            let jit_ok = self.gdb_data.watchpoints.is_empty();
+            #[cfg(not(feature = "gdb"))]
+            let jit_ok = true;
+            if jit_ok {
+                match blk.jit.get() {
+                    jit::JitState::Compiled(f) => return self.run_compiled(&blk, f),
+                    jit::JitState::Cold(n) if n + 1 >= jit::HOT_THRESHOLD => {
+                        let mem_base = self.state.memory.base();
+                        let mem_size = self.state.memory.size() as u64;
+                        let c_ext = self.config.inst_set.c_ext;
+                        match self.jit.compile(&blk, mem_base, mem_size, c_ext) {
+                            Some(f) => {
+                                blk.jit.set(jit::JitState::Compiled(f));
+                                return self.run_compiled(&blk, f);
+                            }
+                            // 首条指令不支持：该块永远走解释器
+                            None => blk.jit.set(jit::JitState::Blocked),
+                        }
+                    }
+                    jit::JitState::Cold(n) => blk.jit.set(jit::JitState::Cold(n + 1)),
+                    jit::JitState::Blocked => {}
+                }
+            }
+        }
+
+        let mut executed = 0usize;
+        let mut i = 0usize;
+        while i < blk.insts.len() {
+            let d = &blk.insts[i];
+            // 保持 pc/npc 与逐条执行路径一致，供追踪器和错误报告使用
+            self.state.pc = d.pc;
+
+            // 块路径同样喂入取指：预译码不免去真机上的I缓存压力
+            #[cfg(feature = "cache-model")]
+            self.cache_model.fetch(d.pc);
+
+            #[cfg(not(feature = "tracer"))]
+            let result = if let Some(f) = d.fused {
+                // 宏融合对：单次调用执行两条指令
+                let d2 = &blk.insts[i + 1];
+                #[cfg(feature = "cache-model")]
+                self.cache_model.fetch(d2.pc);
+                self.state.set_npc(d2.pc + d2.len);
+                executed += 2;
+                i += 2;
+                f(self, d.inst, d2.inst, d.pc)
+            } else {
+                self.state.set_npc(d.pc + d.len);
+                executed += 1;
+                i += 1;
+                (d.handler.execute)(self, d.inst, d.pc)
+            };
+            // tracer需逐条回调，块中不存在融合对
+            #[cfg(feature = "tracer")]
+            let result = {
+                self.state.set_npc(d.pc + d.len);
+                executed += 1;
+                i += 1;
+                (d.handler.execute)(self, d.inst, d.pc)
+            };
+
+            if let Err(e) = result {
+                let instruction_msg =
+                    disasm_riscv64_instruction(d.inst, d.pc).unwrap_or("未知指令".to_string());
+                return Err(e.context(format!(
+                    "无法执行PC {:#010x} 处的指令 {:#010x} ({}), cpu状态:\n{}",
+                    d.pc, d.inst, instruction_msg, self.state
+                )));
+            }
+
+            #[cfg(feature = "tracer")] // 条件编译追踪器相关
+            self.tracer.trace(d.pc, d.inst, self.pending_event());
+
+            if self.event_pending {
+                if let Event::Halted(x) = self.event {
+                    self.on_halted(x)?;
+                }
+                break;
+            }
+        }
+        Ok(executed)
+    }
+
+    /// 运行已编译的块
+    ///
+    /// 返回值低位为1表示JIT在 `返回值 & !1` 处退出（MMIO、越界或不支持
+    /// 的指令），此前的寄存器写入均已提交，解释器从该PC继续即可。
+    #[cfg(all(feature = "jit", not(feature = "tracer")))]
+    fn run_compiled(&mut self, blk: &block::Block, f: jit::CompiledBlock) -> Result<usize> {
+        let regs = self.state.registers.as_mut_ptr();
+        let mem = self.state.memory.host_ptr();
+        let dirty = self.state.memory.dirty_ptr();
+        // 安全性：编译代码仅经带边界检查的偏移访问寄存器数组与主内存，
+        // 脏页位图按主内存大小分配，页号在界内即位图下标在界内
+        let ret = unsafe { f(regs, mem, dirty) };
+        if ret & 1 == 0 {
+            // 整块执行完毕，ret即下一条PC
+            self.state.pc = blk.insts.last().map(|d| d.pc).unwrap_or(blk.start);
+            self.state.set_npc(ret);
+            Ok(blk.insts.len())
+        } else {
+            // 剩余部分由解释器执行（会在退出PC处建立新的短块）。
+            // 退出PC之前的指令已经退休：insts按PC升序，二分定位前缀
+            // 长度，计数才能与mcycle/minstret等架构可见状态对上
+            let bail_pc = ret & !1;
+            self.state.set_npc(bail_pc);
+            Ok(blk.insts.partition_point(|d| d.pc < bail_pc))
+        }
+    }
+
     /// 执行单步指令
     #[inline(always)]
     pub fn step(&mut self) -> Result<()> {
         self.exec_state = ExecState::Running;
-        self.event = Event::None; // 重置事件
+        if self.event_pending {
+            // 冷路径：上一步的事件外层已读取过，归档并清除
+            self.consume_event();
+        }
 
         self.step_internal()?;
 
-        // 捕获除了None以外的event，放入事件列表
-        #[cfg(feature = "gdb")] // 条件编译 GDB 相关
-        if self.event != Event::None {
-            self.event_list.push_overwrite(self.event);
-        }
-
         #[cfg(feature = "difftest")] // 条件编译 DiffTest 相关
         match self.event {
             Event::Halted(_) => (),
             _ => {
                 if !self.state.memory.is_last_mmio() {
                     use crate::difftest::Difftest;
-                    tracing::info!("check diff");
+                    // 逐条日志点只在hot-log下编译，避免热循环里的格式化开销
+                    #[cfg(feature = "hot-log")]
+                    tracing::trace!(pc = self.state.get_pc(), "check diff");
 
-                    Difftest::step(&mut self.ref_emu);
-                    let ref_state = self.ref_emu.self_state();
+                    Difftest::step(self.ref_core());
+                    let ref_state = self.ref_core().self_state();
                     if ref_state != self.self_state() {
                         use anyhow::anyhow;
 
@@ -244,8 +970,11 @@ impl Emulator {
                     // 跳过检测，直接同步状态
 
                     use crate::difftest::Difftest;
-                    self.ref_emu.set_pc(self.state.get_npc());
-                    self.ref_emu.set_regs(&self.self_state().reg);
+                    let dut = self.self_state();
+                    let npc = self.state.get_npc();
+                    let core = self.ref_core();
+                    core.set_pc(npc);
+                    core.set_regs(&dut.reg);
                 }
             }
         }
@@ -257,49 +986,100 @@ impl Emulator {
     }
 
     /// 运行模拟器
+    ///
+    /// 多hart配置下按时间片轮转：每个hart连续执行一个配额的指令，
+    /// 再切换到下一个hart，所有hart共享内存与设备
+    #[cfg(not(any(feature = "gdb", feature = "difftest")))]
     pub fn steps(&mut self, n: usize) -> Result<()> {
+        /// 单个hart连续执行的指令配额
+        const HART_QUANTUM: usize = 4096;
+
         self.exec_state = ExecState::Running;
-        for _ in 0..n {
-            self.event = Event::None; // 重置事件
+        let mut executed = 0usize;
+        while executed < n {
+            let quantum = if self.harts.len() > 1 {
+                HART_QUANTUM.min(n - executed)
+            } else {
+                n - executed
+            };
+            // 块引擎热路径：整块执行，无逐条的取指/译码开销
+            let mut in_quantum = 0usize;
+            while in_quantum < quantum {
+                let retired = self.step_block()?;
+                in_quantum += retired;
+                // 块引擎按块推进计数器：块内读数最多滞后一个块的长度
+                self.state.bump_counters(retired as u64);
+                // 设备事件：每块一次期限整数比较，到期才走冷路径弹堆
+                let now = self.retired_insts();
+                if self.scheduler.due(now) {
+                    self.scheduler.run_due(now);
+                }
+                // perfcnt读数滞后不超过一个基本块
+                self.publish_perf();
+                if self.exec_state == ExecState::End {
+                    break;
+                }
+            }
+            executed += in_quantum;
+            if self.exec_state == ExecState::End {
+                break;
+            }
+            if self.harts.len() > 1 {
+                self.next_hart();
+            }
+        }
+        #[cfg(feature = "perf-stats")]
+        {
+            self.perf.instructions += executed as u64;
+            if self.event_pending {
+                self.perf.events += 1;
+            }
+        }
+        if self.exec_state != ExecState::End {
+            self.exec_state = ExecState::Idle;
+        }
+        Ok(())
+    }
 
-            self.step_internal()?;
+    /// 运行模拟器（gdb需要逐条执行以便检查断点/观察点事件）
+    ///
+    /// 内层按固定预算批量执行：事件在批次入口清零一次，事件入列与退出
+    /// 检查只在事件实际触发时走冷路径，避免逐条循环的固定记账开销。
+    /// 多hart配置下批次兼作时间片，批尾轮转到下一个hart。
+    #[cfg(all(feature = "gdb", not(feature = "difftest")))]
+    pub fn steps(&mut self, n: usize) -> Result<()> {
+        /// 单个批次的指令预算（多hart下即单个hart的时间片）
+        const STEP_BATCH: usize = 4096;
 
-            // 捕获除了None以外的event，放入事件列表
-            #[cfg(feature = "gdb")] // 条件编译 GDB 相关
-            if self.event != Event::None {
-                self.event_list.push_overwrite(self.event);
+        self.exec_state = ExecState::Running;
+        let mut remaining = n;
+        'run: while remaining > 0 {
+            let budget = remaining.min(STEP_BATCH);
+            remaining -= budget;
+            if self.event_pending {
+                self.consume_event(); // 批次入口归档残留事件
             }
 
-            #[cfg(feature = "difftest")] // 条件编译 DiffTest 相关
-            match self.event {
-                Event::Halted(_) => (),
-                _ => {
-                    if !self.state.memory.is_last_mmio() {
-                        use crate::difftest::Difftest;
-
-                        Difftest::step(&mut self.ref_emu);
-                        let ref_state = self.ref_emu.self_state();
-                        if ref_state != self.self_state() {
-                            use anyhow::anyhow;
-
-                            return Err(anyhow!(
-                                "Failed in difftest check, ref state: {}, self state: {}",
-                                ref_state,
-                                self.state
-                            ));
-                        }
-                    } else {
-                        // 跳过检测，直接同步状态
+            for _ in 0..budget {
+                self.step_internal()?;
 
-                        use crate::difftest::Difftest;
-                        self.ref_emu.set_pc(self.state.get_npc());
-                        self.ref_emu.set_regs(&self.self_state().reg);
+                if self.event_pending {
+                    // 冷路径：停机事件留给外层读取，其余归档后继续
+                    if self.exec_state == ExecState::End {
+                        break 'run;
                     }
+                    self.consume_event();
                 }
             }
 
-            if self.exec_state == ExecState::End {
-                break;
+            // 设备事件：每批一次期限整数比较
+            let now = self.retired_insts();
+            if self.scheduler.due(now) {
+                self.scheduler.run_due(now);
+            }
+            self.publish_perf();
+            if self.harts.len() > 1 {
+                self.next_hart();
             }
         }
         if self.exec_state != ExecState::End {
@@ -308,6 +1088,291 @@ impl Emulator {
         Ok(())
     }
 
+    /// 运行模拟器（difftest流水线模式）
+    ///
+    /// 参考端的补跑与比较异步进行，DUT只在队列满时停顿。默认后端把
+    /// 内置参考核移交专用线程，批记录经有界队列送入；指定`--diff-shm`
+    /// 时改走共享内存环形缓冲，对接进程外的参考实现（如Spike适配器）。
+    /// 调用结束时结算途中上报的分歧：进程内后端收回参考核并经
+    /// `diff_bisect`回滚重放定位到具体指令，进程外后端无法回卷，
+    /// 按批粒度报告。
+    #[cfg(feature = "difftest")]
+    pub fn steps(&mut self, n: usize) -> Result<()> {
+        use crate::difftest::{DiffBackend, DiffTracking, RefPipeline, RefReport};
+
+        /// 进度行间隔：每这么多条指令打印一次，替代逐条日志
+        const PROGRESS_EVERY: u64 = 16 * 1024 * 1024;
+
+        self.exec_state = ExecState::Running;
+        let start_insts = self.retired_insts();
+        let mut track = DiffTracking::default();
+
+        let run = if let Some(shm) = self.diff_shm.clone() {
+            let run = self.steps_pipelined(n, shm.as_ref(), &mut track);
+            // 收尾：等在途批的回报到齐（参考端失联时放弃校验）
+            while track.mismatch.is_none() && !track.outstanding.is_empty() {
+                match shm.wait_report() {
+                    Some(RefReport::Ack { seq }) => track.retire(seq),
+                    Some(RefReport::Mismatch {
+                        seq,
+                        ref_state,
+                        mem,
+                    }) => track.mismatch = Some((seq, ref_state, mem)),
+                    None => break,
+                }
+            }
+            if let Some((seq, ref_state, mem)) = track.mismatch.take() {
+                use anyhow::anyhow;
+                return Err(anyhow!(
+                    "Failed in difftest check (共享内存后端, 批{}, {}分歧), ref state: {}, self state: {}",
+                    seq,
+                    if mem { "内存" } else { "寄存器" },
+                    ref_state,
+                    self.state
+                ));
+            }
+            run
+        } else {
+            let core = self.ref_emu.take().expect("参考核在流水线线程上");
+            let pipe = RefPipeline::spawn(core);
+            let run = self.steps_pipelined(n, &pipe, &mut track);
+            let (core, late_mismatch) = pipe.finish();
+            self.ref_emu = Some(core);
+            if let Some((seq, _ref_state, mem)) = track.mismatch.take().or(late_mismatch) {
+                return self.diff_bisect(track.replay_count(seq), mem);
+            }
+            run
+        };
+
+        let retired = self.retired_insts();
+        if retired / PROGRESS_EVERY != start_insts / PROGRESS_EVERY {
+            tracing::info!(instructions = retired, "difftest进度");
+        }
+        run?;
+        if self.exec_state != ExecState::End {
+            self.exec_state = ExecState::Idle;
+        }
+        Ok(())
+    }
+
+    /// 流水线difftest执行体
+    ///
+    /// 检查点只在流水线排空时前移，保证任何在途批失败都能回滚重放。
+    /// 只有MMIO访问（参考核无法执行）会提前封批并送同步记录。返回Ok
+    /// 不代表全部批已通过，收尾结算在`steps`中经`finish`完成。
+    #[cfg(feature = "difftest")]
+    fn steps_pipelined(
+        &mut self,
+        n: usize,
+        pipe: &dyn crate::difftest::DiffBackend,
+        track: &mut crate::difftest::DiffTracking,
+    ) -> Result<()> {
+        use crate::difftest::{Difftest, RefCmd, RefReport};
+
+        /// 单个批次的指令预算
+        const STEP_BATCH: usize = 4096;
+
+        let mut remaining = n;
+        'run: while remaining > 0 {
+            let budget = remaining.min(STEP_BATCH);
+            remaining -= budget;
+            if self.event_pending {
+                self.consume_event(); // 批次入口归档残留事件
+            }
+
+            // 排空已到的回报；分歧立即停止推进，保住当前检查点
+            while let Some(report) = pipe.try_report() {
+                match report {
+                    RefReport::Ack { seq } => track.retire(seq),
+                    RefReport::Mismatch {
+                        seq,
+                        ref_state,
+                        mem,
+                    } => {
+                        track.mismatch = Some((seq, ref_state, mem));
+                        break 'run;
+                    }
+                }
+            }
+            if track.outstanding.is_empty() {
+                self.snapshot();
+                track.dut_insts = 0;
+            }
+
+            // 参考核尚未补跑的指令数
+            let mut pending = 0usize;
+            for _ in 0..budget {
+                self.step_internal()?;
+                track.dut_insts += 1;
+
+                match self.event {
+                    Event::Halted(_) => (),
+                    _ => {
+                        if !self.state.memory.is_last_mmio() {
+                            pending += 1;
+                        } else {
+                            // MMIO指令参考核无法执行：封批后送同步记录跳过
+                            if !self.diff_submit(pipe, track, &mut pending) {
+                                break 'run;
+                            }
+                            let dut = self.self_state();
+                            let sync = RefCmd::Sync {
+                                regs: dut.reg,
+                                npc: self.state.get_npc(),
+                            };
+                            if !pipe.submit(sync) {
+                                break 'run;
+                            }
+                        }
+                    }
+                }
+
+                if self.event_pending {
+                    // 冷路径：停机事件留给外层读取，其余归档后继续
+                    if self.exec_state == ExecState::End {
+                        let _ = self.diff_submit(pipe, track, &mut pending);
+                        break 'run;
+                    }
+                    self.consume_event();
+                }
+            }
+
+            if !self.diff_submit(pipe, track, &mut pending) {
+                break 'run;
+            }
+        }
+        Ok(())
+    }
+
+    /// 封装当前批送入流水线；返回false表示参考核线程已因分歧退出
+    #[cfg(feature = "difftest")]
+    fn diff_submit(
+        &mut self,
+        pipe: &dyn crate::difftest::DiffBackend,
+        track: &mut crate::difftest::DiffTracking,
+        pending: &mut usize,
+    ) -> bool {
+        use crate::difftest::{Difftest, RefCmd};
+
+        if *pending == 0 {
+            return true;
+        }
+        track.seq += 1;
+        track.outstanding.push_back((track.seq, track.dut_insts));
+        // 批尾带上自检查点起写过的内存区间哈希，寄存器之外的
+        // 内存分歧也能在批边界被发现
+        let (mem_spans, mem_hash) = self.state.memory.hash_dirty_spans();
+        let batch = RefCmd::Batch {
+            seq: track.seq,
+            count: *pending,
+            dut: self.self_state(),
+            mem_spans,
+            mem_hash,
+        };
+        *pending = 0;
+        pipe.submit(batch)
+    }
+
+    /// difftest分歧定位冷路径：回滚两核到检查点，逐条重放比较，
+    /// 报告窗口内首个状态分歧的指令
+    ///
+    /// `check_mem`为真（批比较失败在内存哈希上）时，重放的每一步
+    /// 都对脏页哈希复查，定位首个内存分歧的指令
+    #[cfg(feature = "difftest")]
+    #[cold]
+    fn diff_bisect(&mut self, count: usize, check_mem: bool) -> Result<()> {
+        use crate::difftest::Difftest;
+        use anyhow::anyhow;
+
+        tracing::error!("difftest批量比较失败，回滚到检查点逐条定位分歧指令");
+        // 窗口内写过的页要在回滚消费脏位之前记录，用于回卷参考核内存
+        let spans = self.state.memory.dirty_page_spans();
+        self.restore()?;
+        // 检查点处两核状态一致，参考核的寄存器/PC/内存都可从DUT回卷
+        let dut = self.self_state();
+        let npc = self.state.get_npc();
+        let core = self.ref_core();
+        core.set_pc(npc);
+        core.set_regs(&dut.reg);
+        for (base, len) in spans {
+            for off in (0..len as u64).step_by(8) {
+                let val = self.state.memory.read_doubleword(base + off)?;
+                self.ref_core().set_mem(base + off, val, 8);
+            }
+        }
+
+        for i in 0..count {
+            self.step_internal()?;
+            if self.event_pending && self.exec_state != ExecState::End {
+                self.consume_event();
+            }
+            if matches!(self.event, Event::Halted(_)) {
+                continue;
+            }
+            if self.state.memory.is_last_mmio() {
+                // 重放窗口可能跨MMIO切批点：与主循环一样直接同步跳过
+                let dut = self.self_state();
+                let npc = self.state.get_npc();
+                let core = self.ref_core();
+                core.set_pc(npc);
+                core.set_regs(&dut.reg);
+                continue;
+            }
+            Difftest::step(self.ref_core());
+            let ref_state = self.ref_core().self_state();
+            if ref_state != self.self_state() {
+                return Err(anyhow!(
+                    "Failed in difftest check, 检查点后第{}条指令首次分歧, ref state: {}, self state: {}",
+                    i + 1,
+                    ref_state,
+                    self.state
+                ));
+            }
+            if check_mem {
+                let (spans, hash) = self.state.memory.hash_dirty_spans();
+                if crate::difftest::hash_ref_spans(self.ref_core(), &spans) != hash {
+                    return Err(anyhow!(
+                        "Failed in difftest check, 检查点后第{}条指令首次出现内存分歧 (pc={:#x})",
+                        i + 1,
+                        self.state.get_pc()
+                    ));
+                }
+            }
+        }
+        Err(anyhow!(
+            "difftest批量比较失败，但逐条重放未复现（疑似不在比较范围内的状态差异）"
+        ))
+    }
+
+    /// 参考核的同步访问（单步比较、分歧定位、ELF装载用）
+    ///
+    /// 仅当参考核在本线程时可用；steps流水线期间核在工作线程上
+    #[cfg(feature = "difftest")]
+    fn ref_core(&mut self) -> &mut rv64emu::rv64core::cpu_core::CpuCore {
+        self.ref_emu.as_mut().expect("参考核在流水线线程上")
+    }
+
+    /// 轮转到下一个hart：保存当前体系结构状态并载入下一个上下文
+    ///
+    /// 切换时保守地丢弃LR/SC保留，避免SC在别的hart写入后仍然成功
+    #[cfg(not(feature = "difftest"))]
+    fn next_hart(&mut self) {
+        self.state.reservation = None;
+        self.state.save_hart(&mut self.harts[self.cur_hart]);
+        self.cur_hart = (self.cur_hart + 1) % self.harts.len();
+        self.state.load_hart(&self.harts[self.cur_hart]);
+    }
+
+    /// 跳转目标对齐检查：启用C扩展时IALIGN为16，允许2字节对齐的目标
+    #[inline(always)]
+    pub(crate) fn is_inst_addr_misaligned(&self, pc: u64) -> bool {
+        if self.config.inst_set.c_ext {
+            pc & 0b1 != 0
+        } else {
+            pc & 0b11 != 0
+        }
+    }
+
     /// 获取处理器状态引用
     #[inline(always)]
     pub fn get_state_ref(&self) -> &State {
@@ -364,8 +1429,29 @@ impl Emulator {
         self.state.get_regs()
     }
 
-    // 返回事件列表
+    /// 指令处理器触发事件的唯一入口：写入事件并置挂起标志，
+    /// 归档等记账全部留给消费侧的冷路径
+    #[inline(always)]
+    pub(crate) fn raise_event(&mut self, event: Event) {
+        self.event = event;
+        self.event_pending = true;
+    }
+
+    /// 冷路径：消费挂起的事件——归档进事件列表并清除标志
+    #[cold]
+    #[inline(never)]
+    fn consume_event(&mut self) {
+        #[cfg(feature = "gdb")] // 条件编译 GDB 相关
+        self.event_list.push_overwrite(self.event);
+        self.event = Event::None;
+        self.event_pending = false;
+    }
+
+    // 返回事件列表（先归档仍然挂起的当前事件）
     pub fn get_events(&mut self) -> Vec<Event> {
+        if self.event_pending {
+            self.consume_event();
+        }
         let mut events = Vec::new();
         while let Result::Ok(event) = self.event_list.pop() {
             events.push(event);
@@ -377,8 +1463,516 @@ impl Emulator {
         self.event
     }
 
+    /// 已退休指令数（所有hart的minstret之和）
+    #[inline(always)]
+    pub fn retired_insts(&self) -> u64 {
+        let mut total = self
+            .state
+            .get_csr(instructions::insts::CSR_MINSTRET)
+            .unwrap_or(0);
+        for (i, hart) in self.harts.iter().enumerate() {
+            // 当前hart的最新计数在state中，跳过其过期的上下文槽位
+            if i != self.cur_hart {
+                total += hart.minstret();
+            }
+        }
+        total
+    }
+
     #[cfg(feature = "difftest")]
     pub fn get_ref_mut(&mut self) -> &mut CpuCore {
-        &mut self.ref_emu
+        self.ref_core()
+    }
+
+    /// 复位到上电状态供批量运行复用
+    ///
+    /// 重建各hart的复位上下文、清零被写过的内存页并使译码/块缓存
+    /// 失效；配置解析、内存分配与设备注册的成果全部保留，比重建
+    /// `Emulator`便宜得多
+    pub fn reset(&mut self) {
+        let harts: Vec<state::HartContext> = (0..self.harts.len())
+            .map(|i| self.state.new_hart_context(i as u64))
+            .collect();
+        self.state.load_hart(&harts[0]);
+        self.harts = harts;
+        self.cur_hart = 0;
+        self.state.memory.reset();
+        self.checkpoint = None;
+        self.block_cache.clear();
+        self.decoder.clear_cache();
+        self.event = Event::None;
+        self.event_pending = false;
+        self.execption = None;
+        self.exec_state = ExecState::Idle;
+    }
+
+    /// 拍摄检查点：捕获所有hart的体系结构状态、设备状态与主内存
+    ///
+    /// 内存部分基于脏页增量，只有首次快照付出一次全量复制；
+    /// 之后的快照代价与上次快照以来写过的页数成正比
+    pub fn snapshot(&mut self) {
+        let mut live = self.state.new_hart_context(0);
+        self.state.save_hart(&mut live);
+        self.state.memory.checkpoint();
+        self.checkpoint = Some(EmuCheckpoint {
+            live,
+            harts: self.harts.clone(),
+            cur_hart: self.cur_hart,
+            devices: self.state.memory.save_device_states(),
+        });
+    }
+
+    /// 回滚到最近一次检查点
+    ///
+    /// 恢复hart状态、设备状态与自快照以来被写过的内存页，
+    /// 并使译码缓存与基本块缓存失效（代码页可能被回滚覆盖）
+    pub fn restore(&mut self) -> Result<()> {
+        let Some(cp) = self.checkpoint.take() else {
+            return Err(anyhow::anyhow!("没有可回滚的检查点"));
+        };
+        self.state.memory.rollback();
+        self.state.memory.restore_device_states(&cp.devices)?;
+        self.state.load_hart(&cp.live);
+        self.harts.clone_from(&cp.harts);
+        self.cur_hart = cp.cur_hart;
+        self.checkpoint = Some(cp);
+
+        self.block_cache.clear();
+        self.decoder.clear_cache();
+        self.event = Event::None;
+        self.event_pending = false;
+        if self.exec_state == ExecState::End {
+            self.exec_state = ExecState::Idle;
+        }
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use clap::Parser;
+
+    fn create_test_emulator() -> Emulator {
+        let args = crate::Args::parse_from(["emulator"]);
+        Emulator::new(&args).unwrap()
+    }
+
+    /// 向内存写入指令序列（从boot_pc开始）
+    ///
+    /// 只写DUT内存，不同步difftest参考核；驱动`steps()`的执行类
+    /// 测试因此都标注`cfg(not(feature = "difftest"))`，否则参考核
+    /// 从未编程，首条指令即分歧
+    #[cfg(not(feature = "difftest"))]
+    fn load_insts(emu: &mut Emulator, insts: &[u32]) {
+        let base = emu.get_pc();
+        for (i, inst) in insts.iter().enumerate() {
+            emu.write_memory(base + (i * 4) as u64, &inst.to_le_bytes())
+                .unwrap();
+        }
+    }
+
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_straight_line_block_execution() {
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x00500093, // addi x1, x0, 5
+                0x00700113, // addi x2, x0, 7
+                0x002081b3, // add  x3, x1, x2
+                0x00100073, // ebreak (a0 = 0 -> 正常退出)
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(1).unwrap(), 5);
+        assert_eq!(emu.get_reg(2).unwrap(), 7);
+        assert_eq!(emu.get_reg(3).unwrap(), 12);
+    }
+
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_compressed_arithmetic() {
+        let mut emu = create_test_emulator();
+        let base = emu.get_pc();
+        let insts: [u16; 4] = [
+            0x4095, // c.li  x1, 5
+            0x0085, // c.addi x1, 1
+            0x8406, // c.mv  x8, x1
+            0x9002, // c.ebreak
+        ];
+        for (i, inst) in insts.iter().enumerate() {
+            emu.write_memory(base + (i * 2) as u64, &inst.to_le_bytes())
+                .unwrap();
+        }
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(1).unwrap(), 6);
+        assert_eq!(emu.get_reg(8).unwrap(), 6);
+    }
+
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_compressed_sp_relative_mem() {
+        let mut emu = create_test_emulator();
+        let base = emu.get_pc();
+        // 混合16/32位指令：设置sp后通过sp相对寻址写回/读出
+        let mut code: Vec<u8> = Vec::new();
+        code.extend_from_slice(&0x00001117u32.to_le_bytes()); // auipc x2, 0x1 -> sp = pc + 0x1000
+        code.extend_from_slice(&0x50f5u16.to_le_bytes()); // c.li  x1, -3
+        code.extend_from_slice(&0xe006u16.to_le_bytes()); // c.sdsp x1, 0(sp)
+        code.extend_from_slice(&0x6182u16.to_le_bytes()); // c.ldsp x3, 0(sp)
+        code.extend_from_slice(&0x9002u16.to_le_bytes()); // c.ebreak
+        emu.write_memory(base, &code).unwrap();
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(3).unwrap(), (-3i64) as u64);
+    }
+
+    /// LR/SC与AMO基本语义：保留命中/失效、读-改-写与旧值返回
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_atomic_ops() {
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x00001117, // auipc x2, 0x1 -> x2 = pc + 0x1000
+                0x00500093, // addi x1, x0, 5
+                0x00113023, // sd   x1, 0(x2)
+                0x00700213, // addi x4, x0, 7
+                0x004131af, // amoadd.d x3, x4, (x2) -> x3 = 5, mem = 12
+                0x100132af, // lr.d x5, (x2)         -> x5 = 12, 登记保留
+                0x1811332f, // sc.d x6, x1, (x2)     -> 命中: x6 = 0, mem = 5
+                0x181133af, // sc.d x7, x1, (x2)     -> 保留已清除: x7 = 1
+                0x00013403, // ld   x8, 0(x2)
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(3).unwrap(), 5);
+        assert_eq!(emu.get_reg(5).unwrap(), 12);
+        assert_eq!(emu.get_reg(6).unwrap(), 0);
+        assert_eq!(emu.get_reg(7).unwrap(), 1);
+        assert_eq!(emu.get_reg(8).unwrap(), 5);
+    }
+
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_float_ops() {
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x00001317, // auipc x6, 0x1 -> x6 = pc + 0x1000
+                0x404900b7, // lui x1, 0x40490 -> 0x40490000 (f32的3.140625)
+                0xf00080d3, // fmv.w.x f1, x1
+                0xf0000053, // fmv.w.x f0, x0 -> f0 = +0.0（装箱）
+                0x00108153, // fadd.s f2, f1, f1 -> 6.28125
+                0xc0011153, // fcvt.w.s x2, f2, rtz -> 6
+                0xa02091d3, // flt.s x3, f1, f2 -> 1
+                0x18008353, // fdiv.s f6, f1, f0 -> +inf, fflags置DZ
+                0x06400213, // addi x4, x0, 100
+                0xd20201d3, // fcvt.d.w f3, x4 -> 100.0
+                0x1a318243, // fmadd.d f4, f3, f3, f3 -> 10100.0
+                0xc22212d3, // fcvt.l.d x5, f4, rtz -> 10100
+                0x00433027, // fsd f4, 0(x6)
+                0x00033287, // fld f5, 0(x6)
+                0xa242a3d3, // feq.d x7, f5, f4 -> 1
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(2).unwrap(), 6);
+        assert_eq!(emu.get_reg(3).unwrap(), 1);
+        assert_eq!(emu.get_reg(5).unwrap(), 10100);
+        assert_eq!(emu.get_reg(7).unwrap(), 1);
+        // fdiv.s结果为装箱的+inf，且除零标志已累积
+        assert_eq!(emu.state.f_regs[6], 0xffff_ffff_7f80_0000);
+        assert_ne!(emu.state.fcsr & 0x08, 0);
+    }
+
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_vector_ops() {
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x00001317, // auipc x6, 0x1 -> x6 = pc + 0x1000
+                0x01000093, // addi x1, x0, 16
+                0x0000f157, // vsetvli x2, x1, e8, m1 -> vl = 16
+                0x5e02b0d7, // vmv.v.i v1, 5
+                0x5e03b157, // vmv.v.i v2, 7
+                0x022081d7, // vadd.vv v3, v2, v1 -> 每元素12
+                0x020301a7, // vse8.v v3, (x6)
+                0x02030207, // vle8.v v4, (x6)
+                0x00033203, // ld x4, 0(x6) -> 0x0c0c0c0c0c0c0c0c
+                0x0230c2d7, // vadd.vx v5, v3, x1 -> 每元素28
+                0x020302a7, // vse8.v v5, (x6)
+                0x00033283, // ld x5, 0(x6) -> 0x1c1c1c1c1c1c1c1c
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(2).unwrap(), 16);
+        assert_eq!(emu.get_reg(4).unwrap(), 0x0c0c_0c0c_0c0c_0c0c);
+        assert_eq!(emu.get_reg(5).unwrap(), 0x1c1c_1c1c_1c1c_1c1c);
+        // vle8回读的v4与v3一致
+        assert_eq!(emu.state.v_regs[3 * 16..4 * 16], emu.state.v_regs[4 * 16..5 * 16]);
+    }
+
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_bitmanip_ops() {
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x123450b7, // lui  x1, 0x12345
+                0x67808093, // addi x1, x1, 0x678 -> 0x12345678
+                0x2010c133, // sh2add x2, x1, x1 -> x1*5
+                0x4020f1b3, // andn x3, x1, x2
+                0x60209213, // cpop x4, x1 -> 13
+                0x6b80d293, // rev8 x5, x1
+                0xfff00313, // addi x6, x0, -1
+                0x0a60e3b3, // max  x7, x1, x6 -> 有符号比较取x1
+                0x6080d413, // rori x8, x1, 8
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(2).unwrap(), 0x5b05_b058);
+        assert_eq!(emu.get_reg(3).unwrap(), 0x0030_4620);
+        assert_eq!(emu.get_reg(4).unwrap(), 13);
+        assert_eq!(emu.get_reg(5).unwrap(), 0x7856_3412_0000_0000);
+        assert_eq!(emu.get_reg(7).unwrap(), 0x1234_5678);
+        assert_eq!(emu.get_reg(8).unwrap(), 0x7800_0000_0012_3456);
+    }
+
+    /// 覆盖Zicsr指令与体系结构计数器：mscratch读改写、计数器随执行推进
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_csr_ops_and_counters() {
+        use super::instructions::insts;
+
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x00500093, // addi  x1, x0, 5
+                0x340093f3, // csrrw x7, mscratch, x1
+                0x34002473, // csrrs x8, mscratch, x0
+                0x3400d273, // csrrwi x4, mscratch, 1 -> 旧值5入x4
+                0x00000513, // addi  x10, x0, 0 (退出码0)
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(7).unwrap(), 0); // mscratch复位值
+        assert_eq!(emu.get_reg(8).unwrap(), 5);
+        let state = emu.get_state_ref();
+        assert_eq!(state.get_csr(insts::CSR_MSCRATCH).unwrap(), 1);
+        // 共执行6条指令，mcycle/minstret按1 CPI同步推进，
+        // 用户态cycle/instret是它们的只读影子
+        assert_eq!(state.get_csr(insts::CSR_MINSTRET).unwrap(), 6);
+        assert_eq!(state.get_csr(insts::CSR_CYCLE).unwrap(), 6);
+    }
+
+    /// 覆盖多hart轮转调度：两个hart通过共享内存中的标志同步，
+    /// hart 0自旋等待hart 1写入的标志后退出
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_multi_hart_round_robin() {
+        let mut emu = create_test_emulator();
+        // 追加第二个hart（mhartid=1），与hart 0共享内存
+        let ctx = emu.state.new_hart_context(1);
+        emu.harts.push(ctx);
+        load_insts(
+            &mut emu,
+            &[
+                0xf14022f3, // csrrs x5, mhartid, x0
+                0x00100317, // auipc x6, 0x100 -> 标志地址 pc+0x100000
+                0x00029a63, // bne  x5, x0, +20 (hart 1跳到写端)
+                0x00032383, // 读端: lw  x7, 0(x6)
+                0xfe038ee3, // beq  x7, x0, -4 (自旋等待标志)
+                0x00000513, // addi x10, x0, 0
+                0x00100073, // ebreak
+                0x00100413, // 写端: addi x8, x0, 1
+                0x00832023, // sw   x8, 0(x6)
+                0x0000006f, // jal  x0, 0 (原地死循环)
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        // hart 0停机时读到了hart 1写入的标志
+        assert_eq!(emu.get_reg(7).unwrap(), 1);
+        assert_eq!(emu.get_reg(5).unwrap(), 0);
+    }
+
+    /// 覆盖宏融合路径：lui+addi、slli+srli与比较+分支对
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_fused_pairs() {
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x123450b7, // lui  x1, 0x12345
+                0x67808093, // addi x1, x1, 0x678
+                0x02009113, // slli x2, x1, 32
+                0x02015113, // srli x2, x2, 32
+                0x00500193, // addi x3, x0, 5
+                0xfff18193, // addi x3, x3, -1
+                0x00302233, // slt  x4, x0, x3
+                0xfe021ce3, // bne  x4, x0, -8
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(1).unwrap(), 0x12345678);
+        assert_eq!(emu.get_reg(2).unwrap(), 0x12345678);
+        assert_eq!(emu.get_reg(3).unwrap(), 0);
+        assert_eq!(emu.get_reg(4).unwrap(), 0);
+    }
+
+    /// 循环体执行次数远超JIT热阈值，启用`jit`特性时覆盖编译执行路径
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_hot_loop_execution() {
+        let mut emu = create_test_emulator();
+        // 累加1..=200：循环块会变热并被编译（若启用jit）
+        load_insts(
+            &mut emu,
+            &[
+                0x0c800113, // addi x2, x0, 200
+                0x00000093, // addi x1, x0, 0
+                0x00000193, // addi x3, x0, 0
+                0x00108093, // addi x1, x1, 1
+                0x001181b3, // add  x3, x3, x1
+                0xfe209ce3, // bne  x1, x2, -8
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(3).unwrap(), 200 * 201 / 2);
+    }
+
+    /// 热循环中带内存访问：覆盖JIT生成的边界检查加载/存储路径
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_hot_loop_with_memory() {
+        let mut emu = create_test_emulator();
+        load_insts(
+            &mut emu,
+            &[
+                0x00001117, // auipc x2, 0x1 -> x2 = pc + 0x1000
+                0x06400213, // addi x4, x0, 100
+                0x00000093, // addi x1, x0, 0
+                0x00108093, // addi x1, x1, 1
+                0x00113023, // sd   x1, 0(x2)
+                0x00013183, // ld   x3, 0(x2)
+                0xfe409ae3, // bne  x1, x4, -12
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(1).unwrap(), 100);
+        assert_eq!(emu.get_reg(3).unwrap(), 100);
+    }
+
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_block_with_backward_branch() {
+        let mut emu = create_test_emulator();
+        // 循环10次：x1从0加到10
+        load_insts(
+            &mut emu,
+            &[
+                0x00a00113, // addi x2, x0, 10
+                0x00108093, // addi x1, x1, 1
+                0xfe209ee3, // bne  x1, x2, -4
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(1).unwrap(), 10);
+    }
+
+    /// 批量复用：reset后寄存器/计数器/内存回到上电状态，可再次运行
+    #[test]
+    #[cfg(not(feature = "difftest"))]
+    fn test_reset_between_runs() {
+        let mut emu = create_test_emulator();
+        let boot_pc = emu.get_pc();
+        load_insts(
+            &mut emu,
+            &[
+                0x00500093, // addi x1, x0, 5
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(1).unwrap(), 5);
+
+        emu.reset();
+        assert_eq!(emu.get_exec_state(), ExecState::Idle);
+        assert_eq!(emu.get_pc(), boot_pc);
+        assert_eq!(emu.get_reg(1).unwrap(), 0);
+        assert_eq!(emu.retired_insts(), 0);
+        // 上一次运行写入的代码页已清零
+        assert_eq!(emu.read_memory(boot_pc, 4).unwrap(), vec![0u8; 4]);
+
+        // 复位后的第二个程序正常运行
+        load_insts(
+            &mut emu,
+            &[
+                0x00700113, // addi x2, x0, 7
+                0x00100073, // ebreak
+            ],
+        );
+        emu.steps(usize::MAX).unwrap();
+        assert_eq!(emu.get_exec_state(), ExecState::End);
+        assert_eq!(emu.get_reg(2).unwrap(), 7);
+    }
+
+    /// 快照/回滚：寄存器与内存恢复到检查点，检查点可反复回滚
+    #[test]
+    fn test_snapshot_restore() {
+        let mut emu = create_test_emulator();
+        emu.set_reg(1, 0x1234).unwrap();
+        emu.write_memory(0x8000_2000, &0xdeadbeefu32.to_le_bytes())
+            .unwrap();
+        emu.snapshot();
+
+        // 快照后改写寄存器、覆盖旧页并弄脏新页
+        emu.set_reg(1, 0x5678).unwrap();
+        emu.write_memory(0x8000_2000, &0u32.to_le_bytes()).unwrap();
+        emu.write_memory(0x8000_3000, &[0xff; 8]).unwrap();
+
+        emu.restore().unwrap();
+        assert_eq!(emu.get_reg(1).unwrap(), 0x1234);
+        assert_eq!(
+            emu.read_memory(0x8000_2000, 4).unwrap(),
+            0xdeadbeefu32.to_le_bytes()
+        );
+        assert_eq!(emu.read_memory(0x8000_3000, 8).unwrap(), vec![0u8; 8]);
+
+        // 检查点保留，可再次回滚
+        emu.set_reg(1, 9).unwrap();
+        emu.restore().unwrap();
+        assert_eq!(emu.get_reg(1).unwrap(), 0x1234);
     }
 }
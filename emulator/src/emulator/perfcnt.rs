@@ -0,0 +1,122 @@
+//! 客户机可见的性能计数器设备
+//!
+//! 微基准用墙钟打分会把模拟器速度和客户机代码质量混在一起；这个
+//! 设备把退休指令数、模型周期数与perf-stats热路径计数暴露给客户
+//! 机，`bench_done`可以报告每迭代指令数——跨宿主机稳定，客户机
+//! 侧优化可以精确对比。
+//!
+//! 设备由CPU挂靠：工厂建不了（计数在模拟器手里），`Emulator`创建
+//! 时按设备配置直接映射，运行循环每块/每批把计数发布进共享原子，
+//! 读数滞后不超过一个基本块。
+//!
+//! 寄存器映射（相对于设备基址，均为8字节小端只读；
+//! runtime/perfcnt.h 与此保持一致）:
+//! - 0x00: INSTRET（退休指令数）
+//! - 0x08: CYCLES（模型周期数，当前按1 CPI与指令数一致）
+//! - 0x10: MEM_READS  / 0x18: MEM_WRITES（主内存访问，perf-stats）
+//! - 0x20: MMIO_READS / 0x28: MMIO_WRITES（perf-stats）
+//! - 0x30: FETCH_FAST / 0x38: FETCH_SLOW（取指路径，perf-stats）
+
+use mmio_trait::{DeviceError, MmioDevice};
+use std::sync::Arc;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+const INSTRET_REG: u64 = 0x00;
+const CYCLES_REG: u64 = 0x08;
+const MEM_READS_REG: u64 = 0x10;
+const MEM_WRITES_REG: u64 = 0x18;
+const MMIO_READS_REG: u64 = 0x20;
+const MMIO_WRITES_REG: u64 = 0x28;
+const FETCH_FAST_REG: u64 = 0x30;
+const FETCH_SLOW_REG: u64 = 0x38;
+
+/// CPU侧与设备共享的计数器存储
+///
+/// 发布端每块一次宽松存储，设备读出最近发布的值；非perf-stats
+/// 构建下热路径计数保持为0
+#[derive(Default)]
+pub struct PerfShared {
+    pub instret: AtomicU64,
+    pub cycles: AtomicU64,
+    pub mem_reads: AtomicU64,
+    pub mem_writes: AtomicU64,
+    pub mmio_reads: AtomicU64,
+    pub mmio_writes: AtomicU64,
+    pub fetch_fast: AtomicU64,
+    pub fetch_slow: AtomicU64,
+}
+
+/// 性能计数器 MMIO 设备
+pub struct PerfCnt {
+    name: String,
+    shared: Arc<PerfShared>,
+}
+
+impl PerfCnt {
+    pub fn new(name: String, shared: Arc<PerfShared>) -> Self {
+        Self { name, shared }
+    }
+}
+
+impl MmioDevice for PerfCnt {
+    fn read(&mut self, offset: u64, size: usize) -> Result<Vec<u8>, DeviceError> {
+        let counter = match offset {
+            INSTRET_REG => &self.shared.instret,
+            CYCLES_REG => &self.shared.cycles,
+            MEM_READS_REG => &self.shared.mem_reads,
+            MEM_WRITES_REG => &self.shared.mem_writes,
+            MMIO_READS_REG => &self.shared.mmio_reads,
+            MMIO_WRITES_REG => &self.shared.mmio_writes,
+            FETCH_FAST_REG => &self.shared.fetch_fast,
+            FETCH_SLOW_REG => &self.shared.fetch_slow,
+            _ => {
+                return Err(DeviceError::Access(format!(
+                    "PerfCnt 不支持的寄存器偏移: {:#x}",
+                    offset
+                )))
+            }
+        };
+        match size {
+            1 | 2 | 4 | 8 => {
+                let bytes = counter.load(Ordering::Relaxed).to_le_bytes();
+                Ok(bytes[..size].to_vec())
+            }
+            _ => Err(DeviceError::Unsupported(
+                "PerfCnt 计数器只支持 1/2/4/8 字节读取".to_string(),
+            )),
+        }
+    }
+
+    fn write(&mut self, _offset: u64, _data: &[u8]) -> Result<(), DeviceError> {
+        Err(DeviceError::Unsupported(
+            "PerfCnt 计数器为只读".to_string(),
+        ))
+    }
+
+    fn name(&self) -> &str {
+        &self.name
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_read_published_counters() {
+        let shared = Arc::new(PerfShared::default());
+        let mut dev = PerfCnt::new("perfcnt0".to_string(), shared.clone());
+        shared.instret.store(12345, Ordering::Relaxed);
+        shared.cycles.store(12345, Ordering::Relaxed);
+
+        let r = dev.read(INSTRET_REG, 8).unwrap();
+        assert_eq!(u64::from_le_bytes(r.try_into().unwrap()), 12345);
+        let r = dev.read(CYCLES_REG, 4).unwrap();
+        assert_eq!(u32::from_le_bytes(r.try_into().unwrap()), 12345);
+        // 未发布的热路径计数读出0
+        let r = dev.read(FETCH_SLOW_REG, 8).unwrap();
+        assert_eq!(u64::from_le_bytes(r.try_into().unwrap()), 0);
+        assert!(dev.write(INSTRET_REG, &[0]).is_err());
+        assert!(dev.read(0x40, 8).is_err());
+    }
+}
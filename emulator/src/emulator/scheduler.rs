@@ -0,0 +1,179 @@
+//! 设备事件调度器
+//!
+//! 以退休指令数为时间轴：设备把"第due条指令后叫我"登记进最小堆，
+//! 运行循环的热路径只比较一个缓存的最近期限整数，到期才走冷路径
+//! 弹堆并驱动设备的`tick`回调。这是中断类设备（定时器中断、
+//! UART RX）不在热循环里逐条轮询每个设备的前提。
+
+use crate::emulator::memory::DeviceCell;
+use std::cmp::Ordering;
+use std::collections::BinaryHeap;
+
+/// 一次已登记的设备唤醒
+struct SchedEntry {
+    /// 到期时刻（全局退休指令数）
+    due: u64,
+    /// 登记序号：同刻事件按登记顺序触发
+    seq: u64,
+    /// 周期性事件的重复间隔
+    // difftest逐条单步、不走块循环，到期检查整条链路不会被调用
+    #[cfg_attr(feature = "difftest", allow(dead_code))]
+    period: Option<u64>,
+    #[cfg_attr(feature = "difftest", allow(dead_code))]
+    device: DeviceCell,
+}
+
+// 堆序只看(due, seq)；BinaryHeap是最大堆，比较取反得到最小堆
+impl Ord for SchedEntry {
+    fn cmp(&self, other: &Self) -> Ordering {
+        (other.due, other.seq).cmp(&(self.due, self.seq))
+    }
+}
+
+impl PartialOrd for SchedEntry {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl PartialEq for SchedEntry {
+    fn eq(&self, other: &Self) -> bool {
+        self.due == other.due && self.seq == other.seq
+    }
+}
+
+impl Eq for SchedEntry {}
+
+/// 按退休指令数驱动设备唤醒的调度器
+pub struct DeviceScheduler {
+    heap: BinaryHeap<SchedEntry>,
+    /// 最近的到期时刻（堆空时为u64::MAX），热路径只读这一个整数
+    next_due: u64,
+    next_seq: u64,
+}
+
+impl DeviceScheduler {
+    pub fn new() -> Self {
+        Self {
+            heap: BinaryHeap::new(),
+            next_due: u64::MAX,
+            next_seq: 0,
+        }
+    }
+
+    /// 登记一次性唤醒：退休指令数到达`due`后驱动设备的`tick`
+    pub fn schedule_at(&mut self, due: u64, device: DeviceCell) {
+        self.push(due, None, device);
+    }
+
+    /// 登记周期性唤醒：首次在`due`，此后每`period`条指令重复
+    pub fn schedule_every(&mut self, due: u64, period: u64, device: DeviceCell) {
+        self.push(due, Some(period.max(1)), device);
+    }
+
+    fn push(&mut self, due: u64, period: Option<u64>, device: DeviceCell) {
+        self.heap.push(SchedEntry {
+            due,
+            seq: self.next_seq,
+            period,
+            device,
+        });
+        self.next_seq += 1;
+        self.next_due = self.next_due.min(due);
+    }
+
+    /// 热路径检查：退休指令数是否已到最近期限（无事件时恒为假）
+    #[cfg_attr(feature = "difftest", allow(dead_code))]
+    #[inline(always)]
+    pub fn due(&self, now: u64) -> bool {
+        now >= self.next_due
+    }
+
+    /// 冷路径：驱动所有到期设备，周期事件重新登记
+    ///
+    /// 周期从当前时刻起算而非名义到期点，长块跨过多个周期时不会
+    /// 积压出一连串补触发
+    #[cfg_attr(feature = "difftest", allow(dead_code))]
+    #[cold]
+    #[inline(never)]
+    pub fn run_due(&mut self, now: u64) {
+        while self.heap.peek().is_some_and(|e| e.due <= now) {
+            let mut entry = self.heap.pop().unwrap();
+            entry.device.with(|d| d.tick(now));
+            if let Some(period) = entry.period {
+                entry.due = now + period;
+                entry.seq = self.next_seq;
+                self.next_seq += 1;
+                self.heap.push(entry);
+            }
+        }
+        self.next_due = self.heap.peek().map_or(u64::MAX, |e| e.due);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use mmio_trait::{DeviceError, MmioDevice};
+    use std::cell::RefCell;
+    use std::rc::Rc;
+    use std::sync::{Arc, Mutex};
+
+    /// 记录每次tick时刻的探针设备
+    struct Probe {
+        ticks: Arc<Mutex<Vec<u64>>>,
+    }
+
+    impl MmioDevice for Probe {
+        fn read(&mut self, _offset: u64, size: usize) -> Result<Vec<u8>, DeviceError> {
+            Ok(vec![0; size])
+        }
+
+        fn write(&mut self, _offset: u64, _data: &[u8]) -> Result<(), DeviceError> {
+            Ok(())
+        }
+
+        fn tick(&mut self, cycles: u64) {
+            self.ticks.lock().unwrap().push(cycles);
+        }
+    }
+
+    fn probe() -> (DeviceCell, Arc<Mutex<Vec<u64>>>) {
+        let ticks = Arc::new(Mutex::new(Vec::new()));
+        let cell = DeviceCell::Local(Rc::new(RefCell::new(Probe {
+            ticks: ticks.clone(),
+        })));
+        (cell, ticks)
+    }
+
+    #[test]
+    fn test_oneshot_ordering() {
+        let mut sched = DeviceScheduler::new();
+        let (cell, ticks) = probe();
+        assert!(!sched.due(u64::MAX - 1)); // 空堆永不到期
+        sched.schedule_at(200, cell.clone());
+        sched.schedule_at(100, cell);
+        assert!(!sched.due(99));
+        assert!(sched.due(100));
+        sched.run_due(150);
+        assert_eq!(*ticks.lock().unwrap(), vec![150]);
+        // 剩下的事件成为新期限
+        assert!(!sched.due(199));
+        sched.run_due(200);
+        assert_eq!(*ticks.lock().unwrap(), vec![150, 200]);
+        assert!(!sched.due(u64::MAX - 1));
+    }
+
+    #[test]
+    fn test_periodic_reschedule() {
+        let mut sched = DeviceScheduler::new();
+        let (cell, ticks) = probe();
+        sched.schedule_every(10, 10, cell);
+        sched.run_due(10);
+        // 跨过多个周期只触发一次，下一期限从当前时刻起算
+        sched.run_due(45);
+        assert_eq!(*ticks.lock().unwrap(), vec![10, 45]);
+        assert!(!sched.due(54));
+        assert!(sched.due(55));
+    }
+}
@@ -1,5 +1,6 @@
 //! CPU状态管理
 
+use super::instructions::insts;
 use super::memory::{Memory, MemoryError};
 use crate::{const_values::EmuConfig, utils::disasm::RiscvDisassembler};
 use anyhow::Result;
@@ -47,19 +48,106 @@ pub enum Event {
     WatchRead(u64),
 }
 
+/// 向量寄存器长度（位）
+pub const VLEN: usize = 128;
+/// 单个向量寄存器的字节数
+pub const VLENB: usize = VLEN / 8;
+
+// 固定槽位CSR文件：CSR地址映射到紧凑数组下标，热路径访问不经过哈希。
+// fcsr/vl/vtype等已有专用字段的CSR不占槽位，在get_csr/set_csr中特判
+const CSR_SLOT_MSTATUS: usize = 0;
+const CSR_SLOT_MTVEC: usize = 1;
+const CSR_SLOT_MSCRATCH: usize = 2;
+const CSR_SLOT_MEPC: usize = 3;
+const CSR_SLOT_MCAUSE: usize = 4;
+const CSR_SLOT_MTVAL: usize = 5;
+const CSR_SLOT_MHARTID: usize = 6;
+const CSR_SLOT_MCYCLE: usize = 7;
+const CSR_SLOT_MINSTRET: usize = 8;
+/// CSR槽位总数
+pub const CSR_SLOT_COUNT: usize = 9;
+
+/// 槽位对应的CSR名称与地址（状态转储用）
+const CSR_SLOT_NAMES: [(&str, u16); CSR_SLOT_COUNT] = [
+    ("mstatus", insts::CSR_MSTATUS),
+    ("mtvec", insts::CSR_MTVEC),
+    ("mscratch", insts::CSR_MSCRATCH),
+    ("mepc", insts::CSR_MEPC),
+    ("mcause", insts::CSR_MCAUSE),
+    ("mtval", insts::CSR_MTVAL),
+    ("mhartid", insts::CSR_MHARTID),
+    ("mcycle", insts::CSR_MCYCLE),
+    ("minstret", insts::CSR_MINSTRET),
+];
+
+/// 将CSR地址映射到槽位；未实现的CSR返回None
+#[inline(always)]
+fn csr_slot(csr: u16) -> Option<usize> {
+    match csr {
+        insts::CSR_MSTATUS => Some(CSR_SLOT_MSTATUS),
+        insts::CSR_MTVEC => Some(CSR_SLOT_MTVEC),
+        insts::CSR_MSCRATCH => Some(CSR_SLOT_MSCRATCH),
+        insts::CSR_MEPC => Some(CSR_SLOT_MEPC),
+        insts::CSR_MCAUSE => Some(CSR_SLOT_MCAUSE),
+        insts::CSR_MTVAL => Some(CSR_SLOT_MTVAL),
+        insts::CSR_MHARTID => Some(CSR_SLOT_MHARTID),
+        insts::CSR_MCYCLE => Some(CSR_SLOT_MCYCLE),
+        insts::CSR_MINSTRET => Some(CSR_SLOT_MINSTRET),
+        _ => None,
+    }
+}
+
+/// 单个硬件线程（hart）的体系结构上下文
+///
+/// 只包含寄存器堆、pc与CSR等私有状态；内存与设备由所有hart共享
+/// （仍由`State`持有）。轮转调度时整体换入/换出`State`
+#[derive(Debug, Clone)]
+pub struct HartContext {
+    pub registers: [u64; 32],
+    pub f_regs: [u64; 32],
+    pub fcsr: u64,
+    pub v_regs: [u8; 32 * VLENB],
+    pub vl: u64,
+    pub vtype: u64,
+    pub pc: u64,
+    pub npc: u64,
+    pub csrs: [u64; CSR_SLOT_COUNT],
+    pub reservation: Option<u64>,
+}
+
+impl HartContext {
+    /// 该hart已退休的指令数（minstret）
+    #[inline(always)]
+    pub fn minstret(&self) -> u64 {
+        self.csrs[CSR_SLOT_MINSTRET]
+    }
+}
+
 /// CPU状态
 #[derive(Debug)]
 pub struct State {
     // 通用寄存器
     pub registers: [u64; 32],
+    // 浮点寄存器（FLEN=64，单精度值NaN装箱存放）
+    pub f_regs: [u64; 32],
+    // 浮点控制状态寄存器：[7:5]=frm，[4:0]=fflags
+    pub fcsr: u64,
+    // 向量寄存器组（按字节平铺，LMUL>1的寄存器组天然连续）
+    pub v_regs: [u8; 32 * VLENB],
+    // 向量长度寄存器vl
+    pub vl: u64,
+    // 向量类型寄存器vtype（复位时vill置位）
+    pub vtype: u64,
     // 程序计数器
     pub pc: u64,
     // npc
     pub npc: u64,
-    // CSR寄存器
-    pub csrs: rustc_hash::FxHashMap<u16, u64>,
+    // CSR寄存器（固定槽位数组，见csr_slot）
+    pub csrs: [u64; CSR_SLOT_COUNT],
     // 内存
     pub memory: Memory,
+    // LR/SC保留地址（LR登记，SC校验并清除）
+    pub reservation: Option<u64>,
     // 设置
     pub config: Rc<EmuConfig>,
 }
@@ -70,16 +158,24 @@ impl State {
         // 使用 device_file 中的 memory 配置创建内存
         let mut memory = Memory::new(config.clone(), device_file)?;
         
-        // 初始化设备（从 device_file 中读取设备列表）
-        super::device_manager::DeviceManager::initialize_devices(&mut memory, &device_file.devices)
+        // 初始化设备（从 device_file 中读取设备列表）；
+        // 多hart关闭时设备容器走单线程无锁路径
+        let threaded = config.others.harts > 1;
+        super::device_manager::DeviceManager::initialize_devices(&mut memory, &device_file.devices, threaded)
             .map_err(|e| anyhow::anyhow!("设备初始化失败: {}", e))?;
 
         Ok(Self {
             registers: [0; 32],
+            f_regs: [0; 32],
+            fcsr: 0,
+            v_regs: [0; 32 * VLENB],
+            vl: 0,
+            vtype: 1 << 63,
             pc: config.memory.boot_pc,
             npc: config.memory.boot_pc,
-            csrs: rustc_hash::FxHashMap::default(),
+            csrs: [0; CSR_SLOT_COUNT],
             memory,
+            reservation: None,
             config
         })
     }
@@ -101,12 +197,16 @@ impl State {
     pub fn fetch_instruction(&self, pc: u64) -> Result<u32> {
         // 快速路径：如果PC在主内存区域，使用unsafe快速读取
         if self.memory.is_mem_region_range(pc, 4) {
+            #[cfg(feature = "perf-stats")]
+            super::memory::MemStats::bump(&self.memory.stats.fetch_fast);
             // 安全检查：确保4字节读取不会越界
             unsafe {
                 return Ok(self.memory.read_u32_fast(pc));
             }
         }
-        
+
+        #[cfg(feature = "perf-stats")]
+        super::memory::MemStats::bump(&self.memory.stats.fetch_slow);
         // 慢速路径：可能涉及MMIO或边界情况
         let bytes = self.read_memory(pc, 4)?;
         Ok(bytes
@@ -170,19 +270,118 @@ impl State {
     }
 
     /// 获取CSR值
+    ///
+    /// 浮点/向量CSR直接来自专用字段；用户态只读计数器cycle/instret
+    /// 是机器态mcycle/minstret的影子（time近似为cycle）
     #[inline(always)]
     pub fn get_csr(&self, csr: u16) -> Result<u64> {
-        self.csrs
-            .get(&csr)
-            .copied()
-            .ok_or_else(|| StateError::InvalidCsr(csr).into())
+        match csr {
+            insts::CSR_FFLAGS => Ok(self.fcsr & 0x1f),
+            insts::CSR_FRM => Ok((self.fcsr >> 5) & 0b111),
+            insts::CSR_FCSR => Ok(self.fcsr & 0xff),
+            insts::CSR_VL => Ok(self.vl),
+            insts::CSR_VTYPE => Ok(self.vtype),
+            insts::CSR_VLENB => Ok(VLENB as u64),
+            insts::CSR_CYCLE | insts::CSR_TIME => Ok(self.csrs[CSR_SLOT_MCYCLE]),
+            insts::CSR_INSTRET => Ok(self.csrs[CSR_SLOT_MINSTRET]),
+            _ => csr_slot(csr)
+                .map(|slot| self.csrs[slot])
+                .ok_or_else(|| StateError::InvalidCsr(csr).into()),
+        }
     }
 
-    /// 设置CSR值
+    /// 设置CSR值（对只读CSR或未实现的CSR返回错误）
     #[inline(always)]
     pub fn set_csr(&mut self, csr: u16, value: u64) -> Result<()> {
-        self.csrs.insert(csr, value);
-        Ok(())
+        match csr {
+            insts::CSR_FFLAGS => {
+                self.fcsr = (self.fcsr & !0x1f) | (value & 0x1f);
+                Ok(())
+            }
+            insts::CSR_FRM => {
+                self.fcsr = (self.fcsr & !0xe0) | ((value & 0b111) << 5);
+                Ok(())
+            }
+            insts::CSR_FCSR => {
+                self.fcsr = value & 0xff;
+                Ok(())
+            }
+            _ => match csr_slot(csr) {
+                Some(slot) => {
+                    self.csrs[slot] = value;
+                    Ok(())
+                }
+                None => Err(StateError::InvalidCsr(csr).into()),
+            },
+        }
+    }
+
+    /// 为指定hartid创建复位状态的hart上下文（从boot_pc启动）
+    pub fn new_hart_context(&self, hartid: u64) -> HartContext {
+        let mut ctx = HartContext {
+            registers: [0; 32],
+            f_regs: [0; 32],
+            fcsr: 0,
+            v_regs: [0; 32 * VLENB],
+            vl: 0,
+            vtype: 1 << 63,
+            pc: self.config.memory.boot_pc,
+            npc: self.config.memory.boot_pc,
+            csrs: [0; CSR_SLOT_COUNT],
+            reservation: None,
+        };
+        ctx.csrs[CSR_SLOT_MHARTID] = hartid;
+        ctx
+    }
+
+    /// 保存当前hart的体系结构状态到上下文
+    pub fn save_hart(&self, ctx: &mut HartContext) {
+        ctx.registers = self.registers;
+        ctx.f_regs = self.f_regs;
+        ctx.fcsr = self.fcsr;
+        ctx.v_regs = self.v_regs;
+        ctx.vl = self.vl;
+        ctx.vtype = self.vtype;
+        ctx.pc = self.pc;
+        ctx.npc = self.npc;
+        ctx.csrs = self.csrs;
+        ctx.reservation = self.reservation;
+    }
+
+    /// 从上下文载入hart的体系结构状态
+    pub fn load_hart(&mut self, ctx: &HartContext) {
+        self.registers = ctx.registers;
+        self.f_regs = ctx.f_regs;
+        self.fcsr = ctx.fcsr;
+        self.v_regs = ctx.v_regs;
+        self.vl = ctx.vl;
+        self.vtype = ctx.vtype;
+        self.pc = ctx.pc;
+        self.npc = ctx.npc;
+        self.csrs = ctx.csrs;
+        self.reservation = ctx.reservation;
+    }
+
+    /// 推进体系结构计数器mcycle/minstret
+    ///
+    /// 按1 CPI计：周期数与退休指令数同步增长，客户机程序可用一条
+    /// `rdcycle`完成计时，无需经过定时器设备的MMIO往返
+    #[inline(always)]
+    pub fn bump_counters(&mut self, n: u64) {
+        self.csrs[CSR_SLOT_MCYCLE] = self.csrs[CSR_SLOT_MCYCLE].wrapping_add(n);
+        self.csrs[CSR_SLOT_MINSTRET] = self.csrs[CSR_SLOT_MINSTRET].wrapping_add(n);
+    }
+
+    /// 读取当前动态舍入模式（fcsr的frm字段）
+    #[inline(always)]
+    pub fn get_frm(&self) -> u32 {
+        ((self.fcsr >> 5) & 0b111) as u32
+    }
+
+    /// 累积浮点异常标志到fcsr的fflags字段
+    #[inline(always)]
+    pub fn accrue_fflags(&mut self, flags: u64) {
+        self.fcsr |= flags & 0x1f;
     }
 }
 
@@ -288,14 +487,15 @@ impl fmt::Display for State {
             }
         }
 
-        // 打印CSR寄存器（如果有的话）
-        if !self.csrs.is_empty() {
+        // 打印非零的CSR寄存器
+        if self.csrs.iter().any(|&v| v != 0) {
             writeln!(f)?;
             writeln!(f, "CSR Registers:")?;
-            let mut csr_pairs: Vec<_> = self.csrs.iter().collect();
-            csr_pairs.sort_by_key(|&(k, _)| k);
-            for (csr, value) in csr_pairs {
-                writeln!(f, "  CSR 0x{:03x}: 0x{:016x}", csr, value)?;
+            for (slot, &value) in self.csrs.iter().enumerate() {
+                if value != 0 {
+                    let (name, addr) = CSR_SLOT_NAMES[slot];
+                    writeln!(f, "  {:>8}(0x{:03x}): 0x{:016x}", name, addr, value)?;
+                }
             }
         }
 
@@ -0,0 +1,237 @@
+//! 函数级调用追踪器
+//!
+//! 只盯jal/jalr（及其C扩展形式）的退休：按RISC-V调用规范的
+//! 链接寄存器提示（rd/rs1 ∈ {x1, x5}）区分调用与返回，把落点
+//! 经`load_elf`时建好的按地址排序的符号索引二分映射回函数，
+//! 维护调用栈与每函数指令数。普通指令只给栈顶函数的平坦计数
+//! 加一，符号查找只发生在调用/返回上，不在每一步。
+//!
+//! 退出时输出平坦profile（各函数的调用次数与归属指令数，按
+//! 指令数降序）和调用边表（caller→callee的调用次数），可直接
+//! 回答"客户机里哪个例程在吃时间"。
+
+use rustc_hash::FxHashMap;
+
+use crate::emulator::state::Event;
+use crate::emulator::tracer::TracerTrace;
+use crate::utils::elf::FuncSym;
+
+/// profile各表最多打印的行数
+const REPORT_ROWS: usize = 50;
+
+/// 一条指令对控制流的意义
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum FlowKind {
+    /// 带链接寄存器的跳转：下一条traced指令是被调函数入口
+    Call,
+    /// 经链接寄存器的返回
+    Return,
+}
+
+/// 按调用规范提示分类一条指令；非调用/返回为None
+fn classify(inst: u32) -> Option<FlowKind> {
+    fn is_link(r: u32) -> bool {
+        r == 1 || r == 5
+    }
+    if inst & 3 == 3 {
+        let rd = (inst >> 7) & 0x1f;
+        let rs1 = (inst >> 15) & 0x1f;
+        match inst & 0x7f {
+            0x6f if is_link(rd) => Some(FlowKind::Call),
+            0x67 if is_link(rd) => Some(FlowKind::Call),
+            0x67 if is_link(rs1) => Some(FlowKind::Return),
+            _ => None,
+        }
+    } else {
+        // C扩展：c.jalr隐式链接x1；c.jr ra/t0按返回处理
+        let f = inst & 0xffff;
+        let rs1 = (f >> 7) & 0x1f;
+        let rs2 = (f >> 2) & 0x1f;
+        if f & 0xf003 == 0x9002 && rs1 != 0 && rs2 == 0 {
+            Some(FlowKind::Call)
+        } else if f & 0xf003 == 0x8002 && is_link(rs1) && rs2 == 0 {
+            Some(FlowKind::Return)
+        } else {
+            None
+        }
+    }
+}
+
+/// 每函数的profile计数
+#[derive(Debug, Default, Clone, Copy)]
+struct FuncStat {
+    /// 被调用次数
+    calls: u64,
+    /// 归属到该函数的退休指令数（平坦，不含被调函数）
+    insts: u64,
+}
+
+/// 函数级调用追踪器
+pub struct CTracer {
+    /// 按地址排序的函数符号索引（load_elf时注入）
+    syms: Vec<FuncSym>,
+    /// 与syms平行的计数；末尾追加一格作为"符号外"桶
+    stats: Vec<FuncStat>,
+    /// 调用栈：syms下标（符号外为syms.len()）
+    stack: Vec<usize>,
+    /// caller→callee调用边及次数
+    edges: FxHashMap<(usize, usize), u64>,
+    /// 上一条指令是调用/返回，等本条的PC来结算
+    pending: Option<FlowKind>,
+}
+
+impl CTracer {
+    pub fn new() -> Self {
+        CTracer {
+            syms: Vec::new(),
+            stats: vec![FuncStat::default()],
+            stack: Vec::new(),
+            edges: FxHashMap::default(),
+            pending: None,
+        }
+    }
+
+    /// 二分查找包含pc的函数；符号外返回哨兵下标
+    fn lookup(&self, pc: u64) -> usize {
+        let i = self.syms.partition_point(|s| s.addr <= pc);
+        if i > 0 {
+            let s = &self.syms[i - 1];
+            if pc < s.addr + s.size {
+                return i - 1;
+            }
+        }
+        self.syms.len()
+    }
+
+    /// 哨兵下标对应的显示名
+    fn name(&self, idx: usize) -> &str {
+        self.syms.get(idx).map_or("<符号外>", |s| &s.name)
+    }
+}
+
+impl Default for CTracer {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl TracerTrace for CTracer {
+    fn name(&self) -> &'static str {
+        "CTracer"
+    }
+
+    /// 结算上一条调用/返回、给栈顶函数计数、再分类本条指令
+    fn trace(&mut self, pc: u64, instruction: u32, _event: Event) {
+        match self.pending.take() {
+            Some(FlowKind::Call) => {
+                let callee = self.lookup(pc);
+                let caller = self.stack.last().copied().unwrap_or(self.syms.len());
+                *self.edges.entry((caller, callee)).or_insert(0) += 1;
+                self.stats[callee].calls += 1;
+                self.stack.push(callee);
+            }
+            Some(FlowKind::Return) => {
+                // 手写汇编可能在空栈上"返回"（如启动代码跳入main前）
+                self.stack.pop();
+            }
+            None => {}
+        }
+        let top = self.stack.last().copied().unwrap_or(self.syms.len());
+        self.stats[top].insts += 1;
+        self.pending = classify(instruction);
+    }
+
+    /// 注入新的符号索引并清空既有profile（批量模式换ELF时重建）
+    fn on_symbols(&mut self, syms: &[FuncSym]) {
+        self.syms = syms.to_vec();
+        self.stats = vec![FuncStat::default(); self.syms.len() + 1];
+        self.stack.clear();
+        self.edges.clear();
+        self.pending = None;
+    }
+
+    /// 输出平坦profile与调用边表
+    fn get_instructions_log(&mut self) -> String {
+        let mut log = String::new();
+        let mut order: Vec<usize> = (0..self.stats.len())
+            .filter(|&i| self.stats[i].insts > 0 || self.stats[i].calls > 0)
+            .collect();
+        order.sort_by_key(|&i| std::cmp::Reverse(self.stats[i].insts));
+
+        log += &format!("{:<32} {:>12} {:>16}\n", "函数", "调用次数", "指令数(平坦)");
+        for &i in order.iter().take(REPORT_ROWS) {
+            log += &format!(
+                "{:<32} {:>12} {:>16}\n",
+                self.name(i),
+                self.stats[i].calls,
+                self.stats[i].insts
+            );
+        }
+
+        let mut edges: Vec<(&(usize, usize), &u64)> = self.edges.iter().collect();
+        edges.sort_by_key(|&(_, n)| std::cmp::Reverse(*n));
+        log += &format!("\n{:<32} -> {:<32} {:>12}\n", "调用者", "被调者", "次数");
+        for (&(caller, callee), n) in edges.into_iter().take(REPORT_ROWS) {
+            log += &format!(
+                "{:<32} -> {:<32} {:>12}\n",
+                self.name(caller),
+                self.name(callee),
+                n
+            );
+        }
+        log
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn syms() -> Vec<FuncSym> {
+        vec![
+            FuncSym {
+                addr: 0x1000,
+                size: 0x40,
+                name: "main".into(),
+            },
+            FuncSym {
+                addr: 0x1040,
+                size: 0x20,
+                name: "helper".into(),
+            },
+        ]
+    }
+
+    #[test]
+    fn test_call_return_profile() {
+        let mut t = CTracer::new();
+        t.on_symbols(&syms());
+        // main两条指令，jal ra调helper，helper一条指令后ret回main
+        t.trace(0x1000, 0x0000_0013, Event::None); // nop（栈空，计入符号外）
+        t.trace(0x1004, 0x03c0_00ef, Event::None); // jal ra, helper
+        t.trace(0x1040, 0x0000_0013, Event::None); // helper入口
+        t.trace(0x1044, 0x0000_8067, Event::None); // ret (jalr x0, x1)
+        t.trace(0x1008, 0x0000_0013, Event::None); // 回到调用点之后
+
+        let log = t.get_instructions_log();
+        assert!(log.contains("helper"));
+        // helper被调1次，归属2条指令（入口nop与ret）
+        assert_eq!(t.stats[1].calls, 1);
+        assert_eq!(t.stats[1].insts, 2);
+        // 返回后helper出栈
+        assert!(t.stack.is_empty());
+        // 调用边：符号外(启动) -> helper？调用者是栈顶=符号外
+        assert_eq!(t.edges.get(&(2, 1)), Some(&1));
+    }
+
+    #[test]
+    fn test_lookup_bounds() {
+        let mut t = CTracer::new();
+        t.on_symbols(&syms());
+        assert_eq!(t.lookup(0x1000), 0);
+        assert_eq!(t.lookup(0x103f), 0);
+        assert_eq!(t.lookup(0x1040), 1);
+        assert_eq!(t.lookup(0x2000), 2); // 符号外
+        assert_eq!(t.lookup(0x0fff), 2);
+    }
+}
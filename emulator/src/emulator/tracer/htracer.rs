@@ -0,0 +1,208 @@
+//! 热点PC直方图追踪器（采样式）
+//!
+//! 全量追踪对长跑的客户机程序太重；本追踪器每隔N条指令采一次
+//! PC（N可配，默认1/1024），落进一张开放寻址的紧凑哈希表，退出
+//! 时按样本数降序输出热点报告，并借ELF符号索引把地址标回
+//! `函数+偏移`。热路径上只有一次计数器自减，到期才做一次哈希
+//! 插入，开销与采样率成正比。
+//!
+//! 报告的样本分布同时可以作为译码表按执行频度重排等
+//! profile引导优化的输入。
+
+use crate::emulator::state::Event;
+use crate::emulator::tracer::TracerTrace;
+use crate::utils::elf::FuncSym;
+
+/// 直方图初始桶数（2的幂；装载因子超限时翻倍重散列）
+const INITIAL_BUCKETS: usize = 1 << 12;
+/// 报告最多打印的行数
+const REPORT_ROWS: usize = 50;
+
+/// 开放寻址的PC→样本数直方图
+///
+/// 斐波那契散列+线性探测；空桶以pc==0表示（PC 0不会是合法采样点，
+/// 客户机内存从高地址基址开始）
+struct PcHistogram {
+    buckets: Vec<(u64, u64)>,
+    used: usize,
+}
+
+impl PcHistogram {
+    fn new() -> Self {
+        PcHistogram {
+            buckets: vec![(0, 0); INITIAL_BUCKETS],
+            used: 0,
+        }
+    }
+
+    #[inline]
+    fn slot(pc: u64, mask: usize) -> usize {
+        (pc.wrapping_mul(0x9e37_79b9_7f4a_7c15) >> 32) as usize & mask
+    }
+
+    /// 给pc记一个样本
+    fn bump(&mut self, pc: u64) {
+        let mask = self.buckets.len() - 1;
+        let mut i = Self::slot(pc, mask);
+        loop {
+            let entry = &mut self.buckets[i];
+            if entry.0 == pc {
+                entry.1 += 1;
+                return;
+            }
+            if entry.0 == 0 {
+                *entry = (pc, 1);
+                self.used += 1;
+                // 装载因子>3/4时翻倍，保证探测链短
+                if self.used * 4 > self.buckets.len() * 3 {
+                    self.grow();
+                }
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+    #[cold]
+    fn grow(&mut self) {
+        let old = std::mem::replace(&mut self.buckets, vec![(0, 0); 0]);
+        self.buckets = vec![(0, 0); old.len() * 2];
+        let mask = self.buckets.len() - 1;
+        for (pc, n) in old {
+            if pc == 0 {
+                continue;
+            }
+            let mut i = Self::slot(pc, mask);
+            while self.buckets[i].0 != 0 {
+                i = (i + 1) & mask;
+            }
+            self.buckets[i] = (pc, n);
+        }
+    }
+}
+
+/// 采样式热点PC追踪器
+pub struct HTracer {
+    hist: PcHistogram,
+    /// 采样间隔（指令数）
+    interval: u64,
+    /// 距下次采样的倒计时
+    countdown: u64,
+    /// 总样本数
+    samples: u64,
+    /// 按地址排序的函数符号索引（load_elf时注入）
+    syms: Vec<FuncSym>,
+}
+
+impl HTracer {
+    pub fn new(interval: u64) -> Self {
+        let interval = interval.max(1);
+        HTracer {
+            hist: PcHistogram::new(),
+            interval,
+            countdown: interval,
+            samples: 0,
+            syms: Vec::new(),
+        }
+    }
+
+    /// 把采样PC标成`函数+偏移`；符号外给裸地址
+    fn symbolize(&self, pc: u64) -> String {
+        let i = self.syms.partition_point(|s| s.addr <= pc);
+        if i > 0 {
+            let s = &self.syms[i - 1];
+            if pc < s.addr + s.size {
+                return format!("{}+{:#x}", s.name, pc - s.addr);
+            }
+        }
+        "<符号外>".to_string()
+    }
+}
+
+impl TracerTrace for HTracer {
+    fn name(&self) -> &'static str {
+        "HTracer"
+    }
+
+    /// 倒计时到期才采样，其余指令只有一次自减
+    fn trace(&mut self, pc: u64, _instruction: u32, _event: Event) {
+        self.countdown -= 1;
+        if self.countdown == 0 {
+            self.countdown = self.interval;
+            self.samples += 1;
+            self.hist.bump(pc);
+        }
+    }
+
+    fn on_symbols(&mut self, syms: &[FuncSym]) {
+        self.syms = syms.to_vec();
+    }
+
+    /// 按样本数降序输出热点报告
+    fn get_instructions_log(&mut self) -> String {
+        let mut entries: Vec<(u64, u64)> = self
+            .hist
+            .buckets
+            .iter()
+            .copied()
+            .filter(|&(pc, _)| pc != 0)
+            .collect();
+        entries.sort_by_key(|&(_, n)| std::cmp::Reverse(n));
+
+        let mut log = format!(
+            "采样间隔 {} 条指令, 共 {} 个样本, {} 个不同PC\n{:<18} {:>10} {:>7}  {}\n",
+            self.interval,
+            self.samples,
+            entries.len(),
+            "PC",
+            "样本数",
+            "占比",
+            "位置"
+        );
+        for &(pc, n) in entries.iter().take(REPORT_ROWS) {
+            log += &format!(
+                "{:#018x} {:>10} {:>6.2}%  {}\n",
+                pc,
+                n,
+                n as f64 / self.samples.max(1) as f64 * 100.0,
+                self.symbolize(pc)
+            );
+        }
+        log
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_sampling_and_report() {
+        let mut t = HTracer::new(4);
+        t.on_symbols(&[FuncSym {
+            addr: 0x8000_0000,
+            size: 0x100,
+            name: "hot_loop".into(),
+        }]);
+        // 16条指令在同一PC上循环：间隔4 → 4个样本
+        for _ in 0..16 {
+            t.trace(0x8000_0010, 0x13, Event::None);
+        }
+        assert_eq!(t.samples, 4);
+        let log = t.get_instructions_log();
+        assert!(log.contains("hot_loop+0x10"));
+    }
+
+    #[test]
+    fn test_histogram_growth() {
+        let mut h = PcHistogram::new();
+        // 插入超过扩容阈值的不同PC，计数不得丢失
+        for i in 1..=(INITIAL_BUCKETS as u64) {
+            h.bump(0x8000_0000 + i * 4);
+            h.bump(0x8000_0000 + i * 4);
+        }
+        assert!(h.buckets.len() > INITIAL_BUCKETS);
+        let total: u64 = h.buckets.iter().map(|&(_, n)| n).sum();
+        assert_eq!(total, INITIAL_BUCKETS as u64 * 2);
+    }
+}
@@ -1,7 +1,6 @@
-use super::super::Emulator;
-use crate::const_values::INSTRUCTION_TRACER_LIST_SIZE;
+use crate::emulator::state::Event;
 use crate::emulator::tracer::TracerTrace;
-use crate::utils::disasm_riscv64_with_details;
+use crate::utils::RiscvDisassembler;
 use crate::utils::ringbuf::RingBuffer;
 
 /// 指令和地址结构体
@@ -17,50 +16,49 @@ pub struct ITracer {
 }
 
 impl ITracer {
-    /// 创建新的指令追踪器
-    pub fn new() -> Self {
+    /// 创建新的指令追踪器，环形缓冲大小来自配置
+    pub fn new(list_size: usize) -> Self {
         ITracer {
-            instructions: RingBuffer::new(INSTRUCTION_TRACER_LIST_SIZE),
+            instructions: RingBuffer::new(list_size),
         }
     }
 }
 
-impl Default for ITracer {
-    fn default() -> Self {
-        Self::new()
-    }
-}
-
 impl TracerTrace for ITracer {
     /// 追踪器名称
     fn name(&self) -> &'static str {
         "ITracer"
     }
 
-    /// 追踪一条指令
-    fn trace(&mut self, emulator: &Emulator) {
-        let pc = emulator.state.get_pc();
-        if let Ok(instruction) = emulator.state.fetch_instruction(pc) {
-            self.instructions.push_overwrite(Instruction {
-                pc,
-                code: instruction,
-            });
-        }
+    /// 追踪一条指令：编码由步进循环直接传入，不再重新取指，
+    /// 从MMIO空间取出的指令也能照常记录
+    fn trace(&mut self, pc: u64, instruction: u32, _event: Event) {
+        self.instructions.push_overwrite(Instruction {
+            pc,
+            code: instruction,
+        });
     }
 
     /// 打印所有追踪的指令(带反汇编)
     fn get_instructions_log(&mut self) -> String {
-        let mut log = String::new();
         let mut temp = Vec::new();
         while let Ok(inst) = self.instructions.pop() {
             temp.push(inst);
         }
 
-        for inst in &temp {
-            if let Ok(disasm) = disasm_riscv64_with_details(inst.code, inst.pc) {
-                log += &format!("{:08x}: {:08x}  {}\n", inst.pc, inst.code, disasm);
-            } else {
-                log += &format!("{:08x}: {:08x}  <invalid>\n", inst.pc, inst.code);
+        // 批量走记忆化反汇编：重复指令字只解码一次
+        let mut log = String::new();
+        match RiscvDisassembler::new() {
+            Ok(disasm) => {
+                let pairs: Vec<(u64, u32)> = temp.iter().map(|i| (i.pc, i.code)).collect();
+                for (inst, text) in temp.iter().zip(disasm.disasm_block(&pairs)) {
+                    log += &format!("{:08x}: {:08x}  {}\n", inst.pc, inst.code, text);
+                }
+            }
+            Err(_) => {
+                for inst in &temp {
+                    log += &format!("{:08x}: {:08x}  <invalid>\n", inst.pc, inst.code);
+                }
             }
         }
 
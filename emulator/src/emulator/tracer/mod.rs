@@ -1,87 +1,96 @@
+mod btracer;
+mod ctracer;
+mod ftracer;
+mod htracer;
 mod itracer;
+mod mtracer;
+mod stream;
 
+pub use btracer::BTracer;
+pub use ctracer::CTracer;
+pub use ftracer::FTracer;
+pub use htracer::HTracer;
 pub use itracer::ITracer;
+pub use mtracer::MTracer;
 
+use anyhow::Result;
 use clap::Args;
-use std::sync::{Mutex, OnceLock};
 
-use super::Emulator;
+use super::state::Event;
 
-static GLOBAL_TRACER: OnceLock<Mutex<Option<Tracer>>> = OnceLock::new();
+#[derive(Args, Debug)]
+pub struct TracerArgs {
+    /// 启用指令追踪器
+    #[arg(long, default_value_t = false)]
+    pub enable_itracer: bool,
 
-/// 初始化全局追踪器
-pub fn init_global_tracer(args: TracerArgs) {
-    GLOBAL_TRACER.get_or_init(|| {
-        let mut tracer = Tracer::new();
-        tracer.add_tracers(args);
-        Mutex::new(Some(tracer))
-    });
-}
+    /// 全量指令追踪：把整个运行的指令流以二进制记录写入该文件
+    /// （PC差分编码，专用写线程落盘，格式见ftracer模块文档）
+    #[arg(long, value_name = "PATH")]
+    pub trace_file: Option<String>,
 
-/// 全局追踪入口
-pub fn global_trace(emulator: &Emulator) {
-    let tracers = GLOBAL_TRACER.get();
-    match tracers {
-        Some(tracer) => {
-            if let Ok(mut tracer) = tracer.lock() {
-                if let Some(ref mut t) = *tracer {
-                    t.trace(emulator);
-                }
-            }
-        }
-        None => {
-            tracing::warn!("全局追踪器未初始化，请先调用 init_global_tracer");
-        }
-    }
-}
+    /// 启用内存访问追踪器（最近访存的环形缓冲，退出时打印）
+    #[arg(long, default_value_t = false)]
+    pub enable_mtracer: bool,
 
-/// 获取全局追踪日志
-pub fn global_get_log() -> Option<String> {
-    let tracers = GLOBAL_TRACER.get();
-    match tracers {
-        Some(tracer) => {
-            if let Ok(mut tracer) = tracer.lock() {
-                if let Some(ref mut t) = *tracer {
-                    return Some(t.print_log());
-                }
-            }
-        }
-        None => {
-            tracing::warn!("全局追踪器未初始化，请先调用 init_global_tracer");
-        }
-    };
-    None
-}
+    /// 全量内存访问追踪：把每次数据访存以二进制记录写入该文件
+    /// （格式见mtracer模块文档）
+    #[arg(long, value_name = "PATH")]
+    pub mtrace_file: Option<String>,
 
-/// 销毁全局追踪器
-pub fn destroy_global_tracer() {
-    if let Some(tracer) = GLOBAL_TRACER.get() {
-        if let Ok(mut tracer) = tracer.lock() {
-            *tracer = None; // 清空追踪器
-        }
-    } else {
-        tracing::warn!("全局追踪器未初始化，无法销毁");
-    }
-}
+    /// 启用函数级调用追踪器（按ELF符号的平坦profile与调用图）
+    #[arg(long, default_value_t = false)]
+    pub enable_ctracer: bool,
 
-#[derive(Args, Debug)]
-pub struct TracerArgs {
-    /// 启用指令追踪器
+    /// 启用采样式热点PC直方图追踪器
     #[arg(long, default_value_t = false)]
-    pub enable_itracer: bool,
+    pub enable_htracer: bool,
+
+    /// 热点采样间隔：每N条指令采一次PC
+    #[arg(long, default_value_t = 1024, value_name = "N")]
+    pub htracer_interval: u64,
+
+    /// 启用分支行为追踪器（taken率、jalr落点分布、平均块长）
+    #[arg(long, default_value_t = false)]
+    pub enable_btracer: bool,
+
+    /// 分支站点采样间隔：每N次分支事件记录一次站点信息
+    #[arg(long, default_value_t = 1, value_name = "N")]
+    pub btracer_interval: u64,
 }
 
 /// 统一的追踪器入口
+///
+/// 由`Emulator`直接持有：追踪器在启动时从`TracerArgs`配置一次，
+/// 之后逐条指令的trace是无同步的直接调用（旧版经全局`OnceLock<Mutex>`
+/// 转发，每条指令都要一对原子读改写且无法内联进`step_internal`）
 pub struct Tracer {
     tracers: Vec<Box<dyn TracerTrace>>,
 }
 
-trait TracerTrace: Send + Sync {
+trait TracerTrace {
     /// 追踪器名称
     fn name(&self) -> &'static str;
 
-    /// 追踪一条指令
-    fn trace(&mut self, emulator: &Emulator);
+    /// 追踪一条已退休的指令（PC、编码与本条产生的事件）
+    fn trace(&mut self, pc: u64, instruction: u32, event: Event);
+
+    /// 追踪一次数据访存（载入/存储处理器上报；默认不关心）
+    fn trace_mem(&mut self, _pc: u64, _addr: u64, _size: u8, _is_write: bool, _value: u64) {}
+
+    /// 追踪一次分支/跳转事件（分支处理器上报；默认不关心）
+    fn trace_branch(
+        &mut self,
+        _pc: u64,
+        _taken: bool,
+        _conditional: bool,
+        _indirect: bool,
+        _target: u64,
+    ) {
+    }
+
+    /// ELF加载后注入函数符号索引（默认不关心）
+    fn on_symbols(&mut self, _syms: &[crate::utils::elf::FuncSym]) {}
 
     /// 打印Log
     fn get_instructions_log(&mut self) -> String;
@@ -95,16 +104,68 @@ impl Tracer {
         Tracer { tracers }
     }
 
-    pub fn add_tracers(&mut self, args: TracerArgs) {
+    /// 按启动参数注册追踪器（注册只发生在构造时这一次）
+    pub fn add_tracers(
+        &mut self,
+        args: &TracerArgs,
+        config: &crate::const_values::EmuConfig,
+    ) -> Result<()> {
         if args.enable_itracer {
-            self.tracers.push(Box::new(ITracer::new()));
+            self.tracers.push(Box::new(ITracer::new(
+                config.debug.instruction_tracer_list_size,
+            )));
+        }
+        if let Some(path) = &args.trace_file {
+            self.tracers.push(Box::new(FTracer::new(path)?));
+        }
+        if args.enable_ctracer {
+            self.tracers.push(Box::new(CTracer::new()));
+        }
+        if args.enable_btracer {
+            self.tracers.push(Box::new(BTracer::new(args.btracer_interval)));
+        }
+        if args.enable_htracer {
+            self.tracers.push(Box::new(HTracer::new(args.htracer_interval)));
+        }
+        if args.enable_mtracer || args.mtrace_file.is_some() {
+            self.tracers.push(Box::new(MTracer::new(
+                args.enable_mtracer
+                    .then_some(config.debug.instruction_tracer_list_size),
+                args.mtrace_file.as_deref(),
+            )?));
+        }
+        Ok(())
+    }
+
+    /// 统一的trace入口：参数都是步进循环手上现成的值，
+    /// 追踪器不再回头访问客户机内存重新取指
+    #[inline]
+    pub fn trace(&mut self, pc: u64, instruction: u32, event: Event) {
+        for tracer in &mut self.tracers {
+            tracer.trace(pc, instruction, event);
+        }
+    }
+
+    /// 把函数符号索引分发给关心的追踪器（load_elf后调用一次）
+    pub fn set_symbols(&mut self, syms: &[crate::utils::elf::FuncSym]) {
+        for tracer in &mut self.tracers {
+            tracer.on_symbols(syms);
+        }
+    }
+
+    /// 分支/跳转事件的trace入口（只有注册了BTracer时才有消费者）
+    #[inline]
+    pub fn trace_branch(&mut self, pc: u64, taken: bool, conditional: bool, indirect: bool, target: u64) {
+        for tracer in &mut self.tracers {
+            tracer.trace_branch(pc, taken, conditional, indirect, target);
         }
     }
 
-    /// 统一的trace入口
-    pub fn trace(&mut self, emulator: &Emulator) {
+    /// 数据访存的trace入口（只有注册了MTracer时才有消费者）
+    #[inline]
+    pub fn trace_mem(&mut self, pc: u64, addr: u64, size: u8, is_write: bool, value: u64) {
         for tracer in &mut self.tracers {
-            tracer.trace(emulator);
+            tracer.trace_mem(pc, addr, size, is_write, value);
         }
     }
 
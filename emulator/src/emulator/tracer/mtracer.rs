@@ -0,0 +1,160 @@
+//! 内存访问追踪器
+//!
+//! 记录每次数据访存的`(pc, addr, size, 读/写, value)`，供固件的
+//! 缓存行为分析使用——不必再往客户机代码里手插UART打印去观察
+//! 访存序列。记录由`rv64i.rs`的载入/存储处理器在算完地址后直接
+//! 上报，追踪器不再访问客户机内存。
+//!
+//! 两种输出模式（可同时开）：
+//! - `--enable-mtracer`：环形缓冲保留最近若干次访存，退出时随
+//!   追踪日志打印（同[`ITracer`](super::ITracer)的用法）
+//! - `--mtrace-file PATH`：全量二进制流，经[`StreamWriter`]的
+//!   双缓冲写线程落盘
+//!
+//! 流文件格式（小端）：文件头魔数`DOLPHMTR`+u32版本+u32保留，
+//! 记录为32字节 `{ pc: u64, addr: u64, value: u64, flags: u8, pad: [u8;7] }`，
+//! `flags`低7位是访问字节数，最高位置位表示写。
+
+use anyhow::Result;
+
+use crate::emulator::state::Event;
+use crate::emulator::tracer::TracerTrace;
+use crate::emulator::tracer::stream::StreamWriter;
+use crate::utils::ringbuf::RingBuffer;
+
+/// 流文件头魔数
+const MAGIC: &[u8; 8] = b"DOLPHMTR";
+/// flags中的写标志位
+const FLAG_WRITE: u8 = 0x80;
+
+/// 一次数据访存
+#[derive(Debug, Clone, Copy, Default)]
+struct MemAccess {
+    pc: u64,
+    addr: u64,
+    value: u64,
+    size: u8,
+    is_write: bool,
+}
+
+/// 内存访问追踪器
+pub struct MTracer {
+    /// 最近访存的环形缓冲（`--enable-mtracer`时为Some）
+    recent: Option<RingBuffer<MemAccess>>,
+    /// 全量流输出（`--mtrace-file`时为Some）
+    stream: Option<(StreamWriter, String)>,
+    /// 已记录的访存数
+    records: u64,
+}
+
+impl MTracer {
+    /// 创建追踪器；`ring_size`为Some时启用环形缓冲，
+    /// `stream_path`为Some时启用全量流
+    pub fn new(ring_size: Option<usize>, stream_path: Option<&str>) -> Result<Self> {
+        let stream = match stream_path {
+            Some(path) => Some((StreamWriter::new(path, MAGIC)?, path.to_string())),
+            None => None,
+        };
+        Ok(MTracer {
+            recent: ring_size.map(RingBuffer::new),
+            stream,
+            records: 0,
+        })
+    }
+}
+
+impl TracerTrace for MTracer {
+    fn name(&self) -> &'static str {
+        "MTracer"
+    }
+
+    /// 指令级回调与访存无关，此追踪器只消费trace_mem
+    fn trace(&mut self, _pc: u64, _instruction: u32, _event: Event) {}
+
+    /// 记录一次数据访存
+    fn trace_mem(&mut self, pc: u64, addr: u64, size: u8, is_write: bool, value: u64) {
+        if let Some(recent) = &mut self.recent {
+            recent.push_overwrite(MemAccess {
+                pc,
+                addr,
+                value,
+                size,
+                is_write,
+            });
+        }
+        if let Some((out, _)) = &mut self.stream {
+            let mut rec = [0u8; 32];
+            rec[..8].copy_from_slice(&pc.to_le_bytes());
+            rec[8..16].copy_from_slice(&addr.to_le_bytes());
+            rec[16..24].copy_from_slice(&value.to_le_bytes());
+            rec[24] = size | if is_write { FLAG_WRITE } else { 0 };
+            out.push(&rec);
+        }
+        self.records += 1;
+    }
+
+    /// 打印最近的访存记录与落盘情况
+    fn get_instructions_log(&mut self) -> String {
+        let mut log = String::new();
+        if let Some(recent) = &mut self.recent {
+            let mut temp = Vec::new();
+            while let Ok(acc) = recent.pop() {
+                temp.push(acc);
+            }
+            for acc in &temp {
+                log += &format!(
+                    "{:08x}: {} {:016x} [{}] = {:016x}\n",
+                    acc.pc,
+                    if acc.is_write { "W" } else { "R" },
+                    acc.addr,
+                    acc.size,
+                    acc.value
+                );
+            }
+            // 重新放回ringbuf
+            for acc in temp {
+                recent.push_overwrite(acc);
+            }
+        }
+        if let Some((_, path)) = &self.stream {
+            log += &format!("已向 {} 写出 {} 条访存记录\n", path, self.records);
+        }
+        log
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_mtracer_stream_roundtrip() {
+        let path = std::env::temp_dir().join("dolphin_mtracer_test.bin");
+        let path = path.to_str().unwrap();
+        let accesses = [
+            (0x8000_0000u64, 0x8001_0000u64, 8u8, false, 0xdead_beefu64),
+            (0x8000_0004, 0x8001_0008, 1, true, 0xff),
+            (0x8000_0008, 0x1000_0000, 4, true, 0x1234_5678),
+        ];
+        {
+            let mut tracer = MTracer::new(Some(4), Some(path)).unwrap();
+            for &(pc, addr, size, is_write, value) in &accesses {
+                tracer.trace_mem(pc, addr, size, is_write, value);
+            }
+            // 环形缓冲的文本日志包含读写方向
+            let log = tracer.get_instructions_log();
+            assert!(log.contains("W 0000000080010008"));
+        }
+        let data = std::fs::read(path).unwrap();
+        assert_eq!(&data[..8], MAGIC);
+        for (i, &(pc, addr, size, is_write, value)) in accesses.iter().enumerate() {
+            let rec = &data[16 + i * 32..16 + (i + 1) * 32];
+            assert_eq!(u64::from_le_bytes(rec[..8].try_into().unwrap()), pc);
+            assert_eq!(u64::from_le_bytes(rec[8..16].try_into().unwrap()), addr);
+            assert_eq!(u64::from_le_bytes(rec[16..24].try_into().unwrap()), value);
+            assert_eq!(rec[24] & 0x7f, size);
+            assert_eq!(rec[24] & FLAG_WRITE != 0, is_write);
+        }
+        let _ = std::fs::remove_file(path);
+    }
+}
@@ -0,0 +1,107 @@
+//! 追踪流的公共落盘后端：双缓冲+专用写线程
+//!
+//! [`FTracer`](super::FTracer)与[`MTracer`](super::MTracer)的流式
+//! 模式共用这套机制：热路径只往前台缓冲追加字节，缓冲写满后整块
+//! 与写线程还回的空缓冲交换，顺序write在后台进行，生成侧不等I/O。
+//!
+//! 每个流文件以8字节魔数+u32版本号+u32保留位开头，记录格式由
+//! 各追踪器自己定义。
+
+use std::fs::File;
+use std::io::{BufWriter, Write};
+use std::sync::mpsc::{self, Receiver, SyncSender};
+use std::thread::JoinHandle;
+
+use anyhow::{Context, Result};
+
+/// 单个流缓冲的容量：写满即移交写线程
+const BUF_CAP: usize = 1 << 20;
+/// 格式版本号（所有流文件共用）
+const VERSION: u32 = 1;
+
+/// 双缓冲流写出器
+pub(super) struct StreamWriter {
+    /// 当前在填的前台缓冲
+    buf: Vec<u8>,
+    /// 满缓冲送往写线程
+    full_tx: Option<SyncSender<Vec<u8>>>,
+    /// 写线程还回的空缓冲
+    empty_rx: Receiver<Vec<u8>>,
+    writer: Option<JoinHandle<std::io::Result<()>>>,
+}
+
+impl StreamWriter {
+    /// 打开输出文件、写文件头并启动写线程
+    pub(super) fn new(path: &str, magic: &[u8; 8]) -> Result<Self> {
+        let file = File::create(path).with_context(|| format!("无法创建追踪文件 '{}'", path))?;
+        let mut out = BufWriter::new(file);
+        out.write_all(magic)?;
+        out.write_all(&VERSION.to_le_bytes())?;
+        out.write_all(&0u32.to_le_bytes())?;
+
+        // 双缓冲：一块在主线程填，一块在写线程落盘
+        let (full_tx, full_rx) = mpsc::sync_channel::<Vec<u8>>(1);
+        let (empty_tx, empty_rx) = mpsc::channel::<Vec<u8>>();
+        empty_tx.send(Vec::with_capacity(BUF_CAP)).ok();
+        let writer = std::thread::Builder::new()
+            .name("trace-writer".into())
+            .spawn(move || -> std::io::Result<()> {
+                while let Ok(mut buf) = full_rx.recv() {
+                    out.write_all(&buf)?;
+                    buf.clear();
+                    // 主线程已退出时还不回去也无妨
+                    let _ = empty_tx.send(buf);
+                }
+                out.flush()
+            })
+            .expect("无法创建追踪写线程");
+
+        Ok(StreamWriter {
+            buf: Vec::with_capacity(BUF_CAP),
+            full_tx: Some(full_tx),
+            empty_rx,
+            writer: Some(writer),
+        })
+    }
+
+    /// 追加一条记录；缓冲满时移交写线程
+    #[inline]
+    pub(super) fn push(&mut self, record: &[u8]) {
+        self.buf.extend_from_slice(record);
+        if self.buf.len() >= BUF_CAP - 32 {
+            self.rotate();
+        }
+    }
+
+    /// 把填满的前台缓冲换成写线程还回的空缓冲
+    ///
+    /// 只在写线程落后于生成速度时阻塞；顺序write跟得上的话
+    /// 空缓冲总是现成的
+    #[cold]
+    fn rotate(&mut self) {
+        let Some(tx) = &self.full_tx else { return };
+        let Ok(mut next) = self.empty_rx.recv() else {
+            return;
+        };
+        std::mem::swap(&mut self.buf, &mut next);
+        let _ = tx.send(next);
+    }
+}
+
+impl Drop for StreamWriter {
+    /// 冲出残余缓冲、关闭队列并等写线程把文件刷完
+    fn drop(&mut self) {
+        if let Some(tx) = self.full_tx.take() {
+            if !self.buf.is_empty() {
+                let _ = tx.send(std::mem::take(&mut self.buf));
+            }
+        }
+        if let Some(writer) = self.writer.take() {
+            match writer.join() {
+                Ok(Err(e)) => tracing::warn!("追踪文件写入失败: {}", e),
+                Err(_) => tracing::warn!("追踪写线程异常退出"),
+                Ok(Ok(())) => {}
+            }
+        }
+    }
+}
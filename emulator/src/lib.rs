@@ -41,27 +41,137 @@ pub struct Args {
     #[arg(short = 'd', long, default_value = "../devices/profile/device.toml")]
     pub device_config: String,
 
+    /// 以JSON格式输出退出时的性能报告（供性能CI解析）
+    #[arg(long, default_value = "false")]
+    pub perf_json: bool,
+
+    /// 批量模式：在同一进程内依次运行多个ELF并报告各自的通过情况，
+    /// 运行之间只复位体系结构状态与被写过的内存页
+    #[arg(long, num_args = 1.., value_name = "ELF")]
+    pub batch: Vec<String>,
+
+    /// 预译码块持久缓存目录：运行结束把块表按ELF内容哈希存盘，
+    /// 下次运行同一ELF直接读回，CI反复运行时省掉热身译码
+    #[arg(long, value_name = "DIR")]
+    pub block_store: Option<String>,
+
+    /// 每执行约N条指令自动拍摄一次检查点（0为关闭）；
+    /// 实际粒度为运行块大小，首次快照全量复制内存、之后仅增量
+    #[arg(long, default_value = "0")]
+    pub snapshot_every: u64,
+
+    /// 共享内存difftest文件路径：外部参考实现（如Spike适配器）映射
+    /// 同一文件，经环形缓冲批量交换寄存器快照与脏页哈希；
+    /// 不设置则使用内置的rv64emu参考核
+    #[cfg(feature = "difftest")]
+    #[arg(long, value_name = "PATH")]
+    pub diff_shm: Option<String>,
+
     /// 追踪器参数
     #[cfg(feature = "tracer")]
     #[command(flatten)]
     pub tracer: TracerArgs,
 }
 
+/// SIGINT标志：信号处理器只置位，报告由主循环在块间退出后正常输出
+static INTERRUPTED: std::sync::atomic::AtomicBool = std::sync::atomic::AtomicBool::new(false);
+
+extern "C" fn on_sigint(_sig: libc::c_int) {
+    INTERRUPTED.store(true, std::sync::atomic::Ordering::Relaxed);
+}
+
+/// 安装SIGINT处理器，使Ctrl-C中断运行循环而非直接杀死进程
+fn install_sigint_handler() {
+    unsafe {
+        libc::signal(libc::SIGINT, on_sigint as libc::sighandler_t);
+    }
+}
+
+/// 输出主机侧性能报告：指令数、墙钟时间与MIPS
+fn print_perf_report(instructions: u64, elapsed: std::time::Duration, json: bool) {
+    let secs = elapsed.as_secs_f64();
+    let mips = if secs > 0.0 {
+        instructions as f64 / secs / 1e6
+    } else {
+        0.0
+    };
+    if json {
+        println!(
+            "{{\"instructions\":{},\"wall_time_s\":{:.6},\"mips\":{:.3}}}",
+            instructions, secs, mips
+        );
+    } else {
+        println!(
+            "性能报告: 指令数 {}, 墙钟时间 {:.3}s, {:.2} MIPS",
+            instructions, secs, mips
+        );
+    }
+}
+
+/// 批量模式：在同一进程内依次运行清单中的ELF，报告逐项通过情况
+///
+/// 每个程序结束后用`Emulator::reset`复位，省掉逐次进程启动的配置
+/// 解析、128MB内存清零与译码表构建；有任一程序未通过时返回错误
+#[cfg(not(feature = "gdb"))]
+fn run_batch(emu: &mut Emulator, elfs: &[String]) -> Result<()> {
+    use colored::Colorize;
+
+    let mut failed = 0usize;
+    for (i, elf_path) in elfs.iter().enumerate() {
+        if i > 0 {
+            emu.reset();
+        }
+        let start = std::time::Instant::now();
+        let result = emu.load_elf(elf_path).and_then(|_| {
+            while emu.get_exec_state() != emulator::ExecState::End {
+                if INTERRUPTED.load(std::sync::atomic::Ordering::Relaxed) {
+                    break;
+                }
+                emu.steps(emulator::RUN_CHUNK)?;
+            }
+            Ok(())
+        });
+        if INTERRUPTED.load(std::sync::atomic::Ordering::Relaxed) {
+            info!("收到SIGINT，跳过剩余程序");
+            break;
+        }
+        let secs = start.elapsed().as_secs_f64();
+        // 复位会清掉块缓存，持久化必须发生在每个程序结束时
+        emu.save_block_store();
+        match result {
+            Ok(()) => println!("{} {} ({:.3}s)", "PASS".green(), elf_path, secs),
+            Err(e) => {
+                failed += 1;
+                println!("{} {} ({:.3}s): {:#}", "FAIL".red(), elf_path, secs, e);
+            }
+        }
+    }
+    println!("批量运行完成: {}/{} 通过", elfs.len() - failed, elfs.len());
+    if failed > 0 {
+        return Err(anyhow::anyhow!("{failed} 个程序未通过"));
+    }
+    Ok(())
+}
+
 pub fn build_emu_run_blocking(args: Args) -> Result<()> {
     // 创建模拟器
     let mut emu = Emulator::new(&args)?;
 
+    // 批量模式：不走单ELF的加载与运行路径
+    #[cfg(not(feature = "gdb"))]
+    if !args.batch.is_empty() {
+        install_sigint_handler();
+        return run_batch(&mut emu, &args.batch);
+    }
+
     if let Some(elf_path) = &args.elf {
         info!(path = %elf_path, "加载ELF文件");
+        // difftest下load_elf内部一趟共享加载，参考核同步装入
         emu.load_elf(elf_path)?;
-
-        #[cfg(feature = "difftest")]
-        utils::load_elf_diff(emu.get_ref_mut(), elf_path)?;
     }
 
-    // 初始化全局追踪器
-    #[cfg(feature = "tracer")]
-    emulator::tracer::init_global_tracer(args.tracer);
+    install_sigint_handler();
+    let run_start = std::time::Instant::now();
 
     #[cfg(feature = "gdb")] // 条件编译 GDB 支持
     {
@@ -81,23 +191,57 @@ pub fn build_emu_run_blocking(args: Args) -> Result<()> {
     }
     #[cfg(not(feature = "gdb"))] // 如果没有启用 GDB
     {
-        // 运行模拟器
+        // 运行模拟器：按固定大小的块推进，直到程序结束或收到SIGINT
+        let mut next_snapshot = if args.snapshot_every > 0 {
+            args.snapshot_every
+        } else {
+            u64::MAX
+        };
         while emu.get_exec_state() != emulator::ExecState::End {
+            if INTERRUPTED.load(std::sync::atomic::Ordering::Relaxed) {
+                info!("收到SIGINT，提前结束运行");
+                break;
+            }
             // 执行模拟器步骤
-            emu.steps(usize::MAX)?;
+            emu.steps(emulator::RUN_CHUNK)?;
+
+            // 周期性自动快照（在块间进行，状态一致）
+            if emu.retired_insts() >= next_snapshot {
+                emu.snapshot();
+                info!(instructions = emu.retired_insts(), "已拍摄检查点");
+                next_snapshot = emu.retired_insts().saturating_add(args.snapshot_every);
+            }
         }
     }
 
+    // 运行结束持久化块缓存（GDB会话可能在内存中打过断点补丁，不保存）
+    #[cfg(not(feature = "gdb"))]
+    emu.save_block_store();
+
+    // 退出（含SIGINT中断）时输出主机侧性能报告
+    print_perf_report(emu.retired_insts(), run_start.elapsed(), args.perf_json);
+
+    // 退出时输出性能计数汇总
+    #[cfg(feature = "perf-stats")]
+    info!("性能统计:\n{}", emu.perf_summary());
+
+    // 退出时输出缓存模型统计
+    #[cfg(feature = "cache-model")]
+    info!("缓存模型统计:\n{}", emu.cache_summary());
+
+    // 退出时输出分支预测器模型统计
+    #[cfg(feature = "branch-model")]
+    info!("分支预测器模型统计:\n{}", emu.branch_summary());
+
     #[cfg(feature = "tracer")]
     {
-        // 打印追踪日志
-        use crate::emulator::tracer::destroy_global_tracer;
-        if let Some(log) = emulator::tracer::global_get_log() {
-            info!("追踪日志:\n{}", log);
-        } else {
+        // 打印追踪日志（追踪器随模拟器一起构造，无全局状态需要销毁）
+        let log = emu.tracer_log();
+        if log.is_empty() {
             info!("没有追踪日志");
+        } else {
+            info!("追踪日志:\n{}", log);
         }
-        destroy_global_tracer();
     }
 
     Ok(())
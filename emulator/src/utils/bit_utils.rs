@@ -137,6 +137,20 @@ impl BitSlice for u32 {
     }
 }
 
+/// 编译期位段提取：取闭区间[HI:LO]（与指令手册位号一致），
+/// 掩码与移位量在单态化时折叠为立即数。
+/// 要求 LO <= HI < 64，违反时在debug构建下因移位越界panic
+#[inline(always)]
+pub fn bits<const HI: u32, const LO: u32>(value: impl Into<u64>) -> u64 {
+    (value.into() >> LO) & (u64::MAX >> (63 - (HI - LO)))
+}
+
+/// 编译期宽度的符号扩展：取value低WIDTH位并符号扩展到64位
+#[inline(always)]
+pub fn sign_extend<const WIDTH: u32>(value: u64) -> u64 {
+    ((value << (64 - WIDTH)) as i64 >> (64 - WIDTH)) as u64
+}
+
 #[inline(always)]
 pub fn sign_extend_64(value: u64, num_bits: u64) -> u64 {
     let shift_amount = 64 - num_bits; // 扩展到64位
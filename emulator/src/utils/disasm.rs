@@ -1,11 +1,24 @@
 //! RISC-V 64位指令反汇编模块
 
+use std::cell::RefCell;
+
 use anyhow::{Result, anyhow};
 use capstone::prelude::*;
+use rustc_hash::FxHashMap;
+
+/// 记忆化缓存的容量上限：超过即整体清空（循环热的trace里
+/// 不同指令字远少于此，实际不会触发）
+const CACHE_CAP: usize = 1 << 16;
 
 /// RISC-V 64位反汇编器
+///
+/// 带(指令字, 地址)→文本的记忆化缓存：循环热的trace里同样的
+/// 指令出现成千上万次，dump大trace时只有首次见到的指令走
+/// capstone，其余都是哈希命中。键里带地址是因为分支/jal的
+/// 操作数文本含按PC算出的绝对目标，单凭指令字不够
 pub struct RiscvDisassembler {
     cs: Capstone,
+    cache: RefCell<FxHashMap<(u32, u64), String>>,
 }
 
 impl RiscvDisassembler {
@@ -18,7 +31,10 @@ impl RiscvDisassembler {
             .build()
             .map_err(|e| anyhow!("Failed to create capstone engine: {}", e))?;
 
-        Ok(Self { cs })
+        Ok(Self {
+            cs,
+            cache: RefCell::new(FxHashMap::default()),
+        })
     }
 
     /// 反汇编单条指令
@@ -30,26 +46,49 @@ impl RiscvDisassembler {
     /// # 返回
     /// 返回反汇编后的文本表示
     pub fn disasm_instruction(&self, code: u32, address: u64) -> Result<String> {
-        let code_bytes = code.to_le_bytes();
+        if let Some(text) = self.cache.borrow().get(&(code, address)) {
+            return Ok(text.clone());
+        }
 
+        let code_bytes = code.to_le_bytes();
         let insns = self
             .cs
             .disasm_all(&code_bytes, address)
             .map_err(|e| anyhow!("Failed to disassemble: {}", e))?;
 
-        if insns.is_empty() {
-            return Ok(format!("0x{:08x}    <invalid>", code));
-        }
-
-        let insn = &insns[0];
-        let mnemonic = insn.mnemonic().unwrap_or("<unknown>");
-        let op_str = insn.op_str().unwrap_or("");
-
-        if op_str.is_empty() {
-            Ok(mnemonic.to_string())
+        let text = if insns.is_empty() {
+            format!("0x{:08x}    <invalid>", code)
         } else {
-            Ok(format!("{} {}", mnemonic, op_str))
+            let insn = &insns[0];
+            let mnemonic = insn.mnemonic().unwrap_or("<unknown>");
+            let op_str = insn.op_str().unwrap_or("");
+            if op_str.is_empty() {
+                mnemonic.to_string()
+            } else {
+                format!("{} {}", mnemonic, op_str)
+            }
+        };
+
+        let mut cache = self.cache.borrow_mut();
+        if cache.len() >= CACHE_CAP {
+            cache.clear();
         }
+        cache.insert((code, address), text.clone());
+        Ok(text)
+    }
+
+    /// 批量反汇编：逐条过记忆化缓存，返回与输入等长的文本列表
+    ///
+    /// 无法反汇编的条目给`<invalid>`文本而不是整体失败，
+    /// 适合把大段二进制trace转成文本
+    pub fn disasm_block(&self, insts: &[(u64, u32)]) -> Vec<String> {
+        insts
+            .iter()
+            .map(|&(pc, code)| {
+                self.disasm_instruction(code, pc)
+                    .unwrap_or_else(|_| "<invalid>".to_string())
+            })
+            .collect()
     }
 
     /// 反汇编指令缓冲区
@@ -92,27 +131,7 @@ impl RiscvDisassembler {
     /// # 返回
     /// 返回包含地址、机器码和反汇编文本的格式化字符串
     pub fn disasm_with_details(&self, code: u32, address: u64) -> Result<String> {
-        let code_bytes = code.to_le_bytes();
-
-        let insns = self
-            .cs
-            .disasm_all(&code_bytes, address)
-            .map_err(|e| anyhow!("Failed to disassemble: {}", e))?;
-
-        if insns.is_empty() {
-            return Ok(format!("0x{:016x}: {:08x}    <invalid>", address, code));
-        }
-
-        let insn = &insns[0];
-        let mnemonic = insn.mnemonic().unwrap_or("<unknown>");
-        let op_str = insn.op_str().unwrap_or("");
-
-        let disasm_text = if op_str.is_empty() {
-            mnemonic.to_string()
-        } else {
-            format!("{} {}", mnemonic, op_str)
-        };
-
+        let disasm_text = self.disasm_instruction(code, address)?;
         Ok(format!(
             "0x{:016x}: {:08x}    {}",
             address, code, disasm_text
@@ -120,16 +139,31 @@ impl RiscvDisassembler {
     }
 }
 
+thread_local! {
+    /// 便利函数共享的反汇编器：capstone引擎与缓存每线程只建一次，
+    /// 错误路径上临时的ad hoc反汇编不再反复初始化引擎
+    static SHARED_DISASM: RefCell<Option<RiscvDisassembler>> = const { RefCell::new(None) };
+}
+
+/// 在线程本地的共享反汇编器上执行f
+fn with_shared_disasm<T>(f: impl FnOnce(&RiscvDisassembler) -> Result<T>) -> Result<T> {
+    SHARED_DISASM.with(|cell| {
+        let mut slot = cell.borrow_mut();
+        if slot.is_none() {
+            *slot = Some(RiscvDisassembler::new()?);
+        }
+        f(slot.as_ref().unwrap())
+    })
+}
+
 /// 便利函数：反汇编单条RISC-V 64位指令
 pub fn disasm_riscv64_instruction(code: u32, address: u64) -> Result<String> {
-    let disasm = RiscvDisassembler::new()?;
-    disasm.disasm_instruction(code, address)
+    with_shared_disasm(|d| d.disasm_instruction(code, address))
 }
 
 /// 便利函数：反汇编RISC-V 64位指令并显示详细信息
 pub fn disasm_riscv64_with_details(code: u32, address: u64) -> Result<String> {
-    let disasm = RiscvDisassembler::new()?;
-    disasm.disasm_with_details(code, address)
+    with_shared_disasm(|d| d.disasm_with_details(code, address))
 }
 
 #[cfg(test)]
@@ -183,6 +217,22 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_cache_and_block() {
+        let disasm = RiscvDisassembler::new().expect("Failed to create disassembler");
+
+        // 同一(指令字, 地址)重复出现只解码一次，其余命中缓存
+        let insts: Vec<(u64, u32)> = (0..100).map(|_| (0x1000u64, 0x00000013u32)).collect();
+        let lines = disasm.disasm_block(&insts);
+        assert_eq!(lines.len(), 100);
+        assert!(lines.iter().all(|l| l == &lines[0]));
+        assert_eq!(disasm.cache.borrow().len(), 1);
+
+        // 缓存命中的文本与直接反汇编一致
+        let direct = disasm.disasm_instruction(0x00000013, 0x1000).unwrap();
+        assert_eq!(lines[0], direct);
+    }
+
     #[test]
     fn test_convenience_functions() {
         let nop_code = 0x00000013;
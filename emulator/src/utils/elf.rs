@@ -3,97 +3,195 @@
 use crate::difftest::Difftest;
 use crate::emulator::State;
 use anyhow::{Context, Result, anyhow};
-use object::{Architecture, Object, ObjectSection, SectionKind};
+use object::{Architecture, Object, ObjectSegment};
 #[cfg(feature = "difftest")]
 use rv64emu::rv64core::cpu_core::CpuCore;
 use std::fs;
 
+/// 只读mmap整个文件
+///
+/// 大镜像（内嵌数据集的60MB+测试ELF）不再read(2)进堆：解析在页
+/// 缓存上原地进行，段数据切片直接指向映射，加载的拷贝只剩每段
+/// 一次进主内存的memcpy
+pub(crate) struct MappedFile {
+    ptr: std::ptr::NonNull<u8>,
+    len: usize,
+}
+
+impl MappedFile {
+    pub(crate) fn open(path: &str) -> Result<Self> {
+        use std::os::unix::io::AsRawFd;
+
+        let file = fs::File::open(path).with_context(|| format!("无法打开ELF文件 '{}'", path))?;
+        let len = file
+            .metadata()
+            .with_context(|| format!("无法读取ELF文件 '{}' 的元数据", path))?
+            .len() as usize;
+        if len == 0 {
+            return Err(anyhow!("ELF文件 '{}' 为空", path));
+        }
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(anyhow!(
+                "无法映射ELF文件 '{}': {}",
+                path,
+                std::io::Error::last_os_error()
+            ));
+        }
+        Ok(Self {
+            ptr: std::ptr::NonNull::new(ptr as *mut u8).unwrap(),
+            len,
+        })
+    }
+
+    pub(crate) fn as_slice(&self) -> &[u8] {
+        // 安全性：映射只读且在self存活期内有效
+        unsafe { std::slice::from_raw_parts(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl Drop for MappedFile {
+    fn drop(&mut self) {
+        unsafe {
+            libc::munmap(self.ptr.as_ptr() as *mut libc::c_void, self.len);
+        }
+    }
+}
+
 /// 加载ELF文件到模拟器内存
-pub fn load_elf(state: &mut State, path: &str) -> Result<()> {
-    // 读取ELF文件
-    let elf_data = fs::read(path).with_context(|| format!("无法读取ELF文件 '{}'", path))?;
-    let elf_file =
-        object::File::parse(&*elf_data).with_context(|| format!("无法解析ELF文件 '{}'", path))?;
+///
+/// 文件mmap后原地验证头部，按PT_LOAD段加载：每段一次成块
+/// `write_memory`（主内存路径即单次memcpy加标脏），加载开销是
+/// O(段数)次系统调用加O(字节数)一遍拷贝，没有中间堆缓冲。
+/// 返回文件内容哈希，作为持久化块缓存的键
+pub fn load_elf(state: &mut State, path: &str) -> Result<u64> {
+    let mapped = MappedFile::open(path)?;
+    let elf_file = object::File::parse(mapped.as_slice())
+        .with_context(|| format!("无法解析ELF文件 '{}'", path))?;
 
     // 验证目标架构
     if !matches!(elf_file.architecture(), Architecture::Riscv64) {
         return Err(anyhow!("不支持的目标架构, 仅支持RISC-V"));
     }
 
-    // 遍历所有节并加载到内存
-    for section in elf_file.sections() {
-        // 跳过非分配节
-        if !matches!(
-            section.kind(),
-            SectionKind::Text | SectionKind::Data | SectionKind::ReadOnlyData | SectionKind::ReadOnlyString
-        ) {
+    // 按程序头加载：object的段迭代器只产出PT_LOAD
+    for segment in elf_file.segments() {
+        let addr = segment.address();
+        let data = segment
+            .data()
+            .with_context(|| format!("无法读取地址 {:#x} 处段的数据", addr))?;
+        if data.is_empty() {
             continue;
         }
 
-        let section_name = section.name().unwrap_or("<unknown>").to_string();
-        let addr = section.address();
-
-        let data = section
-            .data()
-            .with_context(|| format!("无法读取节 '{}' 的数据", section_name))?;
-
-        // println!("section name: {}, section start address: 0x{:x}, section len: 0x{:x}", section_name, addr, data.len());
-        // if section_name == ".text" {
-        //     for (i, chunk) in data.chunks(4).enumerate() {
-        //         let instruction = u32::from_le_bytes(chunk.try_into().unwrap());
-        //         println!("instruction 0x{:08x}: 0x{:08x}", i as u64 * 4 + addr, instruction);
-        //     }
-        // }
-
-        // 写入内存
+        // 每段一次成块写入（bss部分依赖内存的零初始化/复位清零）
         state
             .write_memory(addr, data)
-            .with_context(|| format!("无法将节 '{}' 写入地址 {:#x}", section_name, addr))?;
+            .with_context(|| format!("无法将段写入地址 {:#x} (长度 {:#x})", addr, data.len()))?;
     }
 
     // 设置程序入口点
     state.set_npc(elf_file.entry());
 
-    Ok(())
+    Ok(crate::emulator::block_store::content_hash(mapped.as_slice()))
 }
 
+/// 函数符号：地址索引中的一个条目
+#[cfg(any(feature = "tracer", feature = "cache-model", feature = "branch-model"))]
+#[derive(Debug, Clone)]
+pub struct FuncSym {
+    pub addr: u64,
+    pub size: u64,
+    pub name: String,
+}
+
+/// 从ELF符号表提取函数符号，按地址排序
+///
+/// 调用追踪器用它把jal/jalr的落点二分映射回函数名；
+/// 节加载（`load_elf`）之外单独解析，普通运行不付这份开销
+#[cfg(any(feature = "tracer", feature = "cache-model", feature = "branch-model"))]
+pub fn load_function_symbols(path: &str) -> Result<Vec<FuncSym>> {
+    use object::{ObjectSymbol, SymbolKind};
+
+    let mapped = MappedFile::open(path)?;
+    let elf_file = object::File::parse(mapped.as_slice())
+        .with_context(|| format!("无法解析ELF文件 '{}'", path))?;
+
+    let mut syms: Vec<FuncSym> = elf_file
+        .symbols()
+        .filter(|s| s.kind() == SymbolKind::Text && s.size() > 0)
+        .filter_map(|s| {
+            Some(FuncSym {
+                addr: s.address(),
+                size: s.size(),
+                name: s.name().ok()?.to_string(),
+            })
+        })
+        .collect();
+    syms.sort_by_key(|s| s.addr);
+    Ok(syms)
+}
+
+/// 一趟加载：DUT与difftest参考核共用同一次mmap与解析
+///
+/// 原先DUT与参考核各自读文件、各自解析，同一镜像过两遍I/O；
+/// 现在每个PT_LOAD段从映射成块写入DUT后，直接把同一切片拷入
+/// 参考核，difftest启动的文件读取与解析开销减半
 #[cfg(feature = "difftest")]
-pub fn load_elf_diff(state: &mut CpuCore, path: &str) -> Result<()> {
-    // 读取ELF文件
-    let elf_data = fs::read(path).with_context(|| format!("无法读取ELF文件 '{}'", path))?;
-    let elf_file =
-        object::File::parse(&*elf_data).with_context(|| format!("无法解析ELF文件 '{}'", path))?;
+pub fn load_elf_shared(state: &mut State, ref_core: &mut CpuCore, path: &str) -> Result<u64> {
+    let mapped = MappedFile::open(path)?;
+    let elf_file = object::File::parse(mapped.as_slice())
+        .with_context(|| format!("无法解析ELF文件 '{}'", path))?;
 
     // 验证目标架构
     if !matches!(elf_file.architecture(), Architecture::Riscv64) {
         return Err(anyhow!("不支持的目标架构, 仅支持RISC-V"));
     }
 
-    // 遍历所有节并加载到内存
-    for section in elf_file.sections() {
-        // 跳过非分配节
-        if !matches!(
-            section.kind(),
-            SectionKind::Text | SectionKind::Data | SectionKind::ReadOnlyData | SectionKind::ReadOnlyString
-        ) {
+    for segment in elf_file.segments() {
+        let addr = segment.address();
+        let data = segment
+            .data()
+            .with_context(|| format!("无法读取地址 {:#x} 处段的数据", addr))?;
+        if data.is_empty() {
             continue;
         }
 
-        let section_name = section.name().unwrap_or("<unknown>").to_string();
-        let addr = section.address();
-
-        let data = section
-            .data()
-            .with_context(|| format!("无法读取节 '{}' 的数据", section_name))?;
-
-        // 写入内存
-        for (i, byte) in data.iter().enumerate() {
-            state.set_mem(addr + i as u64, *byte as u64, 1);
-        }
+        state
+            .write_memory(addr, data)
+            .with_context(|| format!("无法将段写入地址 {:#x} (长度 {:#x})", addr, data.len()))?;
+        copy_segment_to_ref(ref_core, addr, data);
     }
 
-    // 设置程序入口点
-    state.set_pc(elf_file.entry());
+    state.set_npc(elf_file.entry());
+    ref_core.set_pc(elf_file.entry());
 
-    Ok(())
+    Ok(crate::emulator::block_store::content_hash(mapped.as_slice()))
+}
+
+/// 把一个段拷入参考核内存
+///
+/// 参考核没有成块写接口，按8字节字写入、尾部逐字节，
+/// 取代原先的逐字节set_mem循环
+#[cfg(feature = "difftest")]
+fn copy_segment_to_ref(ref_core: &mut CpuCore, addr: u64, data: &[u8]) {
+    let mut cur = addr;
+    let mut words = data.chunks_exact(8);
+    for word in words.by_ref() {
+        ref_core.set_mem(cur, u64::from_le_bytes(word.try_into().unwrap()), 8);
+        cur += 8;
+    }
+    for &byte in words.remainder() {
+        ref_core.set_mem(cur, byte as u64, 1);
+        cur += 1;
+    }
 }
@@ -0,0 +1,468 @@
+//! RV64IMAC合成指令流生成器
+//!
+//! 译码改动（稠密分发表、RVC查找表、宏融合）的基准与校验需要
+//! 受控输入，而不是某个客户程序碰巧包含的指令混合。本模块按
+//! 可配置的类别权重生成合法指令字：criterion套件用它按类别
+//! 测译码吞吐，单元测试用它做模糊校验——`fast_path`的结果必须
+//! 与对完整指令表的线性扫描一致。
+//!
+//! 随机源是种子可复现的xorshift64*，不引入rand依赖。
+
+/// 指令类别：生成权重按类别配置
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum InstClass {
+    /// RV64I寄存器-寄存器运算（含 *W 窄字形式）
+    AluReg,
+    /// RV64I立即数运算、移位与lui/auipc
+    AluImm,
+    /// M扩展乘除（含 *W 形式）
+    MulDiv,
+    /// A扩展：LR/SC与AMO
+    Atomic,
+    /// 整数加载与存储
+    LoadStore,
+    /// 条件分支
+    Branch,
+    /// jal/jalr
+    Jump,
+    /// C扩展16位指令
+    Compressed,
+}
+
+/// 全部类别（等权混合等场景使用）
+pub const ALL_CLASSES: &[InstClass] = &[
+    InstClass::AluReg,
+    InstClass::AluImm,
+    InstClass::MulDiv,
+    InstClass::Atomic,
+    InstClass::LoadStore,
+    InstClass::Branch,
+    InstClass::Jump,
+    InstClass::Compressed,
+];
+
+/// xorshift64*：确定性伪随机源，同种子产出同序列
+struct XorShift(u64);
+
+impl XorShift {
+    fn new(seed: u64) -> Self {
+        // 全零种子会让xorshift卡死在0
+        XorShift(seed.max(1))
+    }
+
+    #[inline]
+    fn next(&mut self) -> u64 {
+        let mut x = self.0;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        self.0 = x;
+        x.wrapping_mul(0x2545_f491_4f6c_dd1d)
+    }
+
+    /// [0, n) 均匀取值（n须大于0；模偏差对测试用途可忽略）
+    #[inline]
+    fn below(&mut self, n: u64) -> u64 {
+        self.next() % n
+    }
+}
+
+/// 按类别权重生成合法RV64IMAC指令字的生成器
+pub struct InstGen {
+    rng: XorShift,
+    mix: Vec<(InstClass, u32)>,
+    total_weight: u64,
+}
+
+impl InstGen {
+    /// 以给定种子与类别权重构造；权重为0的类别不会出现
+    pub fn new(seed: u64, mix: &[(InstClass, u32)]) -> Self {
+        let mix: Vec<_> = mix.iter().copied().filter(|&(_, w)| w > 0).collect();
+        assert!(!mix.is_empty(), "指令混合不能为空");
+        let total_weight = mix.iter().map(|&(_, w)| w as u64).sum();
+        InstGen {
+            rng: XorShift::new(seed),
+            mix,
+            total_weight,
+        }
+    }
+
+    /// 所有类别等权的混合
+    pub fn uniform(seed: u64) -> Self {
+        let mix: Vec<_> = ALL_CLASSES.iter().map(|&c| (c, 1)).collect();
+        Self::new(seed, &mix)
+    }
+
+    /// 按权重抽取下一个类别
+    pub fn next_class(&mut self) -> InstClass {
+        let mut pick = self.rng.below(self.total_weight);
+        for &(class, weight) in &self.mix {
+            if pick < weight as u64 {
+                return class;
+            }
+            pick -= weight as u64;
+        }
+        unreachable!("权重总和与抽签值不一致")
+    }
+
+    /// 生成下一条指令（类别按配置权重抽取）
+    pub fn next_inst(&mut self) -> u32 {
+        let class = self.next_class();
+        self.gen_class(class)
+    }
+
+    /// 生成指定类别的一条合法指令
+    pub fn gen_class(&mut self, class: InstClass) -> u32 {
+        match class {
+            InstClass::AluReg => self.gen_alu_reg(),
+            InstClass::AluImm => self.gen_alu_imm(),
+            InstClass::MulDiv => self.gen_mul_div(),
+            InstClass::Atomic => self.gen_atomic(),
+            InstClass::LoadStore => self.gen_load_store(),
+            InstClass::Branch => self.gen_branch(),
+            InstClass::Jump => self.gen_jump(),
+            InstClass::Compressed => self.gen_compressed(),
+        }
+    }
+
+    /// 生成定长指令流
+    pub fn stream(&mut self, n: usize) -> Vec<u32> {
+        (0..n).map(|_| self.next_inst()).collect()
+    }
+
+    #[inline]
+    fn reg(&mut self) -> u32 {
+        self.rng.below(32) as u32
+    }
+
+    /// 非零寄存器（RVC中x0编码另有含义的槽位使用）
+    #[inline]
+    fn reg_nz(&mut self) -> u32 {
+        1 + self.rng.below(31) as u32
+    }
+
+    /// RVC 3位压缩寄存器编号（x8..x15）
+    #[inline]
+    fn reg_c(&mut self) -> u32 {
+        self.rng.below(8) as u32
+    }
+
+    fn r_type(&mut self, opcode: u32, funct3: u32, funct7: u32) -> u32 {
+        opcode | (self.reg() << 7) | (funct3 << 12) | (self.reg() << 15) | (self.reg() << 20) | (funct7 << 25)
+    }
+
+    fn i_type(&mut self, opcode: u32, funct3: u32, imm12: u32) -> u32 {
+        opcode | (self.reg() << 7) | (funct3 << 12) | (self.reg() << 15) | ((imm12 & 0xFFF) << 20)
+    }
+
+    fn gen_alu_reg(&mut self) -> u32 {
+        // (opcode, funct3, funct7)：RV64I的R型与 *W 形式
+        const OPS: &[(u32, u32, u32)] = &[
+            (0x33, 0, 0x00), // add
+            (0x33, 0, 0x20), // sub
+            (0x33, 1, 0x00), // sll
+            (0x33, 2, 0x00), // slt
+            (0x33, 3, 0x00), // sltu
+            (0x33, 4, 0x00), // xor
+            (0x33, 5, 0x00), // srl
+            (0x33, 5, 0x20), // sra
+            (0x33, 6, 0x00), // or
+            (0x33, 7, 0x00), // and
+            (0x3b, 0, 0x00), // addw
+            (0x3b, 0, 0x20), // subw
+            (0x3b, 1, 0x00), // sllw
+            (0x3b, 5, 0x00), // srlw
+            (0x3b, 5, 0x20), // sraw
+        ];
+        let (opcode, funct3, funct7) = OPS[self.rng.below(OPS.len() as u64) as usize];
+        self.r_type(opcode, funct3, funct7)
+    }
+
+    fn gen_alu_imm(&mut self) -> u32 {
+        match self.rng.below(10) {
+            // addi/slti/sltiu/xori/ori/andi
+            0..=5 => {
+                const F3: &[u32] = &[0, 2, 3, 4, 6, 7];
+                let funct3 = F3[self.rng.below(F3.len() as u64) as usize];
+                let imm = self.rng.next() as u32;
+                self.i_type(0x13, funct3, imm)
+            }
+            // slli/srli/srai（6位shamt，高6位区分算术/逻辑）
+            6 => {
+                let shamt = self.rng.below(64) as u32;
+                match self.rng.below(3) {
+                    0 => self.i_type(0x13, 1, shamt),
+                    1 => self.i_type(0x13, 5, shamt),
+                    _ => self.i_type(0x13, 5, 0x400 | shamt),
+                }
+            }
+            // addiw/slliw/srliw/sraiw
+            7 => {
+                let shamt = self.rng.below(32) as u32;
+                match self.rng.below(4) {
+                    0 => {
+                        let imm = self.rng.next() as u32;
+                        self.i_type(0x1b, 0, imm)
+                    }
+                    1 => self.i_type(0x1b, 1, shamt),
+                    2 => self.i_type(0x1b, 5, shamt),
+                    _ => self.i_type(0x1b, 5, 0x400 | shamt),
+                }
+            }
+            // lui / auipc
+            _ => {
+                let opcode = if self.rng.below(2) == 0 { 0x37 } else { 0x17 };
+                let imm20 = (self.rng.next() as u32) & 0xFFFF_F000;
+                opcode | (self.reg() << 7) | imm20
+            }
+        }
+    }
+
+    fn gen_mul_div(&mut self) -> u32 {
+        // mul..remu与 *W 形式，funct7=1
+        const OPS: &[(u32, u32)] = &[
+            (0x33, 0), // mul
+            (0x33, 1), // mulh
+            (0x33, 2), // mulhsu
+            (0x33, 3), // mulhu
+            (0x33, 4), // div
+            (0x33, 5), // divu
+            (0x33, 6), // rem
+            (0x33, 7), // remu
+            (0x3b, 0), // mulw
+            (0x3b, 4), // divw
+            (0x3b, 5), // divuw
+            (0x3b, 6), // remw
+            (0x3b, 7), // remuw
+        ];
+        let (opcode, funct3) = OPS[self.rng.below(OPS.len() as u64) as usize];
+        self.r_type(opcode, funct3, 1)
+    }
+
+    fn gen_atomic(&mut self) -> u32 {
+        const FUNCT5: &[u32] = &[
+            0x00, // amoadd
+            0x01, // amoswap
+            0x02, // lr（rs2置0）
+            0x03, // sc
+            0x04, // amoxor
+            0x08, // amoor
+            0x0c, // amoand
+            0x10, // amomin
+            0x14, // amomax
+            0x18, // amominu
+            0x1c, // amomaxu
+        ];
+        let funct5 = FUNCT5[self.rng.below(FUNCT5.len() as u64) as usize];
+        let funct3 = 2 + self.rng.below(2) as u32; // .w / .d
+        let aqrl = self.rng.below(4) as u32;
+        let rs2 = if funct5 == 0x02 { 0 } else { self.reg() };
+        0x2f | (self.reg() << 7)
+            | (funct3 << 12)
+            | (self.reg() << 15)
+            | (rs2 << 20)
+            | (aqrl << 25)
+            | (funct5 << 27)
+    }
+
+    fn gen_load_store(&mut self) -> u32 {
+        if self.rng.below(2) == 0 {
+            // lb/lh/lw/ld/lbu/lhu/lwu
+            const F3: &[u32] = &[0, 1, 2, 3, 4, 5, 6];
+            let funct3 = F3[self.rng.below(F3.len() as u64) as usize];
+            let imm = self.rng.next() as u32;
+            self.i_type(0x03, funct3, imm)
+        } else {
+            // sb/sh/sw/sd（S型：imm拆在[11:7]与[31:25]）
+            let funct3 = self.rng.below(4) as u32;
+            let imm = self.rng.next() as u32;
+            0x23 | ((imm & 0x1F) << 7)
+                | (funct3 << 12)
+                | (self.reg() << 15)
+                | (self.reg() << 20)
+                | ((imm & 0xFE0) << 20)
+        }
+    }
+
+    fn gen_branch(&mut self) -> u32 {
+        const F3: &[u32] = &[0, 1, 4, 5, 6, 7];
+        let funct3 = F3[self.rng.below(F3.len() as u64) as usize];
+        let imm = self.rng.next() as u32;
+        0x63 | (((imm >> 1) & 0xF) << 8)
+            | (((imm >> 11) & 1) << 7)
+            | (funct3 << 12)
+            | (self.reg() << 15)
+            | (self.reg() << 20)
+            | ((imm & 0x7E0) << 20)
+            | (((imm >> 12) & 1) << 31)
+    }
+
+    fn gen_jump(&mut self) -> u32 {
+        if self.rng.below(2) == 0 {
+            // jal（J型立即数乱序布位，合法性与取值无关）
+            let imm = self.rng.next() as u32;
+            0x6f | (self.reg() << 7)
+                | (imm & 0xFF000)
+                | (((imm >> 11) & 1) << 20)
+                | ((imm & 0x7FE) << 20)
+                | (((imm >> 20) & 1) << 31)
+        } else {
+            let imm = self.rng.next() as u32;
+            self.i_type(0x67, 0, imm)
+        }
+    }
+
+    fn gen_compressed(&mut self) -> u32 {
+        // 模板满足各编码的非零约束，并避开被更特化编码占用的
+        // 槽位（c.addi16sp占c.lui的rd=2，c.jr/c.jalr占c.mv/c.add的rs2=0）
+        match self.rng.below(18) {
+            // c.addi
+            0 => {
+                let imm = self.rng.below(64) as u32;
+                0x0001 | ((imm >> 5) << 12) | (self.reg_nz() << 7) | ((imm & 0x1F) << 2)
+            }
+            // c.addiw
+            1 => {
+                let imm = self.rng.below(64) as u32;
+                0x2001 | ((imm >> 5) << 12) | (self.reg_nz() << 7) | ((imm & 0x1F) << 2)
+            }
+            // c.li
+            2 => {
+                let imm = self.rng.below(64) as u32;
+                0x4001 | ((imm >> 5) << 12) | (self.reg_nz() << 7) | ((imm & 0x1F) << 2)
+            }
+            // c.lui（rd≠0,2；置imm[17]保证nzimm非零）
+            3 => {
+                let rd = loop {
+                    let r = self.reg_nz();
+                    if r != 2 {
+                        break r;
+                    }
+                };
+                0x6001 | (1 << 12) | (rd << 7) | ((self.rng.below(32) as u32) << 2)
+            }
+            // c.andi
+            4 => {
+                let imm = self.rng.below(64) as u32;
+                0x8801 | ((imm >> 5) << 12) | (self.reg_c() << 7) | ((imm & 0x1F) << 2)
+            }
+            // c.sub/c.xor/c.or/c.and
+            5 => 0x8c01 | (self.reg_c() << 7) | ((self.rng.below(4) as u32) << 5) | (self.reg_c() << 2),
+            // c.subw/c.addw
+            6 => 0x9c01 | (self.reg_c() << 7) | ((self.rng.below(2) as u32) << 5) | (self.reg_c() << 2),
+            // c.slli
+            7 => {
+                let shamt = self.rng.below(64) as u32;
+                0x0002 | ((shamt >> 5) << 12) | (self.reg_nz() << 7) | ((shamt & 0x1F) << 2)
+            }
+            // c.srli/c.srai
+            8 => {
+                let shamt = self.rng.below(64) as u32;
+                let kind = self.rng.below(2) as u32; // [11:10]=00/01
+                0x8001 | ((shamt >> 5) << 12) | (kind << 10) | (self.reg_c() << 7) | ((shamt & 0x1F) << 2)
+            }
+            // c.mv / c.add（rs2≠0避开c.jr/c.jalr编码）
+            9 => {
+                let funct4 = 0x8002 | ((self.rng.below(2) as u32) << 12);
+                funct4 | (self.reg_nz() << 7) | (self.reg_nz() << 2)
+            }
+            // c.jr / c.jalr（rs1≠0，rs2=0）
+            10 => 0x8002 | ((self.rng.below(2) as u32) << 12) | (self.reg_nz() << 7),
+            // c.j
+            11 => 0xa001 | ((self.rng.next() as u32 & 0x7FF) << 2),
+            // c.beqz / c.bnez
+            12 => {
+                let funct3 = 0xc001 | ((self.rng.below(2) as u32) << 13);
+                funct3 | ((self.rng.next() as u32 & 0x7) << 10) | (self.reg_c() << 7) | ((self.rng.next() as u32 & 0x1F) << 2)
+            }
+            // c.lw / c.ld
+            13 => {
+                let funct3 = 0x4000 | ((self.rng.below(2) as u32) << 13);
+                funct3 | ((self.rng.next() as u32 & 0x7) << 10) | (self.reg_c() << 7) | ((self.rng.next() as u32 & 0x3) << 5) | (self.reg_c() << 2)
+            }
+            // c.sw / c.sd
+            14 => {
+                let funct3 = 0xc000 | ((self.rng.below(2) as u32) << 13);
+                funct3 | ((self.rng.next() as u32 & 0x7) << 10) | (self.reg_c() << 7) | ((self.rng.next() as u32 & 0x3) << 5) | (self.reg_c() << 2)
+            }
+            // c.addi4spn（nzuimm非零：置一位保证）
+            15 => 0x0000 | (1 << 6) | ((self.rng.next() as u32 & 0xFF) << 5) | (self.reg_c() << 2),
+            // c.lwsp / c.ldsp（rd≠0）
+            16 => {
+                let funct3 = 0x4002 | ((self.rng.below(2) as u32) << 13);
+                funct3 | ((self.rng.next() as u32 & 1) << 12) | (self.reg_nz() << 7) | ((self.rng.next() as u32 & 0x1F) << 2)
+            }
+            // c.swsp / c.sdsp
+            _ => {
+                let funct3 = 0xc002 | ((self.rng.below(2) as u32) << 13);
+                funct3 | ((self.rng.next() as u32 & 0x3F) << 7) | (self.reg() << 2)
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::const_values::EmuConfig;
+    use crate::emulator::InstDecoder;
+    use std::rc::Rc;
+
+    fn test_decoder() -> InstDecoder {
+        InstDecoder::new(Rc::new(EmuConfig::new("profile/config.toml").unwrap()))
+    }
+
+    /// 同种子同混合必须产出完全相同的流（基准可复现的前提）
+    #[test]
+    fn test_deterministic_stream() {
+        let a = InstGen::uniform(0xd01f).stream(256);
+        let b = InstGen::uniform(0xd01f).stream(256);
+        assert_eq!(a, b);
+    }
+
+    /// 模糊校验：fast_path与完整指令表的线性扫描必须一致
+    ///
+    /// 覆盖稠密分发表、按opcode分桶的兜底路径与RVC查找表；
+    /// 任何模板生成不合法编码也会在这里暴露
+    #[test]
+    fn test_fast_path_agrees_with_linear_scan() {
+        let mut decoder = test_decoder();
+        let mut igen = InstGen::uniform(0x5eed);
+        let mut pc = 0x8000_0000u64;
+        for _ in 0..50_000 {
+            let inst = igen.next_inst();
+            let expect = decoder
+                .lookup_linear(inst)
+                .unwrap_or_else(|| panic!("生成了不可译码的指令: {inst:#010x}"));
+            let (got, len) = decoder
+                .fast_path(pc, inst)
+                .unwrap_or_else(|e| panic!("fast_path拒绝了 {inst:#010x}: {e}"));
+            assert!(
+                std::ptr::eq(got, expect),
+                "译码分歧 {:#010x}: fast_path={} 线性扫描={}",
+                inst,
+                got.name,
+                expect.name
+            );
+            let expect_len = if crate::emulator::is_compressed(inst) { 2 } else { 4 };
+            assert_eq!(len, expect_len, "长度分歧 {inst:#010x}");
+            pc += len;
+        }
+    }
+
+    /// 单类别混合只产出该类别能译出的指令
+    #[test]
+    fn test_single_class_mix() {
+        let mut decoder = test_decoder();
+        let mut igen = InstGen::new(7, &[(InstClass::Atomic, 1)]);
+        for _ in 0..2_000 {
+            let inst = igen.next_inst();
+            let handler = decoder.slow_path(inst).unwrap();
+            assert!(
+                handler.name.starts_with("amo") || handler.name.starts_with("lr.") || handler.name.starts_with("sc."),
+                "Atomic类别生成了 {}",
+                handler.name
+            );
+        }
+    }
+}
@@ -2,10 +2,11 @@
 
 pub mod bit_utils;
 pub mod disasm;
-mod elf;
+pub mod elf;
+pub mod inst_gen;
 pub mod ringbuf;
 
 pub use disasm::{RiscvDisassembler, disasm_riscv64_instruction, disasm_riscv64_with_details};
 pub use elf::load_elf;
 #[cfg(feature = "difftest")]
-pub use elf::load_elf_diff;
+pub use elf::load_elf_shared;
@@ -1,3 +1,18 @@
+//! 环形缓冲
+//!
+//! [`RingBuffer`]是单线程的定长环，支撑每步的`event_list`与各
+//! 追踪器，push是全库执行最多的工具函数：容量取2的幂，下标用
+//! 掩码回绕，push路径上没有取模也没有回绕分支。
+//!
+//! [`spsc_ring`]是无锁的单生产者单消费者变体，头尾计数各占一个
+//! 缓存行（消除伪共享），供difftest流水线、后台trace写线程这类
+//! 跨线程管道共用一份经过审视的实现。
+
+use std::cell::UnsafeCell;
+use std::mem::MaybeUninit;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
 use thiserror::Error;
 
 #[derive(Debug, Error)]
@@ -8,33 +23,35 @@ pub enum RingBufferError {
     Empty,
 }
 
+/// 单线程环形缓冲（容量向上取整到2的幂）
+///
+/// 读写游标单调递增，差值即长度；下标`cursor & mask`回绕，
+/// 不需要`full`标志位
 #[derive(Debug, Clone)]
 pub struct RingBuffer<T> {
     buf: Vec<T>,
+    mask: usize,
     read: usize,
     write: usize,
-    full: bool,
 }
 
 impl<T: Copy + Default> RingBuffer<T> {
     pub fn new(size: usize) -> Self {
+        let cap = size.max(1).next_power_of_two();
         RingBuffer {
-            buf: vec![T::default(); size],
+            buf: vec![T::default(); cap],
+            mask: cap - 1,
             read: 0,
             write: 0,
-            full: false,
         }
     }
 
     pub fn push(&mut self, item: T) -> Result<(), RingBufferError> {
-        if self.full {
+        if self.is_full() {
             return Err(RingBufferError::Full);
         }
-        self.buf[self.write] = item;
-        self.write = (self.write + 1) % self.buf.len();
-        if self.write == self.read {
-            self.full = true;
-        }
+        self.buf[self.write & self.mask] = item;
+        self.write = self.write.wrapping_add(1);
         Ok(())
     }
 
@@ -42,40 +59,159 @@ impl<T: Copy + Default> RingBuffer<T> {
         if self.is_empty() {
             return Err(RingBufferError::Empty);
         }
-        let item = self.buf[self.read];
-        self.read = (self.read + 1) % self.buf.len();
-        self.full = false;
+        let item = self.buf[self.read & self.mask];
+        self.read = self.read.wrapping_add(1);
         Ok(item)
     }
 
+    /// 满时覆盖最旧元素的push：热路径，无检查、无分支地写槽位
+    #[inline(always)]
     pub fn push_overwrite(&mut self, item: T) {
-        self.buf[self.write] = item;
-        self.write = (self.write + 1) % self.buf.len();
-        if self.full {
-            self.read = self.write;
-        } else if self.write == self.read {
-            self.full = true;
+        // 安全性：mask保证下标恒小于buf.len()
+        unsafe {
+            *self.buf.get_unchecked_mut(self.write & self.mask) = item;
+        }
+        self.write = self.write.wrapping_add(1);
+        if self.len() > self.capacity() {
+            self.read = self.read.wrapping_add(1);
         }
     }
 
+    #[inline]
     pub fn is_empty(&self) -> bool {
-        !self.full && self.read == self.write
+        self.read == self.write
     }
 
+    #[inline]
     pub fn is_full(&self) -> bool {
-        self.full
+        self.len() == self.capacity()
     }
 
+    #[inline]
     pub fn capacity(&self) -> usize {
         self.buf.len()
     }
 
+    #[inline]
     pub fn len(&self) -> usize {
-        if self.full {
-            self.buf.len()
-        } else {
-            (self.write + self.buf.len() - self.read) % self.buf.len()
+        self.write.wrapping_sub(self.read)
+    }
+}
+
+/// 按缓存行对齐的包装：生产者与消费者的游标分属不同缓存行，
+/// 避免两个核在同一行上互相失效
+#[repr(align(64))]
+struct CachePadded<T>(T);
+
+/// SPSC环的共享体
+struct SpscInner<T> {
+    buf: Vec<UnsafeCell<MaybeUninit<T>>>,
+    mask: usize,
+    /// 消费者游标（读到哪了）
+    head: CachePadded<AtomicUsize>,
+    /// 生产者游标（写到哪了）
+    tail: CachePadded<AtomicUsize>,
+}
+
+// 安全性：同一槽位在任意时刻只被生产者或消费者一方访问，
+// 由head/tail的Acquire/Release配对保证
+unsafe impl<T: Send> Send for SpscInner<T> {}
+unsafe impl<T: Send> Sync for SpscInner<T> {}
+
+impl<T> Drop for SpscInner<T> {
+    fn drop(&mut self) {
+        // 两端都已销毁，残留元素在此补drop
+        let mut i = self.head.0.load(Ordering::Relaxed);
+        let tail = self.tail.0.load(Ordering::Relaxed);
+        while i != tail {
+            unsafe {
+                (*self.buf[i & self.mask].get()).assume_init_drop();
+            }
+            i = i.wrapping_add(1);
+        }
+    }
+}
+
+/// SPSC环的生产者端（仅可在一个线程上使用）
+pub struct SpscProducer<T> {
+    inner: Arc<SpscInner<T>>,
+    /// 消费者游标的本地缓存：只在疑似满时才重新Acquire加载，
+    /// 避免每次push都跨核读对方缓存行
+    cached_head: usize,
+}
+
+/// SPSC环的消费者端（仅可在一个线程上使用）
+pub struct SpscConsumer<T> {
+    inner: Arc<SpscInner<T>>,
+    /// 生产者游标的本地缓存（同cached_head的用意）
+    cached_tail: usize,
+}
+
+unsafe impl<T: Send> Send for SpscProducer<T> {}
+unsafe impl<T: Send> Send for SpscConsumer<T> {}
+
+/// 创建一个无锁SPSC环，容量向上取整到2的幂
+pub fn spsc_ring<T>(capacity: usize) -> (SpscProducer<T>, SpscConsumer<T>) {
+    let cap = capacity.max(1).next_power_of_two();
+    let inner = Arc::new(SpscInner {
+        buf: (0..cap).map(|_| UnsafeCell::new(MaybeUninit::uninit())).collect(),
+        mask: cap - 1,
+        head: CachePadded(AtomicUsize::new(0)),
+        tail: CachePadded(AtomicUsize::new(0)),
+    });
+    (
+        SpscProducer {
+            inner: inner.clone(),
+            cached_head: 0,
+        },
+        SpscConsumer {
+            inner,
+            cached_tail: 0,
+        },
+    )
+}
+
+impl<T> SpscProducer<T> {
+    /// 尝试入队；环满时原样退还元素
+    pub fn try_push(&mut self, item: T) -> Result<(), T> {
+        let tail = self.inner.tail.0.load(Ordering::Relaxed);
+        if tail.wrapping_sub(self.cached_head) > self.inner.mask {
+            self.cached_head = self.inner.head.0.load(Ordering::Acquire);
+            if tail.wrapping_sub(self.cached_head) > self.inner.mask {
+                return Err(item);
+            }
+        }
+        unsafe {
+            (*self.inner.buf[tail & self.inner.mask].get()).write(item);
+        }
+        self.inner.tail.0.store(tail.wrapping_add(1), Ordering::Release);
+        Ok(())
+    }
+
+    /// 消费者端是否已销毁
+    pub fn is_abandoned(&self) -> bool {
+        Arc::strong_count(&self.inner) == 1
+    }
+}
+
+impl<T> SpscConsumer<T> {
+    /// 尝试出队；环空时返回None
+    pub fn try_pop(&mut self) -> Option<T> {
+        let head = self.inner.head.0.load(Ordering::Relaxed);
+        if head == self.cached_tail {
+            self.cached_tail = self.inner.tail.0.load(Ordering::Acquire);
+            if head == self.cached_tail {
+                return None;
+            }
         }
+        let item = unsafe { (*self.inner.buf[head & self.inner.mask].get()).assume_init_read() };
+        self.inner.head.0.store(head.wrapping_add(1), Ordering::Release);
+        Some(item)
+    }
+
+    /// 生产者端是否已销毁（销毁后剩余元素仍可pop完）
+    pub fn is_abandoned(&self) -> bool {
+        Arc::strong_count(&self.inner) == 1
     }
 }
 
@@ -86,20 +222,22 @@ mod tests {
     #[test]
     fn test_new() {
         let rb: RingBuffer<u8> = RingBuffer::new(10);
-        assert_eq!(rb.capacity(), 10);
+        // 容量向上取整到2的幂
+        assert_eq!(rb.capacity(), 16);
         assert!(rb.is_empty());
         assert!(!rb.is_full());
     }
 
     #[test]
     fn test_push_and_pop() {
-        let mut rb = RingBuffer::new(3);
+        let mut rb = RingBuffer::new(4);
         assert!(rb.push(1).is_ok());
         assert!(rb.push(2).is_ok());
         assert!(rb.push(3).is_ok());
+        assert!(rb.push(4).is_ok());
         assert!(rb.is_full());
 
-        match rb.push(4) {
+        match rb.push(5) {
             Err(RingBufferError::Full) => (),
             _ => panic!("Expected Full error"),
         }
@@ -107,6 +245,7 @@ mod tests {
         assert_eq!(rb.pop().unwrap(), 1);
         assert_eq!(rb.pop().unwrap(), 2);
         assert_eq!(rb.pop().unwrap(), 3);
+        assert_eq!(rb.pop().unwrap(), 4);
         assert!(rb.is_empty());
 
         match rb.pop() {
@@ -134,22 +273,24 @@ mod tests {
 
     #[test]
     fn test_push_overwrite() {
-        let mut rb = RingBuffer::new(3);
+        let mut rb = RingBuffer::new(4);
         rb.push_overwrite(1);
         rb.push_overwrite(2);
         rb.push_overwrite(3);
-        assert!(rb.is_full());
         rb.push_overwrite(4);
         assert!(rb.is_full());
+        rb.push_overwrite(5);
+        assert!(rb.is_full());
         assert_eq!(rb.pop().unwrap(), 2);
         assert_eq!(rb.pop().unwrap(), 3);
         assert_eq!(rb.pop().unwrap(), 4);
+        assert_eq!(rb.pop().unwrap(), 5);
         assert!(rb.is_empty());
     }
 
     #[test]
     fn test_len() {
-        let mut rb = RingBuffer::new(5);
+        let mut rb = RingBuffer::new(4);
         assert_eq!(rb.len(), 0);
         rb.push(1).unwrap();
         assert_eq!(rb.len(), 1);
@@ -160,10 +301,76 @@ mod tests {
         rb.push(3).unwrap();
         rb.push(4).unwrap();
         rb.push(5).unwrap();
-        rb.push(6).unwrap();
-        assert_eq!(rb.len(), 5);
+        assert_eq!(rb.len(), 4);
         assert!(rb.is_full());
         rb.pop().unwrap();
-        assert_eq!(rb.len(), 4);
+        assert_eq!(rb.len(), 3);
+    }
+
+    #[test]
+    fn test_cursor_wraparound() {
+        // 游标回绕usize边界时长度与槽位计算仍然正确
+        let mut rb: RingBuffer<u32> = RingBuffer::new(2);
+        rb.read = usize::MAX - 1;
+        rb.write = usize::MAX - 1;
+        rb.push(1).unwrap();
+        rb.push(2).unwrap();
+        assert!(rb.is_full());
+        assert_eq!(rb.pop().unwrap(), 1);
+        rb.push(3).unwrap();
+        assert_eq!(rb.pop().unwrap(), 2);
+        assert_eq!(rb.pop().unwrap(), 3);
+        assert!(rb.is_empty());
+    }
+
+    #[test]
+    fn test_spsc_basic() {
+        let (mut tx, mut rx) = spsc_ring::<u64>(4);
+        assert!(rx.try_pop().is_none());
+        for i in 0..4 {
+            assert!(tx.try_push(i).is_ok());
+        }
+        // 满后退还元素
+        assert_eq!(tx.try_push(99), Err(99));
+        for i in 0..4 {
+            assert_eq!(rx.try_pop(), Some(i));
+        }
+        assert!(rx.try_pop().is_none());
+    }
+
+    #[test]
+    fn test_spsc_threaded() {
+        const N: u64 = 100_000;
+        let (mut tx, mut rx) = spsc_ring::<u64>(256);
+        let producer = std::thread::spawn(move || {
+            for i in 0..N {
+                let mut v = i;
+                while let Err(ret) = tx.try_push(v) {
+                    v = ret;
+                    std::hint::spin_loop();
+                }
+            }
+        });
+        let mut expect = 0;
+        while expect < N {
+            if let Some(v) = rx.try_pop() {
+                assert_eq!(v, expect);
+                expect += 1;
+            } else {
+                std::hint::spin_loop();
+            }
+        }
+        producer.join().unwrap();
+    }
+
+    #[test]
+    fn test_spsc_drops_leftover() {
+        // 带堆分配的元素留在环里也不能泄漏（由SpscInner::drop回收）
+        let (mut tx, rx) = spsc_ring::<String>(4);
+        tx.try_push("a".to_string()).unwrap();
+        tx.try_push("b".to_string()).unwrap();
+        drop(rx);
+        assert!(tx.is_abandoned());
+        drop(tx);
     }
 }
@@ -38,6 +38,7 @@ int    vsprintf  (char *str, const char *format, va_list ap);
 int    vsnprintf (char *str, size_t size, const char *format, va_list ap);
 int    puts      (const char *s);
 int    putchar   (int c);
+void   klib_flush(void);
 
 // assert.h
 void   halt      (int code);
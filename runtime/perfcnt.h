@@ -0,0 +1,37 @@
+#ifndef DOLPHIN_PERFCNT_H
+#define DOLPHIN_PERFCNT_H
+
+#include <stdint.h>
+#include <device_config.h>
+
+#ifndef PERFCNT_BASE
+#define PERFCNT_BASE DEVICE_PERFCNT0_BASE
+#endif
+
+/* 寄存器偏移与模拟器侧 emulator/src/emulator/perfcnt.rs 保持一致 */
+#define PERFCNT_INSTRET_REG     (PERFCNT_BASE + 0x00)
+#define PERFCNT_CYCLES_REG      (PERFCNT_BASE + 0x08)
+#define PERFCNT_MEM_READS_REG   (PERFCNT_BASE + 0x10)
+#define PERFCNT_MEM_WRITES_REG  (PERFCNT_BASE + 0x18)
+#define PERFCNT_MMIO_READS_REG  (PERFCNT_BASE + 0x20)
+#define PERFCNT_MMIO_WRITES_REG (PERFCNT_BASE + 0x28)
+#define PERFCNT_FETCH_FAST_REG  (PERFCNT_BASE + 0x30)
+#define PERFCNT_FETCH_SLOW_REG  (PERFCNT_BASE + 0x38)
+
+/* 读任意perfcnt寄存器（传上面的 *_REG 宏；perf-stats关闭的
+ * 模拟器构建下热路径计数恒为0）；内联为一条64位MMIO读 */
+static inline uint64_t perfcnt_read(uintptr_t reg) {
+    return mmio_read64(reg);
+}
+
+/* 返回已退休的指令数（按基本块发布，读数滞后不超过一个块） */
+static inline uint64_t perfcnt_instret(void) {
+    return perfcnt_read(PERFCNT_INSTRET_REG);
+}
+
+/* 返回模型周期数（当前按 1 CPI，与指令数一致） */
+static inline uint64_t perfcnt_cycles(void) {
+    return perfcnt_read(PERFCNT_CYCLES_REG);
+}
+
+#endif // DOLPHIN_PERFCNT_H
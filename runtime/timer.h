@@ -2,6 +2,7 @@
 #define DOLPHIN_TIMER_H
 
 #include <stdint.h>
+#include <device_config.h>
 
 #ifndef TIMER_BASE
 #define TIMER_BASE DEVICE_TIMER0_BASE
@@ -9,7 +10,24 @@
 
 #define TIMER_CNT0_REG (TIMER_BASE + 0x00)
 
-/* 返回设备提供的当前时间（单位：微秒） */
-uint64_t timer_get_us(void);
+/* 返回设备提供的当前时间（单位：微秒）；内联为一条64位MMIO读 */
+static inline uint64_t timer_get_us(void) {
+    return mmio_read64(TIMER_CNT0_REG);
+}
+
+/* Zicntr计数器读取：不经过MMIO，一条CSR读指令。用.insn直接给出
+ * csrrs rd, csr, x0 的编码，这样 -march=rv64im 下也能汇编，无需
+ * 给工具链加zicsr扩展。CSR号放在I型立即数域（0xC00即-1024）。 */
+static inline uint64_t rdcycle(void) {
+    uint64_t v;
+    __asm__ volatile(".insn i 0x73, 0x2, %0, x0, -1024" : "=r"(v)); /* cycle: 0xC00 */
+    return v;
+}
+
+static inline uint64_t rdinstret(void) {
+    uint64_t v;
+    __asm__ volatile(".insn i 0x73, 0x2, %0, x0, -1022" : "=r"(v)); /* instret: 0xC02 */
+    return v;
+}
 
 #endif // DOLPHIN_TIMER_H
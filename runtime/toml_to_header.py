@@ -91,6 +91,26 @@ def write_header(out_path: str, data: Dict[str, Any]) -> None:
                 lines.append(f"#define DEVICE_{uname}_TYPE \"{t_esc}\"")
             lines.append("")
 
+    # inline MMIO accessor layer: device headers build their register
+    # accessors on these so tight guest I/O loops compile down to bare
+    # volatile load/store instructions instead of call/return pairs
+    lines.append("/* inline MMIO accessors */")
+    lines.append("#ifndef __ASSEMBLER__")
+    lines.append("#include <stdint.h>")
+    lines.append("")
+    for width in (8, 16, 32, 64):
+        lines.append(
+            f"static inline uint{width}_t mmio_read{width}(unsigned long addr) "
+            f"{{ return *(volatile uint{width}_t *)addr; }}"
+        )
+    for width in (8, 16, 32, 64):
+        lines.append(
+            f"static inline void mmio_write{width}(unsigned long addr, uint{width}_t value) "
+            f"{{ *(volatile uint{width}_t *)addr = value; }}"
+        )
+    lines.append("#endif /* __ASSEMBLER__ */")
+    lines.append("")
+
     lines.append("#endif // DOLPHIN_DEVICE_CONFIG_H")
     content = "\n".join(lines) + "\n"
 
@@ -12,7 +12,10 @@ Area heap = RANGE(&_heap_start, MEMORY_BASE + MEMORY_SIZE * 1024 * 1024);
 
 int main(const char *args);
 
+extern void klib_flush(void);
+
 void _trm_init() {
     int ret = main(mainargs);
+    klib_flush(); // main may exit with a partial line still buffered
     ctrap(ret);
 }
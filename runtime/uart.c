@@ -1,16 +1,36 @@
 #include "uart.h"
+#include <stdint.h>
 
 void uart_init(void) {
     /* 当前不需要初始化控制寄存器，保留接口以便将来扩展 */
     (void)UART_STATUS_REG;
 }
 
-void uart_putc(char c) {
-    *(volatile unsigned char *)UART_DATA_REG = (unsigned char)c;
-}
-
 void uart_puts(const char *s) {
     while (s && *s) {
         uart_putc(*s++);
     }
 }
+
+/* Batch transmit: the data register accepts 1-8 byte writes (low byte
+ * first), so a doubleword store carries 8 characters in one MMIO access
+ * instead of 8. Unaligned buffers are assembled into a word first. */
+void uart_write(const char *buf, unsigned long len) {
+    while (len >= 8) {
+        uint64_t w;
+        if (((uintptr_t)buf & 7) == 0) {
+            w = *(const uint64_t *)buf;
+        } else {
+            w = 0;
+            for (int i = 7; i >= 0; i--) {
+                w = (w << 8) | (unsigned char)buf[i];
+            }
+        }
+        mmio_write64(UART_DATA_REG, w);
+        buf += 8;
+        len -= 8;
+    }
+    while (len--) {
+        uart_putc(*buf++);
+    }
+}
@@ -11,7 +11,12 @@
 #define UART_STATUS_REG (UART_BASE + 0x04)
 
 void uart_init(void);
-void uart_putc(char c);
 void uart_puts(const char *s);
+void uart_write(const char *buf, unsigned long len);
+
+/* 单字符发送：内联为一条MMIO字节存储，紧循环里没有调用开销 */
+static inline void uart_putc(char c) {
+    mmio_write8(UART_DATA_REG, (uint8_t)c);
+}
 
 #endif // DOLPHIN_UART_H
@@ -17,7 +17,11 @@ extern "C" {
 #define REF_CPU    "i9-9900K @ 3.60GHz"
 #define REF_SCORE  100000
 
-#define REPEAT  1
+// Warm-up runs (untimed) before REPEAT timed repetitions per benchmark:
+// the minimum filters one-off effects, the median and spread expose
+// run-to-run noise that a single sample would hide
+#define WARMUP  1
+#define REPEAT  5
 
 //                  size |  heap | time |  checksum
 #define QSORT_S {     100,   1 KB,     0, 0x08467105}
@@ -56,6 +60,14 @@ extern "C" {
 #define SSORT_M {   10000, 512 KB,     0, 0x0db7909b}
 #define SSORT_L {  100000,   4 MB,  4002, 0x4f0ab431}
 #define SSORT_H { 3000000,  64 MB,322232, 0xeddbd9b6}
+#define STREAM_S {   1000,  32 KB,     0, 0xe3a3db8e}
+#define STREAM_M {  50000,   2 MB,     0, 0x062a16db}
+#define STREAM_L { 500000,  16 MB,  2000, 0x6af7d7ce}
+#define STREAM_H {2000000,  64 MB,  8000, 0x588dd44c}
+#define   LAT_S {    4096,  32 KB,     0, 0x0000034f}
+#define   LAT_M {   65536,   1 MB,     0, 0x00005a37}
+#define   LAT_L { 1048576,   8 MB,  6000, 0x0000862c}
+#define   LAT_H { 8388608,  64 MB, 60000, 0x0057cd34}
 #define   MD5_S {     100,   1 KB,     0, 0xf902f28f}
 #define   MD5_M {  200000, 256 KB,     0, 0xd4f9bc6d}
 #define   MD5_L {10000000,  10 MB, 15199, 0x27286a42}
@@ -72,6 +84,8 @@ extern "C" {
   def( lzip,  "lzip",  LZIP_S,  LZIP_M,  LZIP_L,  LZIP_H, "Lzip compression") \
   def(ssort, "ssort", SSORT_S, SSORT_M, SSORT_L, SSORT_H, "Suffix sort") \
   def(  md5,   "md5",   MD5_S,   MD5_M,   MD5_L,   MD5_H, "MD5 digest") \
+  def(stream,"stream",STREAM_S,STREAM_M,STREAM_L,STREAM_H, "STREAM-style memory bandwidth") \
+  def(  lat,   "lat",   LAT_S,   LAT_M,   LAT_L,   LAT_H, "Pointer-chase memory latency") \
 
 // Each benchmark will run REPEAT times
 
@@ -102,6 +116,7 @@ extern Setting *setting;
 typedef struct Result {
   int pass;
   uint64_t usec;
+  uint64_t cycles, instret;
 } Result;
 
 void prepare(Result *res);
@@ -11,6 +11,28 @@ static char *hbrk;
 
 static uint64_t uptime() { return timer_get_us(); }
 
+// Cycles per microsecond, calibrated at startup against the MMIO timer.
+// 0 means the cycle counter is unavailable and timing falls back to the
+// timer; otherwise each measurement is two rdcycle reads instead of two
+// MMIO round trips, with cycle granularity instead of microseconds.
+static uint64_t cycles_per_us = 0;
+
+static void calibrate_cycles() {
+  uint64_t c0 = rdcycle();
+  uint64_t t0 = uptime();
+  uint64_t t1;
+  // Spin ~2ms of wall time; the loop itself retires instructions, so
+  // the counter advances under the emulator's 1-CPI cycle model
+  do { t1 = uptime(); } while (t1 - t0 < 2000);
+  uint64_t dc = rdcycle() - c0;
+  if (dc > 0 && t1 > t0) {
+    cycles_per_us = dc / (t1 - t0);
+  }
+  if (cycles_per_us == 0) {
+    printf("cycle counter unavailable, timing via MMIO timer\n");
+  }
+}
+
 static char *format_time(uint64_t us) {
   static char buf[32];
   uint64_t ms = us / 1000;
@@ -41,7 +63,12 @@ Benchmark benchmarks[] = {
 
 // Running a benchmark
 static void bench_prepare(Result *res) {
-  res->usec = uptime();
+  res->instret = rdinstret();
+  if (cycles_per_us > 0) {
+    res->cycles = rdcycle();
+  } else {
+    res->usec = uptime();
+  }
 }
 
 static void bench_reset() {
@@ -49,7 +76,14 @@ static void bench_reset() {
 }
 
 static void bench_done(Result *res) {
-  res->usec = uptime() - res->usec;
+  if (cycles_per_us > 0) {
+    res->cycles = rdcycle() - res->cycles;
+    res->usec = res->cycles / cycles_per_us;
+  } else {
+    res->usec = uptime() - res->usec;
+    res->cycles = 0;
+  }
+  res->instret = rdinstret() - res->instret;
 }
 
 static const char *bench_check(Benchmark *bench) {
@@ -95,6 +129,8 @@ int main(const char *args) {
 
     printf("======= Running MicroBench [input *%s*] =======\n", setting_name);
 
+    calibrate_cycles();
+
     uint32_t bench_score = 0;
     int pass = 1;
     uint64_t t0 = uptime();
@@ -108,18 +144,46 @@ int main(const char *args) {
       printf("[%s] %s: ", bench->name, bench->desc);
       if (msg != NULL) {
         printf("Ignored %s\n", msg);
+        printf("RESULT name=%s input=%s status=ignored\n", bench->name, setting_name);
       } else {
-        uint64_t usec = ULLONG_MAX;
+        uint64_t times[REPEAT];
+        uint64_t last_instret = 0, last_cycles = 0;
         int succ = 1;
-        for (int i = 0; i < REPEAT; i ++) {
+
+        // Untimed warm-up repetitions (still validated)
+        for (int w = 0; w < WARMUP; w ++) {
+          Result res;
+          run_once(bench, &res);
+          succ &= res.pass;
+        }
+
+        for (int r = 0; r < REPEAT; r ++) {
           Result res;
           run_once(bench, &res);
           printf(res.pass ? "*" : "X");
           succ &= res.pass;
-          if (res.usec < usec) usec = res.usec;
+          times[r] = res.usec;
+          last_instret = res.instret;
+          last_cycles = res.cycles;
           score_time += res.usec;
         }
 
+        // Insertion sort: REPEAT is small
+        for (int r = 1; r < REPEAT; r ++) {
+          uint64_t t = times[r];
+          int j = r - 1;
+          while (j >= 0 && times[j] > t) {
+            times[j + 1] = times[j];
+            j --;
+          }
+          times[j + 1] = t;
+        }
+        uint64_t usec = times[0];
+        uint64_t median = times[(REPEAT - 1) / 2];
+        // Noise estimate: spread of the samples relative to the median,
+        // in tenths of a percent (integer printf only)
+        uint64_t noise = median > 0 ? (times[REPEAT - 1] - times[0]) * 1000 / median : 0;
+
         if (succ) printf(" Passed.");
         else printf(" Failed.");
 
@@ -130,8 +194,19 @@ int main(const char *args) {
         printf("\n");
         if (setting_id != 0) {
           printf("  min time: %s ms [%d]\n", format_time(usec), cur);
+          printf("  median: %s ms, noise: %d.%d%%\n", format_time(median),
+                 (int)(noise / 10), (int)(noise % 10));
         }
 
+        // Machine-parsable result line for the perf CI (stable keys)
+        // instret/cycles are from the last timed run: deterministic
+        // across hosts, so the CI can diff them at cycle granularity
+        printf("RESULT name=%s input=%s status=%s min_us=%ld median_us=%ld "
+               "max_us=%ld noise_milli=%ld cycles=%ld instret=%ld score=%d\n",
+               bench->name, setting_name, succ ? "pass" : "fail",
+               usec, median, times[REPEAT - 1], noise, last_cycles,
+               last_instret, cur);
+
         bench_score += cur;
       }
     }
@@ -149,6 +224,8 @@ int main(const char *args) {
     }
     printf("Scored time: %s ms\n", format_time(score_time));
     printf("Total  time: %s ms\n", format_time(total_time));
+    printf("RESULT-SUMMARY input=%s status=%s score=%d scored_us=%ld total_us=%ld\n",
+           setting_name, pass ? "pass" : "fail", bench_score, score_time, total_time);
     return (pass ? 0 : 1);
 }
 
@@ -0,0 +1,42 @@
+#include <benchmark.h>
+
+// Dependent-load latency benchmark: a pointer chase through a random
+// single-cycle permutation (Sattolo shuffle), so every load depends on
+// the previous one and cannot be pipelined or prefetched. The working
+// set (4 bytes per slot) is set per size class to land in different
+// levels of a modeled memory hierarchy.
+
+static int N;
+static uint32_t *next_idx;
+static uint32_t ans;
+
+void bench_lat_prepare() {
+  N = setting->size;
+  next_idx = (uint32_t *)bench_alloc(N * sizeof(uint32_t));
+  for (int i = 0; i < N; i ++) {
+    next_idx[i] = i;
+  }
+  bench_srand(1);
+  // Sattolo's algorithm: one cycle visiting every slot
+  for (int i = N - 1; i > 0; i --) {
+    int j = (int)((bench_rand() * 32768u + bench_rand()) % (uint32_t)i);
+    uint32_t t = next_idx[i];
+    next_idx[i] = next_idx[j];
+    next_idx[j] = t;
+  }
+}
+
+void bench_lat_run() {
+  // Not a multiple of the cycle length N, so the final position is a
+  // nontrivial function of the whole permutation
+  long steps = (long)N * 2 + (N >> 1) + 1;
+  uint32_t p = 0;
+  for (long s = 0; s < steps; s ++) {
+    p = next_idx[p];
+  }
+  ans = p;
+}
+
+int bench_lat_validate() {
+  return ans == setting->checksum;
+}
@@ -0,0 +1,40 @@
+#include <benchmark.h>
+
+// STREAM-style memory bandwidth kernels (copy / scale / add / triad)
+// over uint64_t arrays -- the rv64im target has no FPU, and integer
+// kernels stress Memory::read/write identically. Each run streams the
+// three arrays STREAM_PASSES times, so regressions in the emulator's
+// memory path show up directly in the scorecard.
+
+#define STREAM_SCALAR 3
+#define STREAM_PASSES 4
+
+static int N;
+static uint64_t *a, *b, *c;
+static uint32_t ans;
+
+void bench_stream_prepare() {
+  N = setting->size;
+  a = (uint64_t *)bench_alloc(N * sizeof(uint64_t));
+  b = (uint64_t *)bench_alloc(N * sizeof(uint64_t));
+  c = (uint64_t *)bench_alloc(N * sizeof(uint64_t));
+  for (int i = 0; i < N; i ++) {
+    a[i] = (uint64_t)i * 2654435761u + 12345;
+    b[i] = (uint64_t)i ^ 0x5555555555555555ull;
+    c[i] = 0;
+  }
+}
+
+void bench_stream_run() {
+  for (int p = 0; p < STREAM_PASSES; p ++) {
+    for (int i = 0; i < N; i ++) c[i] = a[i];                          // copy
+    for (int i = 0; i < N; i ++) b[i] = STREAM_SCALAR * c[i];          // scale
+    for (int i = 0; i < N; i ++) c[i] = a[i] + b[i];                   // add
+    for (int i = 0; i < N; i ++) a[i] = b[i] + STREAM_SCALAR * c[i];   // triad
+  }
+  ans = checksum(a, a + N);
+}
+
+int bench_stream_validate() {
+  return ans == setting->checksum;
+}
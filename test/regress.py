@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+regress.py - parallel regression runner with result caching.
+
+Usage:
+    python3 test/regress.py [ELF_OR_DIR ...] [options]
+
+Behavior:
+- Collects guest ELFs from the given files/directories (default: any
+  xmake/cmake build output under test/).
+- Runs them through the emulator's warm-process batch mode, split into
+  chunks executed in parallel across host cores.
+- Caches PASS results keyed by (ELF hash, emulator build hash, config
+  hash); unchanged passing tests are skipped on the next sweep.
+  Failures are never cached, so they always re-run.
+- Aggregates GOOD/BAD TRAP outcomes into one report and exits non-zero
+  if anything failed.
+"""
+
+from __future__ import annotations
+import argparse
+import hashlib
+import json
+import os
+import re
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+EMULATOR_DIR = os.path.join(REPO_ROOT, "emulator")
+DEFAULT_EMULATOR = os.path.join(EMULATOR_DIR, "target", "release", "emulator")
+DEFAULT_CACHE = os.path.join(REPO_ROOT, "test", ".regress_cache.json")
+CONFIG_FILES = [
+    os.path.join(EMULATOR_DIR, "profile", "config.toml"),
+    os.path.join(REPO_ROOT, "devices", "profile", "device.toml"),
+]
+
+PASS_RE = re.compile(r"^PASS (\S+)")
+FAIL_RE = re.compile(r"^FAIL (\S+)")
+
+
+def file_hash(path: str) -> str:
+    h = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def config_hash() -> str:
+    """Hash of emulator + device configuration; any change invalidates the cache."""
+    h = hashlib.sha256()
+    for path in CONFIG_FILES:
+        if os.path.exists(path):
+            h.update(file_hash(path).encode())
+    return h.hexdigest()
+
+
+def is_elf(path: str) -> bool:
+    try:
+        with open(path, "rb") as f:
+            return f.read(4) == b"\x7fELF"
+    except OSError:
+        return False
+
+
+def collect_elfs(inputs: list[str]) -> list[str]:
+    """Expand files/directories into a sorted, de-duplicated ELF list."""
+    if not inputs:
+        inputs = [os.path.join(REPO_ROOT, "test")]
+    elfs: list[str] = []
+    for item in inputs:
+        if os.path.isfile(item):
+            if is_elf(item):
+                elfs.append(os.path.abspath(item))
+        elif os.path.isdir(item):
+            for root, _dirs, files in os.walk(item):
+                for name in files:
+                    path = os.path.join(root, name)
+                    if is_elf(path):
+                        elfs.append(os.path.abspath(path))
+    return sorted(set(elfs))
+
+
+def build_emulator() -> None:
+    print("Building emulator (release)...")
+    subprocess.run(["cargo", "build", "--release"], cwd=EMULATOR_DIR, check=True)
+
+
+def load_cache(path: str) -> dict:
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+
+def save_cache(path: str, cache: dict) -> None:
+    tmp = f"{path}.tmp.{os.getpid()}"
+    with open(tmp, "w") as f:
+        json.dump(cache, f, indent=1, sort_keys=True)
+    os.replace(tmp, path)
+
+
+def cache_key(elf_hash: str, emu_hash: str, cfg_hash: str) -> str:
+    return hashlib.sha256(f"{elf_hash}:{emu_hash}:{cfg_hash}".encode()).hexdigest()
+
+
+def run_chunk(emulator: str, chunk: list[str]) -> dict[str, bool]:
+    """Run one warm-process batch; returns per-ELF pass/fail."""
+    proc = subprocess.run(
+        [emulator, "--batch", *chunk],
+        cwd=EMULATOR_DIR,
+        capture_output=True,
+        text=True,
+    )
+    results: dict[str, bool] = {}
+    for line in proc.stdout.splitlines():
+        m = PASS_RE.match(line)
+        if m:
+            results[m.group(1)] = True
+            continue
+        m = FAIL_RE.match(line)
+        if m:
+            results[m.group(1)] = False
+    # A crash before per-test reporting marks the whole chunk failed
+    for elf in chunk:
+        if elf not in results:
+            results[elf] = False
+    return results
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Parallel regression runner with result caching")
+    parser.add_argument("inputs", nargs="*", help="ELF files or directories to scan (default: test/)")
+    parser.add_argument("--emulator", default=DEFAULT_EMULATOR, help="emulator binary to use")
+    parser.add_argument("--build", action="store_true", help="cargo build --release before running")
+    parser.add_argument("--jobs", "-j", type=int, default=os.cpu_count() or 1, help="parallel emulator processes")
+    parser.add_argument("--chunk-size", type=int, default=8, help="ELFs per warm-process batch")
+    parser.add_argument("--cache", default=DEFAULT_CACHE, help="result cache file")
+    parser.add_argument("--no-cache", action="store_true", help="ignore and do not update the cache")
+    args = parser.parse_args()
+
+    if args.build:
+        build_emulator()
+    if not os.path.exists(args.emulator):
+        print(f"Error: emulator binary not found at {args.emulator} (try --build)")
+        return 1
+
+    elfs = collect_elfs(args.inputs)
+    if not elfs:
+        print("No guest ELFs found.")
+        return 1
+
+    emu_hash = file_hash(args.emulator)
+    cfg_hash = config_hash()
+    cache = {} if args.no_cache else load_cache(args.cache)
+
+    keys = {elf: cache_key(file_hash(elf), emu_hash, cfg_hash) for elf in elfs}
+    cached = [elf for elf in elfs if cache.get(keys[elf]) == "pass"]
+    to_run = [elf for elf in elfs if elf not in cached]
+    if cached:
+        print(f"Skipping {len(cached)} cached pass(es).")
+
+    results: dict[str, bool] = {elf: True for elf in cached}
+    if to_run:
+        chunks = [to_run[i:i + args.chunk_size] for i in range(0, len(to_run), args.chunk_size)]
+        print(f"Running {len(to_run)} test(s) in {len(chunks)} batch(es) on {args.jobs} worker(s)...")
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            for chunk_result in pool.map(lambda c: run_chunk(args.emulator, c), chunks):
+                results.update(chunk_result)
+
+    passed = sorted(elf for elf, ok in results.items() if ok)
+    failed = sorted(elf for elf, ok in results.items() if not ok)
+
+    # Only passes are cached; failures always re-run next sweep
+    if not args.no_cache:
+        for elf in passed:
+            if elf in keys:
+                cache[keys[elf]] = "pass"
+        save_cache(args.cache, cache)
+
+    print(f"\n=== regression report: {len(passed)}/{len(results)} passed "
+          f"({len(cached)} from cache) ===")
+    for elf in failed:
+        print(f"  FAIL {os.path.relpath(elf, REPO_ROOT)}")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())